@@ -23,29 +23,38 @@
 #include <QByteArray>
 #include <QFile>
 #include <QRegExp>
+#include <QTextCodec>
+#include <QTextStream>
 #include <QVector>
 #include <QApplication>
 
+#include <kcharsets.h>
 #include <kmessagebox.h>
 #include <kdebug.h>
 #include <kpluginfactory.h>
 #include <klocale.h>
+#include <KConfigGroup>
+#include <KSharedConfig>
 
 #include <KoCsvImportDialog.h>
+#include <KoCsvTokenizer.h>
 #include <KoFilterChain.h>
 #include <KoFilterManager.h>
 
 #include <sheets/ElapsedTime_p.h>
 #include <sheets/CalculationSettings.h>
 #include <sheets/Cell.h>
+#include <sheets/CellStorage.h>
 #include <sheets/part/Doc.h>
 #include <sheets/Global.h>
 #include <sheets/Map.h>
 #include <sheets/RowColumnFormat.h>
 #include <sheets/Sheet.h>
+#include <sheets/StringPool.h>
 #include <sheets/Style.h>
 #include <sheets/Value.h>
 #include <sheets/ValueConverter.h>
+#include <sheets/ValueParser.h>
 
 using namespace Calligra::Sheets;
 
@@ -59,6 +68,74 @@ using namespace Calligra::Sheets;
 
 K_PLUGIN_FACTORY_WITH_JSON(CSVImportFactory, "calligra_filter_csv2sheets.json", registerPlugin<CSVFilter>();)
 
+// The number of characters decoded at once by the streaming import.
+static const int g_chunkSize = 64 * 1024;
+// The streaming import measures the column widths in this many rows only.
+static const int g_widthSampleRows = 1000;
+
+namespace
+{
+
+// The width of the column needed for text.
+double textWidth(const QFontMetrics& fontMetrics, const QString& text)
+{
+    // ### FIXME: how to calculate the width of numbers (as they might not be in the right format)
+    return fontMetrics.width(text);
+}
+
+/*
+ * Fills the cells of the streaming import. Only the first rows are measured
+ * for the column widths.
+ */
+class CellFiller : public KoCsvTokenizer::Handler
+{
+public:
+    CellFiller(Sheet* sheet)
+            : m_sheet(sheet)
+            , m_storage(sheet->cellStorage())
+            , m_parser(sheet->map()->parser())
+            , m_firstLetterUpper(sheet->getFirstLetterUpper())
+            , m_fontMetrics(Cell(sheet, 1, 1).style().font()) {
+    }
+
+    void field(int row, int col, const QString& text) Q_DECL_OVERRIDE {
+        if (text.isEmpty())
+            return;
+        if (row <= g_widthSampleRows) {
+            if (col > m_widths.count())
+                m_widths.resize(col);
+            m_widths[col - 1] = qMax(m_widths[col - 1], textWidth(m_fontMetrics, text));
+        }
+        if (text[0] == '=') {
+            // formulas need the cell
+            Cell(m_sheet, col, row).parseUserInput(text);
+            return;
+        }
+        // the same as Cell::parseUserInput() for a new cell without style or validity
+        Value value = m_parser->parse(text);
+        if (m_firstLetterUpper && value.isString()) {
+            const QString str = value.asString();
+            value = Value(str[0].toUpper() + str.right(str.length() - 1));
+        }
+        m_storage->setUserInput(col, row, text);
+        m_storage->setValue(col, row, value);
+    }
+
+    const QVector<double>& widths() const {
+        return m_widths;
+    }
+
+private:
+    Sheet* m_sheet;
+    CellStorage* m_storage;
+    const ValueParser* m_parser;
+    bool m_firstLetterUpper;
+    QFontMetrics m_fontMetrics;
+    QVector<double> m_widths;
+};
+
+} // namespace
+
 CSVFilter::CSVFilter(QObject* parent, const QVariantList&) :
         KoFilter(parent)
 {
@@ -95,6 +172,12 @@ KoFilter::ConversionStatus CSVFilter::convert(const QByteArray& from, const QByt
         return KoFilter::FileNotFound;
     }
 
+    if (m_chain->manager()->getBatchMode()) {
+        const KoFilter::ConversionStatus status = convertStreaming(ksdoc, &in);
+        in.close();
+        return status;
+    }
+
     QString csv_delimiter;
     // ###### FIXME: disabled for now
     //if (!config.isNull())
@@ -147,8 +230,7 @@ KoFilter::ConversionStatus CSVFilter::convert(const QByteArray& from, const QByt
             emit sigProgress(value);
             const QString text(dialog->text(row, col));
 
-            // ### FIXME: how to calculate the width of numbers (as they might not be in the right format)
-            const double len = fm.width(text);
+            const double len = textWidth(fm, text);
             if (len > widths[col])
                 widths[col] = len;
 
@@ -205,4 +287,64 @@ KoFilter::ConversionStatus CSVFilter::convert(const QByteArray& from, const QByt
     return KoFilter::OK;
 }
 
+KoFilter::ConversionStatus CSVFilter::convertStreaming(Doc* ksdoc, QFile* in)
+{
+    // The settings the import dialog would use, see KoCsvImportDialog.
+    KConfigGroup configGroup = KSharedConfig::openConfig()->group("CSVDialog Settings");
+    const QChar textQuote = configGroup.readEntry("textQuote", "\"").at(0);
+    const QString delimiter = configGroup.readEntry("delimiter", ",");
+    const bool ignoreDuplicates = configGroup.readEntry("ignoreDups", false);
+    QTextCodec* codec = 0;
+    const QString codecText = configGroup.readEntry("codec", "");
+    if (!codecText.isEmpty())
+        codec = QTextCodec::codecForName(KCharsets::charsets()->encodingForName(codecText).toUtf8());
+    if (!codec)
+        codec = QTextCodec::codecForName("UTF-8");
+
+    ElapsedTime t("Filling data into document");
+
+    Sheet *sheet = ksdoc->map()->addNewSheet();
+    CellFiller filler(sheet);
+    // Share the repeated strings of the file, but not of later edits.
+    StringPool* const stringPool = ksdoc->map()->stringPool();
+    stringPool->setEnabled(true);
+
+    QTextStream inputStream(in);
+    inputStream.setCodec(codec);
+
+    const qint64 size = qMax(in->size(), qint64(1));
+    int progress = 0;
+    emit sigProgress(progress);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    KoCsvTokenizer tokenizer(delimiter, textQuote, ignoreDuplicates);
+    while (!inputStream.atEnd()) {
+        const QString chunk = inputStream.read(g_chunkSize);
+        tokenizer.parse(chunk.constData(), chunk.length(), &filler);
+
+        // report the progress once per percent only
+        const int current = int(98 * in->pos() / size);
+        if (current > progress) {
+            progress = current;
+            emit sigProgress(progress);
+        }
+    }
+    tokenizer.finish(&filler);
+    stringPool->setEnabled(false);
+
+    emit sigProgress(98);
+
+    const double defaultWidth = ksdoc->map()->defaultColumnFormat()->width();
+    const QVector<double>& widths = filler.widths();
+    for (int i = 0; i < widths.count(); ++i) {
+        if (widths[i] > defaultWidth)
+            sheet->nonDefaultColumnFormat(i + 1)->setWidth(widths[i]);
+    }
+
+    emit sigProgress(100);
+    QApplication::restoreOverrideCursor();
+
+    return KoFilter::OK;
+}
+
 #include <csvimport.moc>
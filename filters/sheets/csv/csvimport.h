@@ -23,6 +23,16 @@
 #include <KoFilter.h>
 #include <QVariantList>
 
+class QFile;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Doc;
+}
+}
+
 class CSVFilter : public KoFilter
 {
 
@@ -33,5 +43,10 @@ public:
     virtual ~CSVFilter() {}
 
     virtual KoFilter::ConversionStatus convert(const QByteArray& from, const QByteArray& to);
+
+private:
+    // Batch mode: parses the file chunk by chunk and fills the cells row by row
+    // without keeping the whole file in memory.
+    KoFilter::ConversionStatus convertStreaming(Calligra::Sheets::Doc* ksdoc, QFile* in);
 };
 #endif // CSVIMPORT_H
@@ -252,7 +252,9 @@ void KoImageData::setImage(const QString &url, KoStore *store, KoImageCollection
             KoStoreDevice device(store);
             const bool lossy = url.endsWith(".jpg", Qt::CaseInsensitive) || url.endsWith(".gif", Qt::CaseInsensitive);
             if (!lossy && device.size() < MAX_MEMORY_IMAGESIZE) {
-                QByteArray data = device.readAll();
+                QByteArray data = store->view();
+                if (data.isNull())
+                    data = device.readAll();
                 if (d->image.loadFromData(data)) {
                     QCryptographicHash md5(QCryptographicHash::Md5);
                     md5.addData(data);
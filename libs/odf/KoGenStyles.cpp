@@ -32,6 +32,11 @@
 #include <float.h>
 #include <OdfDebug.h>
 
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QStringList>
+
 static const struct {
     KoGenStyle::Type m_type;
     const char * m_elementName;
@@ -108,10 +113,76 @@ static void insertRawOdfStyles(const QByteArray& xml, QByteArray& styles)
     styles.append(xml);
 }
 
+// The provisional names of a collection with a target are enclosed in
+// noncharacters, that Unicode reserves for the internal use of applications.
+static const ushort provisionalBegin = 0xFDD0;
+static const ushort provisionalEnd = 0xFDD1;
+
+static QString provisionalName(int index)
+{
+    return QChar(provisionalBegin) + QString::number(index) + QChar(provisionalEnd);
+}
+
+// Replaces the provisional names in value by the final ones.
+static QString resolveNames(const QString &value, const QStringList &names)
+{
+    int begin = value.indexOf(QChar(provisionalBegin));
+    if (begin == -1)
+        return value;
+    QString result;
+    int pos = 0;
+    while (begin != -1) {
+        const int end = value.indexOf(QChar(provisionalEnd), begin);
+        if (end == -1)
+            break;
+        result += value.midRef(pos, begin - pos);
+        result += names.value(value.midRef(begin + 1, end - begin - 1).toInt());
+        pos = end + 1;
+        begin = value.indexOf(QChar(provisionalBegin), pos);
+    }
+    result += value.midRef(pos);
+    return result;
+}
+
+static void resolveNames(QMap<QString, QString> &map, const QStringList &names)
+{
+    QMap<QString, QString>::iterator it = map.begin();
+    for (; it != map.end(); ++it)
+        *it = resolveNames(*it, names);
+}
+
+// Replaces the provisional names in the written xml by the final ones.
+static void resolveNames(QByteArray &xml, const QStringList &names)
+{
+    const QByteArray begin = QString(QChar(provisionalBegin)).toUtf8();
+    const QByteArray end = QString(QChar(provisionalEnd)).toUtf8();
+    int from = xml.indexOf(begin);
+    if (from == -1)
+        return;
+    QByteArray result;
+    result.reserve(xml.size());
+    int pos = 0;
+    while (from != -1) {
+        const int to = xml.indexOf(end, from);
+        if (to == -1)
+            break;
+        const int index = xml.mid(from + begin.size(), to - from - begin.size()).toInt();
+        QString name = names.value(index);
+        // the final name may be the one of a user style
+        name.replace('&', "&amp;").replace('<', "&lt;").replace('>', "&gt;").replace('"', "&quot;");
+        result.append(xml.constData() + pos, from - pos);
+        result.append(name.toUtf8());
+        pos = to + end.size();
+        from = xml.indexOf(begin, pos);
+    }
+    result.append(xml.constData() + pos, xml.size() - pos);
+    xml = result;
+}
+
 class Q_DECL_HIDDEN KoGenStyles::Private
 {
 public:
-    Private(KoGenStyles *q) : q(q)
+    Private(KoGenStyles *q) : q(q), target(0), mutex(QMutex::Recursive)
     {
     }
 
@@ -152,6 +223,7 @@ public:
     QMap<QString, KoFontFace> fontFaces;
 
     StyleMap::iterator insertStyle(const KoGenStyle &style, const QString &name, InsertionFlags flags);
+    void resolveNames(KoGenStyle &style, const QStringList &names) const;
 
     struct RelationTarget {
         QString target; // the style we point to
@@ -166,6 +238,14 @@ public:
     QByteArray rawOdfFontFaceDecls;
 
     KoGenStyles *q;
+
+    /// the collection receiving the styles in commit(), if the names are provisional
+    KoGenStyles *target;
+    /// the base names and flags passed to insert() for the provisional names
+    QVector<QPair<QString, InsertionFlags> > provisional;
+
+    /// guards all members, the collection may be filled from several threads
+    mutable QMutex mutex;
 };
 
 QVector<KoGenStyles::NamedStyle> KoGenStyles::Private::styles(bool autoStylesInStylesDotXml, KoGenStyle::Type type) const
@@ -297,6 +377,12 @@ KoGenStyles::KoGenStyles()
 {
 }
 
+KoGenStyles::KoGenStyles(KoGenStyles *target)
+        : d(new Private(this))
+{
+    d->target = target;
+}
+
 KoGenStyles::~KoGenStyles()
 {
     delete d;
@@ -304,6 +390,7 @@ KoGenStyles::~KoGenStyles()
 
 QString KoGenStyles::insert(const KoGenStyle& style, const QString& baseName, InsertionFlags flags)
 {
+    QMutexLocker locker(&d->mutex);
     // if it is a default style it has to be saved differently
     if (style.isDefaultStyle()) {
         // we can have only one default style per type
@@ -373,6 +460,18 @@ QString KoGenStyles::insert(const KoGenStyle& style, const QString& baseName, In
 KoGenStyles::StyleMap::iterator KoGenStyles::Private::insertStyle(const KoGenStyle &style,
                                                                   const QString& baseName, InsertionFlags flags)
 {
+    if (target) {
+        const QString styleName = provisionalName(styleList.count());
+        provisional.append(qMakePair(baseName, flags));
+        styleNames[style.m_familyName].insert(styleName);
+        KoGenStyles::StyleMap::iterator it = styleMap.insert(style, styleName);
+        NamedStyle s;
+        s.style = &it.key();
+        s.name = styleName;
+        styleList.append(s);
+        return it;
+    }
+
     QString styleName(baseName);
     if (styleName.isEmpty()) {
         switch (style.type()) {
@@ -399,16 +498,19 @@ KoGenStyles::StyleMap::iterator KoGenStyles::Private::insertStyle(const KoGenSty
 
 KoGenStyles::StyleMap KoGenStyles::styles() const
 {
+    QMutexLocker locker(&d->mutex);
     return d->styleMap;
 }
 
 QVector<KoGenStyles::NamedStyle> KoGenStyles::styles(KoGenStyle::Type type) const
 {
+    QMutexLocker locker(&d->mutex);
     return d->styles(false, type);
 }
 
 const KoGenStyle* KoGenStyles::style(const QString &name, const QByteArray &family) const
 {
+    QMutexLocker locker(&d->mutex);
     QVector<KoGenStyles::NamedStyle>::const_iterator it = d->styleList.constBegin();
     const QVector<KoGenStyles::NamedStyle>::const_iterator end = d->styleList.constEnd();
     for (; it != end ; ++it) {
@@ -416,6 +518,8 @@ const KoGenStyle* KoGenStyles::style(const QString &name, const QByteArray &fami
             return (*it).style;
         }
     }
+    if (d->target)
+        return d->target->style(name, family);
     return 0;
 }
 
@@ -426,6 +530,7 @@ KoGenStyle* KoGenStyles::styleForModification(const QString &name, const QByteAr
 
 void KoGenStyles::markStyleForStylesXml(const QString &name, const QByteArray &family)
 {
+    QMutexLocker locker(&d->mutex);
     Q_ASSERT(d->styleNames[family].contains(name));
     d->styleNames[family].remove(name);
     d->autoStylesInStylesDotXml[family].insert(name);
@@ -434,6 +539,7 @@ void KoGenStyles::markStyleForStylesXml(const QString &name, const QByteArray &f
 
 void KoGenStyles::insertFontFace(const KoFontFace &face)
 {
+    QMutexLocker locker(&d->mutex);
     Q_ASSERT(!face.isNull());
     if (face.isNull()) {
         warnOdf << "This font face is null and will not be added to styles: set at least the name";
@@ -444,11 +550,13 @@ void KoGenStyles::insertFontFace(const KoFontFace &face)
 
 KoFontFace KoGenStyles::fontFace(const QString& name) const
 {
+    QMutexLocker locker(&d->mutex);
     return d->fontFaces.value(name);
 }
 
 bool KoGenStyles::saveOdfStylesDotXml(KoStore* store, KoXmlWriter* manifestWriter) const
 {
+    QMutexLocker locker(&d->mutex);
     if (!store->open("styles.xml"))
         return false;
 
@@ -474,6 +582,7 @@ bool KoGenStyles::saveOdfStylesDotXml(KoStore* store, KoXmlWriter* manifestWrite
 
 void KoGenStyles::saveOdfStyles(StylesPlacement placement, KoXmlWriter* xmlWriter) const
 {
+    QMutexLocker locker(&d->mutex);
     switch (placement) {
     case DocumentStyles:
         d->saveOdfDocumentStyles(xmlWriter);
@@ -495,6 +604,7 @@ void KoGenStyles::saveOdfStyles(StylesPlacement placement, KoXmlWriter* xmlWrite
 
 void KoGenStyles::insertRawOdfStyles(StylesPlacement placement, const QByteArray& xml)
 {
+    QMutexLocker locker(&d->mutex);
     switch (placement) {
     case DocumentStyles:
         ::insertRawOdfStyles(xml, d->rawOdfDocumentStyles);
@@ -516,12 +626,58 @@ void KoGenStyles::insertRawOdfStyles(StylesPlacement placement, const QByteArray
 
 void KoGenStyles::insertStyleRelation(const QString &source, const QString &target, const char *tagName)
 {
+    QMutexLocker locker(&d->mutex);
     KoGenStyles::Private::RelationTarget relation;
     relation.target = target;
     relation.attribute = QString(tagName);
     d->relations.insert(source, relation);
 }
 
+void KoGenStyles::Private::resolveNames(KoGenStyle &style, const QStringList &names) const
+{
+    style.m_parentName = ::resolveNames(style.m_parentName, names);
+    for (int i = 0; i <= KoGenStyle::LastPropertyType; ++i) {
+        ::resolveNames(style.m_properties[i], names);
+        ::resolveNames(style.m_childProperties[i], names);
+    }
+    ::resolveNames(style.m_attributes, names);
+    for (int i = 0; i < style.m_maps.count(); ++i)
+        ::resolveNames(style.m_maps[i], names);
+}
+
+void KoGenStyles::commit(QByteArray &xml)
+{
+    QMutexLocker locker(&d->mutex);
+    Q_ASSERT(d->target);
+    if (!d->target)
+        return;
+
+    // The styles refer to the ones inserted before them only.
+    QStringList names;
+    for (int i = 0; i < d->styleList.count(); ++i) {
+        KoGenStyle style(*d->styleList[i].style);
+        d->resolveNames(style, names);
+        names.append(d->target->insert(style, d->provisional[i].first, d->provisional[i].second));
+    }
+
+    foreach (const KoGenStyle &style, d->defaultStyles)
+        d->target->insert(style);
+    foreach (const KoFontFace &face, d->fontFaces)
+        d->target->insertFontFace(face);
+    d->target->insertRawOdfStyles(DocumentStyles, ::resolveNames(QString::fromUtf8(d->rawOdfDocumentStyles), names).toUtf8());
+    d->target->insertRawOdfStyles(MasterStyles, ::resolveNames(QString::fromUtf8(d->rawOdfMasterStyles), names).toUtf8());
+    d->target->insertRawOdfStyles(DocumentAutomaticStyles, ::resolveNames(QString::fromUtf8(d->rawOdfAutomaticStyles_contentDotXml), names).toUtf8());
+    d->target->insertRawOdfStyles(StylesXmlAutomaticStyles, ::resolveNames(QString::fromUtf8(d->rawOdfAutomaticStyles_stylesDotXml), names).toUtf8());
+    d->target->insertRawOdfStyles(FontFaceDecls, ::resolveNames(QString::fromUtf8(d->rawOdfFontFaceDecls), names).toUtf8());
+    QHash<QString, Private::RelationTarget>::const_iterator it = d->relations.constBegin();
+    for (; it != d->relations.constEnd(); ++it) {
+        d->target->insertStyleRelation(::resolveNames(it.key(), names), ::resolveNames(it.value().target, names),
+                                       it.value().attribute.toLatin1().constData());
+    }
+
+    ::resolveNames(xml, names);
+}
+
 QDebug operator<<(QDebug dbg, const KoGenStyles& styles)
 {
     dbg.nospace() << "KoGenStyles:";
@@ -53,6 +53,11 @@ class KoFontFace;
  * Since this is used for saving only, it doesn't feature refcounting, nor
  * removal of individual styles.
  *
+ * The collection may be filled from several threads at once. As the generated
+ * names depend on the order of insertion, parts of a document saved in
+ * parallel should rather gather their styles in collections of their own,
+ * see KoGenStyles(KoGenStyles*) and commit().
+ *
  * @note The use of KoGenStyles isn't mandatory, of course. If the application
  * is already designed with user and automatic styles in mind for a given
  * set of properties, it can go ahead and save all styles directly (after
@@ -72,6 +77,14 @@ public:
     typedef QMultiMap<KoGenStyle, QString> StyleMap;
 
     KoGenStyles();
+    /**
+     * Creates a collection for a part of a document, that is saved while
+     * other parts are saved into \p target , too.
+     * The inserted styles get provisional names, that are replaced by the
+     * names generated by \p target in commit(). Parent styles are looked up
+     * in \p target , if they are not in this collection.
+     */
+    explicit KoGenStyles(KoGenStyles *target);
     ~KoGenStyles();
 
     /**
@@ -243,6 +256,15 @@ public:
      */
     void insertStyleRelation(const QString &source, const QString &target, const char *tagName);
 
+    /**
+     * Inserts the styles of a collection created by KoGenStyles(KoGenStyles*)
+     * into its target, in the order they were inserted here, and replaces
+     * their provisional names in \p xml , the saved part, by the final ones.
+     * Committing the parts in document order gives the same names as saving
+     * them one after another into the target.
+     */
+    void commit(QByteArray &xml);
+
 private:
     friend KOODF_EXPORT QDebug operator<<(QDebug dbg, const KoGenStyles& styles);
 
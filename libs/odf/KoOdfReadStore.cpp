@@ -28,24 +28,137 @@
 
 #include "KoOdfStylesReader.h"
 
+#include <QBuffer>
 #include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+namespace
+{
+
+// Copies the XML of the content.xml file up to the first bodyElements children
+// of the body content element, e.g. office:text, and closes the open elements.
+// The prefixes are copied as they are.
+bool skimXml(QIODevice *device, int bodyElements, QIODevice *output, QString *errorMessage)
+{
+    QXmlStreamReader reader(device);
+    reader.setNamespaceProcessing(false);
+    QXmlStreamWriter writer(output);
+
+    int depth = 0;
+    int count = 0;
+    bool inBody = false;
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            ++depth;
+            if (depth == 2) {
+                const QStringRef name = reader.qualifiedName();
+                inBody = name == QLatin1String("body") || name.endsWith(QLatin1String(":body"));
+            } else if (depth == 4 && inBody) {
+                if (count == bodyElements)
+                    break;
+                ++count;
+            }
+        } else if (reader.isEndElement()) {
+            --depth;
+        }
+        if (reader.hasError())
+            break;
+        writer.writeCurrentToken(reader);
+    }
+    if (reader.hasError()) {
+        *errorMessage = i18n("Parsing error in the main document at line %1, column %2\nError message: %3"
+                             , reader.lineNumber(), reader.columnNumber(), reader.errorString());
+        return false;
+    }
+    writer.writeEndDocument();
+    return true;
+}
+
+} // namespace
 
 class Q_DECL_HIDDEN KoOdfReadStore::Private
 {
 public:
     Private(KoStore *s)
             : store(s)
+            , lazy(false)
+            , stylesParsed(true)
+            , contentParsed(true)
+            , settingsParsed(true)
     {
     }
 
+    bool parse(const QString &fileName, KoXmlDocument &doc);
+    bool skim(const QString &name, int bodyElements, KoXmlDocument &doc, QString &errorMessage);
+
     KoStore * store;
     KoOdfStylesReader stylesReader;
     // it is needed to keep the stylesDoc around so that you can access the styles
     KoXmlDocument stylesDoc;
     KoXmlDocument contentDoc;
     KoXmlDocument settingsDoc;
+    // the skimmed content.xml in lazy mode; the styles of its automatic styles
+    // point into it like the ones of stylesDoc
+    KoXmlDocument contentStylesDoc;
+
+    bool lazy;
+    // The directory of the document in the store, as the current one may change until the
+    // files are parsed in lazy mode.
+    QString path;
+    bool stylesParsed;
+    bool contentParsed;
+    bool settingsParsed;
+    // the error of the last file parsed on demand
+    QString lastError;
 };
 
+bool KoOdfReadStore::Private::skim(const QString &name, int bodyElements, KoXmlDocument &doc, QString &errorMessage)
+{
+    if (!store->open(name)) {
+        debugOdf << "Entry content.xml not found!";
+        errorMessage = i18n("Could not find %1", QString("content.xml"));
+        return false;
+    }
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    bool ok = skimXml(store->device(), bodyElements, &buffer, &errorMessage);
+    // The rest of the file is not read.
+    store->close();
+    buffer.close();
+    if (ok) {
+        ok = KoOdfReadStore::loadAndParse(&buffer, doc, errorMessage, "content.xml");
+    }
+    return ok;
+}
+
+bool KoOdfReadStore::Private::parse(const QString &fileName, KoXmlDocument &doc)
+{
+    if (store->isOpen()) {
+        warnOdf << "Cannot parse" << fileName << "while another file of the store is open";
+        lastError = i18n("Could not open %1", fileName);
+        return false;
+    }
+    const QString name = QLatin1String("tar:/") + path + fileName;
+    if (!store->hasFile(name)) {
+        // the files besides content.xml are optional
+        return true;
+    }
+    if (!store->open(name)) {
+        lastError = i18n("Could not open %1", fileName);
+        return false;
+    }
+    QString errorMessage;
+    const bool ok = KoOdfReadStore::loadAndParse(store->device(), doc, errorMessage, fileName);
+    store->close();
+    if (!ok) {
+        lastError = errorMessage;
+    }
+    return ok;
+}
+
 KoOdfReadStore::KoOdfReadStore(KoStore *store)
         : d(new Private(store))
 {
@@ -61,23 +174,80 @@ KoStore * KoOdfReadStore::store() const
     return d->store;
 }
 
+void KoOdfReadStore::setLazyParsing(bool lazy)
+{
+    d->lazy = lazy;
+}
+
+bool KoOdfReadStore::isLazyParsing() const
+{
+    return d->lazy;
+}
+
+QString KoOdfReadStore::lastError() const
+{
+    return d->lastError;
+}
+
 KoOdfStylesReader &KoOdfReadStore::styles()
 {
+    if (!d->stylesParsed) {
+        d->stylesParsed = true;
+        d->parse("styles.xml", d->stylesDoc);
+        d->stylesReader.createStyleMap(d->stylesDoc, true);
+        // The automatic styles of content.xml are in front of the body.
+        if (d->contentParsed) {
+            d->stylesReader.createStyleMap(d->contentDoc, false);
+        } else if (d->store->isOpen()) {
+            warnOdf << "Cannot read the automatic styles of content.xml while another file of the store is open";
+            d->lastError = i18n("Could not open %1", QString("content.xml"));
+        } else if (!d->contentStylesDoc.documentElement().isNull()) {
+            // skimmed by skimContent() already
+            d->stylesReader.createStyleMap(d->contentStylesDoc, false);
+        } else {
+            QString errorMessage;
+            if (d->skim(QLatin1String("tar:/") + d->path + "content.xml", 0, d->contentStylesDoc, errorMessage)) {
+                d->stylesReader.createStyleMap(d->contentStylesDoc, false);
+            } else {
+                d->lastError = errorMessage;
+            }
+        }
+    }
     return d->stylesReader;
 }
 
 KoXmlDocument KoOdfReadStore::contentDoc() const
 {
+    if (!d->contentParsed) {
+        d->contentParsed = true;
+        d->parse("content.xml", d->contentDoc);
+    }
     return d->contentDoc;
 }
 
 KoXmlDocument KoOdfReadStore::settingsDoc() const
 {
+    if (!d->settingsParsed) {
+        d->settingsParsed = true;
+        d->parse("settings.xml", d->settingsDoc);
+    }
     return d->settingsDoc;
 }
 
 bool KoOdfReadStore::loadAndParse(QString &errorMessage)
 {
+    if (d->lazy) {
+        if (!d->store->hasFile("content.xml")) {
+            errorMessage = i18n("Could not find %1", QString("content.xml"));
+            return false;
+        }
+        d->path = d->store->currentPath();
+        d->stylesParsed = false;
+        d->contentParsed = false;
+        d->settingsParsed = false;
+        return true;
+    }
+
     if (!loadAndParse("content.xml", d->contentDoc, errorMessage)) {
         return false;
     }
@@ -98,6 +268,38 @@ bool KoOdfReadStore::loadAndParse(QString &errorMessage)
     return true;
 }
 
+bool KoOdfReadStore::loadAndParseStylesAndSettings(QString &errorMessage)
+{
+    if (d->store->hasFile("styles.xml")) {
+        if (!loadAndParse("styles.xml", d->stylesDoc, errorMessage)) {
+            return false;
+        }
+    }
+    // Load styles from style.xml
+    d->stylesReader.createStyleMap(d->stylesDoc, true);
+
+    if (d->store->hasFile("settings.xml")) {
+        loadAndParse("settings.xml", d->settingsDoc, errorMessage);
+    }
+    return true;
+}
+
+bool KoOdfReadStore::skimContent(int bodyElements, KoXmlDocument &doc, QString &errorMessage)
+{
+    if (!d->store) {
+        errorMessage = i18n("No store backend");
+        return false;
+    }
+    if (!d->skim("content.xml", bodyElements, doc, errorMessage)) {
+        return false;
+    }
+    // styles() reads the automatic styles from it
+    if (d->lazy && !d->stylesParsed && d->contentStylesDoc.documentElement().isNull()) {
+        d->contentStylesDoc = doc;
+    }
+    return true;
+}
+
 bool KoOdfReadStore::loadAndParse(const QString &fileName, KoXmlDocument &doc, QString &errorMessage)
 {
     if (!d->store) {
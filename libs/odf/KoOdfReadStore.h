@@ -48,6 +48,35 @@ public:
      */
     KoStore* store() const;
 
+    /**
+     * Enable or disable lazy parsing, disabled by default.
+     *
+     * In lazy mode loadAndParse( QString ) only checks that the content.xml file
+     * exists. Each of styles(), contentDoc() and settingsDoc() then parses its
+     * file on the first call. For the automatic styles of the content.xml file
+     * styles() skims the content.xml file up to the body only, unless
+     * skimContent() did so already.
+     *
+     * Tools that only need some parts, e.g. the meta data or the first page,
+     * do not pay for parsing the whole document this way. The store must not
+     * have another file open when a file gets parsed.
+     */
+    void setLazyParsing(bool lazy);
+
+    /**
+     * @return true if the files are parsed on the first access
+     */
+    bool isLazyParsing() const;
+
+    /**
+     * In lazy mode styles(), contentDoc() and settingsDoc() cannot report
+     * errors, they return what could be parsed.
+     *
+     * @return the error message of the last file that could not be parsed
+     *         on demand, or an empty string if there was no error
+     */
+    QString lastError() const;
+
     /**
      * Get the styles
      *
@@ -92,6 +121,36 @@ public:
      */
     bool loadAndParse(QString &errorMessage);
 
+    /**
+     * Load and parse the styles.xml and the settings.xml file only
+     *
+     * This is for documents reading the content.xml file with a stream reader.
+     * contentDoc() stays empty. The automatic styles of the content.xml file
+     * have to be added with styles().createStyleMap( doc, false ).
+     *
+     * @param errorMessage The errorMessage is set in case an error is encounted.
+     * @return true if loading and parsing was successful, false otherwise.
+     */
+    bool loadAndParseStylesAndSettings(QString &errorMessage);
+
+    /**
+     * Parse the beginning of the content.xml file only
+     *
+     * The resulting document contains everything in front of the body, e.g.
+     * the automatic styles, and the first @p bodyElements child elements of
+     * the body content element, e.g. the first pages of a presentation or the
+     * first paragraphs of a text. The reading stops after them, so the time
+     * needed does not depend on the size of the document.
+     *
+     * In lazy mode styles() takes the automatic styles from this document,
+     * if the styles were not read yet.
+     *
+     * @param doc the skimmed document; contentDoc() is not changed
+     * @param errorMessage The errorMessage is set in case an error is encounted.
+     * @return true if loading and parsing was successful, false otherwise.
+     */
+    bool skimContent(int bodyElements, KoXmlDocument &doc, QString &errorMessage);
+
     /**
      * Load a file from an odf store
      */
@@ -24,22 +24,49 @@
 
 #include <OdfDebug.h>
 
+#include <QVector>
+
 //#define DEBUG_STYLESTACK
 
+// Looks the atom of a name up without interning it. A name that was never
+// interned occurs in no document, so the lookups can end early if it is null.
+static inline KoQName findName(const QString &nsURI, const QString &localName)
+{
+#ifdef KOXML_USE_QDOM
+    // QDom documents do not intern their names
+    return KoQName(nsURI, localName);
+#else
+    return KoQName::find(nsURI, localName);
+#endif
+}
+
 class KoStyleStack::KoStyleStackPrivate
 {
+public:
+    void setPropertiesNames(const QString &styleNSURI, const QList<QString> &tagNames);
+
+    /// the interned m_propertiesTagNames
+    QVector<KoQName> propertiesNames;
 };
 
+void KoStyleStack::KoStyleStackPrivate::setPropertiesNames(const QString &styleNSURI, const QList<QString> &tagNames)
+{
+    propertiesNames.clear();
+    foreach (const QString &tagName, tagNames)
+        propertiesNames.append(KoQName(styleNSURI, tagName));
+}
+
 KoStyleStack::KoStyleStack()
-        : m_styleNSURI(KoXmlNS::style), m_foNSURI(KoXmlNS::fo), d(0)
+        : m_styleNSURI(KoXmlNS::style), m_foNSURI(KoXmlNS::fo), d(new KoStyleStackPrivate)
 {
     clear();
 }
 
 KoStyleStack::KoStyleStack(const char* styleNSURI, const char* foNSURI)
-        : m_styleNSURI(styleNSURI), m_foNSURI(foNSURI), d(0)
+        : m_styleNSURI(styleNSURI), m_foNSURI(foNSURI), d(new KoStyleStackPrivate)
 {
     m_propertiesTagNames.append("properties");
+    d->setPropertiesNames(m_styleNSURI, m_propertiesTagNames);
     clear();
 }
 
@@ -105,22 +132,27 @@ QString KoStyleStack::property(const QString &nsURI, const QString &name, const
 
 inline QString KoStyleStack::property(const QString &nsURI, const QString &name, const QString *detail) const
 {
-    QString fullName(name);
+    // look the names up once, the lookups below compare atoms only
+    const KoQName attributeName = findName(nsURI, name);
+    KoQName detailName;
     if (detail) {
-        fullName += '-' + *detail;
+        detailName = findName(nsURI, name + '-' + *detail);
+    }
+    if (attributeName.isNull() && detailName.isNull()) {
+        return QString();
     }
     QList<KoXmlElement>::ConstIterator it = m_stack.end();
     while (it != m_stack.begin()) {
         --it;
-        foreach (const QString &propertyTagName, m_propertiesTagNames) {
-            KoXmlElement properties = KoXml::namedItemNS(*it, m_styleNSURI, propertyTagName);
+        foreach (const KoQName &propertiesName, d->propertiesNames) {
+            KoXmlElement properties = KoXml::namedItemNS(*it, propertiesName);
             if (detail) {
-                QString attribute(properties.attributeNS(nsURI, fullName));
+                QString attribute(KoXml::attributeNS(properties, detailName));
                 if (!attribute.isEmpty()) {
                     return attribute;
                 }
             }
-            QString attribute(properties.attributeNS(nsURI, name));
+            QString attribute(KoXml::attributeNS(properties, attributeName));
             if (!attribute.isEmpty()) {
                 return attribute;
             }
@@ -141,17 +173,21 @@ bool KoStyleStack::hasProperty(const QString &nsURI, const QString &name, const
 
 inline bool KoStyleStack::hasProperty(const QString &nsURI, const QString &name, const QString *detail) const
 {
-    QString fullName(name);
+    const KoQName attributeName = findName(nsURI, name);
+    KoQName detailName;
     if (detail) {
-        fullName += '-' + *detail;
+        detailName = findName(nsURI, name + '-' + *detail);
+    }
+    if (attributeName.isNull() && detailName.isNull()) {
+        return false;
     }
     QList<KoXmlElement>::ConstIterator it = m_stack.end();
     while (it != m_stack.begin()) {
         --it;
-        foreach (const QString &propertiesTagName, m_propertiesTagNames) {
-            const KoXmlElement properties = KoXml::namedItemNS(*it, m_styleNSURI, propertiesTagName);
-            if (properties.hasAttributeNS(nsURI, name) ||
-                    (detail && properties.hasAttributeNS(nsURI, fullName)))
+        foreach (const KoQName &propertiesName, d->propertiesNames) {
+            const KoXmlElement properties = KoXml::namedItemNS(*it, propertiesName);
+            if (KoXml::hasAttributeNS(properties, attributeName) ||
+                    (detail && KoXml::hasAttributeNS(properties, detailName)))
                 return true;
         }
     }
@@ -162,16 +198,16 @@ inline bool KoStyleStack::hasProperty(const QString &nsURI, const QString &name,
 // This can be generalized though (hasPropertyThatCanBePercentOfParent() ? :)
 QPair<qreal,qreal> KoStyleStack::fontSize(const qreal defaultFontPointSize) const
 {
-    const QString name = "font-size";
+    const KoQName name = findName(m_foNSURI, QStringLiteral("font-size"));
     qreal percent = 100;
     QList<KoXmlElement>::ConstIterator it = m_stack.end(); // reverse iterator
 
-    while (it != m_stack.begin()) {
+    while (!name.isNull() && it != m_stack.begin()) {
         --it;
-        foreach (const QString &propertiesTagName, m_propertiesTagNames) {
-            KoXmlElement properties = KoXml::namedItemNS(*it, m_styleNSURI, propertiesTagName).toElement();
-            if (properties.hasAttributeNS(m_foNSURI, name)) {
-                const QString value = properties.attributeNS(m_foNSURI, name, QString());
+        foreach (const KoQName &propertiesName, d->propertiesNames) {
+            KoXmlElement properties = KoXml::namedItemNS(*it, propertiesName);
+            if (KoXml::hasAttributeNS(properties, name)) {
+                const QString value = KoXml::attributeNS(properties, name);
                 if (value.endsWith('%')) {
                     //sebsauer, 20070609, the specs don't say that we have to calc them together but
                     //just that we are looking for a valid parent fontsize. So, let's only take the
@@ -194,12 +230,15 @@ QPair<qreal,qreal> KoStyleStack::fontSize(const qreal defaultFontPointSize) cons
 
 bool KoStyleStack::hasChildNode(const QString &nsURI, const QString &localName) const
 {
+    const KoQName childName = findName(nsURI, localName);
+    if (childName.isNull())
+        return false;
     QList<KoXmlElement>::ConstIterator it = m_stack.end();
     while (it != m_stack.begin()) {
         --it;
-        foreach (const QString &propertiesTagName, m_propertiesTagNames) {
-            KoXmlElement properties = KoXml::namedItemNS(*it, m_styleNSURI, propertiesTagName);
-            if (!KoXml::namedItemNS(properties, nsURI, localName).isNull())
+        foreach (const KoQName &propertiesName, d->propertiesNames) {
+            KoXmlElement properties = KoXml::namedItemNS(*it, propertiesName);
+            if (!KoXml::namedItemNS(properties, childName).isNull())
                 return true;
         }
     }
@@ -209,13 +248,16 @@ bool KoStyleStack::hasChildNode(const QString &nsURI, const QString &localName)
 
 KoXmlElement KoStyleStack::childNode(const QString &nsURI, const QString &localName) const
 {
+    const KoQName childName = findName(nsURI, localName);
+    if (childName.isNull())
+        return KoXmlElement();
     QList<KoXmlElement>::ConstIterator it = m_stack.end();
 
     while (it != m_stack.begin()) {
         --it;
-        foreach (const QString &propertiesTagName, m_propertiesTagNames) {
-            KoXmlElement properties = KoXml::namedItemNS(*it, m_styleNSURI, propertiesTagName);
-            KoXmlElement e = KoXml::namedItemNS(properties, nsURI, localName);
+        foreach (const KoQName &propertiesName, d->propertiesNames) {
+            KoXmlElement properties = KoXml::namedItemNS(*it, propertiesName);
+            KoXmlElement e = KoXml::namedItemNS(properties, childName);
             if (!e.isNull())
                 return e;
         }
@@ -262,6 +304,7 @@ void KoStyleStack::setTypeProperties(const char* typeProperties)
 {
     m_propertiesTagNames.clear();
     m_propertiesTagNames.append(typeProperties == 0 || qstrlen(typeProperties) == 0 ? QString("properties") : (QString(typeProperties) + "-properties"));
+    d->setPropertiesNames(m_styleNSURI, m_propertiesTagNames);
 }
 
 void KoStyleStack::setTypeProperties(const QList<QString> &typeProperties)
@@ -275,4 +318,5 @@ void KoStyleStack::setTypeProperties(const QList<QString> &typeProperties)
     if (m_propertiesTagNames.empty()) {
         m_propertiesTagNames.append("properties");
     }
+    d->setPropertiesNames(m_styleNSURI, m_propertiesTagNames);
 }
@@ -0,0 +1,225 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkXmlReader.h"
+
+#include <KoStyleStack.h>
+#include <KoXmlNS.h>
+#include <KoXmlReader.h>
+
+#include <QList>
+#include <QLoggingCategory>
+#include <QTest>
+
+// The sizes of the generated content.xml, about 6 MB.
+static const int g_styles = 100;
+static const int g_tables = 20;
+static const int g_rows = 100;
+static const int g_columns = 20;
+
+// Generates the content of a spreadsheet: automatic cell styles, the sheets
+// followed by the named expressions and cells with a few attributes each.
+static QByteArray createContent()
+{
+    QByteArray content;
+    content += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    content += "<office:document-content";
+    content += " xmlns:office=\"" + KoXmlNS::office.toUtf8() + '"';
+    content += " xmlns:style=\"" + KoXmlNS::style.toUtf8() + '"';
+    content += " xmlns:text=\"" + KoXmlNS::text.toUtf8() + '"';
+    content += " xmlns:table=\"" + KoXmlNS::table.toUtf8() + '"';
+    content += " xmlns:fo=\"" + KoXmlNS::fo.toUtf8() + "\">";
+    content += "<office:automatic-styles>";
+    for (int i = 0; i < g_styles; ++i) {
+        content += "<style:style style:name=\"ce" + QByteArray::number(i) + "\" style:family=\"table-cell\">";
+        content += "<style:table-cell-properties fo:background-color=\"#ffffff\" fo:border=\"none\"/>";
+        content += "<style:paragraph-properties fo:text-align=\"start\"/>";
+        content += "<style:text-properties fo:font-size=\"10pt\" fo:font-weight=\"bold\"/>";
+        content += "</style:style>";
+    }
+    content += "</office:automatic-styles>";
+    content += "<office:body><office:spreadsheet>";
+    for (int t = 0; t < g_tables; ++t) {
+        content += "<table:table table:name=\"Sheet" + QByteArray::number(t) + "\">";
+        for (int r = 0; r < g_rows; ++r) {
+            content += "<table:table-row table:style-name=\"ro1\">";
+            for (int c = 0; c < g_columns; ++c) {
+                const QByteArray value = QByteArray::number(r * g_columns + c);
+                content += "<table:table-cell table:style-name=\"ce" + QByteArray::number(c % g_styles) + '"';
+                content += " office:value-type=\"float\" office:value=\"" + value + "\">";
+                content += "<text:p>" + value + "</text:p>";
+                content += "</table:table-cell>";
+            }
+            content += "</table:table-row>";
+        }
+        content += "</table:table>";
+    }
+    content += "<table:named-expressions/>";
+    content += "</office:spreadsheet></office:body>";
+    content += "</office:document-content>";
+    return content;
+}
+
+static KoXmlElement spreadsheetElement(const KoXmlDocument &doc)
+{
+    const KoXmlElement body = KoXml::namedItemNS(doc.documentElement(), KoXmlNS::office, "body");
+    return KoXml::namedItemNS(body, KoXmlNS::office, "spreadsheet");
+}
+
+static void addLookups()
+{
+    QTest::addColumn<bool>("atoms");
+
+    QTest::newRow("strings") << false;
+    QTest::newRow("atoms") << true;
+}
+
+void XmlReaderBenchmark::initTestCase()
+{
+    QLoggingCategory::setFilterRules("*.debug=false\n"
+        "calligra.lib.odf=true\ncalligra.lib.store=true");
+
+    m_content = createContent();
+}
+
+void XmlReaderBenchmark::testParsing()
+{
+    QBENCHMARK {
+        KoXmlDocument doc;
+        QVERIFY(doc.setContent(m_content, true));
+        // load all nodes, like a loader iterating the whole document
+        KoXmlNode root = doc.documentElement();
+        KoXml::load(root, 8);
+    }
+}
+
+void XmlReaderBenchmark::testAttributeLookup_data()
+{
+    addLookups();
+}
+
+void XmlReaderBenchmark::testAttributeLookup()
+{
+    QFETCH(bool, atoms);
+
+    KoXmlDocument doc;
+    QVERIFY(doc.setContent(m_content, true));
+    const KoXmlElement spreadsheet = spreadsheetElement(doc);
+    KoXmlNode root = doc.documentElement();
+    KoXml::load(root, 8);
+
+    const KoQName styleName(KoXmlNS::table, "style-name");
+    const KoQName valueType(KoXmlNS::office, "value-type");
+    const KoQName value(KoXmlNS::office, "value");
+    const KoQName formula(KoXmlNS::table, "formula");
+    int found = 0;
+    QBENCHMARK {
+        KoXmlElement table;
+        forEachElement(table, spreadsheet) {
+            KoXmlElement row;
+            forEachElement(row, table) {
+                KoXmlElement cell;
+                forEachElement(cell, row) {
+                    if (atoms) {
+                        found += !KoXml::attributeNS(cell, styleName).isEmpty();
+                        found += !KoXml::attributeNS(cell, valueType).isEmpty();
+                        found += !KoXml::attributeNS(cell, value).isEmpty();
+                        found += KoXml::hasAttributeNS(cell, formula);
+                    } else {
+                        found += !cell.attributeNS(KoXmlNS::table, "style-name").isEmpty();
+                        found += !cell.attributeNS(KoXmlNS::office, "value-type").isEmpty();
+                        found += !cell.attributeNS(KoXmlNS::office, "value").isEmpty();
+                        found += cell.hasAttributeNS(KoXmlNS::table, "formula");
+                    }
+                }
+            }
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void XmlReaderBenchmark::testChildLookup_data()
+{
+    addLookups();
+}
+
+void XmlReaderBenchmark::testChildLookup()
+{
+    QFETCH(bool, atoms);
+
+    KoXmlDocument doc;
+    QVERIFY(doc.setContent(m_content, true));
+    const KoXmlElement spreadsheet = spreadsheetElement(doc);
+    const KoXmlElement automaticStyles = KoXml::namedItemNS(doc.documentElement(), KoXmlNS::office, "automatic-styles");
+    QList<KoXmlElement> styles;
+    KoXmlElement element;
+    forEachElement(element, automaticStyles)
+        styles.append(element);
+
+    // the named expressions follow all sheets, the text properties are the last of few
+    const KoQName namedExpressions(KoXmlNS::table, "named-expressions");
+    const KoQName textProperties(KoXmlNS::style, "text-properties");
+    int found = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 100; ++i) {
+            foreach (const KoXmlElement &style, styles) {
+                if (atoms) {
+                    found += !KoXml::namedItemNS(spreadsheet, namedExpressions).isNull();
+                    found += !KoXml::namedItemNS(style, textProperties).isNull();
+                } else {
+                    found += !KoXml::namedItemNS(spreadsheet, KoXmlNS::table, "named-expressions").isNull();
+                    found += !KoXml::namedItemNS(style, KoXmlNS::style, "text-properties").isNull();
+                }
+            }
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void XmlReaderBenchmark::testStyleStack()
+{
+    KoXmlDocument doc;
+    QVERIFY(doc.setContent(m_content, true));
+    const KoXmlElement automaticStyles = KoXml::namedItemNS(doc.documentElement(), KoXmlNS::office, "automatic-styles");
+    QList<KoXmlElement> styles;
+    KoXmlElement element;
+    forEachElement(element, automaticStyles)
+        styles.append(element);
+
+    KoStyleStack stack;
+    stack.setTypeProperties(QList<QString>() << "table-cell" << "paragraph" << "text");
+    int found = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 100; ++i) {
+            foreach (const KoXmlElement &style, styles) {
+                stack.save();
+                stack.push(style);
+                found += stack.hasProperty(KoXmlNS::fo, "background-color");
+                found += !stack.property(KoXmlNS::fo, "border", "left").isEmpty();
+                found += !stack.property(KoXmlNS::fo, "text-align").isEmpty();
+                found += !stack.property(KoXmlNS::fo, "font-size").isEmpty();
+                found += stack.hasProperty(KoXmlNS::style, "rotation-angle");
+                stack.restore();
+            }
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+QTEST_GUILESS_MAIN(XmlReaderBenchmark)
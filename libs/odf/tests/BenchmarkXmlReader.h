@@ -0,0 +1,42 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef BENCHMARK_XML_READER_H
+#define BENCHMARK_XML_READER_H
+
+#include <QByteArray>
+#include <QObject>
+
+class XmlReaderBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testParsing();
+    void testAttributeLookup_data();
+    void testAttributeLookup();
+    void testChildLookup_data();
+    void testChildLookup();
+    void testStyleStack();
+
+private:
+    QByteArray m_content;
+};
+
+#endif // BENCHMARK_XML_READER_H
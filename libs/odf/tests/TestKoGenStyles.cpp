@@ -376,4 +376,49 @@ void TestKoGenStyles::testStylesDotXml()
     QCOMPARE(firstName, QString("P2"));     // anything but not P1.
 }
 
+void TestKoGenStyles::testCommit()
+{
+    KoGenStyles coll;
+    KoGenStyle user(KoGenStyle::ParagraphStyle, "paragraph");
+    user.addProperty("style:margin-left", "1cm");
+    QCOMPARE(coll.insert(user, "User", KoGenStyles::DontAddNumberToName), QString("User"));
+
+    // Two parts saved at once, that get their names in commit().
+    KoGenStyles first(&coll);
+    KoGenStyles second(&coll);
+
+    KoGenStyle shared(KoGenStyle::TextAutoStyle, "text");
+    shared.addProperty("fo:font-weight", "bold");
+    KoGenStyle own(KoGenStyle::TextAutoStyle, "text");
+    own.addProperty("fo:font-style", "italic");
+
+    const QString secondOwnName = second.insert(own, "T");
+    const QString secondSharedName = second.insert(shared, "T");
+    // equal to its parent, that is looked up in the target
+    KoGenStyle sameAsUser(KoGenStyle::ParagraphAutoStyle, "paragraph", "User");
+    sameAsUser.addProperty("style:margin-left", "1cm");
+    QCOMPARE(second.insert(sameAsUser, "P"), QString("User"));
+
+    const QString sharedName = first.insert(shared, "T");
+    KoGenStyle paragraph(KoGenStyle::ParagraphAutoStyle, "paragraph", "User");
+    paragraph.addAttribute("style:master-page-name", sharedName); // refers to a provisional name
+    const QString paragraphName = first.insert(paragraph, "P");
+    QVERIFY(coll.styles(KoGenStyle::TextAutoStyle).isEmpty());
+
+    QByteArray firstXml = "<p a=\"" + paragraphName.toUtf8() + "\" b=\"" + sharedName.toUtf8() + "\"/>";
+    QByteArray secondXml = "<p a=\"" + secondOwnName.toUtf8() + "\" b=\"" + secondSharedName.toUtf8() + "\"/>";
+    first.commit(firstXml);
+    second.commit(secondXml);
+
+    // the names of saving the first part before the second one
+    QCOMPARE(firstXml, QByteArray("<p a=\"P1\" b=\"T1\"/>"));
+    QCOMPARE(secondXml, QByteArray("<p a=\"T2\" b=\"T1\"/>"));
+    const KoGenStyle *committed = coll.style("P1", "paragraph");
+    QVERIFY(committed);
+    QCOMPARE(committed->attribute("style:master-page-name"), QString("T1"));
+    QCOMPARE(committed->parentName(), QString("User"));
+    QCOMPARE(coll.styles(KoGenStyle::TextAutoStyle).count(), 2);
+    QCOMPARE(coll.styles(KoGenStyle::TextAutoStyle)[0].name, QString("T1"));
+}
+
 QTEST_MAIN(TestKoGenStyles)
@@ -32,6 +32,7 @@ private Q_SLOTS:
     void testUserStyles();
     void testWriteStyle();
     void testStylesDotXml();
+    void testCommit();
 };
 
 #endif // TESTKOGENSTYLES_H
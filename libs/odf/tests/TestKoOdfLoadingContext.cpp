@@ -145,6 +145,11 @@ void TestKoOdfLoadingContext::testFillStyleStack()
         QCOMPARE(styleStack.property(KoXmlNS::draw, "fill"), QString("solid"));
         QVERIFY(styleStack.hasProperty(KoXmlNS::draw, "stroke"));
         QCOMPARE(styleStack.property(KoXmlNS::draw, "stroke"), QString("solid"));
+        // names that occur in no document
+        QVERIFY(!styleStack.hasProperty(KoXmlNS::draw, "no-such-property"));
+        QCOMPARE(styleStack.property(KoXmlNS::draw, "no-such-property"), QString());
+        QVERIFY(!styleStack.hasChildNode(KoXmlNS::style, "no-such-child"));
+        QVERIFY(styleStack.childNode(KoXmlNS::style, "no-such-child").isNull());
         styleStack.restore();
     }
     delete store;
@@ -0,0 +1,221 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestKoOdfReadStore.h"
+
+#include <KoOdfReadStore.h>
+#include <KoOdfStylesReader.h>
+#include <KoStore.h>
+#include <KoXmlNS.h>
+#include <KoXmlReader.h>
+
+#include <QScopedPointer>
+#include <QTest>
+
+static const int ParagraphCount = 1000;
+
+static bool writeFile(KoStore *store, const QString &name, const QByteArray &data)
+{
+    return store->open(name) && store->write(data) == data.size() && store->close();
+}
+
+static int paragraphCount(const KoXmlDocument &doc)
+{
+    const KoXmlElement body = KoXml::namedItemNS(doc.documentElement(), KoXmlNS::office, "body");
+    const KoXmlElement text = KoXml::namedItemNS(body, KoXmlNS::office, "text");
+    int count = 0;
+    KoXmlElement paragraph;
+    forEachElement(paragraph, text) {
+        if (paragraph.localName() == "p" && paragraph.namespaceURI() == KoXmlNS::text)
+            ++count;
+    }
+    return count;
+}
+
+static QString fontWeight(KoOdfStylesReader &styles)
+{
+    const KoXmlElement *style = styles.findContentAutoStyle("P1", "paragraph");
+    if (!style)
+        return QString();
+    const KoXmlElement properties = KoXml::namedItemNS(*style, KoXmlNS::style, "text-properties");
+    return properties.attributeNS(KoXmlNS::fo, "font-weight");
+}
+
+void TestKoOdfReadStore::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_fileName = m_dir.path() + QLatin1String("/test.odt");
+
+    QByteArray content =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<office:document-content xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+        " xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\""
+        " xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\""
+        " xmlns:fo=\"urn:oasis:names:tc:opendocument:xmlns:xsl-fo-compatible:1.0\" office:version=\"1.2\">"
+        "<office:automatic-styles>"
+        "<style:style style:name=\"P1\" style:family=\"paragraph\"><style:text-properties fo:font-weight=\"bold\"/></style:style>"
+        "</office:automatic-styles>"
+        "<office:body><office:text>";
+    for (int i = 0; i < ParagraphCount; ++i)
+        content += "<text:p text:style-name=\"P1\">Paragraph <text:span>" + QByteArray::number(i) + "</text:span> &amp; more</text:p>";
+    content += "</office:text></office:body></office:document-content>";
+
+    const QByteArray styles =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<office:document-styles xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+        " xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\" office:version=\"1.2\">"
+        "<office:styles><style:style style:name=\"Standard\" style:family=\"paragraph\"/></office:styles>"
+        "</office:document-styles>";
+
+    const QByteArray settings =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<office:document-settings xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" office:version=\"1.2\">"
+        "<office:settings/>"
+        "</office:document-settings>";
+
+    QScopedPointer<KoStore> store(KoStore::createStore(m_fileName, KoStore::Write,
+                                                       "application/vnd.oasis.opendocument.text", KoStore::Zip));
+    QVERIFY(writeFile(store.data(), QLatin1String("content.xml"), content));
+    QVERIFY(writeFile(store.data(), QLatin1String("styles.xml"), styles));
+    QVERIFY(writeFile(store.data(), QLatin1String("settings.xml"), settings));
+    QVERIFY(writeFile(store.data(), QLatin1String("Pictures/image.png"), QByteArray(1000, 'x')));
+    QVERIFY(store->finalize());
+}
+
+void TestKoOdfReadStore::testLazyParsing()
+{
+    QScopedPointer<KoStore> store(KoStore::createStore(m_fileName, KoStore::Read));
+    KoOdfReadStore odfStore(store.data());
+    odfStore.setLazyParsing(true);
+    QVERIFY(odfStore.isLazyParsing());
+
+    QString errorMessage;
+    QVERIFY(odfStore.loadAndParse(errorMessage));
+
+    // the current directory does not matter
+    QVERIFY(store->enterDirectory(QLatin1String("Pictures")));
+
+    QCOMPARE(odfStore.settingsDoc().documentElement().localName(), QString("document-settings"));
+
+    QVERIFY(odfStore.styles().findStyle("Standard", "paragraph"));
+    // the automatic styles of content.xml
+    QVERIFY(odfStore.styles().findContentAutoStyle("P1", "paragraph"));
+
+    QCOMPARE(paragraphCount(odfStore.contentDoc()), ParagraphCount);
+    // parsed once
+    QVERIFY(odfStore.contentDoc().documentElement() == odfStore.contentDoc().documentElement());
+    QVERIFY(odfStore.lastError().isEmpty());
+
+    // the skimmed document of the automatic styles is still alive
+    QCOMPARE(fontWeight(odfStore.styles()), QString("bold"));
+}
+
+void TestKoOdfReadStore::testSkimmedStyles()
+{
+    QScopedPointer<KoStore> store(KoStore::createStore(m_fileName, KoStore::Read));
+    KoOdfReadStore odfStore(store.data());
+    odfStore.setLazyParsing(true);
+
+    QString errorMessage;
+    QVERIFY(odfStore.loadAndParse(errorMessage));
+    {
+        KoXmlDocument doc;
+        QVERIFY(odfStore.skimContent(1, doc, errorMessage));
+        QCOMPARE(paragraphCount(doc), 1);
+    }
+    // styles() takes the automatic styles from the skimmed document, which
+    // has to outlive the one above
+    QCOMPARE(fontWeight(odfStore.styles()), QString("bold"));
+    QVERIFY(odfStore.lastError().isEmpty());
+}
+
+void TestKoOdfReadStore::testLazyErrors()
+{
+    const QString fileName = m_dir.path() + QLatin1String("/broken.odt");
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Write,
+                                                           "application/vnd.oasis.opendocument.text", KoStore::Zip));
+        QVERIFY(writeFile(store.data(), QLatin1String("content.xml"),
+                          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                          "<office:document-content xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\">"
+                          "<office:body/></office:document-content>"));
+        QVERIFY(writeFile(store.data(), QLatin1String("settings.xml"), "<office:document-settings>"));
+        QVERIFY(store->finalize());
+    }
+
+    QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Read));
+    KoOdfReadStore odfStore(store.data());
+    odfStore.setLazyParsing(true);
+    QString errorMessage;
+    QVERIFY(odfStore.loadAndParse(errorMessage));
+
+    // a parse error
+    QVERIFY(odfStore.settingsDoc().documentElement().isNull());
+    QVERIFY(!odfStore.lastError().isEmpty());
+
+    // the content.xml file cannot be read while another file is open
+    QVERIFY(store->open(QLatin1String("content.xml")));
+    QVERIFY(odfStore.contentDoc().documentElement().isNull());
+    QVERIFY(odfStore.lastError().contains(QLatin1String("content.xml")));
+    store->close();
+}
+
+void TestKoOdfReadStore::testSkimContent_data()
+{
+    QTest::addColumn<int>("bodyElements");
+    QTest::addColumn<int>("paragraphs");
+
+    QTest::newRow("none") << 0 << 0;
+    QTest::newRow("one") << 1 << 1;
+    QTest::newRow("some") << 10 << 10;
+    QTest::newRow("all") << ParagraphCount << ParagraphCount;
+    QTest::newRow("more") << ParagraphCount + 1 << ParagraphCount;
+}
+
+void TestKoOdfReadStore::testSkimContent()
+{
+    QFETCH(int, bodyElements);
+    QFETCH(int, paragraphs);
+
+    QScopedPointer<KoStore> store(KoStore::createStore(m_fileName, KoStore::Read));
+    KoOdfReadStore odfStore(store.data());
+
+    KoXmlDocument doc;
+    QString errorMessage;
+    QVERIFY(odfStore.skimContent(bodyElements, doc, errorMessage));
+    QVERIFY(!store->isOpen());
+
+    const KoXmlElement root = doc.documentElement();
+    QCOMPARE(root.localName(), QString("document-content"));
+    QCOMPARE(root.namespaceURI(), KoXmlNS::office);
+    QVERIFY(!KoXml::namedItemNS(root, KoXmlNS::office, "automatic-styles").isNull());
+    QCOMPARE(paragraphCount(doc), paragraphs);
+
+    if (paragraphs > 0) {
+        const KoXmlElement body = KoXml::namedItemNS(root, KoXmlNS::office, "body");
+        const KoXmlElement text = KoXml::namedItemNS(body, KoXmlNS::office, "text");
+        const KoXmlElement paragraph = KoXml::namedItemNS(text, KoXmlNS::text, "p");
+        QCOMPARE(paragraph.text(), QString("Paragraph 0 & more"));
+    }
+
+    // the skimmed document is not the content document
+    QVERIFY(odfStore.contentDoc().documentElement().isNull());
+}
+
+QTEST_GUILESS_MAIN(TestKoOdfReadStore)
@@ -6,6 +6,8 @@
 #include <QProcess>
 #include <QString>
 #include <QTextStream>
+#include <QThread>
+#include <QVector>
 
 #include <KoXmlReader.h>
 
@@ -23,6 +25,9 @@ private Q_SLOTS:
     void testDocument();
     void testDocumentType();
     void testNamespace();
+    void testQName();
+    void testQNameThreads();
+    void testSetElement();
     void testParseQString();
     void testUnload();
     void testSimpleXML();
@@ -937,6 +942,174 @@ void TestXmlReader::testNamespace()
     QCOMPARE(bookAuthorElement.attributeNS(fnordNS, "name", QString()).isEmpty(), true);
 }
 
+void TestXmlReader::testQName()
+{
+    const QString tableNS("urn:oasis:names:tc:opendocument:xmlns:table:1.0");
+    const QString officeNS("urn:oasis:names:tc:opendocument:xmlns:office:1.0");
+
+    // interning
+    QCOMPARE(KoQName().isNull(), true);
+    const KoQName tableName(tableNS, "table");
+    QCOMPARE(tableName.isNull(), false);
+    QCOMPARE(tableName.namespaceURI(), tableNS);
+    QCOMPARE(tableName.localName(), QString("table"));
+    QVERIFY(tableName == KoQName(tableNS, "table"));
+    QVERIFY(tableName == KoQName::find(tableNS, "table"));
+    QVERIFY(tableName != KoQName(officeNS, "table"));
+    QCOMPARE(KoQName::find(tableNS, "not-interned-yet").isNull(), true);
+
+    // more children than needed for an index, with repeated names
+    QBuffer xmldevice;
+    xmldevice.open(QIODevice::WriteOnly);
+    QTextStream xmlstream(&xmldevice);
+    xmlstream << "<office:spreadsheet xmlns:office=\"" << officeNS << "\"";
+    xmlstream << " xmlns:table=\"" << tableNS << "\">";
+    for (int i = 0; i < 40; ++i) {
+        xmlstream << "<table:table table:name=\"Sheet" << i << "\" name=\"plain\">";
+        xmlstream << "<table:table-row/>";
+        xmlstream << "</table:table>";
+    }
+    xmlstream << "<table:named-expressions/>";
+    xmlstream << "</office:spreadsheet>";
+    xmldevice.close();
+
+    KoXmlDocument doc;
+    QCOMPARE(doc.setContent(&xmldevice, true), true);
+    const KoXmlElement spreadsheet = doc.documentElement();
+
+    // the first child of each name is found, like without an index
+    const KoXmlElement table = KoXml::namedItemNS(spreadsheet, tableName);
+    QCOMPARE(table.isNull(), false);
+    QCOMPARE(table.attributeNS(tableNS, "name"), QString("Sheet0"));
+    QVERIFY(table == KoXml::namedItemNS(spreadsheet, tableNS, "table"));
+    QVERIFY(table == spreadsheet.namedItemNS(tableNS, "table").toElement());
+    const KoXmlElement expressions = KoXml::namedItemNS(spreadsheet, KoQName(tableNS, "named-expressions"));
+    QCOMPARE(expressions.isNull(), false);
+    QCOMPARE(expressions.localName(), QString("named-expressions"));
+    QCOMPARE(KoXml::namedItemNS(spreadsheet, KoQName(officeNS, "table")).isNull(), true);
+    QCOMPARE(KoXml::namedItemNS(spreadsheet, KoQName()).isNull(), true);
+    QCOMPARE(spreadsheet.namedItemNS(tableNS, "unknown").isNull(), true);
+
+    // a few children, without an index
+    const KoXmlElement row = KoXml::namedItemNS(table, KoQName(tableNS, "table-row"));
+    QCOMPARE(row.isNull(), false);
+    QVERIFY(row == table.firstChildElement());
+
+    // attributes
+    const KoQName nameAttribute(tableNS, "name");
+    QCOMPARE(KoXml::hasAttributeNS(table, nameAttribute), true);
+    QCOMPARE(KoXml::attributeNS(table, nameAttribute), QString("Sheet0"));
+    QCOMPARE(KoXml::hasAttributeNS(table, KoQName(officeNS, "name")), false);
+    QCOMPARE(KoXml::attributeNS(table, KoQName(officeNS, "name"), "none"), QString("none"));
+    QCOMPARE(KoXml::hasAttributeNS(row, nameAttribute), false);
+    QCOMPARE(KoXml::attributeNS(KoXmlElement(), nameAttribute, "none"), QString("none"));
+    QCOMPARE(table.attribute("name"), QString("plain"));
+    QCOMPARE(table.attributeFullNames().count(), 1);
+    QVERIFY(table.attributeFullNames().first() == qMakePair(tableNS, QString("name")));
+
+    // after unloading, the children and the index are loaded again
+    KoXmlNode node = spreadsheet;
+    KoXml::unload(node);
+    QCOMPARE(KoXml::namedItemNS(spreadsheet, tableName).attributeNS(tableNS, "name"), QString("Sheet0"));
+}
+
+namespace
+{
+// interns the same names as the other threads, beginning at another one
+class QNameThread : public QThread
+{
+public:
+    QNameThread(int first, int count) : first(first), names(count) {}
+    void run() {
+        const QString ns("urn:test");
+        for (int i = 0; i < names.count(); ++i) {
+            const int n = (first + i) % names.count();
+            const QString localName = QString("name-%1").arg(n);
+            names[n] = KoQName(ns, localName);
+            if (KoQName::find(ns, localName) != names[n] || names[n].localName() != localName)
+                names[n] = KoQName();
+        }
+    }
+    const int first;
+    QVector<KoQName> names;
+};
+}
+
+void TestXmlReader::testQNameThreads()
+{
+    // enough names to grow the table several times
+    const int count = 5000;
+    QList<QNameThread*> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.append(new QNameThread(i * count / 4, count));
+    foreach (QNameThread* thread, threads)
+        thread->start();
+    foreach (QNameThread* thread, threads)
+        thread->wait();
+
+    for (int n = 0; n < count; ++n) {
+        const KoQName name = threads.first()->names.at(n);
+        QVERIFY(!name.isNull());
+        QCOMPARE(name.localName(), QString("name-%1").arg(n));
+        foreach (QNameThread* thread, threads)
+            QVERIFY(thread->names.at(n) == name);
+    }
+    qDeleteAll(threads);
+}
+
+void TestXmlReader::testSetElement()
+{
+    const QString tableNS("urn:oasis:names:tc:opendocument:xmlns:table:1.0");
+    const QString textNS("urn:oasis:names:tc:opendocument:xmlns:text:1.0");
+
+    // the namespaces are declared by the enclosing elements
+    QByteArray xml;
+    xml += "<table:table xmlns:table=\"" + tableNS.toUtf8() + "\">";
+    xml += "<table:table-row-group xmlns:text=\"" + textNS.toUtf8() + "\">";
+    xml += "<table:table-row table:style-name=\"ro1\">";
+    xml += "<table:table-cell><text:p>A1</text:p></table:table-cell>";
+    xml += "</table:table-row>";
+    xml += "<table:table-row/>";
+    xml += "</table:table-row-group>";
+    xml += "</table:table>";
+
+    QXmlStreamReader reader(xml);
+    reader.setNamespaceProcessing(true);
+    QCOMPARE(reader.readNextStartElement(), true); // table:table
+    QCOMPARE(reader.readNextStartElement(), true); // table:table-row-group
+    QCOMPARE(reader.readNextStartElement(), true); // table:table-row
+
+    // only the element
+    KoXmlDocument rowStart;
+    QCOMPARE(KoXml::setElement(rowStart, &reader, false), true);
+    QCOMPARE(reader.isStartElement(), true);
+    QCOMPARE(rowStart.documentElement().localName(), QString("table-row"));
+    QCOMPARE(rowStart.documentElement().attributeNS(tableNS, "style-name"), QString("ro1"));
+    QCOMPARE(rowStart.documentElement().hasChildNodes(), false);
+
+    // the element with its children
+    KoXmlDocument row;
+    QCOMPARE(KoXml::setElement(row, &reader), true);
+    QCOMPARE(reader.isEndElement(), true);
+    QCOMPARE(reader.name().toString(), QString("table-row"));
+    const KoXmlElement rowElement = row.documentElement();
+    QCOMPARE(rowElement.namespaceURI(), tableNS);
+    QCOMPARE(rowElement.attributeNS(tableNS, "style-name"), QString("ro1"));
+    const KoXmlElement cell = KoXml::namedItemNS(rowElement, tableNS, "table-cell");
+    QCOMPARE(cell.isNull(), false);
+    const KoXmlElement paragraph = KoXml::namedItemNS(cell, textNS, "p");
+    QCOMPARE(paragraph.isNull(), false);
+    QCOMPARE(paragraph.text(), QString("A1"));
+
+    // the reader goes on after the element
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.name().toString(), QString("table-row"));
+    QCOMPARE(KoXml::setElement(row, &reader), true);
+    QCOMPARE(row.documentElement().hasChildNodes(), false);
+    QCOMPARE(reader.readNextStartElement(), false);
+    QCOMPARE(reader.name().toString(), QString("table-row-group"));
+}
+
 // mostly similar to testNamespace above, but parse from a QString
 void TestXmlReader::testParseQString()
 {
@@ -21,6 +21,7 @@
 
 #include <QString>
 #include <QBuffer>
+#include <QElapsedTimer>
 #include <QTest>
 #include <QLoggingCategory>
 
@@ -42,6 +43,10 @@ private Q_SLOTS:
     void testEscalingLongString2();
     void testConfig();
 
+    void testEscapingUnicode();
+    void testDeviceFlush();
+
+    void speedTest_data();
     void speedTest();
 
 private:
@@ -183,7 +188,7 @@ void TestXmlWriter::testAddManifestEntry()
 
 void TestXmlWriter::testEscapingLongString()
 {
-    int sz = 15000;  // must be more than KoXmlWriter::s_escapeBufferLen
+    int sz = 20000;  // must be more than KoXmlWriter's s_outputBufferLength
     QString x(sz);
     x.fill('x', sz);
     x += '&';
@@ -228,16 +233,51 @@ void TestXmlWriter::testConfig()
             " <config:config-item config:name=\"TestConfigDouble\" config:type=\"double\">5</config:config-item>"));
 }
 
+void TestXmlWriter::testEscapingUnicode()
+{
+    // surrogate pairs, markup and control codes; long enough for the fast path
+    const QString text = QString::fromUtf8("<€uro> & \"plain ascii text\" \xf0\x9d\x84\x9e\x01ö");
+    setup();
+    writer->startElement("test");
+    writer->addAttribute("a", text);
+    writer->addTextNode(text);
+    writer->endElement();
+    const QString escaped = QString::fromUtf8("&lt;€uro&gt; &amp; &quot;plain ascii text&quot; \xf0\x9d\x84\x9eö");
+    QCOMPARE(content(), QString("<test a=\"" + escaped + "\">" + escaped + "</test>"));
+}
+
+void TestXmlWriter::testDeviceFlush()
+{
+    setup();
+    writer->startElement("test");
+    writer->addAttribute("a", "b");
+    // the buffered output is written, before the device is handed out
+    QVERIFY(writer->device()->pos() > 0);
+    QVERIFY(buffer->data().endsWith("<test a=\"b\""));
+    writer->endElement();
+    QCOMPARE(content(), QString("<test a=\"b\"/>"));
+}
+
 static const int NumParagraphs = 30000;
 
+void TestXmlWriter::speedTest_data()
+{
+    QTest::addColumn<QString>("paragText");
+
+    QTest::newRow("ascii") << QString::fromLatin1("This is the text of the paragraph. It does not need any escaping at all.");
+    QTest::newRow("unicode") << QString::fromUtf8("This is the text of the paragraph. I'm including a euro sign to test encoding issues: €");
+    QTest::newRow("markup") << QString::fromLatin1("if (a < b && c > d) { return \"<tag>\"; } // escaped & more");
+}
+
 void TestXmlWriter::speedTest()
 {
-    QTime time;
-    time.start();
-    QString paragText = QString::fromUtf8("This is the text of the paragraph. I'm including a euro sign to test encoding issues: €");
+    QFETCH(QString, paragText);
     QString styleName = "Heading 1";
 
     QFile out(QString::fromLatin1("out5.xml"));
+    qint64 size = 0;
+    QElapsedTimer timer;
+    timer.start();
     if (out.open(QIODevice::WriteOnly)) {
         KoXmlWriter writer(&out);
         writer.startDocument("rootelem");
@@ -250,11 +290,14 @@ void TestXmlWriter::speedTest()
         }
         writer.endElement();
         writer.endDocument();
+        size = out.size();
     }
+    const qint64 elapsed = qMax(qint64(1), timer.elapsed());
     out.close();
     out.remove();
-    qInfo()<<"writing"<<NumParagraphs<<"XML elements using KoXmlWriter:"<<time.elapsed()<<"ms";
-    // TODO we might want to convert this into a QBenchmark test
+    qInfo()<<"writing"<<NumParagraphs<<"XML elements using KoXmlWriter:"<<elapsed<<"ms,"
+           <<size * 1000.0 / elapsed / (1024 * 1024)<<"MB/s";
+    QTest::setBenchmarkResult(size * 1000.0 / elapsed, QTest::BytesPerSecond);
 }
 
 QTEST_GUILESS_MAIN(TestXmlWriter)
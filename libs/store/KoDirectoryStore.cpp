@@ -87,6 +87,16 @@ bool KoDirectoryStore::openReadOrWrite(const QString& name, QIODevice::OpenModeF
     return true;
 }
 
+QIODevice *KoDirectoryStore::openReadDevice(const QString &name)
+{
+    QFile *file = new QFile(m_basePath + name);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return 0;
+    }
+    return file;
+}
+
 bool KoDirectoryStore::enterRelativeDirectory(const QString& dirName)
 {
     QDir origDir(m_currentPath);
@@ -37,6 +37,7 @@ protected:
     virtual bool openRead(const QString &name) {
         return openReadOrWrite(name, QIODevice::ReadOnly);
     }
+    virtual QIODevice *openReadDevice(const QString &name);
     virtual bool closeRead() {
         return true;
     }
@@ -0,0 +1,263 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "KoMappedZip.h"
+
+#include <QBuffer>
+
+#include <kcompressiondevice.h>
+#include <StoreDebug.h>
+
+namespace
+{
+
+const quint32 LocalHeaderSignature = 0x04034b50;
+const quint32 CentralHeaderSignature = 0x02014b50;
+const quint32 EndOfCentralDirectorySignature = 0x06054b50;
+
+const int LocalHeaderSize = 30;
+const int CentralHeaderSize = 46;
+const int EndOfCentralDirectorySize = 22;
+const int MaximumCommentSize = 0xffff;
+
+const quint16 EncryptedFlag = 0x0001;
+const quint16 Utf8Flag = 0x0800;
+
+const quint16 StoredMethod = 0;
+const quint16 DeflatedMethod = 8;
+
+inline quint16 readUInt16(const char *data)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    return quint16(p[0]) | quint16(p[1]) << 8;
+}
+
+inline quint32 readUInt32(const char *data)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+}
+
+QString normalizedPath(const QString &path)
+{
+    int begin = 0;
+    int end = path.length();
+    while (begin < end && path[begin] == QLatin1Char('/'))
+        ++begin;
+    while (end > begin && path[end - 1] == QLatin1Char('/'))
+        --end;
+    return (begin == 0 && end == path.length()) ? path : path.mid(begin, end - begin);
+}
+
+} // namespace
+
+KoMappedZip::KoMappedZip()
+    : m_data(0)
+    , m_size(0)
+{
+}
+
+KoMappedZip::~KoMappedZip()
+{
+}
+
+bool KoMappedZip::open(const QString &fileName)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+    m_size = m_file.size();
+    if (m_size < EndOfCentralDirectorySize)
+        return false;
+    // The mapping stays valid until the file is closed.
+    m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    if (!m_data) {
+        debugStore << "Cannot map" << fileName << m_file.errorString();
+        return false;
+    }
+    if (!parseCentralDirectory()) {
+        debugStore << fileName << "is not supported by the mapped reader";
+        m_entries.clear();
+        m_directories.clear();
+        return false;
+    }
+    return true;
+}
+
+bool KoMappedZip::parseCentralDirectory()
+{
+    // The end of central directory record is followed by the archive comment only.
+    qint64 end = -1;
+    const qint64 last = m_size - EndOfCentralDirectorySize;
+    const qint64 first = qMax<qint64>(0, last - MaximumCommentSize);
+    for (qint64 pos = last; pos >= first; --pos) {
+        if (readUInt32(m_data + pos) == EndOfCentralDirectorySignature) {
+            end = pos;
+            break;
+        }
+    }
+    if (end < 0)
+        return false;
+
+    const char *record = m_data + end;
+    const quint16 disk = readUInt16(record + 4);
+    const quint16 directoryDisk = readUInt16(record + 6);
+    const quint16 diskEntries = readUInt16(record + 8);
+    const quint16 entries = readUInt16(record + 10);
+    const quint32 directorySize = readUInt32(record + 12);
+    const quint32 directoryOffset = readUInt32(record + 16);
+    // Spanned and ZIP64 archives are left to KZip.
+    if (disk != 0 || directoryDisk != 0 || diskEntries != entries)
+        return false;
+    if (entries == 0xffff || directorySize == 0xffffffff || directoryOffset == 0xffffffff)
+        return false;
+    if (qint64(directoryOffset) + directorySize > end)
+        return false;
+
+    m_entries.reserve(entries);
+    const char *header = m_data + directoryOffset;
+    const char *const directoryEnd = header + directorySize;
+    for (int i = 0; i < entries; ++i) {
+        if (directoryEnd - header < CentralHeaderSize || readUInt32(header) != CentralHeaderSignature)
+            return false;
+        const quint16 flags = readUInt16(header + 8);
+        const quint16 method = readUInt16(header + 10);
+        const quint32 compressedSize = readUInt32(header + 20);
+        const quint32 size = readUInt32(header + 24);
+        const quint16 nameLength = readUInt16(header + 28);
+        const quint16 extraLength = readUInt16(header + 30);
+        const quint16 commentLength = readUInt16(header + 32);
+        const quint32 headerOffset = readUInt32(header + 42);
+        const qint64 recordSize = qint64(CentralHeaderSize) + nameLength + extraLength + commentLength;
+        if (directoryEnd - header < recordSize)
+            return false;
+        if (flags & EncryptedFlag)
+            return false;
+        if (method != StoredMethod && method != DeflatedMethod)
+            return false;
+        if (compressedSize == 0xffffffff || size == 0xffffffff || headerOffset == 0xffffffff)
+            return false;
+        if (qint64(headerOffset) + LocalHeaderSize + compressedSize > directoryOffset)
+            return false;
+
+        const QByteArray rawName(header + CentralHeaderSize, nameLength);
+        const QString name = (flags & Utf8Flag) ? QString::fromUtf8(rawName) : QFile::decodeName(rawName);
+        header += recordSize;
+
+        const QString path = normalizedPath(name);
+        if (path.isEmpty())
+            continue;
+        // The parents of each entry are directories, even if they are not listed.
+        for (int slash = path.indexOf(QLatin1Char('/')); slash > 0; slash = path.indexOf(QLatin1Char('/'), slash + 1))
+            m_directories.insert(path.left(slash));
+        if (name.endsWith(QLatin1Char('/'))) {
+            m_directories.insert(path);
+            continue;
+        }
+
+        Entry entry;
+        entry.headerOffset = headerOffset;
+        entry.compressedSize = compressedSize;
+        entry.size = size;
+        entry.deflated = method == DeflatedMethod;
+        m_entries.insert(path, entry);
+    }
+    return true;
+}
+
+qint64 KoMappedZip::dataOffset(const Entry &entry) const
+{
+    // The local header may have another extra field than the central one.
+    const char *header = m_data + entry.headerOffset;
+    if (readUInt32(header) != LocalHeaderSignature)
+        return -1;
+    const qint64 offset = entry.headerOffset + LocalHeaderSize + readUInt16(header + 26) + readUInt16(header + 28);
+    if (offset + entry.compressedSize > m_size)
+        return -1;
+    return offset;
+}
+
+QByteArray KoMappedZip::rawData(const QString &path, const Entry **entry) const
+{
+    const QHash<QString, Entry>::ConstIterator it = m_entries.constFind(normalizedPath(path));
+    if (it == m_entries.constEnd())
+        return QByteArray();
+    const qint64 offset = dataOffset(it.value());
+    if (offset < 0) {
+        warnStore << "Damaged local header of" << path;
+        return QByteArray();
+    }
+    *entry = &it.value();
+    return QByteArray::fromRawData(m_data + offset, it->compressedSize);
+}
+
+bool KoMappedZip::isFile(const QString &path) const
+{
+    return m_entries.contains(normalizedPath(path));
+}
+
+bool KoMappedZip::isDirectory(const QString &path) const
+{
+    const QString directory = normalizedPath(path);
+    return directory.isEmpty() || m_directories.contains(directory);
+}
+
+QStringList KoMappedZip::rootDirectories() const
+{
+    QStringList directories;
+    foreach (const QString &directory, m_directories) {
+        if (!directory.contains(QLatin1Char('/')))
+            directories.append(directory);
+    }
+    return directories;
+}
+
+QByteArray KoMappedZip::view(const QString &path) const
+{
+    const Entry *entry = 0;
+    const QByteArray data = rawData(path, &entry);
+    if (!entry || entry->deflated)
+        return QByteArray();
+    return data;
+}
+
+QIODevice *KoMappedZip::createDevice(const QString &path, qint64 *size) const
+{
+    const Entry *entry = 0;
+    const QByteArray data = rawData(path, &entry);
+    if (!entry)
+        return 0;
+
+    // The buffer shares the mapped data as long as nobody writes to it.
+    QBuffer *buffer = new QBuffer;
+    buffer->setData(data);
+    buffer->open(QIODevice::ReadOnly);
+    *size = entry->size;
+    if (!entry->deflated)
+        return buffer;
+
+    KCompressionDevice *device = new KCompressionDevice(buffer, true, KCompressionDevice::GZip);
+    device->setSkipHeaders();
+    if (!device->open(QIODevice::ReadOnly)) {
+        warnStore << "Cannot inflate" << path;
+        delete device;
+        return 0;
+    }
+    return device;
+}
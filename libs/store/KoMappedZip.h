@@ -0,0 +1,107 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KO_MAPPED_ZIP_H
+#define KO_MAPPED_ZIP_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QIODevice;
+
+/**
+ * Reads a ZIP package by mapping the file into memory.
+ *
+ * The central directory is parsed once by open(). The data of an entry is
+ * only touched when the entry is read: stored entries are returned as views
+ * into the mapping, deflated entries are inflated while they are read.
+ *
+ * Packages using ZIP64, encryption or other compression methods than
+ * deflate are rejected by open(); KoZipStore reads them with KZip then.
+ *
+ * All paths are relative to the root of the package, e.g. "Pictures/a.png".
+ */
+class KoMappedZip
+{
+public:
+    KoMappedZip();
+    ~KoMappedZip();
+
+    /**
+     * Maps @p fileName and parses its central directory.
+     * @return false, if the file cannot be mapped or is not supported
+     */
+    bool open(const QString &fileName);
+
+    /**
+     * @return true, if @p path is a file in the package
+     */
+    bool isFile(const QString &path) const;
+
+    /**
+     * @return true, if @p path is a directory in the package, explicitly
+     *         or as the parent of a file; the root is a directory
+     */
+    bool isDirectory(const QString &path) const;
+
+    /**
+     * @return the directories in the root of the package
+     */
+    QStringList rootDirectories() const;
+
+    /**
+     * @return the content of the stored file @p path without copying it, or
+     *         a null QByteArray for deflated or missing files. The data stays
+     *         valid as long as this object exists.
+     */
+    QByteArray view(const QString &path) const;
+
+    /**
+     * Creates an opened device reading the uncompressed content of @p path .
+     * @param size is set to the uncompressed size of the file
+     * @return the device owned by the caller, or 0 for missing or damaged files
+     */
+    QIODevice *createDevice(const QString &path, qint64 *size) const;
+
+private:
+    Q_DISABLE_COPY(KoMappedZip)
+
+    struct Entry {
+        qint64 headerOffset;    ///< of the local file header
+        qint64 compressedSize;
+        qint64 size;
+        bool deflated;
+    };
+
+    bool parseCentralDirectory();
+    qint64 dataOffset(const Entry &entry) const;
+    QByteArray rawData(const QString &path, const Entry **entry) const;
+
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    QHash<QString, Entry> m_entries;
+    QSet<QString> m_directories;
+};
+
+#endif
@@ -54,6 +54,19 @@ static KoStore::Backend determineBackend(QIODevice *dev)
     return DefaultFormat; // fallback
 }
 
+#ifdef QCA2
+// Whether the manifest of a package lists encrypted files. In doubt the
+// encrypted store has to be used.
+static bool hasEncryptionData(KoStore *store)
+{
+    if (!store->open(QLatin1String("META-INF/manifest.xml")))
+        return false;
+    const QByteArray manifest = store->read(store->size());
+    store->close();
+    return manifest.contains("encryption-data");
+}
+#endif
+
 KoStore* KoStore::createStore(const QString& fileName, Mode mode, const QByteArray & appIdentification, Backend backend, bool writeMimetype)
 {
     bool automatic = false;
@@ -80,7 +93,12 @@ KoStore* KoStore::createStore(const QString& fileName, Mode mode, const QByteArr
     case Zip:
 #ifdef QCA2
         if (automatic && mode == Read) {
-            // When automatically detecting, this might as well be an encrypted file. We'll need to check anyway, so we'll just use the encrypted store.
+            // When automatically detecting, this might as well be an encrypted file.
+            // Other files are read by the zip store, which maps local files into memory.
+            KoStore *store = new KoZipStore(fileName, Read, appIdentification, writeMimetype);
+            if (!store->bad() && !hasEncryptionData(store))
+                return store;
+            delete store;
             return new KoEncryptedStore(fileName, Read, appIdentification, writeMimetype);
         }
 #endif
@@ -270,6 +288,7 @@ bool KoStore::close()
 
     delete d->stream;
     d->stream = 0;
+    d->view.clear();
     d->isOpen = false;
     return ret;
 }
@@ -284,6 +303,14 @@ QIODevice* KoStore::device() const
     return d->stream;
 }
 
+QByteArray KoStore::view() const
+{
+    Q_D(const KoStore);
+    if (!d->isOpen || d->mode != Read)
+        return QByteArray();
+    return d->view;
+}
+
 QByteArray KoStore::read(qint64 max)
 {
     Q_D(KoStore);
@@ -489,6 +516,25 @@ bool KoStore::extractFile(const QString &srcName, QByteArray &data)
     return d->extractFile(srcName, buffer);
 }
 
+QIODevice *KoStore::createReadDevice(const QString &name)
+{
+    Q_D(KoStore);
+    if (d->mode != Read) {
+        errorStore << "KoStore: Can not create a read device in write mode" << endl;
+        return 0;
+    }
+    QIODevice *device = openReadDevice(d->toExternalNaming(name));
+    if (device) {
+        return device;
+    }
+    QBuffer *buffer = new QBuffer;
+    if (!d->extractFile(name, *buffer) || !buffer->open(QIODevice::ReadOnly)) {
+        delete buffer;
+        return 0;
+    }
+    return buffer;
+}
+
 bool KoStorePrivate::extractFile(const QString &srcName, QIODevice &buffer)
 {
     if (!q->open(srcName))
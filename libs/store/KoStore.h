@@ -141,6 +141,28 @@ public:
      */
     QIODevice *device() const;
 
+    /**
+     * Get the content of the currently opened file without copying it.
+     * Only stored (uncompressed) files of memory-mapped packages can be
+     * viewed, see KoZipStore. The data stays valid as long as the store
+     * exists.
+     * @return the content, or a null QByteArray if the backend cannot
+     *         provide a view; use @ref device or @ref read then.
+     */
+    QByteArray view() const;
+
+    /**
+     * Create a device reading the file @p name of the store. Unlike
+     * @ref device it does not need @ref open, so other files of the store
+     * can be opened and closed while it is read.
+     * Backends, that cannot read several files at once, read the whole file
+     * into memory for this.
+     * @param name The filename, as for @ref open
+     * @return the opened device owned by the caller, or 0 if the file cannot
+     *         be read
+     */
+    QIODevice *createReadDevice(const QString &name);
+
     /**
      * Read data from the currently opened file. You can also use the streams
      * for this.
@@ -339,6 +361,16 @@ protected:
      * @return true on success
      */
     virtual bool openRead(const QString &name) = 0;
+    /**
+     * Create a device reading the file @p name , that is independent of the
+     * file opened with open(). Used by createReadDevice().
+     * @param name "absolute path" (in the archive) to the file to read
+     * @return the opened device, or 0 if the backend does not support it
+     */
+    virtual QIODevice *openReadDevice(const QString &name) {
+        Q_UNUSED(name);
+        return 0;
+    }
 
     /**
      * @return true on success
@@ -98,6 +98,9 @@ public:
     /// The stream for the current read or write operation
     QIODevice *stream;
 
+    /// The content of the current file, if the backend provides it without copying
+    QByteArray view;
+
     bool isOpen;
     /// Must be set by the constructor.
     bool good;
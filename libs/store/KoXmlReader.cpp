@@ -69,8 +69,13 @@
 
  */
 
+#include <QGlobalStatic>
+#include <QHash>
+#include <QAtomicPointer>
+#include <QMutex>
 #include <QTextCodec>
 #include <QTextDecoder>
+#include <QVector>
 
 #ifndef KOXML_USE_QDOM
 
@@ -79,6 +84,7 @@
 #include <QXmlStreamReader>
 #include <QXmlStreamEntityResolver>
 
+#include <QAtomicInt>
 #include <QBuffer>
 #include <QByteArray>
 #include <QDataStream>
@@ -109,23 +115,20 @@
 #endif
 #endif
 
-// this is used to quickly get namespaced attribute(s)
-typedef QPair<QString, QString> KoXmlStringPair;
-
-class KoQName {
+class KoXmlQName {
 public:
     QString nsURI;
     QString name;
 
-    explicit KoQName(const QString& nsURI_, const QString& name_)
+    explicit KoXmlQName(const QString& nsURI_, const QString& name_)
         : nsURI(nsURI_), name(name_) {}
-    bool operator==(const KoQName& qname) const {
+    bool operator==(const KoXmlQName& qname) const {
         // local name is more likely to differ, so compare that first
         return name == qname.name && nsURI == qname.nsURI;
     }
 };
 
-uint qHash(const KoQName& qname)
+uint qHash(const KoXmlQName& qname)
 {
     // possibly add a faster hash function that only includes some trailing
     // part of the nsURI
@@ -135,21 +138,6 @@ uint qHash(const KoQName& qname)
     return qHash(qname.nsURI)^qHash(qname.name);
 }
 
-// this simplistic hash is rather fast-and-furious. it works because
-// likely there is very few namespaced attributes per element
-static inline uint qHash(const KoXmlStringPair &p, uint /*seed*/ = 0)
-{
-    return qHash(p.second[0].unicode()) ^ 0x1477;
-
-    // in case of doubt, use this:
-    // return qHash(p.first)^qHash(p.second);
-}
-
-static inline bool operator==(const KoXmlStringPair &a, const KoXmlStringPair &b)
-{
-    return a.second == b.second && a.first == b.first;
-}
-
 // Older versions of OpenOffice.org used different namespaces. This function
 // does translate the old namespaces into the new ones.
 static QString fixNamespace(const QString &nsURI)
@@ -308,14 +296,17 @@ public:
     QVector<KoXmlPackedItem> items;
 #endif
 
-    QList<KoQName> qnameList;
+    QList<KoXmlQName> qnameList;
+    // the atoms of qnameList, i.e. namespace URI and local name of
+    // the nodes, or namespace URI only without namespace processing
+    QVector<KoQName> qnameAtoms;
     QString docType;
 
 private:
-    QHash<KoQName, unsigned> qnameHash;
+    QHash<KoXmlQName, unsigned> qnameHash;
 
     unsigned cacheQName(const QString& name, const QString& nsURI) {
-        KoQName qname(nsURI, name);
+        KoXmlQName qname(nsURI, name);
 
         const unsigned ii = qnameHash.value(qname, (unsigned)-1);
         if (ii != (unsigned)-1)
@@ -326,6 +317,11 @@ private:
         qnameList.append(qname);
         qnameHash.insert(qname, i);
 
+        QString localName;
+        if (processNamespace)
+            localName = name.mid(name.indexOf(':') + 1);
+        qnameAtoms.append(KoQName(nsURI, localName));
+
         return i;
     }
 
@@ -402,6 +398,7 @@ public:
         currentDepth = 0;
         qnameHash.clear();
         qnameList.clear();
+        qnameAtoms.clear();
         valueHash.clear();
         valueList.clear();
         groups.clear();
@@ -562,6 +559,7 @@ public:
     void clear() {
         qnameHash.clear();
         qnameList.clear();
+        qnameAtoms.clear();
         valueHash.clear();
         valueList.clear();
         items.clear();
@@ -640,6 +638,39 @@ namespace {
         return error;
     }
 
+    void parseStartElement(QXmlStreamReader &xml, KoXmlPackedDocument &doc);
+
+    // parse the element at the current position as if it were the document
+    // element of a standalone xml document
+    ParseError parseDocumentElement(QXmlStreamReader &xml, KoXmlPackedDocument &doc,
+                                    bool withChildren, bool stripSpaces = true)
+    {
+        doc.clear();
+        ParseError error;
+        if (xml.tokenType() != QXmlStreamReader::StartElement) {
+            error.error = true;
+            error.errorMsg = QLatin1String("The reader is not at a start element");
+            error.errorColumn = xml.columnNumber();
+            error.errorLine = xml.lineNumber();
+            return error;
+        }
+        if (withChildren) {
+            parseElement(xml, doc, stripSpaces);
+        } else {
+            parseStartElement(xml, doc);
+            doc.closeElement();
+        }
+        if (xml.hasError()) {
+            error.error = true;
+            error.errorMsg = xml.errorString();
+            error.errorColumn = xml.columnNumber();
+            error.errorLine = xml.lineNumber();
+        } else {
+            doc.finish();
+        }
+        return error;
+    }
+
     void parseElementContents(QXmlStreamReader &xml, KoXmlPackedDocument &doc)
     {
         xml.readNext();
@@ -717,7 +748,7 @@ namespace {
         }
     }
 
-    void parseElement(QXmlStreamReader &xml, KoXmlPackedDocument &doc, bool stripSpaces)
+    void parseStartElement(QXmlStreamReader &xml, KoXmlPackedDocument &doc)
     {
         // Unfortunately MSVC fails using QXmlStreamReader::const_iterator
         // so we apply a for loop instead. https://bugreports.qt.io/browse/QTBUG-45368
@@ -729,6 +760,11 @@ namespace {
                              attr[a].namespaceUri().toString(),
                              attr[a].value().toString());
         }
+    }
+
+    void parseElement(QXmlStreamReader &xml, KoXmlPackedDocument &doc, bool stripSpaces)
+    {
+        parseStartElement(xml, doc);
         if (stripSpaces)
           parseElementContentsStripSpaces(xml, doc);
         else
@@ -764,12 +800,14 @@ public:
     QString namespaceURI;
     QString prefix;
     QString localName;
+    // namespaceURI and localName of an element
+    KoQName qname;
 
     void ref() {
-        ++refCount;
+        refCount.ref();
     }
     void unref() {
-        if (!--refCount) {
+        if (!refCount.deref()) {
             delete this;
         }
     }
@@ -783,6 +821,10 @@ public:
     KoXmlNodeData* next;
     KoXmlNodeData* first;
     KoXmlNodeData* last;
+    // the first child element of each name, only for many children
+    QHash<KoQName, KoXmlNodeData*>* childIndex;
+
+    KoXmlNodeData* namedItemNS(const KoQName& name);
 
     QString text();
 
@@ -793,9 +835,11 @@ public:
     inline void setAttribute(const QString& name, const QString& value);
     inline QString attribute(const QString& name, const QString& def) const;
     inline bool hasAttribute(const QString& name) const;
-    inline void setAttributeNS(const QString& nsURI, const QString& name, const QString& value);
+    inline void setAttributeNS(const KoQName& name, const QString& value);
     inline QString attributeNS(const QString& nsURI, const QString& name, const QString& def) const;
+    inline QString attributeNS(const KoQName& name, const QString& def) const;
     inline bool hasAttributeNS(const QString& nsURI, const QString& name) const;
+    inline bool hasAttributeNS(const KoQName& name) const;
     inline void clearAttributes();
     inline QStringList attributeNames() const;
     inline QList< QPair<QString, QString> > attributeFullNames() const;
@@ -811,6 +855,7 @@ public:
     // used when doing on-demand (re)parse
     void loadChildren(int depth = 1);
     void unloadChildren();
+    void buildChildIndex();
 
     void dump();
 
@@ -821,10 +866,10 @@ public:
 
 private:
     QHash<QString, QString> attr;
-    QHash<KoXmlStringPair, QString> attrNS;
+    QHash<KoQName, QString> attrNS;
     QString textData;
-    // reference counting
-    unsigned long refCount;
+    // reference counting, atomic as loaded nodes may be read from several threads
+    QAtomicInt refCount;
     friend class KoXmlElement;
 };
 
@@ -837,7 +882,7 @@ KoXmlNodeData::KoXmlNodeData(unsigned long initialRefCount)
 #ifdef KOXML_COMPACT
     , nodeDepth(0)
 #endif
-    , parent(0), prev(0), next(0), first(0), last(0)
+    , parent(0), prev(0), next(0), first(0), last(0), childIndex(0)
     , packedDoc(0), nodeIndex(0)
     , refCount(initialRefCount)
 {
@@ -866,6 +911,7 @@ void KoXmlNodeData::clear()
     tagName.clear();
     prefix.clear();
     namespaceURI.clear();
+    qname = KoQName();
     textData.clear();
     packedDoc = 0;
 
@@ -875,6 +921,8 @@ void KoXmlNodeData::clear()
     parent = 0;
     prev = next = 0;
     first = last = 0;
+    delete childIndex;
+    childIndex = 0;
 
     loaded = false;
 }
@@ -940,28 +988,35 @@ bool KoXmlNodeData::hasAttribute(const QString& name) const
     return attr.contains(name);
 }
 
-void KoXmlNodeData::setAttributeNS(const QString& nsURI,
-                                   const QString& name, const QString& value)
+void KoXmlNodeData::setAttributeNS(const KoQName& name, const QString& value)
 {
-    int i = name.indexOf(':');
-    if (i != -1) {
-        QString localName(name.mid(i + 1));
-        KoXmlStringPair key(nsURI, localName);
-        attrNS.insert(key, value);
-    }
+    attrNS.insert(name, value);
 }
 
 QString KoXmlNodeData::attributeNS(const QString& nsURI, const QString& name,
                                    const QString& def) const
 {
-    KoXmlStringPair key(nsURI, name);
-    return attrNS.value(key, def);
+    // every parsed name is interned, so an unknown name is no attribute
+    if (attrNS.isEmpty())
+        return def;
+    return attrNS.value(KoQName::find(nsURI, name), def);
+}
+
+QString KoXmlNodeData::attributeNS(const KoQName& name, const QString& def) const
+{
+    return attrNS.value(name, def);
 }
 
 bool KoXmlNodeData::hasAttributeNS(const QString& nsURI, const QString& name) const
 {
-    KoXmlStringPair key(nsURI, name);
-    return attrNS.contains(key);
+    if (attrNS.isEmpty())
+        return false;
+    return attrNS.contains(KoQName::find(nsURI, name));
+}
+
+bool KoXmlNodeData::hasAttributeNS(const KoQName& name) const
+{
+    return attrNS.contains(name);
 }
 
 void KoXmlNodeData::clearAttributes()
@@ -983,7 +1038,9 @@ QStringList KoXmlNodeData::attributeNames() const
 QList< QPair<QString, QString> > KoXmlNodeData::attributeFullNames() const
 {
     QList< QPair<QString, QString> > result;
-    result = attrNS.keys();
+    QHash<KoQName, QString>::ConstIterator end = attrNS.constEnd();
+    for (QHash<KoQName, QString>::ConstIterator it = attrNS.constBegin(); it != end; ++it)
+        result.append(qMakePair(it.key().namespaceURI(), it.key().localName()));
 
     return result;
 }
@@ -993,6 +1050,43 @@ QString KoXmlNodeData::data() const
     return textData;
 }
 
+// the number of child elements from which on they are indexed by name
+static const int ChildIndexThreshold = 16;
+
+void KoXmlNodeData::buildChildIndex()
+{
+    int count = 0;
+    for (KoXmlNodeData* node = first; node && count < ChildIndexThreshold; node = node->next) {
+        if (node->nodeType == KoXmlNode::ElementNode)
+            ++count;
+    }
+    if (count < ChildIndexThreshold)
+        return;
+
+    childIndex = new QHash<KoQName, KoXmlNodeData*>;
+    // backwards, so the first child of each name wins
+    for (KoXmlNodeData* node = last; node; node = node->prev) {
+        if (node->nodeType == KoXmlNode::ElementNode)
+            childIndex->insert(node->qname, node);
+    }
+}
+
+KoXmlNodeData* KoXmlNodeData::namedItemNS(const KoQName& name)
+{
+    if (!loaded)
+        loadChildren();
+
+    if (name.isNull())
+        return 0;
+    if (childIndex)
+        return childIndex->value(name);
+    for (KoXmlNodeData* node = first; node; node = node->next) {
+        if (node->nodeType == KoXmlNode::ElementNode && node->qname == name)
+            return node;
+    }
+    return 0;
+}
+
 #ifdef KOXML_COMPACT
 
 void KoXmlNodeData::loadChildren(int depth)
@@ -1026,7 +1120,7 @@ void KoXmlNodeData::loadChildren(int depth)
 
         // attribute belongs to this node
         if (item.attr) {
-            KoQName qname = packedDoc->qnameList[item.qnameIndex];
+            KoXmlQName qname = packedDoc->qnameList[item.qnameIndex];
             QString value = item.value;
 
             QString prefix;
@@ -1040,12 +1134,13 @@ void KoXmlNodeData::loadChildren(int depth)
             if (i != -1) localName = qName.mid(i + 1);
 
             if (packedDoc->processNamespace) {
-                setAttributeNS(qname.nsURI, qName, value);
+                if (i != -1)
+                    setAttributeNS(packedDoc->qnameAtoms[item.qnameIndex], value);
                 setAttribute(localName, value);
             } else
                 setAttribute(qName, value);
         } else {
-            KoQName qname = packedDoc->qnameList[item.qnameIndex];
+            KoXmlQName qname = packedDoc->qnameList[item.qnameIndex];
             QString value = item.value;
 
             QString nodeName = qname.name;
@@ -1072,6 +1167,8 @@ void KoXmlNodeData::loadChildren(int depth)
             dat->localName = localName;
             dat->prefix = prefix;
             dat->namespaceURI = qname.nsURI;
+            if (item.type == KoXmlNode::ElementNode)
+                dat->qname = packedDoc->qnameAtoms[item.qnameIndex];
             dat->parent = this;
             dat->prev = lastDat;
             dat->next = 0;
@@ -1093,6 +1190,7 @@ void KoXmlNodeData::loadChildren(int depth)
         }
     }
 
+    buildChildIndex();
     loaded = true;
 }
 
@@ -1124,7 +1222,7 @@ void KoXmlNodeData::loadChildren(int depth)
 
         // attribute belongs to this node
         if (item.attr && (item.depth == (unsigned)nodeDepth)) {
-            KoQName qname = packedDoc->qnameList[item.qnameIndex];
+            KoXmlQName qname = packedDoc->qnameList[item.qnameIndex];
             QString value = item.value;
 
             QString prefix;
@@ -1138,7 +1236,8 @@ void KoXmlNodeData::loadChildren(int depth)
             if (i != -1) localName = qName.mid(i + 1);
 
             if (packedDoc->processNamespace) {
-                setAttributeNS(qname.nsURI, qName, value);
+                if (i != -1)
+                    setAttributeNS(packedDoc->qnameAtoms[item.qnameIndex], value);
                 setAttribute(localName, value);
             } else
                 setAttribute(qname.name, value);
@@ -1152,7 +1251,7 @@ void KoXmlNodeData::loadChildren(int depth)
             ok = (item.depth == (unsigned)nodeDepth + 1);
 
             if (ok) {
-                KoQName qname = packedDoc->qnameList[item.qnameIndex];
+                KoXmlQName qname = packedDoc->qnameList[item.qnameIndex];
                 QString value = item.value;
 
                 QString nodeName = qname.name;
@@ -1178,6 +1277,8 @@ void KoXmlNodeData::loadChildren(int depth)
                 dat->localName = localName;
                 dat->prefix = prefix;
                 dat->namespaceURI = qname.nsURI;
+                if (item.type == KoXmlNode::ElementNode)
+                    dat->qname = packedDoc->qnameAtoms[item.qnameIndex];
                 dat->count = 1;
                 dat->parent = this;
                 dat->prev = lastDat;
@@ -1201,6 +1302,7 @@ void KoXmlNodeData::loadChildren(int depth)
         }
     }
 
+    buildChildIndex();
     loaded = true;
 }
 #endif
@@ -1223,6 +1325,8 @@ void KoXmlNodeData::unloadChildren()
     clearAttributes();
     loaded = false;
     first = last = 0;
+    delete childIndex;
+    childIndex = 0;
 }
 
 #ifdef KOXML_COMPACT
@@ -1253,7 +1357,7 @@ static void itemAsQDomNode(QDomDocument& ownerDoc, KoXmlPackedDocument* packedDo
     if (self.type == KoXmlNode::ElementNode) {
         QDomElement element;
 
-        KoQName qname = packedDoc->qnameList[self.qnameIndex];
+        KoXmlQName qname = packedDoc->qnameList[self.qnameIndex];
         qname.nsURI = fixNamespace(qname.nsURI);
 
         if (packedDoc->processNamespace)
@@ -1274,7 +1378,7 @@ static void itemAsQDomNode(QDomDocument& ownerDoc, KoXmlPackedDocument* packedDo
 
             // attribute belongs to this node
             if (item.attr) {
-                KoQName qname = packedDoc->qnameList[item.qnameIndex];
+                KoXmlQName qname = packedDoc->qnameList[item.qnameIndex];
                 qname.nsURI = fixNamespace(qname.nsURI );
                 QString value = item.value;
 
@@ -1341,7 +1445,7 @@ static void itemAsQDomNode(QDomDocument& ownerDoc, KoXmlPackedDocument* packedDo
     if (item.type == KoXmlNode::ElementNode) {
         QDomElement element;
 
-        KoQName qname = packedDoc->qnameList[item.qnameIndex];
+        KoXmlQName qname = packedDoc->qnameList[item.qnameIndex];
         qname.nsURI = fixNamespace(qname.nsURI);
 
         if (packedDoc->processNamespace)
@@ -1368,7 +1472,7 @@ static void itemAsQDomNode(QDomDocument& ownerDoc, KoXmlPackedDocument* packedDo
 
             // attribute belongs to this node
             if (item.attr && (item.depth == (unsigned)nodeDepth)) {
-                KoQName qname = packedDoc->qnameList[item.qnameIndex];
+                KoXmlQName qname = packedDoc->qnameList[item.qnameIndex];
                 qname.nsURI = fixNamespace(qname.nsURI);
                 QString value = item.value;
                 QString prefix;
@@ -1439,7 +1543,7 @@ void KoXmlNodeData::dump()
     printf("  first : %p\n", (void*)first);
     printf("  last : %p\n", (void*)last);
 
-    printf("  refCount: %ld\n", refCount);
+    printf("  refCount: %d\n", refCount.load());
 
     if (loaded)
         printf("  loaded: TRUE\n");
@@ -1463,6 +1567,8 @@ public:
 
     bool setContent(QXmlStreamReader *reader,
                     QString* errorMsg = 0, int* errorLine = 0, int* errorColumn = 0);
+    bool setElement(QXmlStreamReader *reader, bool withChildren,
+                    QString* errorMsg = 0, int* errorLine = 0, int* errorColumn = 0);
 
     KoXmlDocumentType dt;
 
@@ -1520,6 +1626,41 @@ bool KoXmlDocumentData::setContent(QXmlStreamReader* reader, QString* errorMsg,
     return true;
 }
 
+bool KoXmlDocumentData::setElement(QXmlStreamReader* reader, bool withChildren,
+                                   QString* errorMsg, int* errorLine, int* errorColumn)
+{
+    // sanity checks
+    if (!reader) return false;
+
+    if (nodeType != KoXmlNode::DocumentNode)
+        return false;
+
+    clear();
+    nodeType = KoXmlNode::DocumentNode;
+
+    packedDoc = new KoXmlPackedDocument;
+    packedDoc->processNamespace = reader->namespaceProcessing();
+
+    ParseError error = parseDocumentElement(*reader, *packedDoc, withChildren, stripSpaces);
+    if (error.error) {
+        // parsing error has occurred
+        if (errorMsg) *errorMsg = error.errorMsg;
+        if (errorLine) *errorLine = error.errorLine;
+        if (errorColumn)  *errorColumn = error.errorColumn;
+        return false;
+    }
+
+    // initially load
+    loadChildren();
+
+    KoXmlNodeData *typeData = new KoXmlNodeData(0);
+    typeData->nodeType = KoXmlNode::DocumentTypeNode;
+    typeData->parent = this;
+    dt = KoXmlDocumentType(typeData);
+
+    return true;
+}
+
 // ==================================================================
 //
 //         KoXmlNode
@@ -1751,20 +1892,9 @@ KoXmlNode KoXmlNode::namedItem(const QString& name) const
 
 KoXmlNode KoXmlNode::namedItemNS(const QString& nsURI, const QString& name) const
 {
-    if (!d->loaded)
-        d->loadChildren();
-
-    for (KoXmlNodeData* node = d->first; node; node = node->next) {
-        if (node->nodeType == KoXmlNode::ElementNode
-                 && node->localName == name
-                 && node->namespaceURI == nsURI
-                 ) {
-            return KoXmlNode(node);
-        }
-    }
-
-    // not found
-    return KoXmlNode();
+    // every parsed name is interned, so an unknown name is no child
+    KoXmlNodeData* node = d->namedItemNS(KoQName::find(nsURI, name));
+    return node ? KoXmlNode(node) : KoXmlNode();
 }
 
 KoXmlNode KoXmlNode::namedItemNS(const QString& nsURI, const QString& name, KoXmlNamedItemType type) const
@@ -1772,10 +1902,11 @@ KoXmlNode KoXmlNode::namedItemNS(const QString& nsURI, const QString& name, KoXm
     if (!d->loaded)
         d->loadChildren();
 
+    const KoQName qname = KoQName::find(nsURI, name);
     for (KoXmlNodeData* node = d->first; node; node = node->next) {
         if (node->nodeType != KoXmlNode::ElementNode)
             continue;
-        if (node->localName == name && node->namespaceURI == nsURI) {
+        if (!qname.isNull() && node->qname == qname) {
             return KoXmlNode(node);
         }
         bool isPrelude = false;
@@ -1927,10 +2058,7 @@ QString KoXmlElement::attributeNS(const QString& namespaceURI,
     if (!d->loaded)
         d->loadChildren();
 
-    KoXmlStringPair key(namespaceURI, localName);
-    return d->attrNS.value(key, defaultValue);
-
-//  return d->attributeNS( namespaceURI, localName, defaultValue );
+    return d->attributeNS(namespaceURI, localName, defaultValue);
 }
 
 bool KoXmlElement::hasAttribute(const QString& name) const
@@ -2236,6 +2364,174 @@ void  KoXmlDocument::setWhitespaceStripping(bool stripSpaces)
 
 #endif
 
+// ==================================================================
+//
+//         KoQName
+//
+// ==================================================================
+
+namespace {
+
+struct KoQNameKey {
+    QString namespaceURI;
+    QString localName;
+};
+
+inline bool operator==(const KoQNameKey& a, const KoQNameKey& b)
+{
+    // local name is more likely to differ, so compare that first
+    return a.localName == b.localName && a.namespaceURI == b.namespaceURI;
+}
+
+inline uint qHash(const KoQNameKey& key, uint seed = 0)
+{
+    // the namespaces are few, their length tells them apart well enough
+    return qHash(key.localName, seed) ^ uint(key.namespaceURI.length());
+}
+
+// The names are stored in chunks, which never move: chunk k holds the ids
+// from s_firstChunkSize * (2^k - 1) on, 2^k times as many as the first one.
+static const uint s_firstChunkSize = 256;
+static const int s_chunkCount = 24;
+
+// @return the chunk of @p id, sets @p offset to its index in the chunk
+static inline int chunkOf(uint id, uint* offset)
+{
+    const uint v = id / s_firstChunkSize + 1;
+    int k = 0;
+    while (v >> (k + 1))
+        ++k;
+    *offset = id - s_firstChunkSize * ((1u << k) - 1);
+    return k;
+}
+
+// An open addressing hash table of ids. A slot is 0 until an id is stored.
+struct KoQNameIds {
+    explicit KoQNameIds(uint capacity) : mask(capacity - 1), slots(new QAtomicInt[capacity]) {}
+    ~KoQNameIds() {
+        delete[] slots;
+    }
+
+    const uint mask;
+    QAtomicInt* const slots;
+};
+
+/*
+ * The table of all names. Interning takes a mutex, but finding a name and
+ * the name of an atom need no lock: names and ids are only ever appended
+ * and published with release stores after they are complete. A grown hash
+ * table replaces the old one, which is kept until the end, as readers may
+ * still be using it.
+ */
+class KoQNameTable
+{
+public:
+    KoQNameTable() : count(0), ids(new KoQNameIds(2 * s_firstChunkSize)) {
+        // index 0 is the null atom
+        append(KoQNameKey());
+    }
+
+    ~KoQNameTable() {
+        for (int i = 0; i < s_chunkCount; ++i)
+            delete[] chunks[i].load();
+        delete ids.load();
+        qDeleteAll(retiredIds);
+    }
+
+    // the name of an id published before
+    const KoQNameKey& name(uint id) const {
+        uint offset;
+        const int k = chunkOf(id, &offset);
+        return chunks[k].loadAcquire()[offset];
+    }
+
+    uint find(const KoQNameKey& key) const {
+        const KoQNameIds* table = ids.loadAcquire();
+        for (uint i = qHash(key) & table->mask; ; i = (i + 1) & table->mask) {
+            const uint id = uint(table->slots[i].loadAcquire());
+            if (!id || name(id) == key)
+                return id;
+        }
+    }
+
+    uint insert(const KoQNameKey& key) {
+        QMutexLocker locker(&mutex);
+        uint id = find(key);
+        if (!id) {
+            id = append(key);
+            KoQNameIds* table = ids.load();
+            if (2 * count > table->mask + 1) {
+                // grow before the table gets crowded
+                KoQNameIds* grown = new KoQNameIds(2 * (table->mask + 1));
+                for (uint i = 1; i < id; ++i)
+                    insertId(grown, i);
+                retiredIds.append(table);
+                table = grown;
+                ids.storeRelease(table);
+            }
+            insertId(table, id);
+        }
+        return id;
+    }
+
+private:
+    uint append(const KoQNameKey& key) {
+        const uint id = count++;
+        uint offset;
+        const int k = chunkOf(id, &offset);
+        Q_ASSERT(k < s_chunkCount);
+        KoQNameKey* chunk = chunks[k].load();
+        if (!chunk) {
+            chunk = new KoQNameKey[s_firstChunkSize << k];
+            chunks[k].storeRelease(chunk);
+        }
+        chunk[offset] = key;
+        return id;
+    }
+
+    void insertId(KoQNameIds* table, uint id) {
+        uint i = qHash(name(id)) & table->mask;
+        while (table->slots[i].load())
+            i = (i + 1) & table->mask;
+        table->slots[i].storeRelease(int(id));
+    }
+
+    QMutex mutex;
+    uint count; // guarded by mutex
+    QAtomicPointer<KoQNameKey> chunks[s_chunkCount];
+    QAtomicPointer<KoQNameIds> ids;
+    QList<KoQNameIds*> retiredIds; // guarded by mutex
+};
+
+} // namespace
+
+Q_GLOBAL_STATIC(KoQNameTable, s_qnameTable)
+
+KoQName::KoQName(const QString& namespaceURI, const QString& localName)
+{
+    KoQNameTable* table = s_qnameTable();
+    const KoQNameKey key = { namespaceURI, localName };
+    m_id = table->find(key);
+    if (!m_id)
+        m_id = table->insert(key);
+}
+
+KoQName KoQName::find(const QString& namespaceURI, const QString& localName)
+{
+    const KoQNameKey key = { namespaceURI, localName };
+    return KoQName(s_qnameTable()->find(key));
+}
+
+QString KoQName::namespaceURI() const
+{
+    return s_qnameTable()->name(m_id).namespaceURI;
+}
+
+QString KoQName::localName() const
+{
+    return s_qnameTable()->name(m_id).localName;
+}
+
 // ==================================================================
 //
 //         functions in KoXml namespace
@@ -2259,6 +2555,49 @@ KoXmlElement KoXml::namedItemNS(const KoXmlNode& node, const QString& nsURI,
 #endif
 }
 
+KoXmlElement KoXml::namedItemNS(const KoXmlNode& node, const KoQName& name)
+{
+#ifdef KOXML_USE_QDOM
+    return namedItemNS(node, name.namespaceURI(), name.localName());
+#else
+    KoXmlNodeData* data = node.d->namedItemNS(name);
+    return data ? KoXmlNode(data).toElement() : KoXmlElement();
+#endif
+}
+
+QString KoXml::attributeNS(const KoXmlElement& element, const KoQName& name,
+                           const QString& defaultValue)
+{
+#ifdef KOXML_USE_QDOM
+    return element.attributeNS(name.namespaceURI(), name.localName(), defaultValue);
+#else
+    if (!element.isElement())
+        return defaultValue;
+
+    KoXmlNodeData* data = element.d;
+    if (!data->loaded)
+        data->loadChildren();
+
+    return data->attributeNS(name, defaultValue);
+#endif
+}
+
+bool KoXml::hasAttributeNS(const KoXmlElement& element, const KoQName& name)
+{
+#ifdef KOXML_USE_QDOM
+    return element.hasAttributeNS(name.namespaceURI(), name.localName());
+#else
+    if (!element.isElement())
+        return false;
+
+    KoXmlNodeData* data = element.d;
+    if (!data->loaded)
+        data->loadChildren();
+
+    return data->hasAttributeNS(name);
+#endif
+}
+
 KoXmlElement KoXml::namedItemNS(const KoXmlNode& node, const QString& nsURI,
                                 const QString& localName, KoXmlNamedItemType type)
 {
@@ -2350,6 +2689,69 @@ QDomDocument KoXml::asQDomDocument(const KoXmlDocument& document)
 #endif
 }
 
+#ifdef KOXML_USE_QDOM
+// Builds the element at the current position of reader and its children
+// with doc, like QDomDocument::setContent() with namespace processing.
+static QDomElement qdomElement(QDomDocument& doc, QXmlStreamReader* reader, bool withChildren)
+{
+    QDomElement element = doc.createElementNS(reader->namespaceUri().toString(),
+                                              reader->qualifiedName().toString());
+    const QXmlStreamAttributes attributes = reader->attributes();
+    for (int i = 0; i < attributes.count(); ++i) {
+        element.setAttributeNS(attributes[i].namespaceUri().toString(),
+                               attributes[i].qualifiedName().toString(),
+                               attributes[i].value().toString());
+    }
+    if (!withChildren)
+        return element;
+    while (!reader->atEnd()) {
+        switch (reader->readNext()) {
+        case QXmlStreamReader::StartElement:
+            element.appendChild(qdomElement(doc, reader, true));
+            break;
+        case QXmlStreamReader::EndElement:
+            return element;
+        case QXmlStreamReader::Characters:
+            if (reader->isCDATA())
+                element.appendChild(doc.createCDATASection(reader->text().toString()));
+            else if (!reader->isWhitespace())
+                element.appendChild(doc.createTextNode(reader->text().toString()));
+            break;
+        default:
+            break;
+        }
+    }
+    return element;
+}
+#endif
+
+bool KoXml::setElement(KoXmlDocument& doc, QXmlStreamReader* reader, bool withChildren,
+                       QString* errorMsg, int* errorLine, int* errorColumn)
+{
+#ifdef KOXML_USE_QDOM
+    doc.clear();
+    if (reader->tokenType() == QXmlStreamReader::StartElement)
+        doc.appendChild(qdomElement(doc, reader, withChildren));
+    if (reader->hasError() || doc.documentElement().isNull()) {
+        if (errorMsg) *errorMsg = reader->errorString();
+        if (errorLine) *errorLine = reader->lineNumber();
+        if (errorColumn) *errorColumn = reader->columnNumber();
+        return false;
+    }
+    return true;
+#else
+    if (doc.d->nodeType != KoXmlNode::DocumentNode) {
+        const bool stripSpaces = KOXMLDOCDATA(doc.d)->stripSpaces;
+        doc.d->unref();
+        KoXmlDocumentData *dat = new KoXmlDocumentData;
+        dat->nodeType = KoXmlNode::DocumentNode;
+        dat->stripSpaces = stripSpaces;
+        doc.d = dat;
+    }
+    return KOXMLDOCDATA(doc.d)->setElement(reader, withChildren, errorMsg, errorLine, errorColumn);
+#endif
+}
+
 bool KoXml::setDocument(KoXmlDocument& doc, QIODevice* device,
                         bool namespaceProcessing, QString* errorMsg, int* errorLine,
                         int* errorColumn)
@@ -31,6 +31,72 @@
 
 class QIODevice;
 
+/**
+ * KoQName is an interned pair of namespace URI and local name.
+ *
+ * The names are kept in a table for the lifetime of the application, so
+ * an atom is a single integer: copying, comparing and hashing it is O(1).
+ * KoXmlDocument interns each element and attribute name while parsing, and
+ * the elements look up their namespaced attributes and, if they have many
+ * children, their child elements by atom.
+ *
+ * Create the atoms of names used in loops only once, e.g.
+ * @code
+ * const KoQName fontSize(KoXmlNS::fo, QStringLiteral("font-size"));
+ * foreach (const KoXmlElement& properties, list)
+ *     sizes.append(KoXml::attributeNS(properties, fontSize));
+ * @endcode
+ *
+ * The table is thread-safe. Only interning a new name takes a lock, finding
+ * a name and the names of an atom do not.
+ */
+class KOSTORE_EXPORT KoQName
+{
+public:
+    /**
+     * Creates the null atom, which no element or attribute has.
+     */
+    KoQName() : m_id(0) {}
+
+    /**
+     * Interns the name, if needed.
+     */
+    KoQName(const QString& namespaceURI, const QString& localName);
+
+    /**
+     * @return the atom of the name, or the null atom if it was not interned
+     */
+    static KoQName find(const QString& namespaceURI, const QString& localName);
+
+    bool isNull() const {
+        return m_id == 0;
+    }
+    QString namespaceURI() const;
+    QString localName() const;
+
+    uint id() const {
+        return m_id;
+    }
+    bool operator==(const KoQName& other) const {
+        return m_id == other.m_id;
+    }
+    bool operator!=(const KoQName& other) const {
+        return m_id != other.m_id;
+    }
+
+private:
+    explicit KoQName(uint id) : m_id(id) {}
+
+    uint m_id;
+};
+
+Q_DECLARE_TYPEINFO(KoQName, Q_PRIMITIVE_TYPE);
+
+inline uint qHash(const KoQName& name, uint seed = 0)
+{
+    return name.id() ^ seed;
+}
+
 #ifdef KOXML_USE_QDOM
 
 typedef QDomNode KoXmlNode;
@@ -53,6 +119,17 @@ class KoXmlDocument;
 class KoXmlNodeData;
 class KoXmlDocumentData;
 
+// see below, declared here to be friends of KoXmlNode
+namespace KoXml
+{
+KOSTORE_EXPORT KoXmlElement namedItemNS(const KoXmlNode& node, const KoQName& name);
+KOSTORE_EXPORT QString attributeNS(const KoXmlElement& element, const KoQName& name,
+                                   const QString& defaultValue);
+KOSTORE_EXPORT bool hasAttributeNS(const KoXmlElement& element, const KoQName& name);
+KOSTORE_EXPORT bool setElement(KoXmlDocument& doc, QXmlStreamReader* reader, bool withChildren,
+                               QString* errorMsg, int* errorLine, int* errorColumn);
+}
+
 /**
  * The office-text-content-prelude type.
  */
@@ -161,6 +238,12 @@ public:
 protected:
     KoXmlNodeData* d;
     explicit KoXmlNode(KoXmlNodeData*);
+
+private:
+    friend KoXmlElement KoXml::namedItemNS(const KoXmlNode&, const KoQName&);
+    friend QString KoXml::attributeNS(const KoXmlElement&, const KoQName&, const QString&);
+    friend bool KoXml::hasAttributeNS(const KoXmlElement&, const KoQName&);
+    friend bool KoXml::setElement(KoXmlDocument&, QXmlStreamReader*, bool, QString*, int*, int*);
 };
 
 /**
@@ -322,6 +405,8 @@ private:
 
 #endif // KOXML_USE_QDOM
 
+class QXmlStreamReader;
+
 /**
  * This namespace contains a few convenience functions to simplify code using QDom
  * (when loading OASIS documents, in particular).
@@ -378,6 +463,28 @@ KOSTORE_EXPORT KoXmlElement namedItemNS(const KoXmlNode& node,
                                       const QString& nsURI, const QString& localName,
                                       KoXmlNamedItemType type);
 
+/**
+ * Like namedItemNS above, but with an interned name. This is the fastest
+ * way to find a child element, use it in loops.
+ */
+KOSTORE_EXPORT KoXmlElement namedItemNS(const KoXmlNode& node, const KoQName& name);
+
+/**
+ * @return the value of the attribute @p name of @p element ,
+ *         or @p defaultValue if it does not exist
+ *
+ * Like QDomElement::attributeNS(), but with an interned name.
+ */
+KOSTORE_EXPORT QString attributeNS(const KoXmlElement& element, const KoQName& name,
+                                   const QString& defaultValue = QString());
+
+/**
+ * @return true, if @p element has the attribute @p name
+ *
+ * Like QDomElement::hasAttributeNS(), but with an interned name.
+ */
+KOSTORE_EXPORT bool hasAttributeNS(const KoXmlElement& element, const KoQName& name);
+
 /**
  * Explicitly load child nodes of specified node, up to given depth.
  * This function has no effect if QDom is used.
@@ -441,6 +548,21 @@ KOSTORE_EXPORT QDomDocument asQDomDocument(const KoXmlDocument& document);
 KOSTORE_EXPORT bool setDocument(KoXmlDocument& doc, QIODevice* device,
                                 bool namespaceProcessing, QString* errorMsg = 0,
                                 int* errorLine = 0, int* errorColumn = 0);
+
+/*
+ * Load the element at the current position of @p reader, which has to be a
+ * start element, as the document element of @p doc. This builds a part of
+ * a large document without the rest of it, e.g. while the rest is streamed.
+ * The namespaces of the element and its children are resolved by the
+ * reader, so the declarations of the enclosing elements are kept.
+ *
+ * If @p withChildren is true, the children are loaded, too, and the reader
+ * is left at the end of the element. Otherwise only the element with its
+ * attributes is loaded and the reader stays at the start of the element.
+ */
+KOSTORE_EXPORT bool setElement(KoXmlDocument& doc, QXmlStreamReader* reader,
+                               bool withChildren = true, QString* errorMsg = 0,
+                               int* errorLine = 0, int* errorColumn = 0);
 }
 
 /**
@@ -22,29 +22,38 @@
 
 #include <StoreDebug.h>
 #include <QByteArray>
+#include <QPointer>
 #include <QStack>
 #include <float.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 static const int s_indentBufferLength = 100;
-static const int s_escapeBufferLen = 10000;
+static const int s_outputBufferLength = 16 * 1024;
+// Escaping a character takes up to 6 bytes (&quot;), so the text is escaped
+// in chunks fitting into the output buffer.
+static const int s_escapeChunkLength = s_outputBufferLength / 8;
 
 class Q_DECL_HIDDEN KoXmlWriter::Private
 {
 public:
-    Private(QIODevice* dev_, int indentLevel = 0) : dev(dev_), baseIndentLevel(indentLevel) {}
+    Private(QIODevice* dev_, int indentLevel = 0) : dev(dev_), baseIndentLevel(indentLevel), used(0) {}
     ~Private() {
         delete[] indentBuffer;
-        delete[] escapeBuffer;
+        delete[] outputBuffer;
         //TODO: look at if we must delete "dev". For me we must delete it otherwise we will leak it
     }
 
-    QIODevice* dev;
+    QPointer<QIODevice> dev; // some callers delete the device before the writer
     QStack<Tag> tags;
     int baseIndentLevel;
 
     char* indentBuffer; // maybe make it static, but then it needs a K_GLOBAL_STATIC
     // and would eat 1K all the time... Maybe refcount it :)
-    char* escapeBuffer; // can't really be static if we want to be thread-safe
+    char* outputBuffer; // collects the output to write it out in large blocks
+    int used;
 };
 
 KoXmlWriter::KoXmlWriter(QIODevice* dev, int indentLevel)
@@ -59,13 +68,14 @@ void KoXmlWriter::init()
     memset(d->indentBuffer, ' ', s_indentBufferLength);
     *d->indentBuffer = '\n'; // write newline before indentation, in one go
 
-    d->escapeBuffer = new char[s_escapeBufferLen];
+    d->outputBuffer = new char[s_outputBufferLength];
     if (!d->dev->isOpen())
         d->dev->open(QIODevice::WriteOnly);
 }
 
 KoXmlWriter::~KoXmlWriter()
 {
+    flushBuffer();
     delete d;
 }
 
@@ -92,6 +102,7 @@ void KoXmlWriter::endDocument()
     // just to do exactly like QDom does (newline at end of file).
     writeChar('\n');
     Q_ASSERT(d->tags.isEmpty());
+    flushBuffer();
 }
 
 // returns the value of indentInside of the parent
@@ -141,6 +152,8 @@ void KoXmlWriter::addCompleteElement(const char* cstr)
 {
     prepareForChild();
     writeCString(cstr);
+    if (d->tags.isEmpty())
+        flushBuffer();
 }
 
 
@@ -164,12 +177,14 @@ void KoXmlWriter::addCompleteElement(QIODevice* indev)
         qint64 len = indev->read(buffer.data(), buffer.size());
         if (len <= 0)   // e.g. on error
             break;
-        d->dev->write(buffer.data(), len);
+        writeBytes(buffer.data(), len);
     }
     if (!wasOpen) {
         // Restore initial state
         indev->close();
     }
+    if (d->tags.isEmpty())
+        flushBuffer();
 }
 
 void KoXmlWriter::endElement()
@@ -192,25 +207,29 @@ void KoXmlWriter::endElement()
         writeCString(tag.tagName);
         writeChar('>');
     }
+
+    // the outermost element is complete, e.g. for an element written into a buffer
+    if (d->tags.isEmpty())
+        flushBuffer();
+}
+
+void KoXmlWriter::addTextNode(const QString& str)
+{
+    prepareForTextNode();
+    writeEscaped(str.constData(), str.length());
 }
 
 void KoXmlWriter::addTextNode(const QByteArray& cstr)
 {
     // Same as the const char* version below, but here we know the size
     prepareForTextNode();
-    char* escaped = escapeForXML(cstr.constData(), cstr.size());
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(cstr.constData(), cstr.size());
 }
 
 void KoXmlWriter::addTextNode(const char* cstr)
 {
     prepareForTextNode();
-    char* escaped = escapeForXML(cstr, -1);
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(cstr, -1);
 }
 
 void KoXmlWriter::addProcessingInstruction(const char* cstr)
@@ -221,16 +240,22 @@ void KoXmlWriter::addProcessingInstruction(const char* cstr)
     writeCString("?>");
 }
 
+void KoXmlWriter::addAttribute(const char* attrName, const QString& value)
+{
+    writeChar(' ');
+    writeCString(attrName);
+    writeCString("=\"");
+    writeEscaped(value.constData(), value.length());
+    writeChar('"');
+}
+
 void KoXmlWriter::addAttribute(const char* attrName, const QByteArray& value)
 {
     // Same as the const char* one, but here we know the size
     writeChar(' ');
     writeCString(attrName);
     writeCString("=\"");
-    char* escaped = escapeForXML(value.constData(), value.size());
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(value.constData(), value.size());
     writeChar('"');
 }
 
@@ -239,10 +264,7 @@ void KoXmlWriter::addAttribute(const char* attrName, const char* value)
     writeChar(' ');
     writeCString(attrName);
     writeCString("=\"");
-    char* escaped = escapeForXML(value, -1);
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(value, -1);
     writeChar('"');
 }
 
@@ -279,88 +301,197 @@ void KoXmlWriter::addAttributePt(const char* attrName, float value)
 void KoXmlWriter::writeIndent()
 {
     // +1 because of the leading '\n'
-    d->dev->write(d->indentBuffer, qMin(indentLevel() + 1,
-                                        s_indentBufferLength));
+    writeBytes(d->indentBuffer, qMin(indentLevel() + 1,
+                                     s_indentBufferLength));
 }
 
 void KoXmlWriter::writeString(const QString& str)
 {
     // cachegrind says .utf8() is where most of the time is spent
     const QByteArray cstr = str.toUtf8();
-    d->dev->write(cstr);
+    writeBytes(cstr.constData(), cstr.size());
 }
 
-// In case of a reallocation (ret value != d->buffer), the caller owns the return value,
-// it must delete it (with [])
-char* KoXmlWriter::escapeForXML(const char* source, int length = -1) const
+void KoXmlWriter::writeChar(char c)
 {
-    // we're going to be pessimistic on char length; so lets make the outputLength less
-    // the amount one char can take: 6
-    char* destBoundary = d->escapeBuffer + s_escapeBufferLen - 6;
-    char* destination = d->escapeBuffer;
-    char* output = d->escapeBuffer;
-    const char* src = source; // src moves, source remains
-    for (;;) {
-        if (destination >= destBoundary) {
-            // When we come to realize that our escaped string is going to
-            // be bigger than the escape buffer (this shouldn't happen very often...),
-            // we drop the idea of using it, and we allocate a bigger buffer.
-            // Note that this if() can only be hit once per call to the method.
-            if (length == -1)
-                length = qstrlen(source);   // expensive...
-            uint newLength = length * 6 + 1; // worst case. 6 is due to &quot; and &apos;
-            char* buffer = new char[ newLength ];
-            destBoundary = buffer + newLength;
-            uint amountOfCharsAlreadyCopied = destination - d->escapeBuffer;
-            memcpy(buffer, d->escapeBuffer, amountOfCharsAlreadyCopied);
-            output = buffer;
-            destination = buffer + amountOfCharsAlreadyCopied;
+    if (d->used == s_outputBufferLength)
+        flushBuffer();
+    d->outputBuffer[d->used++] = c;
+}
+
+void KoXmlWriter::writeBytes(const char* data, int length)
+{
+    if (d->used + length > s_outputBufferLength) {
+        flushBuffer();
+        if (length > s_outputBufferLength) {
+            if (d->dev)
+                d->dev->write(data, length);
+            return;
         }
-        switch (*src) {
-        case 60: // <
-            memcpy(destination, "&lt;", 4);
-            destination += 4;
-            break;
-        case 62: // >
-            memcpy(destination, "&gt;", 4);
-            destination += 4;
-            break;
-        case 34: // "
-            memcpy(destination, "&quot;", 6);
-            destination += 6;
-            break;
+    }
+    memcpy(d->outputBuffer + d->used, data, length);
+    d->used += length;
+}
+
+void KoXmlWriter::flushBuffer() const
+{
+    if (d->used > 0 && d->dev)
+        d->dev->write(d->outputBuffer, d->used);
+    d->used = 0;
+}
+
+void KoXmlWriter::flush()
+{
+    flushBuffer();
+}
+
+void KoXmlWriter::writeEscaped(const char* source, int length)
+{
+    if (length == -1)
+        length = qstrlen(source);
+    const char* src = source; // src moves, source remains
+    const char* const end = source + length;
+    while (src < end) {
+        const char* const chunkEnd = src + qMin<qptrdiff>(end - src, s_escapeChunkLength);
+        if (d->used + 6 * (chunkEnd - src) > s_outputBufferLength)
+            flushBuffer();
+        char* destination = d->outputBuffer + d->used;
+        while (src < chunkEnd) {
+            switch (*src) {
+            case 60: // <
+                memcpy(destination, "&lt;", 4);
+                destination += 4;
+                break;
+            case 62: // >
+                memcpy(destination, "&gt;", 4);
+                destination += 4;
+                break;
+            case 34: // "
+                memcpy(destination, "&quot;", 6);
+                destination += 6;
+                break;
 #if 0 // needed?
-        case 39: // '
-            memcpy(destination, "&apos;", 6);
-            destination += 6;
-            break;
+            case 39: // '
+                memcpy(destination, "&apos;", 6);
+                destination += 6;
+                break;
 #endif
-        case 38: // &
-            memcpy(destination, "&amp;", 5);
-            destination += 5;
-            break;
-        case 0:
-            *destination = '\0';
-            return output;
-        // Control codes accepted in XML 1.0 documents.
-        case 9:
-        case 10:
-        case 13:
-            *destination++ = *src++;
-            continue;
-        default:
-            // Don't add control codes not accepted in XML 1.0 documents.
-            if (*src > 0 && *src < 32) {
-                ++src;
+            case 38: // &
+                memcpy(destination, "&amp;", 5);
+                destination += 5;
+                break;
+            case 0:
+                d->used = destination - d->outputBuffer;
+                return;
+            // Control codes accepted in XML 1.0 documents.
+            case 9:
+            case 10:
+            case 13:
+                *destination++ = *src;
+                break;
+            default:
+                // Don't add control codes not accepted in XML 1.0 documents.
+                if (*src <= 0 || *src >= 32)
+                    *destination++ = *src;
+                break;
+            }
+            ++src;
+        }
+        d->used = destination - d->outputBuffer;
+    }
+}
+
+void KoXmlWriter::writeEscaped(const QChar* source, int length)
+{
+    // Converts straight from utf16 to utf8, instead of through QString::toUtf8().
+    const ushort* src = reinterpret_cast<const ushort*>(source);
+    const ushort* const end = src + length;
+    while (src < end) {
+        const ushort* chunkEnd = src + qMin<qptrdiff>(end - src, s_escapeChunkLength);
+        // keep surrogate pairs together
+        if (chunkEnd < end && QChar::isHighSurrogate(chunkEnd[-1]))
+            ++chunkEnd;
+        if (d->used + 6 * (chunkEnd - src) > s_outputBufferLength)
+            flushBuffer();
+        char* destination = d->outputBuffer + d->used;
+        while (src < chunkEnd) {
+#ifdef __SSE2__
+            // Copy 8 printable ASCII characters without markup at once.
+            while (chunkEnd - src >= 8) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                // 0x20 <= c < 0x7f, compared unsigned
+                const __m128i offset = _mm_xor_si128(_mm_sub_epi16(chars, _mm_set1_epi16(0x20)),
+                                                     _mm_set1_epi16(short(0x8000)));
+                const __m128i printable = _mm_cmplt_epi16(offset, _mm_set1_epi16(short(0x8000 + 0x5f)));
+                const __m128i markup = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chars, _mm_set1_epi16('<')),
+                                                                 _mm_cmpeq_epi16(chars, _mm_set1_epi16('>'))),
+                                                    _mm_or_si128(_mm_cmpeq_epi16(chars, _mm_set1_epi16('&')),
+                                                                 _mm_cmpeq_epi16(chars, _mm_set1_epi16('"'))));
+                if (_mm_movemask_epi8(_mm_andnot_si128(markup, printable)) != 0xffff)
+                    break;
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(chars, chars));
+                destination += 8;
+                src += 8;
+            }
+            if (src == chunkEnd)
+                break;
+#endif
+            const ushort c = *src++;
+            if (c < 0x80) {
+                switch (c) {
+                case '<':
+                    memcpy(destination, "&lt;", 4);
+                    destination += 4;
+                    break;
+                case '>':
+                    memcpy(destination, "&gt;", 4);
+                    destination += 4;
+                    break;
+                case '"':
+                    memcpy(destination, "&quot;", 6);
+                    destination += 6;
+                    break;
+                case '&':
+                    memcpy(destination, "&amp;", 5);
+                    destination += 5;
+                    break;
+                case 0:
+                    // like the const char* version, stop at the terminator
+                    d->used = destination - d->outputBuffer;
+                    return;
+                // Control codes accepted in XML 1.0 documents.
+                case 9:
+                case 10:
+                case 13:
+                    *destination++ = char(c);
+                    break;
+                default:
+                    // Don't add control codes not accepted in XML 1.0 documents.
+                    if (c >= 32)
+                        *destination++ = char(c);
+                    break;
+                }
+            } else if (c < 0x800) {
+                *destination++ = char(0xc0 | (c >> 6));
+                *destination++ = char(0x80 | (c & 0x3f));
+            } else if (QChar::isHighSurrogate(c) && src < chunkEnd && QChar::isLowSurrogate(*src)) {
+                const uint ucs4 = QChar::surrogateToUcs4(c, *src++);
+                *destination++ = char(0xf0 | (ucs4 >> 18));
+                *destination++ = char(0x80 | ((ucs4 >> 12) & 0x3f));
+                *destination++ = char(0x80 | ((ucs4 >> 6) & 0x3f));
+                *destination++ = char(0x80 | (ucs4 & 0x3f));
+            } else if (QChar::isSurrogate(c)) {
+                // an unpaired surrogate becomes the replacement character, like in QString::toUtf8()
+                memcpy(destination, "\xef\xbf\xbd", 3);
+                destination += 3;
             } else {
-                *destination++ = *src++;
+                *destination++ = char(0xe0 | (c >> 12));
+                *destination++ = char(0x80 | ((c >> 6) & 0x3f));
+                *destination++ = char(0x80 | (c & 0x3f));
             }
-            continue;
         }
-        ++src;
+        d->used = destination - d->outputBuffer;
     }
-    // NOTREACHED (see case 0)
-    return output;
 }
 
 void KoXmlWriter::addManifestEntry(const QString& fullPath, const QString& mediaType)
@@ -528,6 +659,8 @@ void KoXmlWriter::addTextSpan(const QString& text, const QMap<int, int>& tabCach
 
 QIODevice *KoXmlWriter::device() const
 {
+    // callers may read or write the device directly
+    flushBuffer();
     return d->dev;
 }
 
@@ -547,6 +680,7 @@ QList<const char*> KoXmlWriter::tagHierarchy() const
 
 QString KoXmlWriter::toString() const
 {
+    flushBuffer();
     Q_ASSERT(!d->dev->isSequential());
     if (d->dev->isSequential())
         return QString();
@@ -31,6 +31,11 @@
  * The XML is being written out along the way, which avoids requiring the entire
  * document in memory (like QDom does), and avoids using QTextStream at all
  * (which in Qt3 has major performance issues when converting to utf8).
+ *
+ * The output is collected in an internal buffer and written to the device in
+ * large blocks. The buffer is flushed when the outermost element is closed, at
+ * the end of the document, by flush() and whenever device() is called, so that
+ * the device contains everything written so far.
  */
 class KOSTORE_EXPORT KoXmlWriter
 {
@@ -44,8 +49,16 @@ public:
     /// Destructor
     ~KoXmlWriter();
 
+    /**
+     * @return the device, after flushing the buffered output into it
+     */
     QIODevice *device() const;
 
+    /**
+     * Writes the buffered output to the device.
+     */
+    void flush();
+
     /**
      * Start the XML document.
      * This writes out the \<?xml?\> tag with utf8 encoding, and the DOCTYPE.
@@ -69,12 +82,10 @@ public:
     void startElement(const char* tagName, bool indentInside = true);
 
     /**
-     * Overloaded version of addAttribute( const char*, const char* ),
-     * which is a bit slower because it needs to convert @p value to utf8 first.
+     * Overloaded version of addAttribute( const char*, const char* ).
+     * @p value is converted to utf8 while it is escaped.
      */
-    inline void addAttribute(const char* attrName, const QString& value) {
-        addAttribute(attrName, value.toUtf8());
-    }
+    void addAttribute(const char* attrName, const QString& value);
     /**
      * Add an attribute whose value is an integer
      */
@@ -134,12 +145,10 @@ public:
      */
     void endElement();
     /**
-     * Overloaded version of addTextNode( const char* ),
-     * which is a bit slower because it needs to convert @p str to utf8 first.
+     * Overloaded version of addTextNode( const char* ).
+     * @p str is converted to utf8 while it is escaped.
      */
-    inline void addTextNode(const QString& str) {
-        addTextNode(str.toUtf8());
-    }
+    void addTextNode(const QString& str);
     /// Overloaded version of the one taking a const char* argument
     void addTextNode(const QByteArray& cstr);
     /**
@@ -271,20 +280,22 @@ private:
     // Try to use it as much as possible, especially with constants.
     void writeString(const QString& str);
 
-    // TODO check return value!!!
     inline void writeCString(const char* cstr) {
-        device()->write(cstr, qstrlen(cstr));
-    }
-    inline void writeChar(char c) {
-        device()->putChar(c);
+        writeBytes(cstr, qstrlen(cstr));
     }
+    void writeChar(char c);
+    void writeBytes(const char* data, int length);
+    // TODO check return value!!!
+    void flushBuffer() const;
     inline void closeStartElement(Tag& tag) {
         if (!tag.openingTagClosed) {
             tag.openingTagClosed = true;
             writeChar('>');
         }
     }
-    char* escapeForXML(const char* source, int length) const;
+    // Write out the escaped text up to a terminating zero, if any.
+    void writeEscaped(const char* source, int length);
+    void writeEscaped(const QChar* source, int length);
     bool prepareForChild();
     void prepareForTextNode();
     void init();
@@ -20,9 +20,12 @@
 
 #include "KoZipStore.h"
 #include "KoStore_p.h"
+#include "KoMappedZip.h"
+#include "KoZipWriter.h"
 
 #include <QBuffer>
 #include <QByteArray>
+#include <QSaveFile>
 
 #include <kzip.h>
 #include <StoreDebug.h>
@@ -86,7 +89,10 @@ KoZipStore::~KoZipStore()
     debugStore << "KoZipStore::~KoZipStore";
     if (!d->finalized)
         finalize(); // ### no error checking when the app forgot to call finalize itself
+    delete m_writer;
+    delete m_saveFile; // discards the file, if it was not committed
     delete m_pZip;
+    delete m_mappedZip; // unmap before the temporary file gets removed
 
     // Now we have still some job to do for remote files.
     if (d->fileMode == KoStorePrivate::RemoteRead) {
@@ -102,53 +108,95 @@ void KoZipStore::init(const QByteArray& appIdentification)
     Q_D(KoStore);
 
     m_currentDir = 0;
-    d->good = m_pZip->open(d->mode == Write ? QIODevice::WriteOnly : QIODevice::ReadOnly);
-
-    if (!d->good)
-        return;
+    m_mappedZip = 0;
+    m_writer = 0;
+    m_saveFile = 0;
+    m_compressionEnabled = true;
 
     if (d->mode == Write) {
-        //debugStore <<"KoZipStore::init writing mimetype" << appIdentification;
-
-        m_pZip->setCompression(KZip::NoCompression);
-        m_pZip->setExtraField(KZip::NoExtraField);
+        QIODevice *device = m_pZip->device();
+        if (!device) {
+            m_saveFile = new QSaveFile(d->localFileName);
+            device = m_saveFile;
+        }
+        d->good = device->isOpen() || device->open(QIODevice::WriteOnly);
+        if (!d->good)
+            return;
 
-        // Write identification
+        m_writer = new KoZipWriter(device);
+        // Write identification, stored as the first file
         if (d->writeMimetype) {
-            (void)m_pZip->writeFile(QLatin1String("mimetype"), appIdentification);
+            d->good = m_writer->addEntry(QLatin1String("mimetype"), appIdentification, false);
         }
+        return;
+    }
 
-        m_pZip->setCompression(KZip::DeflateCompression);
-        // We don't need the extra field in Calligra - so we leave it as "no extra field".
-    } else {
-        d->good = m_pZip->directory() != 0;
+    if (d->mode == Read && !d->localFileName.isEmpty()) {
+        m_mappedZip = new KoMappedZip;
+        if (m_mappedZip->open(d->localFileName)) {
+            d->good = true;
+            return;
+        }
+        delete m_mappedZip;
+        m_mappedZip = 0;
     }
+
+    d->good = m_pZip->open(QIODevice::ReadOnly);
+
+    if (!d->good)
+        return;
+
+    d->good = m_pZip->directory() != 0;
 }
 
 void KoZipStore::setCompressionEnabled(bool e)
 {
-    if (e) {
-        m_pZip->setCompression(KZip::DeflateCompression);
-    } else {
-        m_pZip->setCompression(KZip::NoCompression);        
-    }
+    m_compressionEnabled = e;
 }
 
 bool KoZipStore::doFinalize()
 {
+    if (m_mappedZip)
+        return true;
+    if (m_writer) {
+        bool ok = m_writer->finish();
+        if (m_saveFile) {
+            if (!ok) {
+                m_saveFile->cancelWriting();
+            }
+            ok = m_saveFile->commit() && ok;
+        } else {
+            m_pZip->device()->close();
+        }
+        return ok;
+    }
     return m_pZip->close();
 }
 
 bool KoZipStore::openWrite(const QString& name)
 {
     Q_D(KoStore);
+    Q_UNUSED(name);
     d->stream = 0; // Don't use!
-    return m_pZip->prepareWriting(name, "", "" /*m_pZip->rootDir()->user(), m_pZip->rootDir()->group()*/, 0);
+    m_buffer.clear();
+    return d->good;
 }
 
 bool KoZipStore::openRead(const QString& name)
 {
     Q_D(KoStore);
+    if (m_mappedZip) {
+        qint64 size = 0;
+        QIODevice *stream = m_mappedZip->createDevice(name, &size);
+        if (!stream) {
+            return false;
+        }
+        delete d->stream;
+        d->stream = stream;
+        d->size = size;
+        d->view = m_mappedZip->view(name);
+        return true;
+    }
     const KArchiveEntry * entry = m_pZip->directory()->entry(name);
     if (entry == 0) {
         return false;
@@ -165,6 +213,16 @@ bool KoZipStore::openRead(const QString& name)
     return true;
 }
 
+QIODevice *KoZipStore::openReadDevice(const QString& name)
+{
+    // The devices of KZip share the archive device, and its position.
+    if (!m_mappedZip) {
+        return 0;
+    }
+    qint64 size = 0;
+    return m_mappedZip->createDevice(name, &size);
+}
+
 qint64 KoZipStore::write(const char* _data, qint64 _len)
 {
     Q_D(KoStore);
@@ -181,13 +239,15 @@ qint64 KoZipStore::write(const char* _data, qint64 _len)
     }
 
     d->size += _len;
-    if (m_pZip->writeData(_data, _len))     // writeData returns a bool!
-        return _len;
-    return 0;
+    m_buffer.append(_data, _len);
+    return _len;
 }
 
 QStringList KoZipStore::directoryList() const
 {
+    if (m_mappedZip) {
+        return m_mappedZip->rootDirectories();
+    }
     QStringList retval;
     const KArchiveDirectory *directory = m_pZip->directory();
     foreach(const QString &name, directory->entries()) {
@@ -203,13 +263,22 @@ bool KoZipStore::closeWrite()
 {
     Q_D(KoStore);
     debugStore << "Wrote file" << d->fileName << " into ZIP archive. size" << d->size;
-    return m_pZip->finishWriting(d->size);
+    const bool ok = m_writer->addEntry(d->fileName, m_buffer, m_compressionEnabled);
+    m_buffer.clear(); // the writer keeps the data until it is written
+    return ok;
 }
 
 bool KoZipStore::enterRelativeDirectory(const QString& dirName)
 {
     Q_D(KoStore);
-    if (d->mode == Read) {
+    if (d->mode == Read && m_mappedZip) {
+        const QString path = m_mappedDir + dirName;
+        if (!m_mappedZip->isDirectory(path)) {
+            return false;
+        }
+        m_mappedDir = path + '/';
+        return true;
+    } else if (d->mode == Read) {
         if (!m_currentDir) {
             m_currentDir = m_pZip->directory(); // initialize
             Q_ASSERT(d->currentPath.isEmpty());
@@ -226,6 +295,20 @@ bool KoZipStore::enterRelativeDirectory(const QString& dirName)
 
 bool KoZipStore::enterAbsoluteDirectory(const QString& path)
 {
+    if (m_mappedZip) {
+        if (path.isEmpty()) {
+            m_mappedDir.clear();
+            return true;
+        }
+        if (!m_mappedZip->isDirectory(path)) {
+            return false;
+        }
+        m_mappedDir = path;
+        if (!m_mappedDir.endsWith('/')) {
+            m_mappedDir += '/';
+        }
+        return true;
+    }
     if (path.isEmpty()) {
         m_currentDir = 0;
         return true;
@@ -237,6 +320,9 @@ bool KoZipStore::enterAbsoluteDirectory(const QString& path)
 
 bool KoZipStore::fileExists(const QString& absPath) const
 {
+    if (m_mappedZip) {
+        return m_mappedZip->isFile(absPath);
+    }
     const KArchiveEntry *entry = m_pZip->directory()->entry(absPath);
     return entry && entry->isFile();
 }
@@ -24,6 +24,9 @@
 
 class KZip;
 class KArchiveDirectory;
+class KoMappedZip;
+class KoZipWriter;
+class QSaveFile;
 class QUrl;
 
 class KoZipStore : public KoStore
@@ -51,6 +54,7 @@ protected:
     virtual bool doFinalize();
     virtual bool openWrite(const QString& name);
     virtual bool openRead(const QString& name);
+    virtual QIODevice *openReadDevice(const QString& name);
     virtual bool closeWrite();
     virtual bool closeRead() {
         return true;
@@ -64,6 +68,21 @@ private:
     /// The archive
     KZip * m_pZip;
 
+    /** In "Read" mode local files are mapped into memory and read without
+    KZip, if they are supported. */
+    KoMappedZip * m_mappedZip;
+
+    /// The current directory in the mapped archive, "" or ending with '/'
+    QString m_mappedDir;
+
+    /// In "Write" mode the entries are compressed in parallel by the writer.
+    KoZipWriter * m_writer;
+    /// The package file, if the store was created with a file name
+    QSaveFile * m_saveFile;
+    /// The content of the current file in "Write" mode
+    QByteArray m_buffer;
+    bool m_compressionEnabled;
+
     /** In "Read" mode this pointer is pointing to the
     current directory in the archive to speed up the verification process */
     const KArchiveDirectory* m_currentDir;
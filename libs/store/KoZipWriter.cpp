@@ -0,0 +1,372 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "KoZipWriter.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QIODevice>
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <StoreDebug.h>
+
+#include <zlib.h>
+
+#include <string.h>
+
+namespace
+{
+
+const int BlockSize = 128 * 1024;
+const int DictionarySize = 32 * 1024;
+const qint64 MaximumPendingSize = 64 * 1024 * 1024;
+
+const quint32 LocalHeaderSignature = 0x04034b50;
+const quint32 CentralHeaderSignature = 0x02014b50;
+const quint32 EndOfCentralDirectorySignature = 0x06054b50;
+
+const quint16 VersionNeeded = 20;
+const quint16 VersionMadeBy = 0x0314; // Unix, 2.0, like KZip
+const quint32 FileAttributes = 0100644 << 16;
+const quint16 Utf8Flag = 0x0800;
+const quint16 StoredMethod = 0;
+const quint16 DeflatedMethod = 8;
+
+struct Entry {
+    QString name;
+    QByteArray data;
+    bool deflated;
+    QVector<QByteArray> blocks; ///< the compressed blocks
+    QVector<quint32> crcs;      ///< the checksums of the uncompressed blocks
+    int pendingBlocks;          ///< guarded by the mutex of the writer
+    bool failed;                ///< guarded by the mutex of the writer
+};
+
+struct CentralRecord {
+    QByteArray name;
+    quint16 flags;
+    quint16 method;
+    quint32 crc;
+    quint32 compressedSize;
+    quint32 size;
+    quint32 offset;
+};
+
+void appendUInt16(QByteArray &data, quint16 value)
+{
+    data.append(char(value & 0xff));
+    data.append(char(value >> 8));
+}
+
+void appendUInt32(QByteArray &data, quint32 value)
+{
+    appendUInt16(data, value & 0xffff);
+    appendUInt16(data, value >> 16);
+}
+
+// Deflates one block, see KoZipWriter.
+bool deflateBlock(const QByteArray &data, int begin, int length, bool last, QByteArray *output)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    const int dictionaryBegin = qMax(0, begin - DictionarySize);
+    if (dictionaryBegin < begin) {
+        deflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(data.constData() + dictionaryBegin),
+                             begin - dictionaryBegin);
+    }
+
+    output->resize(deflateBound(&stream, length));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData() + begin));
+    stream.avail_in = length;
+    stream.next_out = reinterpret_cast<Bytef *>(output->data());
+    stream.avail_out = output->size();
+    // A sync flush ends the block on a byte boundary, so the next one can be appended.
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    bool ok = false;
+    for (;;) {
+        if (stream.avail_out == 0) {
+            output->resize(output->size() + output->size() / 2 + 64);
+            stream.next_out = reinterpret_cast<Bytef *>(output->data() + stream.total_out);
+            stream.avail_out = output->size() - stream.total_out;
+        }
+        const int result = deflate(&stream, flush);
+        if (result == Z_STREAM_END || (result == Z_OK && !last && stream.avail_out != 0)) {
+            ok = true;
+            break;
+        }
+        if (result != Z_OK)
+            break;
+    }
+    output->resize(stream.total_out);
+    deflateEnd(&stream);
+    return ok;
+}
+
+} // namespace
+
+class Q_DECL_HIDDEN KoZipWriter::Private
+{
+public:
+    void writeFinishedEntries(bool wait);
+    bool writeEntry(Entry *entry);
+    bool write(const QByteArray &data);
+
+    QIODevice *device;
+    quint16 time;
+    quint16 date;
+    bool ok;
+
+    QThreadPool threadPool;
+    QMutex mutex;
+    QWaitCondition blockFinished;
+
+    QQueue<Entry *> entries;    ///< added, but not written yet
+    qint64 pendingSize;
+    qint64 offset;
+    QVector<CentralRecord> records;
+};
+
+namespace
+{
+
+class DeflateJob : public QRunnable
+{
+public:
+    DeflateJob(QMutex *mutex, QWaitCondition *finished, Entry *entry, int block)
+        : m_mutex(mutex), m_finished(finished), m_entry(entry), m_block(block) {}
+
+    virtual void run() {
+        const int begin = m_block * BlockSize;
+        const int length = qMin(BlockSize, m_entry->data.size() - begin);
+        const bool last = m_block == m_entry->blocks.count() - 1;
+        const Bytef *data = reinterpret_cast<const Bytef *>(m_entry->data.constData() + begin);
+        m_entry->crcs[m_block] = crc32(crc32(0, Z_NULL, 0), data, length);
+        bool ok = true;
+        if (m_entry->deflated)
+            ok = deflateBlock(m_entry->data, begin, length, last, &m_entry->blocks[m_block]);
+
+        QMutexLocker locker(m_mutex);
+        --m_entry->pendingBlocks;
+        m_entry->failed |= !ok;
+        m_finished->wakeAll();
+    }
+
+private:
+    QMutex *const m_mutex;
+    QWaitCondition *const m_finished;
+    Entry *const m_entry;
+    const int m_block;
+};
+
+} // namespace
+
+KoZipWriter::KoZipWriter(QIODevice *device)
+    : d(new Private)
+{
+    d->device = device;
+    d->ok = device && device->isWritable();
+    d->pendingSize = 0;
+    d->offset = 0;
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDate date = now.date();
+    const QTime time = now.time();
+    d->time = (time.hour() << 11) | (time.minute() << 5) | (time.second() >> 1);
+    d->date = ((qMax(date.year(), 1980) - 1980) << 9) | (date.month() << 5) | date.day();
+}
+
+KoZipWriter::~KoZipWriter()
+{
+    // The jobs refer to the entries.
+    d->threadPool.waitForDone();
+    qDeleteAll(d->entries);
+    delete d;
+}
+
+bool KoZipWriter::addEntry(const QString &name, const QByteArray &data, bool deflated)
+{
+    if (!d->ok)
+        return false;
+
+    Entry *entry = new Entry;
+    entry->name = name;
+    entry->data = data;
+    entry->deflated = deflated;
+    const int blockCount = qMax(1, (data.size() + BlockSize - 1) / BlockSize);
+    entry->blocks.resize(blockCount);
+    entry->crcs.resize(blockCount);
+    entry->pendingBlocks = blockCount;
+    entry->failed = false;
+    d->entries.enqueue(entry);
+    d->pendingSize += data.size();
+    for (int block = 0; block < blockCount; ++block)
+        d->threadPool.start(new DeflateJob(&d->mutex, &d->blockFinished, entry, block));
+
+    d->writeFinishedEntries(false);
+    return d->ok;
+}
+
+bool KoZipWriter::finish()
+{
+    d->writeFinishedEntries(true);
+    if (!d->ok)
+        return false;
+
+    if (d->records.count() > 0xffff || d->offset > 0xffffffff) {
+        warnStore << "Too many entries for a ZIP package without ZIP64";
+        d->ok = false;
+        return false;
+    }
+
+    QByteArray directory;
+    foreach (const CentralRecord &record, d->records) {
+        appendUInt32(directory, CentralHeaderSignature);
+        appendUInt16(directory, VersionMadeBy);
+        appendUInt16(directory, VersionNeeded);
+        appendUInt16(directory, record.flags);
+        appendUInt16(directory, record.method);
+        appendUInt16(directory, d->time);
+        appendUInt16(directory, d->date);
+        appendUInt32(directory, record.crc);
+        appendUInt32(directory, record.compressedSize);
+        appendUInt32(directory, record.size);
+        appendUInt16(directory, record.name.size());
+        appendUInt16(directory, 0); // extra field
+        appendUInt16(directory, 0); // comment
+        appendUInt16(directory, 0); // disk
+        appendUInt16(directory, 0); // internal attributes
+        appendUInt32(directory, FileAttributes);
+        appendUInt32(directory, record.offset);
+        directory.append(record.name);
+    }
+    const qint64 directoryOffset = d->offset;
+    if (directoryOffset + directory.size() > 0xffffffff) {
+        warnStore << "The ZIP package is too large without ZIP64";
+        d->ok = false;
+        return false;
+    }
+    const int directorySize = directory.size();
+    appendUInt32(directory, EndOfCentralDirectorySignature);
+    appendUInt16(directory, 0); // disk
+    appendUInt16(directory, 0); // disk of the central directory
+    appendUInt16(directory, d->records.count());
+    appendUInt16(directory, d->records.count());
+    appendUInt32(directory, directorySize);
+    appendUInt32(directory, directoryOffset);
+    appendUInt16(directory, 0); // comment
+    return d->write(directory);
+}
+
+void KoZipWriter::Private::writeFinishedEntries(bool wait)
+{
+    while (!entries.isEmpty()) {
+        Entry *entry = entries.head();
+        {
+            QMutexLocker locker(&mutex);
+            // Wait for the oldest entry, if too much data is pending.
+            if (entry->pendingBlocks > 0 && !wait && pendingSize <= MaximumPendingSize)
+                return;
+            while (entry->pendingBlocks > 0)
+                blockFinished.wait(&mutex);
+            ok &= !entry->failed;
+        }
+        entries.dequeue();
+        pendingSize -= entry->data.size();
+        if (ok)
+            ok = writeEntry(entry);
+        delete entry;
+    }
+}
+
+bool KoZipWriter::Private::writeEntry(Entry *entry)
+{
+    CentralRecord record;
+    record.name = entry->name.toUtf8();
+    record.flags = 0;
+    for (int i = 0; i < record.name.size(); ++i) {
+        if (record.name.at(i) & 0x80) {
+            record.flags = Utf8Flag;
+            break;
+        }
+    }
+    record.method = entry->deflated ? DeflatedMethod : StoredMethod;
+    record.crc = entry->crcs[0];
+    for (int block = 1; block < entry->crcs.count(); ++block) {
+        const int length = qMin(BlockSize, entry->data.size() - block * BlockSize);
+        record.crc = crc32_combine(record.crc, entry->crcs[block], length);
+    }
+    qint64 compressedSize = entry->data.size();
+    if (entry->deflated) {
+        compressedSize = 0;
+        foreach (const QByteArray &block, entry->blocks)
+            compressedSize += block.size();
+    }
+    if (compressedSize > 0xffffffff || offset > 0xffffffff) {
+        warnStore << "The ZIP package is too large without ZIP64";
+        return false;
+    }
+    record.compressedSize = compressedSize;
+    record.size = entry->data.size();
+    record.offset = offset;
+
+    QByteArray header;
+    header.reserve(30 + record.name.size());
+    appendUInt32(header, LocalHeaderSignature);
+    appendUInt16(header, VersionNeeded);
+    appendUInt16(header, record.flags);
+    appendUInt16(header, record.method);
+    appendUInt16(header, time);
+    appendUInt16(header, date);
+    appendUInt32(header, record.crc);
+    appendUInt32(header, record.compressedSize);
+    appendUInt32(header, record.size);
+    appendUInt16(header, record.name.size());
+    appendUInt16(header, 0); // extra field
+    header.append(record.name);
+    if (!write(header))
+        return false;
+    if (entry->deflated) {
+        foreach (const QByteArray &block, entry->blocks) {
+            if (!write(block))
+                return false;
+        }
+    } else if (!write(entry->data)) {
+        return false;
+    }
+    records.append(record);
+    return true;
+}
+
+bool KoZipWriter::Private::write(const QByteArray &data)
+{
+    if (device->write(data) != data.size()) {
+        warnStore << "Cannot write the ZIP package:" << device->errorString();
+        return false;
+    }
+    offset += data.size();
+    return true;
+}
@@ -0,0 +1,80 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KO_ZIP_WRITER_H
+#define KO_ZIP_WRITER_H
+
+#include <QtGlobal>
+
+class QByteArray;
+class QIODevice;
+class QString;
+
+/**
+ * Writes a ZIP package, compressing the entries on a thread pool.
+ *
+ * Each added entry is split into blocks of 128 KiB, which are deflated
+ * independently like pigz does: a block is primed with the last 32 KiB
+ * of its predecessor and ends with a sync flush, so the concatenated
+ * blocks form one deflate stream. Small entries are one block each, so
+ * independent entries are compressed at the same time, too.
+ *
+ * The entries are written in the order they were added, each as soon as
+ * it is compressed, so the first entry may be the stored "mimetype" file
+ * required by ODF. No extra fields and no data descriptors are written.
+ * At most 64 MiB of uncompressed data are kept in memory; addEntry()
+ * waits for the oldest entries beyond that.
+ *
+ * ZIP64 is not supported: the package is limited to 65535 entries and 4 GiB.
+ */
+class KoZipWriter
+{
+public:
+    /**
+     * @param device opened for writing; it is not closed by the writer
+     */
+    explicit KoZipWriter(QIODevice *device);
+
+    /**
+     * Waits for the running compressions. Call finish() first to get a
+     * complete package.
+     */
+    ~KoZipWriter();
+
+    /**
+     * Adds the file @p name with the content @p data .
+     * @param deflated whether to compress the data or to store it as is
+     * @return false, if an error occurred so far
+     */
+    bool addEntry(const QString &name, const QByteArray &data, bool deflated);
+
+    /**
+     * Writes the remaining entries and the central directory.
+     * @return false, if an error occurred
+     */
+    bool finish();
+
+private:
+    Q_DISABLE_COPY(KoZipWriter)
+
+    class Private;
+    Private * const d;
+};
+
+#endif
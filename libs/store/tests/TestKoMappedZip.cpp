@@ -0,0 +1,152 @@
+/* This file is part of the KDE project
+ * Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestKoMappedZip.h"
+
+#include "../KoMappedZip.h"
+#include <KoStore.h>
+
+#include <kzip.h>
+
+#include <QFile>
+#include <QScopedPointer>
+#include <QTest>
+
+void TestKoMappedZip::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_fileName = m_dir.path() + QLatin1String("/package.odt");
+
+    for (int i = 0; i < 10000; ++i)
+        m_content += "<text:p>" + QByteArray::number(i) + "</text:p>";
+    for (int i = 0; i < 100000; ++i)
+        m_picture += char(i * 7919 >> 3);
+
+    // written like KoZipStore does
+    KZip zip(m_fileName);
+    QVERIFY(zip.open(QIODevice::WriteOnly));
+    zip.setCompression(KZip::NoCompression);
+    zip.setExtraField(KZip::NoExtraField);
+    QVERIFY(zip.writeFile(QLatin1String("mimetype"), "application/vnd.oasis.opendocument.text"));
+    QVERIFY(zip.writeFile(QLatin1String("Pictures/image.png"), m_picture));
+    zip.setCompression(KZip::DeflateCompression);
+    QVERIFY(zip.writeFile(QLatin1String("content.xml"), m_content));
+    QVERIFY(zip.writeFile(QLatin1String("Object 1/content.xml"), m_content));
+    QVERIFY(zip.close());
+}
+
+void TestKoMappedZip::testDirectory()
+{
+    KoMappedZip zip;
+    QVERIFY(zip.open(m_fileName));
+
+    QVERIFY(zip.isFile(QLatin1String("mimetype")));
+    QVERIFY(zip.isFile(QLatin1String("Pictures/image.png")));
+    QVERIFY(zip.isFile(QLatin1String("/Object 1/content.xml")));
+    QVERIFY(!zip.isFile(QLatin1String("Pictures")));
+    QVERIFY(!zip.isFile(QLatin1String("styles.xml")));
+
+    QVERIFY(zip.isDirectory(QString()));
+    QVERIFY(zip.isDirectory(QLatin1String("Pictures")));
+    QVERIFY(zip.isDirectory(QLatin1String("Object 1/")));
+    QVERIFY(!zip.isDirectory(QLatin1String("content.xml")));
+
+    QStringList directories = zip.rootDirectories();
+    directories.sort();
+    QCOMPARE(directories, QStringList() << QLatin1String("Object 1") << QLatin1String("Pictures"));
+}
+
+void TestKoMappedZip::testStoredEntry()
+{
+    KoMappedZip zip;
+    QVERIFY(zip.open(m_fileName));
+
+    const QByteArray view = zip.view(QLatin1String("Pictures/image.png"));
+    QCOMPARE(view, m_picture);
+    // not copied
+    QCOMPARE(zip.view(QLatin1String("Pictures/image.png")).constData(), view.constData());
+
+    qint64 size = 0;
+    QScopedPointer<QIODevice> device(zip.createDevice(QLatin1String("Pictures/image.png"), &size));
+    QVERIFY(device);
+    QCOMPARE(size, qint64(m_picture.size()));
+    QCOMPARE(device->readAll(), m_picture);
+}
+
+void TestKoMappedZip::testDeflatedEntry()
+{
+    KoMappedZip zip;
+    QVERIFY(zip.open(m_fileName));
+
+    QVERIFY(zip.view(QLatin1String("content.xml")).isNull());
+
+    qint64 size = 0;
+    QScopedPointer<QIODevice> device(zip.createDevice(QLatin1String("Object 1/content.xml"), &size));
+    QVERIFY(device);
+    QCOMPARE(size, qint64(m_content.size()));
+    QByteArray content;
+    char buffer[1000];
+    qint64 bytes;
+    while ((bytes = device->read(buffer, sizeof(buffer))) > 0)
+        content.append(buffer, bytes);
+    QCOMPARE(content, m_content);
+
+    QVERIFY(!zip.createDevice(QLatin1String("styles.xml"), &size));
+}
+
+void TestKoMappedZip::testUnsupportedFile()
+{
+    const QString fileName = m_dir.path() + QLatin1String("/broken.odt");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(100, 'x'));
+    file.close();
+
+    KoMappedZip zip;
+    QVERIFY(!zip.open(fileName));
+    QVERIFY(!zip.isFile(QLatin1String("mimetype")));
+}
+
+void TestKoMappedZip::testStore()
+{
+    QScopedPointer<KoStore> store(KoStore::createStore(m_fileName, KoStore::Read, QByteArray(), KoStore::Zip));
+    QVERIFY(!store->bad());
+
+    QVERIFY(store->hasFile(QLatin1String("content.xml")));
+    QVERIFY(store->open(QLatin1String("content.xml")));
+    QVERIFY(store->view().isNull());
+    QCOMPARE(store->size(), qint64(m_content.size()));
+    QCOMPARE(store->read(store->size()), m_content);
+    QVERIFY(store->close());
+
+    QVERIFY(store->enterDirectory(QLatin1String("Pictures")));
+    QVERIFY(store->open(QLatin1String("image.png")));
+    QCOMPARE(store->view(), m_picture);
+    QCOMPARE(store->device()->readAll(), m_picture);
+    QVERIFY(store->close());
+    QVERIFY(store->view().isNull());
+    QVERIFY(store->leaveDirectory());
+
+    QVERIFY(!store->enterDirectory(QLatin1String("Thumbnails")));
+    QVERIFY(store->enterDirectory(QLatin1String("Object 1")));
+    QVERIFY(store->hasFile(QLatin1String("content.xml")));
+    QVERIFY(!store->hasFile(QLatin1String("image.png")));
+}
+
+QTEST_GUILESS_MAIN(TestKoMappedZip)
@@ -0,0 +1,214 @@
+/* This file is part of the KDE project
+ * Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestKoZipWriter.h"
+
+#include "../KoZipWriter.h"
+#include <KoStore.h>
+
+#include <kzip.h>
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QScopedPointer>
+#include <QTest>
+
+// Compressible like XML, but not trivially.
+static QByteArray xmlData(int size)
+{
+    QByteArray data;
+    data.reserve(size + 64);
+    for (int i = 0; data.size() < size; ++i)
+        data += "<text:p text:style-name=\"P" + QByteArray::number(i % 17) + "\">" + QByteArray::number(i * 7919) + "</text:p>";
+    data.truncate(size);
+    return data;
+}
+
+// Hardly compressible like the pictures.
+static QByteArray binaryData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    quint32 state = 2463534242u;
+    for (int i = 0; i < size; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        data[i] = char(state);
+    }
+    return data;
+}
+
+static QByteArray readEntry(const KZip &zip, const QString &name)
+{
+    const KArchiveEntry *entry = zip.directory()->entry(name);
+    if (!entry || !entry->isFile())
+        return QByteArray();
+    return static_cast<const KArchiveFile *>(entry)->data();
+}
+
+void TestKoZipWriter::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void TestKoZipWriter::testEntries_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<bool>("deflated");
+
+    QTest::newRow("empty stored") << QByteArray() << false;
+    QTest::newRow("empty deflated") << QByteArray() << true;
+    QTest::newRow("small") << xmlData(1000) << true;
+    QTest::newRow("one block") << xmlData(128 * 1024) << true;
+    QTest::newRow("blocks") << xmlData(1000000) << true;
+    QTest::newRow("binary blocks") << binaryData(700000) << true;
+    QTest::newRow("stored blocks") << binaryData(300000) << false;
+}
+
+void TestKoZipWriter::testEntries()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, deflated);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    {
+        KoZipWriter writer(&buffer);
+        QVERIFY(writer.addEntry(QLatin1String("first.xml"), xmlData(5000), true));
+        QVERIFY(writer.addEntry(QLatin1String("Pictures/entry"), data, deflated));
+        QVERIFY(writer.addEntry(QString::fromUtf8("Pictures/\xc3\xa4.xml"), xmlData(3000), true));
+        QVERIFY(writer.finish());
+    }
+    buffer.close();
+
+    KZip zip(&buffer);
+    QVERIFY(zip.open(QIODevice::ReadOnly));
+    QCOMPARE(readEntry(zip, QLatin1String("first.xml")), xmlData(5000));
+    QCOMPARE(readEntry(zip, QLatin1String("Pictures/entry")), data);
+    QCOMPARE(readEntry(zip, QString::fromUtf8("Pictures/\xc3\xa4.xml")), xmlData(3000));
+}
+
+void TestKoZipWriter::testMimetypeFirst()
+{
+    const QString fileName = m_dir.path() + QLatin1String("/mimetype.odt");
+    const QByteArray mimetype("application/vnd.oasis.opendocument.text");
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Write, mimetype, KoStore::Zip));
+        QVERIFY(!store->bad());
+        QVERIFY(store->open(QLatin1String("content.xml")));
+        QCOMPARE(store->write(xmlData(500000)), qint64(500000));
+        QVERIFY(store->close());
+        QVERIFY(store->finalize());
+    }
+
+    // ODF requires an uncompressed "mimetype" without extra field at the beginning.
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray header = file.read(30 + 8 + mimetype.size());
+    QCOMPARE(header.left(4), QByteArray("PK\x03\x04", 4));
+    QCOMPARE(header.mid(8, 2), QByteArray(2, '\0'));     // stored
+    QCOMPARE(header.mid(28, 2), QByteArray(2, '\0'));    // no extra field
+    QCOMPARE(header.mid(30, 8), QByteArray("mimetype"));
+    QCOMPARE(header.mid(38), mimetype);
+}
+
+void TestKoZipWriter::testStore()
+{
+    const QString fileName = m_dir.path() + QLatin1String("/store.odt");
+    const QByteArray content = xmlData(2000000);
+    const QByteArray picture = binaryData(1000000);
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Write, "application/x-test", KoStore::Zip));
+        QVERIFY(store->open(QLatin1String("content.xml")));
+        // in pieces like KoXmlWriter
+        for (int i = 0; i < content.size(); i += 16384)
+            store->write(content.constData() + i, qMin(16384, content.size() - i));
+        QVERIFY(store->close());
+        store->setCompressionEnabled(false);
+        QVERIFY(store->open(QLatin1String("Pictures/picture.png")));
+        QCOMPARE(store->write(picture), qint64(picture.size()));
+        QVERIFY(store->close());
+        QVERIFY(store->finalize());
+    }
+
+    QScopedPointer<KoStore> store(KoStore::createStore(fileName, KoStore::Read, QByteArray(), KoStore::Zip));
+    QVERIFY(!store->bad());
+    QVERIFY(store->open(QLatin1String("mimetype")));
+    QCOMPARE(store->read(store->size()), QByteArray("application/x-test"));
+    QVERIFY(store->close());
+    QVERIFY(store->open(QLatin1String("content.xml")));
+    QCOMPARE(store->read(store->size()), content);
+    QVERIFY(store->close());
+    QVERIFY(store->open(QLatin1String("Pictures/picture.png")));
+    // stored
+    QCOMPARE(store->view(), picture);
+    QVERIFY(store->close());
+}
+
+void TestKoZipWriter::benchmarkPackage_data()
+{
+    QTest::addColumn<bool>("parallel");
+
+    QTest::newRow("KZip") << false;
+    QTest::newRow("KoZipWriter") << true;
+}
+
+// A document with a large content.xml and some pictures.
+void TestKoZipWriter::benchmarkPackage()
+{
+    QFETCH(bool, parallel);
+
+    QVector<QByteArray> entries;
+    entries.append(xmlData(8 * 1024 * 1024));
+    entries.append(xmlData(200000));
+    for (int i = 0; i < 8; ++i)
+        entries.append(binaryData(2 * 1024 * 1024));
+    qint64 totalSize = 0;
+    foreach (const QByteArray &entry, entries)
+        totalSize += entry.size();
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QElapsedTimer timer;
+    timer.start();
+    if (parallel) {
+        KoZipWriter writer(&buffer);
+        QVERIFY(writer.addEntry(QLatin1String("mimetype"), "application/x-test", false));
+        for (int i = 0; i < entries.count(); ++i)
+            QVERIFY(writer.addEntry(QString::fromLatin1("entry%1").arg(i), entries[i], true));
+        QVERIFY(writer.finish());
+    } else {
+        KZip zip(&buffer);
+        QVERIFY(zip.open(QIODevice::WriteOnly));
+        zip.setExtraField(KZip::NoExtraField);
+        zip.setCompression(KZip::NoCompression);
+        QVERIFY(zip.writeFile(QLatin1String("mimetype"), "application/x-test"));
+        zip.setCompression(KZip::DeflateCompression);
+        for (int i = 0; i < entries.count(); ++i)
+            QVERIFY(zip.writeFile(QString::fromLatin1("entry%1").arg(i), entries[i]));
+        QVERIFY(zip.close());
+    }
+    const qint64 elapsed = qMax(qint64(1), timer.elapsed());
+    qInfo() << "writing" << totalSize << "bytes using" << QTest::currentDataTag() << ":" << elapsed << "ms,"
+            << totalSize * 1000.0 / elapsed / (1024 * 1024) << "MB/s, package of" << buffer.size() << "bytes";
+    QTest::setBenchmarkResult(totalSize * 1000.0 / elapsed, QTest::BytesPerSecond);
+}
+
+QTEST_GUILESS_MAIN(TestKoZipWriter)
@@ -20,6 +20,8 @@
 
 #include "KoCsvImportDialog.h"
 
+#include "KoCsvTokenizer.h"
+
 // Qt
 #include <QButtonGroup>
 #include <QTextCodec>
@@ -46,7 +48,7 @@ public:
 };
 
 
-class Q_DECL_HIDDEN KoCsvImportDialog::Private
+class Q_DECL_HIDDEN KoCsvImportDialog::Private : public KoCsvTokenizer::Handler
 {
 public:
     KoCsvImportDialog* q;
@@ -70,6 +72,7 @@ public:
     void loadSettings();
     void saveSettings();
     void fillTable();
+    void field(int row, int column, const QString& text) Q_DECL_OVERRIDE;
     void setText(int row, int col, const QString& text);
     void adjustRows(int iRows);
     void adjustCols(int iCols);
@@ -310,249 +313,30 @@ void KoCsvImportDialog::Private::saveSettings()
 
 void KoCsvImportDialog::Private::fillTable()
 {
-    int row, column;
-    bool lastCharDelimiter = false;
-    enum { Start, InQuotedField, MaybeQuotedFieldEnd, QuotedFieldEnd,
-           MaybeInNormalField, InNormalField } state = Start;
-
-    QChar x;
-    QString field;
-
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
     dialog->m_sheet->setRowCount(0);
     dialog->m_sheet->setColumnCount(0);
 
-    int maxColumn = 1;
-    row = column = 1;
     QTextStream inputStream(data, QIODevice::ReadOnly);
     debugWidgets <<"Encoding:" << codec->name();
     inputStream.setCodec( codec );
 
-    int delimiterIndex = 0;
-    const int delimiterLength = delimiter.size();
-    bool lastCharWasCr = false; // Last character was a Carriage Return
-    while (!inputStream.atEnd())
-    {
-        inputStream >> x; // read one char
-
-        // ### TODO: we should perhaps skip all other control characters
-        if ( x == '\r' )
-        {
-            // We have a Carriage Return, assume that its role is the one of a LineFeed
-            lastCharWasCr = true;
-            x = '\n'; // Replace by Line Feed
-        }
-        else if ( x == '\n' && lastCharWasCr )
-        {
-            // The end of line was already handled by the Carriage Return, so do nothing for this character
-            lastCharWasCr = false;
-            continue;
-        }
-        else if ( x == QChar( 0xc ) )
-        {
-            // We have a FormFeed, skip it
-            lastCharWasCr = false;
-            continue;
-        }
-        else
-        {
-            lastCharWasCr = false;
-        }
-
-        if ( column > maxColumn )
-          maxColumn = column;
-        switch (state)
-        {
-         case Start :
-            if (x == textQuote)
-            {
-                state = InQuotedField;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                    state = Start;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-            }
-            else if (x == '\n')
-            {
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                  break;
-            }
-            else
-            {
-                field += x;
-                state = MaybeInNormalField;
-            }
-            break;
-         case InQuotedField :
-            if (x == textQuote)
-            {
-                state = MaybeQuotedFieldEnd;
-            }
-            else if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                  break;
-
-                state = Start;
-            }
-            else
-            {
-                field += x;
-            }
-            break;
-         case MaybeQuotedFieldEnd :
-            if (x == textQuote)
-            {
-                field += x;
-                state = InQuotedField;
-            }
-            else if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                    break;
-                state = Start;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    setText(row - startRow, column - startCol, field.left(field.count()-delimiterIndex));
-                    field.clear();
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-                state = Start;
-            }
-            else
-            {
-                state = QuotedFieldEnd;
-            }
-            break;
-         case QuotedFieldEnd :
-            if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                    break;
-                state = Start;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    setText(row - startRow, column - startCol, field.left(field.count()-delimiterIndex));
-                    field.clear();
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-                state = Start;
-            }
-            else
-            {
-                state = QuotedFieldEnd;
-            }
-            break;
-         case MaybeInNormalField :
-            if (x == textQuote)
-            {
-                field.clear();
-                state = InQuotedField;
-                break;
-            }
-            state = InNormalField;
-         case InNormalField :
-            if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                    break;
-                state = Start;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    setText(row - startRow, column - startCol, field.left(field.count()-delimiterIndex));
-                    field.clear();
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-                state = Start;
-            }
-            else
-            {
-                field += x;
-            }
-        }
-        if (delimiter.isEmpty() || x != delimiter.at(0))
-          lastCharDelimiter = false;
+    KoCsvTokenizer tokenizer(delimiter, textQuote, ignoreDuplicates);
+    while (!inputStream.atEnd()) {
+        const QString chunk = inputStream.read(64 * 1024);
+        tokenizer.parse(chunk.constData(), chunk.length(), this);
     }
+    tokenizer.finish(this);
 
-    if ( !field.isEmpty() )
-    {
-      // the last line of the file had not any line end
-      setText(row - startRow, column - startCol, field);
-      ++row;
-      field.clear();
-    }
-    if (row) row--;  // row is higher by 1, so reduce it
+    const int row = tokenizer.rowCount();
+    const int maxColumn = tokenizer.maxColumn();
 
     columnsAdjusted = true;
     adjustRows( row - startRow );
     adjustCols( maxColumn - startCol );
 
-    for (column = 0; column < dialog->m_sheet->columnCount(); ++column)
+    for (int column = 0; column < dialog->m_sheet->columnCount(); ++column)
     {
         const QTableWidgetItem* headerItem = dialog->m_sheet->horizontalHeaderItem(column);
         if (!headerItem || !formatList.contains(headerItem->text())) {
@@ -575,6 +359,11 @@ void KoCsvImportDialog::Private::fillTable()
     QApplication::restoreOverrideCursor();
 }
 
+void KoCsvImportDialog::Private::field(int row, int column, const QString& text)
+{
+    setText(row - startRow, column - startCol, text);
+}
+
 KoCsvImportDialog::DataType KoCsvImportDialog::dataType(int col) const
 {
     const QString header = d->dialog->m_sheet->model()->headerData(col, Qt::Horizontal).toString();
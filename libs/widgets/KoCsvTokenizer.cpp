@@ -0,0 +1,219 @@
+/* This file is part of the KDE project
+   Copyright (C) 1999 David Faure <faure@kde.org>
+   Copyright (C) 2004 Nicolas GOUTTE <goutte@kde.org>
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "KoCsvTokenizer.h"
+
+class Q_DECL_HIDDEN KoCsvTokenizer::Private
+{
+public:
+    enum State { Start, InQuotedField, MaybeQuotedFieldEnd, QuotedFieldEnd,
+                 MaybeInNormalField, InNormalField };
+
+    QString delimiter;
+    QChar textQuote;
+    bool ignoreDuplicates;
+
+    State state;
+    int row;
+    int column;
+    int maxColumn;
+    int delimiterIndex;
+    bool lastCharDelimiter;
+    bool lastCharWasCr; // Last character was a Carriage Return
+    QString field;
+
+    // Handles a character of the delimiter; returns true, if it completed
+    // the delimiter.
+    bool delimiterChar(QChar x);
+    void endOfLine(Handler* handler);
+};
+
+bool KoCsvTokenizer::Private::delimiterChar(QChar x)
+{
+    field += x;
+    delimiterIndex++;
+    if (field.right(delimiterIndex) == delimiter) {
+        if (!ignoreDuplicates || !lastCharDelimiter)
+            column += delimiter.size();
+        lastCharDelimiter = true;
+        return true;
+    } else if (delimiterIndex >= delimiter.size())
+        delimiterIndex = 0;
+    return false;
+}
+
+void KoCsvTokenizer::Private::endOfLine(Handler* handler)
+{
+    handler->field(row, column, field);
+    field.clear();
+    ++row;
+    column = 1;
+    state = Start;
+}
+
+KoCsvTokenizer::Handler::~Handler()
+{
+}
+
+KoCsvTokenizer::KoCsvTokenizer(const QString& delimiter, QChar textQuote, bool ignoreDuplicates)
+    : d(new Private)
+{
+    d->delimiter = delimiter;
+    d->textQuote = textQuote;
+    d->ignoreDuplicates = ignoreDuplicates;
+    d->state = Private::Start;
+    d->row = 1;
+    d->column = 1;
+    d->maxColumn = 1;
+    d->delimiterIndex = 0;
+    d->lastCharDelimiter = false;
+    d->lastCharWasCr = false;
+}
+
+KoCsvTokenizer::~KoCsvTokenizer()
+{
+    delete d;
+}
+
+void KoCsvTokenizer::parse(const QChar* data, int length, Handler* handler)
+{
+    const QString& delimiter = d->delimiter;
+    const int delimiterLength = delimiter.size();
+    QString& field = d->field;
+
+    for (int i = 0; i < length; ++i) {
+        QChar x = data[i];
+
+        // ### TODO: we should perhaps skip all other control characters
+        if (x == '\r') {
+            // We have a Carriage Return, assume that its role is the one of a LineFeed
+            d->lastCharWasCr = true;
+            x = '\n'; // Replace by Line Feed
+        } else if (x == '\n' && d->lastCharWasCr) {
+            // The end of line was already handled by the Carriage Return, so do nothing for this character
+            d->lastCharWasCr = false;
+            continue;
+        } else if (x == QChar(0xc)) {
+            // We have a FormFeed, skip it
+            d->lastCharWasCr = false;
+            continue;
+        } else {
+            d->lastCharWasCr = false;
+        }
+
+        if (d->column > d->maxColumn)
+            d->maxColumn = d->column;
+
+        switch (d->state) {
+        case Private::Start:
+            if (x == d->textQuote) {
+                d->state = Private::InQuotedField;
+            } else if (d->delimiterIndex < delimiterLength && x == delimiter.at(d->delimiterIndex)) {
+                if (d->delimiterChar(x)) {
+                    field.clear();
+                    d->delimiterIndex = 0;
+                }
+            } else if (x == '\n') {
+                ++d->row;
+                d->column = 1;
+            } else {
+                field += x;
+                d->state = Private::MaybeInNormalField;
+            }
+            break;
+        case Private::InQuotedField:
+            if (x == d->textQuote) {
+                d->state = Private::MaybeQuotedFieldEnd;
+            } else if (x == '\n') {
+                d->endOfLine(handler);
+            } else {
+                field += x;
+            }
+            break;
+        case Private::MaybeQuotedFieldEnd:
+        case Private::QuotedFieldEnd:
+            if (d->state == Private::MaybeQuotedFieldEnd && x == d->textQuote) {
+                // a doubled quote
+                field += x;
+                d->state = Private::InQuotedField;
+            } else if (x == '\n') {
+                d->endOfLine(handler);
+            } else if (d->delimiterIndex < delimiterLength && x == delimiter.at(d->delimiterIndex)) {
+                const int column = d->column;
+                if (d->delimiterChar(x)) {
+                    handler->field(d->row, column, field.left(field.count() - d->delimiterIndex));
+                    field.clear();
+                    d->delimiterIndex = 0;
+                }
+                d->state = Private::Start;
+            } else {
+                d->state = Private::QuotedFieldEnd;
+            }
+            break;
+        case Private::MaybeInNormalField:
+            if (x == d->textQuote) {
+                field.clear();
+                d->state = Private::InQuotedField;
+                break;
+            }
+            d->state = Private::InNormalField;
+            // fall through
+        case Private::InNormalField:
+            if (x == '\n') {
+                d->endOfLine(handler);
+            } else if (d->delimiterIndex < delimiterLength && x == delimiter.at(d->delimiterIndex)) {
+                const int column = d->column;
+                if (d->delimiterChar(x)) {
+                    handler->field(d->row, column, field.left(field.count() - d->delimiterIndex));
+                    field.clear();
+                    d->delimiterIndex = 0;
+                }
+                d->state = Private::Start;
+            } else {
+                field += x;
+            }
+            break;
+        }
+        if (delimiter.isEmpty() || x != delimiter.at(0))
+            d->lastCharDelimiter = false;
+    }
+}
+
+void KoCsvTokenizer::finish(Handler* handler)
+{
+    if (!d->field.isEmpty()) {
+        // the last line of the text had not any line end
+        handler->field(d->row, d->column, d->field);
+        ++d->row;
+        d->field.clear();
+    }
+}
+
+int KoCsvTokenizer::rowCount() const
+{
+    // row is the one of the next field, so it is higher by 1
+    return d->row - 1;
+}
+
+int KoCsvTokenizer::maxColumn() const
+{
+    return d->maxColumn;
+}
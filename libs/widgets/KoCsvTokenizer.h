@@ -0,0 +1,97 @@
+/* This file is part of the KDE project
+   Copyright (C) 1999 David Faure <faure@kde.org>
+   Copyright (C) 2004 Nicolas GOUTTE <goutte@kde.org>
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KO_CSV_TOKENIZER
+#define KO_CSV_TOKENIZER
+
+#include <QString>
+
+#include "kowidgets_export.h"
+
+/**
+ * Splits CSV text into its fields.
+ *
+ * The text may be passed in chunks of any size; a field, a quote or a
+ * delimiter may span several chunks. Each complete field is reported to
+ * the Handler with its row and column, both starting at 1.
+ *
+ * This is the parser of KoCsvImportDialog, the batch mode of the CSV import
+ * filter uses it directly.
+ */
+class KOWIDGETS_EXPORT KoCsvTokenizer
+{
+public:
+    /**
+     * Receives the fields.
+     */
+    class KOWIDGETS_EXPORT Handler
+    {
+    public:
+        virtual ~Handler();
+
+        /**
+         * Called for each field; the \p text may be empty.
+         */
+        virtual void field(int row, int column, const QString& text) = 0;
+    };
+
+    /**
+     * Constructor.
+     * \param delimiter the field delimiter, may consist of several characters
+     * \param textQuote the quote of text fields; a null character disables quoting
+     * \param ignoreDuplicates whether consecutive delimiters count as one
+     */
+    KoCsvTokenizer(const QString& delimiter, QChar textQuote, bool ignoreDuplicates);
+
+    /**
+     * Destructor.
+     */
+    ~KoCsvTokenizer();
+
+    /**
+     * Parses the next \p length characters at \p data.
+     */
+    void parse(const QChar* data, int length, Handler* handler);
+
+    /**
+     * Reports the last field, if the text does not end with a line end.
+     * Call it once after the last chunk.
+     */
+    void finish(Handler* handler);
+
+    /**
+     * \return the number of rows parsed so far
+     */
+    int rowCount() const;
+
+    /**
+     * \return the highest column parsed so far
+     */
+    int maxColumn() const;
+
+private:
+    Q_DISABLE_COPY(KoCsvTokenizer)
+
+    class Private;
+    Private * const d;
+};
+
+#endif // KO_CSV_TOKENIZER
@@ -0,0 +1,132 @@
+/* This file is part of the KDE project
+   Copyright (C) 2026 Calligra developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestKoCsvTokenizer.h"
+
+#include <QMap>
+#include <QPair>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "KoCsvImportDialog.h"
+#include "KoCsvTokenizer.h"
+
+typedef QMap<QPair<int, int>, QString> Fields;
+
+namespace
+{
+
+class FieldCollector : public KoCsvTokenizer::Handler
+{
+public:
+    void field(int row, int column, const QString& text) Q_DECL_OVERRIDE {
+        if (!text.isEmpty())
+            fields.insert(qMakePair(row, column), text);
+    }
+
+    Fields fields;
+};
+
+// Parses the text like the streaming CSV import, chunk by chunk.
+Fields tokenize(const QString& text, const QString& delimiter, int chunkSize)
+{
+    FieldCollector collector;
+    KoCsvTokenizer tokenizer(delimiter, QChar('"'), false);
+    for (int i = 0; i < text.length(); i += chunkSize)
+        tokenizer.parse(text.constData() + i, qMin(chunkSize, text.length() - i), &collector);
+    tokenizer.finish(&collector);
+    return collector.fields;
+}
+
+// Parses the text like the import dialog.
+Fields dialogFields(const QString& text, const QString& delimiter)
+{
+    KoCsvImportDialog dialog(0);
+    dialog.setDelimiter(delimiter);
+    dialog.setData(text.toUtf8());
+    Fields fields;
+    for (int row = 0; row < dialog.rows(); ++row) {
+        for (int col = 0; col < dialog.cols(); ++col) {
+            const QString text = dialog.text(row, col);
+            if (!text.isEmpty())
+                fields.insert(qMakePair(row + 1, col + 1), text);
+        }
+    }
+    return fields;
+}
+
+const char* const g_text =
+    "a,b,c\n"
+    "1,2.5,\"quoted, with delimiter\"\r\n"
+    "\"doubled \"\"quote\"\"\",,last\r"
+    "\"multi\nline\",x\n"
+    "\n"
+    "trailing,no line end";
+
+} // namespace
+
+void TestKoCsvTokenizer::initTestCase()
+{
+    // the dialog reads and writes its settings
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestKoCsvTokenizer::testFields()
+{
+    const Fields fields = tokenize(QString::fromUtf8(g_text), ",", 1024);
+
+    QCOMPARE(fields.value(qMakePair(1, 1)), QString("a"));
+    QCOMPARE(fields.value(qMakePair(1, 3)), QString("c"));
+    QCOMPARE(fields.value(qMakePair(2, 2)), QString("2.5"));
+    QCOMPARE(fields.value(qMakePair(2, 3)), QString("quoted, with delimiter"));
+    QCOMPARE(fields.value(qMakePair(3, 1)), QString("doubled \"quote\""));
+    QVERIFY(!fields.contains(qMakePair(3, 2)));
+    QCOMPARE(fields.value(qMakePair(3, 3)), QString("last"));
+    // a line end ends even a quoted field
+    QCOMPARE(fields.value(qMakePair(4, 1)), QString("multi"));
+    QCOMPARE(fields.value(qMakePair(5, 1)), QString("line\""));
+    QCOMPARE(fields.value(qMakePair(7, 2)), QString("no line end"));
+}
+
+void TestKoCsvTokenizer::testChunks_data()
+{
+    QTest::addColumn<QString>("delimiter");
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("comma, 1") << "," << 1;
+    QTest::newRow("comma, 7") << "," << 7;
+    QTest::newRow("comma, all") << "," << 1024;
+    QTest::newRow("multiple characters, 1") << "::" << 1;
+    QTest::newRow("multiple characters, 5") << "::" << 5;
+}
+
+void TestKoCsvTokenizer::testChunks()
+{
+    QFETCH(QString, delimiter);
+    QFETCH(int, chunkSize);
+
+    QString text = QString::fromUtf8(g_text);
+    text.replace(',', delimiter);
+
+    const Fields fields = tokenize(text, delimiter, chunkSize);
+    QVERIFY(!fields.isEmpty());
+    QCOMPARE(fields, dialogFields(text, delimiter));
+}
+
+QTEST_MAIN(TestKoCsvTokenizer)
@@ -64,13 +64,20 @@ KoShape* StencilShapeFactory::
 createFromOdf(KoStore* store, KoDocumentResourceManager* documentRes) const
 {
     KoOdfReadStore odfStore(store);
+    // only the first page is used; styles() reuses its skimmed automatic styles
+    odfStore.setLazyParsing(true);
     QString errorMessage;
     if (! odfStore.loadAndParse(errorMessage)) {
         errorStencilBox << "loading and parsing failed:" << errorMessage << endl;
         return 0;
     }
 
-    KoXmlElement content = odfStore.contentDoc().documentElement();
+    KoXmlDocument contentDoc;
+    if (! odfStore.skimContent(1, contentDoc, errorMessage)) {
+        errorStencilBox << "loading and parsing failed:" << errorMessage << endl;
+        return 0;
+    }
+    KoXmlElement content = contentDoc.documentElement();
     KoXmlElement realBody(KoXml::namedItemNS(content, KoXmlNS::office, "body"));
     if (realBody.isNull()) {
         errorStencilBox << "No body tag found!" << endl;
@@ -99,6 +106,9 @@ createFromOdf(KoStore* store, KoDocumentResourceManager* documentRes) const
     }
 
     KoOdfLoadingContext loadingContext(odfStore.styles(), odfStore.store());
+    if (!odfStore.lastError().isEmpty()) {
+        warnStencilBox << "loading the styles failed:" << odfStore.lastError();
+    }
     KoShapeLoadingContext context(loadingContext, documentRes);
 
     KoShapeRegistry* registry = KoShapeRegistry::instance();
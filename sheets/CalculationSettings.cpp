@@ -47,6 +47,8 @@ public:
     bool useRegularExpressions    : 1;
     bool useWildcards             : 1;
     bool automaticCalculation     : 1;
+    bool parallelCalculation      : 1;
+    int threadCount; // the maximum number of threads for parallel recalculations
     int refYear; // the reference year two-digit years are relative to
     QDate refDate; // the reference date all dates are relative to
     // The precision used for decimal numbers, if the default cell style's
@@ -72,6 +74,8 @@ CalculationSettings::CalculationSettings()
     d->useRegularExpressions    = true;
     d->useWildcards             = false;
     d->automaticCalculation     = true;
+    d->parallelCalculation      = false;
+    d->threadCount = 0;
     d->refYear = 1930;
     d->refDate = QDate(1899, 12, 30);
     d->precision = -1;
@@ -198,3 +202,23 @@ bool CalculationSettings::useWildcards() const
 {
     return d->useWildcards;
 }
+
+void CalculationSettings::setParallelCalculationEnabled(bool enable)
+{
+    d->parallelCalculation = enable;
+}
+
+bool CalculationSettings::isParallelCalculationEnabled() const
+{
+    return d->parallelCalculation;
+}
+
+void CalculationSettings::setCalculationThreadCount(int count)
+{
+    d->threadCount = qMax(0, count);
+}
+
+int CalculationSettings::calculationThreadCount() const
+{
+    return d->threadCount;
+}
@@ -182,6 +182,35 @@ public:
     void setUseWildcards(bool enabled);
     bool useWildcards() const;
 
+    /**
+     * Enables the parallel recalculation.
+     * If enabled, the cells sharing the same reference depth are evaluated
+     * concurrently by a pool of worker threads. The results are stored
+     * afterwards in the same order as in a serial recalculation.
+     *
+     * This is an application setting and not saved in the document.
+     * \see RecalcManager
+     */
+    void setParallelCalculationEnabled(bool enable);
+
+    /**
+     * \return \c true, if cells are recalculated concurrently (default: \c false)
+     */
+    bool isParallelCalculationEnabled() const;
+
+    /**
+     * Sets the maximum number of threads used for the parallel recalculation.
+     * A value below one means, that the number of threads is chosen by the
+     * number of available processor cores.
+     */
+    void setCalculationThreadCount(int count);
+
+    /**
+     * \return the maximum number of threads used for the parallel
+     * recalculation (default: 0, i.e. one per processor core)
+     */
+    int calculationThreadCount() const;
+
 private:
     class Private;
     Private * const d;
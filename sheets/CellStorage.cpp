@@ -25,8 +25,6 @@
 // Qt
 #ifdef CALLIGRA_SHEETS_MT
 #include <QReadWriteLock>
-#include <QReadLocker>
-#include <QWriteLocker>
 #endif
 
 // Calligra
@@ -44,6 +42,7 @@
 #include "RectStorage.h"
 #include "RowRepeatStorage.h"
 #include "Sheet.h"
+#include "StringPool.h"
 #include "StyleStorage.h"
 #include "ValidityStorage.h"
 #include "ValueStorage.h"
@@ -63,6 +62,73 @@ using namespace Calligra::Sheets;
 
 typedef RectStorage<QString> NamedAreaStorage;
 
+#ifdef CALLIGRA_SHEETS_MT
+namespace
+{
+// Each storage has its own lock. If several locks are needed, they are
+// acquired at once and always in this order to avoid deadlocks.
+enum StorageLock {
+    BindingLock     = 0x0001,
+    CommentLock     = 0x0002,
+    ConditionsLock  = 0x0004,
+    DatabaseLock    = 0x0008,
+    FormulaLock     = 0x0010,
+    FusionLock      = 0x0020,
+    LinkLock        = 0x0040,
+    MatrixLock      = 0x0080,
+    NamedAreaLock   = 0x0100,
+    StyleLock       = 0x0200,
+    UserInputLock   = 0x0400,
+    ValidityLock    = 0x0800,
+    ValueLock       = 0x1000,
+    RichTextLock    = 0x2000,
+    RowRepeatLock   = 0x4000,
+    AllLocks        = 0x7FFF
+};
+const int g_storageLockCount = 15;
+
+// Setters call each other, e.g. setValue() calls unlockCells() and vice versa.
+// Note, that a thread holding a write lock must not acquire the read lock.
+class StorageReadWriteLock : public QReadWriteLock
+{
+public:
+    StorageReadWriteLock() : QReadWriteLock(QReadWriteLock::Recursive) {}
+};
+
+class StorageLocker
+{
+public:
+    enum Mode { Read, Write };
+
+    StorageLocker(StorageReadWriteLock* locks, int storages, Mode mode)
+            : m_locks(locks)
+            , m_storages(storages) {
+        for (int i = 0; i < g_storageLockCount; ++i) {
+            if (!(m_storages & (1 << i)))
+                continue;
+            if (mode == Write)
+                m_locks[i].lockForWrite();
+            else
+                m_locks[i].lockForRead();
+        }
+    }
+
+    ~StorageLocker() {
+        for (int i = g_storageLockCount - 1; i >= 0; --i) {
+            if (m_storages & (1 << i))
+                m_locks[i].unlock();
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(StorageLocker)
+
+    StorageReadWriteLock* const m_locks;
+    const int m_storages;
+};
+} // namespace
+#endif
+
 class Q_DECL_HIDDEN CellStorage::Private
 {
 public:
@@ -84,9 +150,6 @@ public:
             , richTextStorage(new RichTextStorage())
             , rowRepeatStorage(new RowRepeatStorage())
             , undoData(0)
-#ifdef CALLIGRA_SHEETS_MT
-            , bigUglyLock(QReadWriteLock::Recursive)
-#endif
     {}
 
     Private(const Private& other, Sheet* sheet)
@@ -107,9 +170,6 @@ public:
             , richTextStorage(new RichTextStorage(*other.richTextStorage))
             , rowRepeatStorage(new RowRepeatStorage(*other.rowRepeatStorage))
             , undoData(0)
-#ifdef CALLIGRA_SHEETS_MT
-            , bigUglyLock(QReadWriteLock::Recursive)
-#endif
     {}
 
     ~Private() {
@@ -151,7 +211,8 @@ public:
     CellStorageUndoData*    undoData;
 
 #ifdef CALLIGRA_SHEETS_MT
-    QReadWriteLock bigUglyLock;
+    // indexed by the bit of the StorageLock
+    mutable StorageReadWriteLock locks[g_storageLockCount];
 #endif
 };
 
@@ -261,7 +322,7 @@ Sheet* CellStorage::sheet() const
 void CellStorage::take(int col, int row)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | LinkLock | UserInputLock | ValueLock | RichTextLock | RowRepeatLock, StorageLocker::Write);
 #endif
 
     Formula oldFormula;
@@ -279,7 +340,7 @@ void CellStorage::take(int col, int row)
     if (!d->sheet->map()->isLoading()) {
         // Trigger a recalculation of the consuming cells.
         CellDamage::Changes changes = CellDamage:: Binding | CellDamage::Formula | CellDamage::Value;
-        d->sheet->map()->addDamage(new CellDamage(Cell(d->sheet, col, row), changes));
+        d->sheet->map()->addCellDamage(d->sheet, QRect(col, row, 1, 1), changes);
 
         d->rowRepeatStorage->setRowRepeat(row, 1);
     }
@@ -287,7 +348,7 @@ void CellStorage::take(int col, int row)
     int prevCol;
     Value v = d->valueStorage->prevInRow(col, row, &prevCol);
     if (!v.isEmpty())
-        d->sheet->map()->addDamage(new CellDamage(Cell(d->sheet, prevCol, row), CellDamage::Appearance));
+        d->sheet->map()->addCellDamage(d->sheet, QRect(prevCol, row, 1, 1), CellDamage::Appearance);
 
 
     // recording undo?
@@ -303,7 +364,7 @@ void CellStorage::take(int col, int row)
 Binding CellStorage::binding(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, BindingLock, StorageLocker::Read);
 #endif
     return d->bindingStorage->contains(QPoint(column, row));
 }
@@ -311,7 +372,7 @@ Binding CellStorage::binding(int column, int row) const
 void CellStorage::setBinding(const Region& region, const Binding& binding)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, BindingLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -323,7 +384,7 @@ void CellStorage::setBinding(const Region& region, const Binding& binding)
 void CellStorage::removeBinding(const Region& region, const Binding& binding)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, BindingLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData) {
@@ -335,7 +396,7 @@ void CellStorage::removeBinding(const Region& region, const Binding& binding)
 QString CellStorage::comment(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, CommentLock, StorageLocker::Read);
 #endif
     return d->commentStorage->contains(QPoint(column, row));
 }
@@ -343,7 +404,7 @@ QString CellStorage::comment(int column, int row) const
 void CellStorage::setComment(const Region& region, const QString& comment)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, CommentLock | RowRepeatLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -361,7 +422,7 @@ void CellStorage::setComment(const Region& region, const QString& comment)
 Conditions CellStorage::conditions(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, ConditionsLock, StorageLocker::Read);
 #endif
     return d->conditionsStorage->contains(QPoint(column, row));
 }
@@ -369,7 +430,7 @@ Conditions CellStorage::conditions(int column, int row) const
 void CellStorage::setConditions(const Region& region, Conditions conditions)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, ConditionsLock | RowRepeatLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -387,7 +448,7 @@ void CellStorage::setConditions(const Region& region, Conditions conditions)
 Database CellStorage::database(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, DatabaseLock, StorageLocker::Read);
 #endif
     QPair<QRectF, Database> pair = d->databaseStorage->containedPair(QPoint(column, row));
     if (pair.first.isEmpty())
@@ -403,7 +464,7 @@ Database CellStorage::database(int column, int row) const
 QList< QPair<QRectF, Database> > CellStorage::databases(const Region& region) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, DatabaseLock, StorageLocker::Read);
 #endif
     return d->databaseStorage->intersectingPairs(region);
 }
@@ -411,7 +472,7 @@ QList< QPair<QRectF, Database> > CellStorage::databases(const Region& region) co
 void CellStorage::setDatabase(const Region& region, const Database& database)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, DatabaseLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -423,7 +484,7 @@ void CellStorage::setDatabase(const Region& region, const Database& database)
 Formula CellStorage::formula(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock, StorageLocker::Read);
 #endif
     return d->formulaStorage->lookup(column, row, Formula::empty());
 }
@@ -431,7 +492,7 @@ Formula CellStorage::formula(int column, int row) const
 void CellStorage::setFormula(int column, int row, const Formula& formula)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | ValueLock | RowRepeatLock, StorageLocker::Write);
 #endif
     Formula old = Formula::empty();
     if (formula.expression().isEmpty())
@@ -443,7 +504,7 @@ void CellStorage::setFormula(int column, int row, const Formula& formula)
     if (formula != old) {
         if (!d->sheet->map()->isLoading()) {
             // trigger an update of the dependencies and a recalculation
-            d->sheet->map()->addDamage(new CellDamage(Cell(d->sheet, column, row), CellDamage::Formula | CellDamage::Value));
+            d->sheet->map()->addCellDamage(d->sheet, QRect(column, row, 1, 1), CellDamage::Formula | CellDamage::Value);
             d->rowRepeatStorage->setRowRepeat(row, 1);
         }
         // recording undo?
@@ -453,7 +514,7 @@ void CellStorage::setFormula(int column, int row, const Formula& formula)
             // because the new value is calculated later by the damage
             // processing and is not recorded for undoing.
             if (old == Formula())
-                d->undoData->values << qMakePair(QPoint(column, row), value(column, row));
+                d->undoData->values << qMakePair(QPoint(column, row), d->valueStorage->lookup(column, row));
         }
     }
 }
@@ -461,7 +522,7 @@ void CellStorage::setFormula(int column, int row, const Formula& formula)
 QString CellStorage::link(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, LinkLock, StorageLocker::Read);
 #endif
     return d->linkStorage->lookup(column, row);
 }
@@ -469,7 +530,7 @@ QString CellStorage::link(int column, int row) const
 void CellStorage::setLink(int column, int row, const QString& link)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, LinkLock | RowRepeatLock, StorageLocker::Write);
 #endif
     QString old;
     if (link.isEmpty())
@@ -487,7 +548,7 @@ void CellStorage::setLink(int column, int row, const QString& link)
 QString CellStorage::namedArea(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, NamedAreaLock, StorageLocker::Read);
 #endif
     QPair<QRectF, QString> pair = d->namedAreaStorage->containedPair(QPoint(column, row));
     if (pair.first.isEmpty())
@@ -500,7 +561,7 @@ QString CellStorage::namedArea(int column, int row) const
 QList< QPair<QRectF, QString> > CellStorage::namedAreas(const Region& region) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, NamedAreaLock, StorageLocker::Read);
 #endif
     return d->namedAreaStorage->intersectingPairs(region);
 }
@@ -508,7 +569,7 @@ QList< QPair<QRectF, QString> > CellStorage::namedAreas(const Region& region) co
 void CellStorage::setNamedArea(const Region& region, const QString& namedArea)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, NamedAreaLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -520,7 +581,7 @@ void CellStorage::setNamedArea(const Region& region, const QString& namedArea)
 void CellStorage::removeNamedArea(const Region& region, const QString& namedArea)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, NamedAreaLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -538,7 +599,7 @@ void CellStorage::emitInsertNamedArea(const Region &region, const QString &named
 Style CellStorage::style(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, StyleLock, StorageLocker::Read);
 #endif
     return d->styleStorage->contains(QPoint(column, row));
 }
@@ -546,7 +607,7 @@ Style CellStorage::style(int column, int row) const
 Style CellStorage::style(const QRect& rect) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, StyleLock, StorageLocker::Read);
 #endif
     return d->styleStorage->contains(rect);
 }
@@ -554,7 +615,7 @@ Style CellStorage::style(const QRect& rect) const
 void CellStorage::setStyle(const Region& region, const Style& style)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, StyleLock | RowRepeatLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -572,7 +633,7 @@ void CellStorage::setStyle(const Region& region, const Style& style)
 void CellStorage::insertSubStyle(const QRect &rect, const SharedSubStyle &subStyle)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, StyleLock | RowRepeatLock, StorageLocker::Write);
 #endif
     d->styleStorage->insert(rect, subStyle);
     if (!d->sheet->map()->isLoading()) {
@@ -584,7 +645,7 @@ void CellStorage::insertSubStyle(const QRect &rect, const SharedSubStyle &subSty
 QString CellStorage::userInput(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, UserInputLock, StorageLocker::Read);
 #endif
     return d->userInputStorage->lookup(column, row);
 }
@@ -592,13 +653,13 @@ QString CellStorage::userInput(int column, int row) const
 void CellStorage::setUserInput(int column, int row, const QString& userInput)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, UserInputLock | RowRepeatLock, StorageLocker::Write);
 #endif
     QString old;
     if (userInput.isEmpty())
         old = d->userInputStorage->take(column, row);
     else
-        old = d->userInputStorage->insert(column, row, userInput);
+        old = d->userInputStorage->insert(column, row, d->sheet->map()->stringPool()->intern(userInput, d->sheet));
 
     // recording undo?
     if (d->undoData && userInput != old)
@@ -610,7 +671,7 @@ void CellStorage::setUserInput(int column, int row, const QString& userInput)
 QSharedPointer<QTextDocument> CellStorage::richText(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, RichTextLock, StorageLocker::Read);
 #endif
     return d->richTextStorage->lookup(column, row);
 }
@@ -618,7 +679,7 @@ QSharedPointer<QTextDocument> CellStorage::richText(int column, int row) const
 void CellStorage::setRichText(int column, int row, QSharedPointer<QTextDocument> text)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, RichTextLock, StorageLocker::Write);
 #endif
     QSharedPointer<QTextDocument> old;
     if (text.isNull())
@@ -634,7 +695,7 @@ void CellStorage::setRichText(int column, int row, QSharedPointer<QTextDocument>
 Validity CellStorage::validity(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, ValidityLock, StorageLocker::Read);
 #endif
     return d->validityStorage->contains(QPoint(column, row));
 }
@@ -642,7 +703,7 @@ Validity CellStorage::validity(int column, int row) const
 void CellStorage::setValidity(const Region& region, Validity validity)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, ValidityLock | RowRepeatLock, StorageLocker::Write);
 #endif
     // recording undo?
     if (d->undoData)
@@ -660,7 +721,7 @@ void CellStorage::setValidity(const Region& region, Validity validity)
 Value CellStorage::value(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, ValueLock, StorageLocker::Read);
 #endif
     return d->valueStorage->lookup(column, row);
 }
@@ -668,7 +729,7 @@ Value CellStorage::value(int column, int row) const
 Value CellStorage::valueRegion(const Region& region) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, ValueLock, StorageLocker::Read);
 #endif
     // create a subStorage with adjusted origin
     return Value(d->valueStorage->subStorage(region, false), region.boundingRect().size());
@@ -677,7 +738,7 @@ Value CellStorage::valueRegion(const Region& region) const
 void CellStorage::setValue(int column, int row, const Value& value)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, MatrixLock | ValueLock | RowRepeatLock, StorageLocker::Write);
 #endif
     // release any lock
     unlockCells(column, row);
@@ -686,7 +747,7 @@ void CellStorage::setValue(int column, int row, const Value& value)
     if (value.isEmpty())
         old = d->valueStorage->take(column, row);
     else
-        old = d->valueStorage->insert(column, row, value);
+        old = d->valueStorage->insert(column, row, d->sheet->map()->stringPool()->intern(value, d->sheet));
 
     // value changed?
     if (value != old) {
@@ -697,12 +758,12 @@ void CellStorage::setValue(int column, int row, const Value& value)
             // already in a recalculation process.
             if (!d->sheet->map()->recalcManager()->isActive())
                 changes |= CellDamage::Value;
-            d->sheet->map()->addDamage(new CellDamage(Cell(d->sheet, column, row), changes));
+            d->sheet->map()->addCellDamage(d->sheet, QRect(column, row, 1, 1), changes);
             // Also trigger a relayouting of the first non-empty cell to the left of this one
             int prevCol;
             Value v = d->valueStorage->prevInRow(column, row, &prevCol);
             if (!v.isEmpty())
-                d->sheet->map()->addDamage(new CellDamage(Cell(d->sheet, prevCol, row), CellDamage::Appearance));
+                d->sheet->map()->addCellDamage(d->sheet, QRect(prevCol, row, 1, 1), CellDamage::Appearance);
             d->rowRepeatStorage->setRowRepeat(row, 1);
         }
         // recording undo?
@@ -714,7 +775,7 @@ void CellStorage::setValue(int column, int row, const Value& value)
 bool CellStorage::doesMergeCells(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FusionLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->fusionStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -730,7 +791,7 @@ bool CellStorage::doesMergeCells(int column, int row) const
 bool CellStorage::isPartOfMerged(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FusionLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->fusionStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -746,7 +807,7 @@ bool CellStorage::isPartOfMerged(int column, int row) const
 void CellStorage::mergeCells(int column, int row, int numXCells, int numYCells)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FusionLock | RowRepeatLock, StorageLocker::Write);
 #endif
     // Start by unmerging the cells that we merge right now
     const QPair<QRectF, bool> pair = d->fusionStorage->containedPair(QPoint(column, row));
@@ -762,7 +823,7 @@ void CellStorage::mergeCells(int column, int row, int numXCells, int numYCells)
 Cell CellStorage::masterCell(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FusionLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->fusionStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -775,7 +836,7 @@ Cell CellStorage::masterCell(int column, int row) const
 int CellStorage::mergedXCells(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FusionLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->fusionStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -789,7 +850,7 @@ int CellStorage::mergedXCells(int column, int row) const
 int CellStorage::mergedYCells(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FusionLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->fusionStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -803,7 +864,7 @@ int CellStorage::mergedYCells(int column, int row) const
 QList<Cell> CellStorage::masterCells(const Region& region) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FusionLock, StorageLocker::Read);
 #endif
     const QList<QPair<QRectF, bool> > pairs = d->fusionStorage->intersectingPairs(region);
     if (pairs.isEmpty())
@@ -822,7 +883,7 @@ QList<Cell> CellStorage::masterCells(const Region& region) const
 bool CellStorage::locksCells(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, MatrixLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->matrixStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -838,7 +899,7 @@ bool CellStorage::locksCells(int column, int row) const
 bool CellStorage::isLocked(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, MatrixLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->matrixStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -854,7 +915,7 @@ bool CellStorage::isLocked(int column, int row) const
 bool CellStorage::hasLockedCells(const Region& region) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, MatrixLock, StorageLocker::Read);
 #endif
     typedef QPair<QRectF, bool> RectBoolPair;
     QList<QPair<QRectF, bool> > pairs = d->matrixStorage->intersectingPairs(region);
@@ -880,7 +941,7 @@ bool CellStorage::hasLockedCells(const Region& region) const
 void CellStorage::lockCells(const QRect& rect)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, MatrixLock, StorageLocker::Write);
 #endif
     // Start by unlocking the cells that we lock right now
     const QPair<QRectF, bool> pair = d->matrixStorage->containedPair(rect.topLeft());  // FIXME
@@ -894,7 +955,7 @@ void CellStorage::lockCells(const QRect& rect)
 void CellStorage::unlockCells(int column, int row)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, MatrixLock | ValueLock | RowRepeatLock, StorageLocker::Write);
 #endif
     const QPair<QRectF, bool> pair = d->matrixStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -920,7 +981,7 @@ void CellStorage::unlockCells(int column, int row)
 QRect CellStorage::lockedCells(int column, int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, MatrixLock, StorageLocker::Read);
 #endif
     const QPair<QRectF, bool> pair = d->matrixStorage->containedPair(QPoint(column, row));
     if (pair.first.isNull())
@@ -935,14 +996,14 @@ QRect CellStorage::lockedCells(int column, int row) const
 void CellStorage::insertColumns(int position, int number)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     // FIXME Stefan: Would it be better to directly alter the dependency tree?
     // TODO Stefan: Optimize: Avoid the double creation of the sub-storages, but don't process
     //              formulas, that will get out of bounds after the operation.
     const Region invalidRegion(QRect(QPoint(position, 1), QPoint(KS_colMax, KS_rowMax)), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -997,11 +1058,11 @@ void CellStorage::insertColumns(int position, int number)
 void CellStorage::removeColumns(int position, int number)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     const Region invalidRegion(QRect(QPoint(position, 1), QPoint(KS_colMax, KS_rowMax)), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -1057,11 +1118,11 @@ void CellStorage::removeColumns(int position, int number)
 void CellStorage::insertRows(int position, int number)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     const Region invalidRegion(QRect(QPoint(1, position), QPoint(KS_colMax, KS_rowMax)), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -1118,11 +1179,11 @@ void CellStorage::insertRows(int position, int number)
 void CellStorage::removeRows(int position, int number)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     const Region invalidRegion(QRect(QPoint(1, position), QPoint(KS_colMax, KS_rowMax)), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -1180,11 +1241,11 @@ void CellStorage::removeRows(int position, int number)
 void CellStorage::removeShiftLeft(const QRect& rect)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     const Region invalidRegion(QRect(rect.topLeft(), QPoint(KS_colMax, rect.bottom())), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -1242,11 +1303,11 @@ void CellStorage::removeShiftLeft(const QRect& rect)
 void CellStorage::insertShiftRight(const QRect& rect)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     const Region invalidRegion(QRect(rect.topLeft(), QPoint(KS_colMax, rect.bottom())), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -1303,11 +1364,11 @@ void CellStorage::insertShiftRight(const QRect& rect)
 void CellStorage::removeShiftUp(const QRect& rect)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     const Region invalidRegion(QRect(rect.topLeft(), QPoint(rect.right(), KS_rowMax)), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -1365,11 +1426,11 @@ void CellStorage::removeShiftUp(const QRect& rect)
 void CellStorage::insertShiftDown(const QRect& rect)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, AllLocks, StorageLocker::Write);
 #endif
     // Trigger a dependency update of the cells, which have a formula. (old positions)
     const Region invalidRegion(QRect(rect.topLeft(), QPoint(rect.right(), KS_rowMax)), d->sheet);
-    PointStorage<Formula> subStorage = d->formulaStorage->subStorage(invalidRegion);
+    FormulaStorageBase subStorage = d->formulaStorage->subStorage(invalidRegion);
     Cell cell;
     for (int i = 0; i < subStorage.count(); ++i) {
         cell = Cell(d->sheet, subStorage.col(i), subStorage.row(i));
@@ -1426,7 +1487,7 @@ void CellStorage::insertShiftDown(const QRect& rect)
 Cell CellStorage::firstInColumn(int col, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | ValueLock, StorageLocker::Read);
 #endif
     Q_UNUSED(visiting);
 
@@ -1445,7 +1506,7 @@ Cell CellStorage::firstInColumn(int col, Visiting visiting) const
 Cell CellStorage::firstInRow(int row, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | StyleLock | ValueLock, StorageLocker::Read);
 #endif
     int newCol = 0;
     int tmpCol = 0;
@@ -1467,7 +1528,7 @@ Cell CellStorage::firstInRow(int row, Visiting visiting) const
 Cell CellStorage::lastInColumn(int col, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | ValueLock, StorageLocker::Read);
 #endif
     Q_UNUSED(visiting);
     int newRow = 0;
@@ -1484,7 +1545,7 @@ Cell CellStorage::lastInColumn(int col, Visiting visiting) const
 Cell CellStorage::lastInRow(int row, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | ValueLock, StorageLocker::Read);
 #endif
     Q_UNUSED(visiting);
     int newCol = 0;
@@ -1501,7 +1562,7 @@ Cell CellStorage::lastInRow(int row, Visiting visiting) const
 Cell CellStorage::nextInColumn(int col, int row, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | ValueLock, StorageLocker::Read);
 #endif
     Q_UNUSED(visiting);
     int newRow = 0;
@@ -1519,7 +1580,7 @@ Cell CellStorage::nextInColumn(int col, int row, Visiting visiting) const
 Cell CellStorage::nextInRow(int col, int row, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | StyleLock | ValueLock, StorageLocker::Read);
 #endif
     int newCol = 0;
     int tmpCol = 0;
@@ -1541,7 +1602,7 @@ Cell CellStorage::nextInRow(int col, int row, Visiting visiting) const
 Cell CellStorage::prevInColumn(int col, int row, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | ValueLock, StorageLocker::Read);
 #endif
     Q_UNUSED(visiting);
     int newRow = 0;
@@ -1558,7 +1619,7 @@ Cell CellStorage::prevInColumn(int col, int row, Visiting visiting) const
 Cell CellStorage::prevInRow(int col, int row, Visiting visiting) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | ValueLock, StorageLocker::Read);
 #endif
     Q_UNUSED(visiting);
     int newCol = 0;
@@ -1575,7 +1636,7 @@ Cell CellStorage::prevInRow(int col, int row, Visiting visiting) const
 int CellStorage::columns(bool includeStyles) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, CommentLock | ConditionsLock | FormulaLock | FusionLock | LinkLock | StyleLock | ValidityLock | ValueLock, StorageLocker::Read);
 #endif
     int max = 0;
     max = qMax(max, d->commentStorage->usedArea().right());
@@ -1596,7 +1657,7 @@ int CellStorage::columns(bool includeStyles) const
 int CellStorage::rows(bool includeStyles) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, CommentLock | ConditionsLock | FormulaLock | FusionLock | LinkLock | StyleLock | ValidityLock | ValueLock, StorageLocker::Read);
 #endif
     int max = 0;
     max = qMax(max, d->commentStorage->usedArea().bottom());
@@ -1617,7 +1678,7 @@ int CellStorage::rows(bool includeStyles) const
 CellStorage CellStorage::subStorage(const Region& region) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, FormulaLock | LinkLock | ValueLock, StorageLocker::Read);
 #endif
     CellStorage subStorage(d->sheet);
     *subStorage.d->formulaStorage = d->formulaStorage->subStorage(region);
@@ -1656,6 +1717,11 @@ const LinkStorage* CellStorage::linkStorage() const
     return d->linkStorage;
 }
 
+const RichTextStorage* CellStorage::richTextStorage() const
+{
+    return d->richTextStorage;
+}
+
 const StyleStorage* CellStorage::styleStorage() const
 {
     return d->styleStorage;
@@ -1678,9 +1744,6 @@ const ValueStorage* CellStorage::valueStorage() const
 
 void CellStorage::startUndoRecording()
 {
-#ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
-#endif
     // If undoData is not null, the recording wasn't stopped.
     // Should not happen, hence this assertion.
     Q_ASSERT(d->undoData == 0);
@@ -1689,9 +1752,6 @@ void CellStorage::startUndoRecording()
 
 void CellStorage::stopUndoRecording(KUndo2Command *parent)
 {
-#ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
-#endif
     // If undoData is null, the recording wasn't started.
     // Should not happen, hence this assertion.
     Q_ASSERT(d->undoData != 0);
@@ -1707,7 +1767,7 @@ void CellStorage::stopUndoRecording(KUndo2Command *parent)
 void CellStorage::loadConditions(const QList<QPair<QRegion, Conditions> >& conditions)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, ConditionsLock, StorageLocker::Write);
 #endif
     d->conditionsStorage->load(conditions);
 }
@@ -1715,7 +1775,7 @@ void CellStorage::loadConditions(const QList<QPair<QRegion, Conditions> >& condi
 void CellStorage::loadStyles(const QList<QPair<QRegion, Style> > &styles)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, StyleLock, StorageLocker::Write);
 #endif
     d->styleStorage->load(styles);
 }
@@ -1728,7 +1788,7 @@ void CellStorage::invalidateStyleCache()
 int CellStorage::rowRepeat(int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, RowRepeatLock, StorageLocker::Read);
 #endif
     return d->rowRepeatStorage->rowRepeat(row);
 }
@@ -1736,7 +1796,7 @@ int CellStorage::rowRepeat(int row) const
 int CellStorage::firstIdenticalRow(int row) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker rl(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, RowRepeatLock, StorageLocker::Read);
 #endif
     return d->rowRepeatStorage->firstIdenticalRow(row);
 }
@@ -1744,7 +1804,7 @@ int CellStorage::firstIdenticalRow(int row) const
 void CellStorage::setRowsRepeated(int row, int count)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->bigUglyLock);
+    const StorageLocker locker(d->locks, RowRepeatLock, StorageLocker::Write);
 #endif
     d->rowRepeatStorage->setRowRepeat(row, count);
 }
@@ -67,6 +67,14 @@ class ValueStorage;
  * \author Stefan Nikolaus <stefan.nikolaus@kdemail.net>
  *
  * \note If you fill the storage, do it row-wise. That's more performant.
+ * \note The lookups of values and formulas, i.e. value(), valueRegion() and
+ *       formula(), do not alter the storage. They may be called from several
+ *       threads at once, as long as no data is changed meanwhile.
+ * \note If built with CALLIGRA_SHEETS_MT, each of the wrapped storages is
+ *       guarded by its own read/write lock. All lookups may then be called
+ *       from several threads, while one thread changes the data. Lookups of
+ *       different kinds of data, e.g. values and styles, do not block each
+ *       other. The storages returned by valueStorage() etc. are not guarded.
  */
 class CALLIGRA_SHEETS_ODF_EXPORT CellStorage : public QObject
 {
@@ -379,6 +387,7 @@ public:
     const FormulaStorage* formulaStorage() const;
     const FusionStorage* fusionStorage() const;
     const LinkStorage* linkStorage() const;
+    const RichTextStorage* richTextStorage() const;
     const StyleStorage* styleStorage() const;
     const UserInputStorage* userInputStorage() const;
     const ValidityStorage* validityStorage() const;
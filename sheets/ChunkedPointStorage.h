@@ -0,0 +1,644 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_CHUNKED_POINT_STORAGE
+#define CALLIGRA_SHEETS_CHUNKED_POINT_STORAGE
+
+#include <QPair>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+#include "PointStorage.h"
+#include "Region.h"
+#include "calligra_sheets_limits.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+/**
+ * \ingroup Storage
+ * A pointwise storage split into blocks of rows.
+ * Offers the same interface as PointStorage.
+ *
+ * PointStorage keeps all data in one compressed sparse matrix. Inserting a
+ * value in front of other data moves all following data and adjusts all
+ * following row offsets. Filling a large sheet in random order, as e.g.
+ * done by a recalculation or a paste, becomes quadratic.
+ *
+ * This storage consists of a PointStorage for each block of \p ChunkRows rows.
+ * Insertions, lookups and removals only touch the block containing the
+ * row, hence their costs do not depend on the amount of data in other
+ * blocks. Access by index, i.e. col(), row() and data(), uses the index of
+ * the first data of each block. Updating these offsets costs one integer per
+ * following block, which is far less than moving the following data.
+ * Reading never alters the storage, so several threads may read it at once,
+ * e.g. during a parallel recalculation, as they may read a PointStorage.
+ *
+ * Operations moving data between rows, i.e. insertRows(), removeRows(),
+ * removeShiftUp() and insertShiftDown(), are done on a flat PointStorage
+ * and are linear in the amount of data, as they are for PointStorage.
+ *
+ * ValueStorage and FormulaStorage are based on it, if the CMake option
+ * CALLIGRA_SHEETS_CHUNKED_STORAGE is enabled.
+ *
+ * \see PointStorage
+ */
+template<typename T, int ChunkRows = 256>
+class ChunkedPointStorage
+{
+    friend class PointStorageBenchmark;
+    friend class PointStorageTest;
+
+public:
+    /**
+     * Constructor.
+     * Creates an empty storage.
+     */
+    ChunkedPointStorage()
+            : m_count(0) {
+    }
+
+    /**
+     * Creates a storage with the data of \p storage .
+     */
+    ChunkedPointStorage(const PointStorage<T>& storage)  //krazy:exclude=explicit
+            : m_count(0) {
+        fromPointStorage(storage);
+    }
+
+    /**
+     * Removes all data.
+     */
+    void clear() {
+        m_chunks.clear();
+        m_offsets.clear();
+        m_count = 0;
+    }
+
+    /**
+     * Returns the number of items in the storage.
+     * Usable to iterate over all non-default data.
+     * \return number of items
+     * \see col()
+     * \see row()
+     * \see data()
+     */
+    int count() const {
+        return m_count;
+    }
+
+    /**
+     * Inserts \p data at \p col , \p row .
+     * \return the overridden data (default data, if no overwrite)
+     */
+    T insert(int col, int row, const T& data) {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count()) {
+            // the new blocks follow all data
+            const int chunks = m_chunks.count();
+            m_chunks.resize(chunk + 1);
+            m_offsets.resize(chunk + 1);
+            for (int i = chunks; i <= chunk; ++i)
+                m_offsets[i] = m_count;
+        }
+        PointStorage<T>& storage = m_chunks[chunk];
+        const int count = storage.count();
+        const T oldData = storage.insert(col, localRow(row), data);
+        dataCountChanged(chunk, storage.count() - count);
+        return oldData;
+    }
+
+    /**
+     * Looks up the data at \p col , \p row . If no data was found returns a
+     * default object.
+     * \return the data at the given coordinate
+     */
+    T lookup(int col, int row, const T& defaultVal = T()) const {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count())
+            return defaultVal;
+        return m_chunks.at(chunk).lookup(col, localRow(row), defaultVal);
+    }
+
+    /**
+     * Removes data at \p col , \p row .
+     * \return the removed data (default data, if none)
+     */
+    T take(int col, int row, const T& defaultVal = T()) {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count())
+            return defaultVal;
+        PointStorage<T>& storage = m_chunks[chunk];
+        const int count = storage.count();
+        const T oldData = storage.take(col, localRow(row), defaultVal);
+        dataCountChanged(chunk, storage.count() - count);
+        squeezeChunks();
+        return oldData;
+    }
+
+    /**
+     * Insert \p number columns at \p position .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertColumns(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int chunk = m_chunks.count() - 1; chunk >= 0; --chunk)
+            oldData += toGlobal(m_chunks[chunk].insertColumns(position, number), chunk);
+        updateOffsets();
+        return oldData;
+    }
+
+    /**
+     * Removes \p number columns at \p position .
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeColumns(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int chunk = m_chunks.count() - 1; chunk >= 0; --chunk)
+            oldData += toGlobal(m_chunks[chunk].removeColumns(position, number), chunk);
+        updateOffsets();
+        return oldData;
+    }
+
+    /**
+     * Insert \p number rows at \p position .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertRows(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_rowMax);
+        PointStorage<T> storage = toPointStorage();
+        const QVector< QPair<QPoint, T> > oldData = storage.insertRows(position, number);
+        fromPointStorage(storage);
+        return oldData;
+    }
+
+    /**
+     * Removes \p number rows at \p position .
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeRows(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_rowMax);
+        PointStorage<T> storage = toPointStorage();
+        const QVector< QPair<QPoint, T> > oldData = storage.removeRows(position, number);
+        fromPointStorage(storage);
+        return oldData;
+    }
+
+    /**
+     * Shifts the data right of \p rect to the left by the width of \p rect .
+     * The data formerly contained in \p rect becomes overridden.
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeShiftLeft(const QRect& rect) {
+        Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int chunk = qMin(chunkIndex(rect.bottom()), m_chunks.count() - 1); chunk >= chunkIndex(rect.top()); --chunk)
+            oldData += toGlobal(m_chunks[chunk].removeShiftLeft(localRect(rect, chunk)), chunk);
+        updateOffsets();
+        return oldData;
+    }
+
+    /**
+     * Shifts the data in and right of \p rect to the right by the width of \p rect .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertShiftRight(const QRect& rect) {
+        Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int chunk = chunkIndex(rect.top()); chunk <= chunkIndex(rect.bottom()) && chunk < m_chunks.count(); ++chunk)
+            oldData += toGlobal(m_chunks[chunk].insertShiftRight(localRect(rect, chunk)), chunk);
+        updateOffsets();
+        return oldData;
+    }
+
+    /**
+     * Shifts the data below \p rect to the top by the height of \p rect .
+     * The data formerly contained in \p rect becomes overridden.
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeShiftUp(const QRect& rect) {
+        Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
+        PointStorage<T> storage = toPointStorage();
+        const QVector< QPair<QPoint, T> > oldData = storage.removeShiftUp(rect);
+        fromPointStorage(storage);
+        return oldData;
+    }
+
+    /**
+     * Shifts the data in and below \p rect to the bottom by the height of \p rect .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertShiftDown(const QRect& rect) {
+        Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
+        PointStorage<T> storage = toPointStorage();
+        const QVector< QPair<QPoint, T> > oldData = storage.insertShiftDown(rect);
+        fromPointStorage(storage);
+        return oldData;
+    }
+
+    /**
+     * Retrieve the first used data in \p col .
+     * Can be used in conjunction with nextInColumn() to loop through a column.
+     * \return the first used data in \p col or the default data, if the column is empty.
+     */
+    T firstInColumn(int col, int* newRow = 0) const {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        return firstInColumn(col, 0, newRow);
+    }
+
+    /**
+     * Retrieve the first used data in \p row .
+     * Can be used in conjunction with nextInRow() to loop through a row.
+     * \return the first used data in \p row or the default data, if the row is empty.
+     */
+    T firstInRow(int row, int* newCol = 0) const {
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count())
+            return noData(newCol);
+        return m_chunks.at(chunk).firstInRow(localRow(row), newCol);
+    }
+
+    /**
+     * Retrieve the last used data in \p col .
+     * Can be used in conjunction with prevInColumn() to loop through a column.
+     * \return the last used data in \p col or the default data, if the column is empty.
+     */
+    T lastInColumn(int col, int* newRow = 0) const {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        return lastInColumn(col, m_chunks.count() - 1, newRow);
+    }
+
+    /**
+     * Retrieve the last used data in \p row .
+     * Can be used in conjunction with prevInRow() to loop through a row.
+     * \return the last used data in \p row or the default data, if the row is empty.
+     */
+    T lastInRow(int row, int* newCol = 0) const {
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count() || localRow(row) > m_chunks.at(chunk).rows())
+            return noData(newCol);
+        return m_chunks.at(chunk).lastInRow(localRow(row), newCol);
+    }
+
+    /**
+     * Retrieve the next used data in \p col after \p row .
+     * Can be used in conjunction with firstInColumn() to loop through a column.
+     * \return the next used data in \p col or the default data, there is no further data.
+     */
+    T nextInColumn(int col, int row, int* newRow = 0) const {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count())
+            return noData(newRow);
+        int localNewRow = 0;
+        const T data = m_chunks.at(chunk).nextInColumn(col, localRow(row), &localNewRow);
+        if (localNewRow) {
+            if (newRow)
+                *newRow = globalRow(localNewRow, chunk);
+            return data;
+        }
+        return firstInColumn(col, chunk + 1, newRow);
+    }
+
+    /**
+     * Retrieve the next used data in \p row after \p col .
+     * Can be used in conjunction with firstInRow() to loop through a row.
+     * \return the next used data in \p row or the default data, if there is no further data.
+     */
+    T nextInRow(int col, int row, int* newCol = 0) const {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count())
+            return noData(newCol);
+        return m_chunks.at(chunk).nextInRow(col, localRow(row), newCol);
+    }
+
+    /**
+     * Retrieve the previous used data in \p col after \p row .
+     * Can be used in conjunction with lastInColumn() to loop through a column.
+     * \return the previous used data in \p col or the default data, there is no further data.
+     */
+    T prevInColumn(int col, int row, int* newRow = 0) const {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count())
+            return lastInColumn(col, m_chunks.count() - 1, newRow);
+        int localNewRow = 0;
+        const T data = m_chunks.at(chunk).prevInColumn(col, localRow(row), &localNewRow);
+        if (localNewRow) {
+            if (newRow)
+                *newRow = globalRow(localNewRow, chunk);
+            return data;
+        }
+        return lastInColumn(col, chunk - 1, newRow);
+    }
+
+    /**
+     * Retrieve the previous used data in \p row after \p col .
+     * Can be used in conjunction with lastInRow() to loop through a row.
+     * \return the previous used data in \p row or the default data, if there is no further data.
+     */
+    T prevInRow(int col, int row, int* newCol = 0) const {
+        Q_ASSERT(1 <= col && col <= KS_colMax);
+        Q_ASSERT(1 <= row && row <= KS_rowMax);
+        const int chunk = chunkIndex(row);
+        if (chunk >= m_chunks.count())
+            return noData(newCol);
+        return m_chunks.at(chunk).prevInRow(col, localRow(row), newCol);
+    }
+
+    /**
+     * For debugging/testing purposes.
+     * \note only works with primitive/printable data
+     */
+    QString dump() const {
+        return toPointStorage().dump();
+    }
+
+    /**
+     * Returns the column of the non-default data at \p index .
+     * \return the data's column at \p index .
+     * \see count()
+     * \see row()
+     * \see data()
+     */
+    int col(int index) const {
+        const int chunk = chunkOfIndex(index);
+        if (chunk == -1)
+            return 0;
+        return m_chunks.at(chunk).col(index - m_offsets.at(chunk));
+    }
+
+    /**
+     * Returns the row of the non-default data at \p index .
+     * \return the data's row at \p index .
+     * \see count()
+     * \see col()
+     * \see data()
+     */
+    int row(int index) const {
+        const int chunk = chunkOfIndex(index);
+        if (chunk == -1)
+            return 0;
+        return globalRow(m_chunks.at(chunk).row(index - m_offsets.at(chunk)), chunk);
+    }
+
+    /**
+     * Returns the non-default data at \p index .
+     * \return the data at \p index .
+     * \see count()
+     * \see col()
+     * \see row()
+     */
+    T data(int index) const {
+        const int chunk = chunkOfIndex(index);
+        if (chunk == -1)
+            return T();
+        return m_chunks.at(chunk).data(index - m_offsets.at(chunk));
+    }
+
+    /**
+     * Returns a reference to the non-default data at \p index .
+     * Avoids the copy of data(); \p index has to be valid.
+     * \see data()
+     */
+    const T& constData(int index) const {
+        const int chunk = chunkOfIndex(index);
+        Q_ASSERT(chunk != -1);
+        return m_chunks.at(chunk).constData(index - m_offsets.at(chunk));
+    }
+
+    /**
+     * The maximum occupied column, i.e. the horizontal storage dimension.
+     * \return the maximum column
+     */
+    int columns() const {
+        int columns = 0;
+        for (int chunk = 0; chunk < m_chunks.count(); ++chunk)
+            columns = qMax(m_chunks.at(chunk).columns(), columns);
+        return columns;
+    }
+
+    /**
+     * The maximum occupied row, i.e. the vertical storage dimension.
+     * \return the maximum row
+     */
+    int rows() const {
+        for (int chunk = m_chunks.count() - 1; chunk >= 0; --chunk) {
+            if (m_chunks.at(chunk).rows() > 0)
+                return globalRow(m_chunks.at(chunk).rows(), chunk);
+        }
+        return 0;
+    }
+
+    /**
+     * Creates a substorage consisting of the values in \p region.
+     * If \p keepOffset is \c true, the values' positions are not altered.
+     * Otherwise, the upper left of \p region's bounding rect is used as new origin,
+     * and all positions are adjusted.
+     * \return a subset of the storage stripped down to the values in \p region
+     */
+    ChunkedPointStorage<T, ChunkRows> subStorage(const Region& region, bool keepOffset = true) const {
+        // Determine the offset.
+        const QPoint offset = keepOffset ? QPoint(0, 0) : region.boundingRect().topLeft() - QPoint(1, 1);
+        // this generates an array of values
+        ChunkedPointStorage<T, ChunkRows> subStorage;
+        const int lastRow = rows();
+        Region::ConstIterator end(region.constEnd());
+        for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+            const QRect rect = (*it)->rect();
+            for (int row = rect.top(); row <= rect.bottom() && row <= lastRow; ++row) {
+                const PointStorage<T>& storage = m_chunks.at(chunkIndex(row));
+                const int local = localRow(row);
+                int col = 0;
+                T data = storage.firstInRow(local, &col);
+                while (col) {
+                    if (col > rect.right())
+                        break;
+                    if (col >= rect.left())
+                        subStorage.insert(col - offset.x(), row - offset.y(), data);
+                    data = storage.nextInRow(col, local, &col);
+                }
+            }
+        }
+        return subStorage;
+    }
+
+    /**
+     * Creates a PointStorage with the same data.
+     */
+    PointStorage<T> toPointStorage() const {
+        PointStorage<T> storage;
+        for (int chunk = 0; chunk < m_chunks.count(); ++chunk) {
+            const PointStorage<T>& source = m_chunks.at(chunk);
+            // row-wise, i.e. appending
+            for (int i = 0; i < source.count(); ++i)
+                storage.insert(source.col(i), globalRow(source.row(i), chunk), source.constData(i));
+        }
+        return storage;
+    }
+
+    /**
+     * Equality operator.
+     */
+    bool operator==(const ChunkedPointStorage<T, ChunkRows>& o) const {
+        if (m_count != o.m_count)
+            return false;
+        const PointStorage<T> empty;
+        const int count = qMax(m_chunks.count(), o.m_chunks.count());
+        for (int chunk = 0; chunk < count; ++chunk) {
+            const PointStorage<T>& a = (chunk < m_chunks.count()) ? m_chunks.at(chunk) : empty;
+            const PointStorage<T>& b = (chunk < o.m_chunks.count()) ? o.m_chunks.at(chunk) : empty;
+            if (!(a == b))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    static int chunkIndex(int row) {
+        return (row - 1) / ChunkRows;
+    }
+
+    static int localRow(int row) {
+        return (row - 1) % ChunkRows + 1;
+    }
+
+    static int globalRow(int localRow, int chunk) {
+        return chunk * ChunkRows + localRow;
+    }
+
+    static QRect localRect(const QRect& rect, int chunk) {
+        const int top = qMax(rect.top(), globalRow(1, chunk));
+        const int bottom = qMin(rect.bottom(), globalRow(ChunkRows, chunk));
+        return QRect(QPoint(rect.left(), localRow(top)), QPoint(rect.right(), localRow(bottom)));
+    }
+
+    static QVector< QPair<QPoint, T> > toGlobal(QVector< QPair<QPoint, T> > data, int chunk) {
+        for (int i = 0; i < data.count(); ++i)
+            data[i].first.setY(globalRow(data[i].first.y(), chunk));
+        return data;
+    }
+
+    static T noData(int* newPosition) {
+        if (newPosition)
+            *newPosition = 0;
+        return T();
+    }
+
+    // the first data in col, starting at the block chunk
+    T firstInColumn(int col, int chunk, int* newRow) const {
+        for (; chunk < m_chunks.count(); ++chunk) {
+            int localNewRow = 0;
+            const T data = m_chunks.at(chunk).firstInColumn(col, &localNewRow);
+            if (localNewRow) {
+                if (newRow)
+                    *newRow = globalRow(localNewRow, chunk);
+                return data;
+            }
+        }
+        return noData(newRow);
+    }
+
+    // the last data in col, starting at the block chunk
+    T lastInColumn(int col, int chunk, int* newRow) const {
+        for (; chunk >= 0; --chunk) {
+            int localNewRow = 0;
+            const T data = m_chunks.at(chunk).lastInColumn(col, &localNewRow);
+            if (localNewRow) {
+                if (newRow)
+                    *newRow = globalRow(localNewRow, chunk);
+                return data;
+            }
+        }
+        return noData(newRow);
+    }
+
+    // adjusts the offsets of the blocks following chunk
+    void dataCountChanged(int chunk, int difference) {
+        if (difference == 0)
+            return;
+        m_count += difference;
+        for (int i = chunk + 1; i < m_offsets.count(); ++i)
+            m_offsets[i] += difference;
+    }
+
+    // recalculates the offsets after a modification of several blocks
+    void updateOffsets() {
+        squeezeChunks();
+        m_offsets.resize(m_chunks.count());
+        m_count = 0;
+        for (int chunk = 0; chunk < m_chunks.count(); ++chunk) {
+            m_offsets[chunk] = m_count;
+            m_count += m_chunks.at(chunk).count();
+        }
+    }
+
+    // removes trailing empty blocks
+    void squeezeChunks() {
+        int chunk = m_chunks.count() - 1;
+        while (chunk >= 0 && m_chunks.at(chunk).count() == 0)
+            --chunk;
+        if (chunk + 1 < m_chunks.count()) {
+            m_chunks.resize(chunk + 1);
+            m_offsets.resize(chunk + 1);
+        }
+    }
+
+    // the block containing the data at index or -1
+    int chunkOfIndex(int index) const {
+        if (index < 0 || index >= m_count)
+            return -1;
+        // the last block starting at or before index; empty blocks share their offset
+        return qUpperBound(m_offsets.constBegin(), m_offsets.constEnd(), index) - m_offsets.constBegin() - 1;
+    }
+
+    void fromPointStorage(const PointStorage<T>& storage) {
+        clear();
+        for (int i = 0; i < storage.count(); ++i)
+            insert(storage.col(i), storage.row(i), storage.constData(i));
+    }
+
+private:
+    QVector< PointStorage<T> > m_chunks;    // the blocks of ChunkRows rows each
+    int m_count;                            // the total amount of data
+    QVector<int> m_offsets;                 // the index of the first data of each block
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_CHUNKED_POINT_STORAGE
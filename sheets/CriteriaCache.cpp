@@ -0,0 +1,268 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+// Local
+#include "CriteriaCache.h"
+
+#include "RangeCache_p.h"
+#include "Region.h"
+#include "Value.h"
+#include "ValueCalc.h"
+
+#include <QBitArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QRect>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+using namespace Calligra::Sheets;
+
+// Smaller ranges are tested by the functions themselves.
+static const int g_minimumIndexSize = 32;
+// The number of criteria remembered per range.
+static const int g_maximumMaskCount = 64;
+
+namespace
+{
+
+// Values with equal keys match the same criteria, see ValueCalc::matches().
+struct ValueKey {
+    int type;
+    int format;
+    Number number;
+    QString string;
+
+    bool operator==(const ValueKey& other) const {
+        return type == other.type && format == other.format &&
+               number == other.number && string == other.string;
+    }
+};
+
+uint qHash(const ValueKey& key)
+{
+    return ::qHash(key.string) ^ ::qHash(numToDouble(key.number)) ^ (uint(key.type) << 4) ^ uint(key.format);
+}
+
+// Only the members set by ValueCalc::getCond() are compared.
+struct ConditionKey {
+    int comp;
+    int type;
+    Number value;
+    QString stringValue;
+
+    explicit ConditionKey(const Condition& condition)
+            : comp(condition.comp)
+            , type(condition.type)
+            , value(condition.type == numeric ? condition.value : Number(0.0))
+            , stringValue(condition.type == string ? condition.stringValue : QString()) {}
+
+    bool operator==(const ConditionKey& other) const {
+        return comp == other.comp && type == other.type &&
+               value == other.value && stringValue == other.stringValue;
+    }
+};
+
+uint qHash(const ConditionKey& key)
+{
+    return ::qHash(key.stringValue) ^ ::qHash(numToDouble(key.value)) ^ (uint(key.comp) << 4) ^ uint(key.type);
+}
+
+class CriteriaIndex
+{
+public:
+    explicit CriteriaIndex(const Value& data);
+
+    bool isValid() const {
+        return m_valid;
+    }
+
+    void matches(const Condition& condition, ValueCalc* calc, QBitArray* mask);
+
+private:
+    struct Group {
+        Value value;
+        QVector<int> positions;
+    };
+
+    bool m_valid;
+    int m_count;
+    QVector<Group> m_groups;
+
+    QMutex m_mutex;
+    QHash<ConditionKey, QBitArray> m_masks;
+};
+
+CriteriaIndex::CriteriaIndex(const Value& data)
+        : m_valid(true)
+        , m_count(data.rows() * data.columns())
+{
+    QHash<ValueKey, int> groups;
+    ValueKey key;
+    const int rows = data.rows();
+    const int columns = data.columns();
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            const Value value = data.element(column, row);
+            key.type = value.type();
+            key.format = value.format();
+            switch (value.type()) {
+            case Value::Empty:
+                key.number = 0.0;
+                key.string.clear();
+                break;
+            case Value::Integer:
+            case Value::Float:
+                key.number = value.asFloat();
+                key.string.clear();
+                break;
+            case Value::Boolean:
+                key.number = value.asBoolean() ? 1.0 : 0.0;
+                key.string.clear();
+                break;
+            case Value::String:
+                key.number = 0.0;
+                key.string = value.asString();
+                break;
+            default:
+                // Arrays, errors and complex numbers are left to the functions.
+                m_valid = false;
+                m_groups.clear();
+                return;
+            }
+            QHash<ValueKey, int>::ConstIterator it = groups.constFind(key);
+            if (it == groups.constEnd()) {
+                it = groups.insert(key, m_groups.count());
+                Group group;
+                group.value = value;
+                m_groups.append(group);
+            }
+            m_groups[it.value()].positions.append(row * columns + column);
+        }
+    }
+}
+
+void CriteriaIndex::matches(const Condition& condition, ValueCalc* calc, QBitArray* mask)
+{
+    const ConditionKey key(condition);
+    {
+        QMutexLocker locker(&m_mutex);
+        const QHash<ConditionKey, QBitArray>::ConstIterator it = m_masks.constFind(key);
+        if (it != m_masks.constEnd()) {
+            *mask = it.value();
+            return;
+        }
+    }
+
+    // Test each distinct value once.
+    QBitArray result(m_count);
+    for (int i = 0; i < m_groups.count(); ++i) {
+        const Group& group = m_groups[i];
+        if (!calc->matches(condition, group.value))
+            continue;
+        for (int j = 0; j < group.positions.count(); ++j)
+            result.setBit(group.positions[j]);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_masks.count() >= g_maximumMaskCount)
+        m_masks.clear();
+    m_masks.insert(key, result);
+    *mask = result;
+}
+
+struct RangeKey {
+    QRect range;
+
+    bool operator==(const RangeKey& other) const {
+        return range == other.range;
+    }
+};
+
+uint qHash(const RangeKey& key)
+{
+    return ::qHash(qMakePair(qMakePair(key.range.left(), key.range.top()),
+                             qMakePair(key.range.right(), key.range.bottom())));
+}
+
+} // namespace
+
+class Q_DECL_HIDDEN CriteriaCache::Private
+{
+public:
+    QMutex mutex;
+    RangeCache<RangeKey, QSharedPointer<CriteriaIndex> > indices;
+};
+
+CriteriaCache::CriteriaCache()
+        : d(new Private)
+{
+}
+
+CriteriaCache::~CriteriaCache()
+{
+    delete d;
+}
+
+bool CriteriaCache::matches(Sheet* sheet, const QRect& range, const Value& data,
+                            const Condition& condition, ValueCalc* calc, QBitArray* mask)
+{
+    if (!sheet || !data.isArray() || int(data.columns()) != range.width() || int(data.rows()) != range.height())
+        return false;
+    if (range.width() * range.height() < g_minimumIndexSize)
+        return false;
+
+    QSharedPointer<CriteriaIndex> index;
+    {
+        QMutexLocker locker(&d->mutex);
+        RangeKey rangeKey;
+        rangeKey.range = range;
+        index = d->indices.value(sheet, rangeKey);
+        if (!index) {
+            index = QSharedPointer<CriteriaIndex>(new CriteriaIndex(data));
+            d->indices.insert(sheet, rangeKey, index);
+        }
+    }
+    if (!index->isValid())
+        return false;
+    index->matches(condition, calc, mask);
+    return true;
+}
+
+void CriteriaCache::regionChanged(Sheet* sheet, const Region& region)
+{
+    if (d->indices.isEmpty())
+        return;
+    QMutexLocker locker(&d->mutex);
+    d->indices.regionChanged(sheet, region);
+}
+
+void CriteriaCache::removeSheet(Sheet* sheet)
+{
+    QMutexLocker locker(&d->mutex);
+    d->indices.removeSheet(sheet);
+}
+
+void CriteriaCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->indices.clear();
+}
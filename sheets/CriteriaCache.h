@@ -0,0 +1,108 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_CRITERIA_CACHE
+#define CALLIGRA_SHEETS_CRITERIA_CACHE
+
+#include <Qt>
+
+#include "sheets_odf_export.h"
+
+class QBitArray;
+class QRect;
+
+namespace Calligra
+{
+namespace Sheets
+{
+struct Condition;
+class Region;
+class Sheet;
+class Value;
+class ValueCalc;
+
+/**
+ * \class CriteriaCache
+ * \brief Caches the matches of the criteria of the conditional aggregates.
+ * \ingroup Value
+ *
+ * SUMIF, COUNTIF, AVERAGEIF and their variants with several criteria test
+ * each cell of a range against a criterion. Dashboards often use thousands
+ * of these formulas on the same few ranges.
+ *
+ * For large ranges an index of the distinct values is built on the first
+ * use. A criterion is then tested once per distinct value instead of once
+ * per cell. The resulting matches are kept per criterion and shared by all
+ * formulas using the same criterion on the same range.
+ *
+ * An index is kept until a CellDamage touches its range.
+ *
+ * The cache may be used from several threads at once.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT CriteriaCache
+{
+public:
+    /**
+     * Constructor.
+     */
+    CriteriaCache();
+
+    /**
+     * Destructor.
+     */
+    ~CriteriaCache();
+
+    /**
+     * Marks the values of \p range on \p sheet matching \p condition .
+     *
+     * \param data the values of \p range
+     * \param calc tests the values, see ValueCalc::matches()
+     * \param mask the matches in row-major order
+     * \return \c false, if the cache cannot handle this range; the caller
+     *         has to test the values itself then
+     */
+    bool matches(Sheet* sheet, const QRect& range, const Value& data,
+                 const Condition& condition, ValueCalc* calc, QBitArray* mask);
+
+    /**
+     * Drops the indices of the ranges on \p sheet intersecting \p region .
+     */
+    void regionChanged(Sheet* sheet, const Region& region);
+
+    /**
+     * Drops the indices of the ranges on \p sheet .
+     */
+    void removeSheet(Sheet* sheet);
+
+    /**
+     * Drops all indices.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(CriteriaCache)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_CRITERIA_CACHE
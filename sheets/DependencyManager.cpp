@@ -236,6 +236,48 @@ QMap<Cell, int> DependencyManager::depths() const
     return d->depths;
 }
 
+int DependencyManager::depth(const Cell& cell) const
+{
+    return d->depths.value(cell);
+}
+
+QList<Cell> DependencyManager::dependentCells(const Region& region) const
+{
+    QList<Cell> cells;
+    QSet<Cell> processedCells;
+    QList<Cell> pendingCells;
+
+    Region::ConstIterator end(region.constEnd());
+    for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+        const QRect range = (*it)->rect();
+        Sheet* const sheet = (*it)->sheet();
+
+        // the cells with a formula in the region itself
+        const FormulaStorageBase formulas = sheet->formulaStorage()->subStorage(Region(range, sheet));
+        for (int c = 0; c < formulas.count(); ++c)
+            pendingCells.append(Cell(sheet, formulas.col(c), formulas.row(c)));
+
+        // the direct consumers of the region
+        QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = d->consumers.constFind(sheet);
+        if (cit != d->consumers.constEnd())
+            pendingCells.append(cit.value()->intersects(range));
+    }
+
+    // Follow the consumers. Not recursive, because reference chains may be long.
+    while (!pendingCells.isEmpty()) {
+        const Cell cell = pendingCells.takeLast();
+        if (processedCells.contains(cell))
+            continue;
+        processedCells.insert(cell);
+        cells.append(cell);
+
+        QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = d->consumers.constFind(cell.sheet());
+        if (cit != d->consumers.constEnd())
+            pendingCells.append(cit.value()->contains(cell.cellPosition()));
+    }
+    return cells;
+}
+
 Calligra::Sheets::Region DependencyManager::consumingRegion(const Cell& cell) const
 {
     return d->consumingRegion(cell);
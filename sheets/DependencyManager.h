@@ -72,10 +72,28 @@ public:
 
     /**
      * Returns the cell depths.
+     * \note This copies the depths of all cells. Use depth() for single cells.
      * \return the cell depths
      */
     QMap<Cell, int> depths() const;
 
+    /**
+     * Returns the reference depth of \p cell .
+     * The depths are kept up to date on each formula change.
+     * \return the reference depth or zero, if \p cell has no formula
+     */
+    int depth(const Cell& cell) const;
+
+    /**
+     * Returns the cells, that need a recalculation, if values in \p region
+     * change. These are the cells with a formula in \p region and all cells
+     * consuming their values, directly or indirectly.
+     *
+     * Only the cells in the dependency cone of \p region are visited.
+     * \return the cells depending on \p region
+     */
+    QList<Cell> dependentCells(const Region& region) const;
+
     /**
      * Returns the region, that consumes the value of \p cell.
      *
@@ -117,6 +117,13 @@ public:
      * @see Map::loadOdf
      */
     virtual bool loadOdf(KoOdfReadStore & odfStore);
+
+    /**
+     * \ingroup OpenDocument
+     * Loads the document without keeping a DOM tree of the whole content.
+     * Wrapper around Odf::loadDocumentStreaming.
+     */
+    virtual bool loadOasisFromStore(KoStore *store);
 protected:
     class Private;
     Private * const d;
@@ -29,6 +29,8 @@
 #include "Sheet.h"
 #include "Map.h"
 #include "NamedAreaManager.h"
+#include "RecalcManager.h"
+#include "RecalcProfile.h"
 #include "Region.h"
 #include "Value.h"
 #include "Util.h"
@@ -39,6 +41,8 @@
 
 #include <limits.h>
 
+#include <QElapsedTimer>
+#include <QScopedPointer>
 #include <QStack>
 #include <QString>
 #include <QTextStream>
@@ -112,9 +116,18 @@ struct stackEntry {
     int row1, col1, row2, col2;
 };
 
+// a cell or range reference resolved at compile time
+struct ResolvedReference {
+    ResolvedReference() : isNamedArea(false) {}
+    Calligra::Sheets::Region region; // sheet, range and absolute/relative flags
+    bool isNamedArea;
+};
+
 class Q_DECL_HIDDEN Formula::Private : public QSharedData
 {
 public:
+    Private() : referenceGeneration(-1) {}
+
     Cell cell;
     Sheet *sheet;
     mutable bool dirty;
@@ -122,8 +135,25 @@ public:
     QString expression;
     mutable QVector<Opcode> codes;
     mutable QVector<Value> constants;
+    // resolved references of the Cell and Range opcodes; same indices as constants
+    mutable QVector<ResolvedReference> references;
+    // the Map::referenceGeneration() the references were resolved in
+    mutable int referenceGeneration;
 
     Value valueOrElement(FuncExtra &fe, const stackEntry& entry) const;
+
+    /**
+     * Resolves the references of the Cell and Range opcodes, so that the
+     * evaluation does not need to parse the reference strings again.
+     */
+    void resolveReferences() const;
+
+    /**
+     * \return \c true, if the resolved references are still up to date
+     */
+    bool hasResolvedReferences() const {
+        return sheet && referenceGeneration == sheet->map()->referenceGeneration();
+    }
 };
 
 class TokenStack : public QVector<Token>
@@ -610,6 +640,9 @@ bool Formula::isValid() const
             compile(tokens);
         else
             d->valid = false;
+    } else if (d->valid && d->sheet && !d->hasResolvedReferences()) {
+        // sheets or named areas changed since the compilation
+        d->resolveReferences();
     }
     return d->valid;
 }
@@ -623,6 +656,8 @@ void Formula::clear()
     d->valid = false;
     d->constants.clear();
     d->codes.clear();
+    d->references.clear();
+    d->referenceGeneration = -1;
 }
 
 // Returns list of token for the expression.
@@ -1465,7 +1500,27 @@ void Formula::compile(const Tokens& tokens) const
     if (!d->valid) {
         d->constants.clear();
         d->codes.clear();
+        d->references.clear();
+        d->referenceGeneration = -1;
+    } else if (d->sheet) {
+        d->resolveReferences();
+    }
+}
+
+void Formula::Private::resolveReferences() const
+{
+    const Map* const map = sheet->map();
+    references.fill(ResolvedReference(), constants.count());
+    for (int i = 0; i < codes.count(); ++i) {
+        const Opcode& opcode = codes.at(i);
+        if (opcode.type != Opcode::Cell && opcode.type != Opcode::Range)
+            continue;
+        const QString reference = constants.at(opcode.index).asString();
+        ResolvedReference& resolved = references[opcode.index];
+        resolved.region = Region(reference, map, sheet);
+        resolved.isNamedArea = map->namedAreaManager()->contains(reference);
     }
+    referenceGeneration = map->referenceGeneration();
 }
 
 bool Formula::isNamedArea(const QString& expr) const
@@ -1541,6 +1596,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
     const Map* map = d->sheet ? d->sheet->map() : new Map(0 /*document*/);
     const ValueConverter* converter = map->converter();
     ValueCalc* calc = map->calc();
+    RecalcProfile* const profile = map->recalcManager()->profile();
 
     QSharedPointer<Function> function;
     FuncExtra fe;
@@ -1560,9 +1616,14 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
     if (!d->valid)
         return Value::errorPARSE();
 
+    // Use the references resolved at compile time, if they are up to date.
+    // Otherwise, parse them again; they get updated by the next isValid() call.
+    const bool resolved = d->hasResolvedReferences();
+
     for (int pc = 0; pc < d->codes.count(); pc++) {
         Value ret;   // for the function caller
-        Opcode& opcode = d->codes[pc];
+        // const access; the formula may be evaluated by several threads at once
+        const Opcode& opcode = d->codes.at(pc);
         index = opcode.index;
         switch (opcode.type) {
             // no operation
@@ -1572,7 +1633,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
             // load a constant, push to stack
         case Opcode::Load:
             entry.reset();
-            entry.val = d->constants[index];
+            entry.val = d->constants.at(index);
             stack.push(entry);
             break;
 
@@ -1650,8 +1711,8 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
         case Opcode::Intersect: {
             val1 = stack.pop().val;
             val2 = stack.pop().val;
-            Region r1(d->constants[index].asString(), map, d->sheet);
-            Region r2(d->constants[index+1].asString(), map, d->sheet);
+            Region r1(d->constants.at(index).asString(), map, d->sheet);
+            Region r2(d->constants.at(index+1).asString(), map, d->sheet);
             if(!r1.isValid() || !r2.isValid()) {
                 val1 = Value::errorNULL();
             } else {
@@ -1762,11 +1823,20 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
 
         // cell in a sheet
         case Opcode::Cell: {
-            c = d->constants[index].asString();
             val1 = Value::empty();
             entry.reset();
 
-            const Region region(c, map, d->sheet);
+            // refer to the resolved region, parse it only if it is outdated
+            QScopedPointer<Region> parsed;
+            bool isNamedArea;
+            if (resolved) {
+                isNamedArea = d->references.at(index).isNamedArea;
+            } else {
+                c = d->constants.at(index).asString();
+                parsed.reset(new Region(c, map, d->sheet));
+                isNamedArea = map->namedAreaManager()->contains(c);
+            }
+            const Region& region = resolved ? d->references.at(index).region : *parsed;
             if (!region.isValid()) {
                 val1 = Value::errorREF();
             } else if (region.isSingular()) {
@@ -1791,7 +1861,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
                 entry.col1 = entry.col2 = position.x();
                 entry.row1 = entry.row2 = position.y();
                 entry.reg = region;
-                entry.regIsNamedOrLabeled = map->namedAreaManager()->contains(c);
+                entry.regIsNamedOrLabeled = isNamedArea;
             } else {
                 warnSheets << "Unhandled non singular region in Opcode::Cell with rects=" << region.rects();
             }
@@ -1802,11 +1872,19 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
 
         // selected range in a sheet
         case Opcode::Range: {
-            c = d->constants[index].asString();
             val1 = Value::empty();
             entry.reset();
 
-            const Region region(c, map, d->sheet);
+            QScopedPointer<Region> parsed;
+            bool isNamedArea;
+            if (resolved) {
+                isNamedArea = d->references.at(index).isNamedArea;
+            } else {
+                c = d->constants.at(index).asString();
+                parsed.reset(new Region(c, map, d->sheet));
+                isNamedArea = map->namedAreaManager()->contains(c);
+            }
+            const Region& region = resolved ? d->references.at(index).region : *parsed;
             if (region.isValid()) {
                 val1 = region.firstSheet()->cellStorage()->valueRegion(region);
                 // store the reference, so we can use it within functions
@@ -1815,7 +1893,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
                 entry.col2 = region.firstRange().right();
                 entry.row2 = region.firstRange().bottom();
                 entry.reg = region;
-                entry.regIsNamedOrLabeled = map->namedAreaManager()->contains(c);
+                entry.regIsNamedOrLabeled = isNamedArea;
             }
 
             entry.val = val1; // any array is valid here
@@ -1825,7 +1903,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
 
         // reference
         case Opcode::Ref:
-            val1 = d->constants[index];
+            val1 = d->constants.at(index);
             entry.reset();
             entry.val = val1;
             stack.push(entry);
@@ -1863,7 +1941,14 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
             if (!function)
                 return Value::errorNAME(); // no such function
 
-            ret = function->exec(args, calc, &fe);
+            if (profile) {
+                QElapsedTimer timer;
+                timer.start();
+                ret = function->exec(args, calc, &fe);
+                profile->addFunctionCall(function->name(), timer.nsecsElapsed());
+            } else {
+                ret = function->exec(args, calc, &fe);
+            }
             entry.reset();
             entry.val = ret;
             stack.push(entry);
@@ -1873,8 +1958,8 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
 #ifdef CALLIGRA_SHEETS_INLINE_ARRAYS
             // creating an array
         case Opcode::Array: {
-            const int cols = d->constants[index].asInteger();
-            const int rows = d->constants[index+1].asInteger();
+            const int cols = d->constants.at(index).asInteger();
+            const int rows = d->constants.at(index+1).asInteger();
             // check if enough array elements are available
             if (stack.count() < cols * rows)
                 return Value::errorVALUE();
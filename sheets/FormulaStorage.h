@@ -22,23 +22,33 @@
 
 #include "Formula.h"
 #include "calligra_sheets_limits.h"
+#ifdef CALLIGRA_SHEETS_CHUNKED_STORAGE
+#include "ChunkedPointStorage.h"
+#else
 #include "PointStorage.h"
+#endif
 
 namespace Calligra
 {
 namespace Sheets
 {
 
+#ifdef CALLIGRA_SHEETS_CHUNKED_STORAGE
+typedef ChunkedPointStorage<Formula> FormulaStorageBase;
+#else
+typedef PointStorage<Formula> FormulaStorageBase;
+#endif
+
 /**
  * \ingroup Storage
  * \ingroup Value
  * Stores formulas.
  */
-class FormulaStorage : public PointStorage<Formula>
+class FormulaStorage : public FormulaStorageBase
 {
 public:
-    FormulaStorage& operator=(const PointStorage<Formula>& o) {
-        PointStorage<Formula>::operator=(o);
+    FormulaStorage& operator=(const FormulaStorageBase& o) {
+        FormulaStorageBase::operator=(o);
         return *this;
     }
 };
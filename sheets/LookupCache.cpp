@@ -0,0 +1,270 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+// Local
+#include "LookupCache.h"
+
+#include "RangeCache_p.h"
+#include "Region.h"
+#include "Value.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QRect>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <float.h>
+
+#include <algorithm>
+
+using namespace Calligra::Sheets;
+
+// Shorter lines are searched linearly by the functions themselves.
+static const int g_minimumIndexSize = 32;
+
+namespace
+{
+
+// The kinds of indexed values in their natural order, see Value::compare().
+enum LookupKind {
+    NumberKind,
+    StringKind,
+    BooleanKind
+};
+
+struct LookupEntry {
+    int kind;
+    double number; // numbers and booleans
+    QString string;
+    int position;
+};
+
+// Converts a value into an entry. Returns false for values, which are not indexed.
+bool makeEntry(const Value& value, Qt::CaseSensitivity caseSensitivity, LookupEntry* entry)
+{
+    switch (value.type()) {
+    case Value::Integer:
+    case Value::Float:
+        entry->kind = NumberKind;
+        entry->number = numToDouble(value.asFloat());
+        return true;
+    case Value::String:
+        entry->kind = StringKind;
+        entry->string = (caseSensitivity == Qt::CaseSensitive) ? value.asString() : value.asString().toLower();
+        return true;
+    case Value::Boolean:
+        entry->kind = BooleanKind;
+        entry->number = value.asBoolean() ? 1.0 : 0.0;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The natural comparison, see Value::compare().
+int compareEntries(const LookupEntry& a, const LookupEntry& b)
+{
+    if (a.kind != b.kind)
+        return (a.kind < b.kind) ? -1 : 1;
+    if (a.kind == StringKind)
+        return a.string.compare(b.string);
+    const double difference = a.number - b.number;
+    if (difference > DBL_EPSILON)
+        return 1;
+    if (difference < -DBL_EPSILON)
+        return -1;
+    return 0;
+}
+
+// A strict ordering for sorting. Equal values keep their order of appearance.
+bool lessThan(const LookupEntry& a, const LookupEntry& b)
+{
+    if (a.kind != b.kind)
+        return a.kind < b.kind;
+    if (a.kind == StringKind) {
+        const int result = a.string.compare(b.string);
+        if (result != 0)
+            return result < 0;
+    } else if (a.number != b.number) {
+        return a.number < b.number;
+    }
+    return a.position < b.position;
+}
+
+bool entryLowerThanKey(const LookupEntry& entry, const LookupEntry& key)
+{
+    return compareEntries(entry, key) < 0;
+}
+
+class LookupIndex
+{
+public:
+    LookupIndex(const Value& data, Qt::Orientation orientation, Qt::CaseSensitivity caseSensitivity);
+
+    int find(const LookupEntry& key, bool rangeLookup) const;
+
+private:
+    // sorted by lessThan()
+    QVector<LookupEntry> m_entries;
+    // the first position of each string
+    QHash<QString, int> m_strings;
+};
+
+LookupIndex::LookupIndex(const Value& data, Qt::Orientation orientation, Qt::CaseSensitivity caseSensitivity)
+{
+    const int count = (orientation == Qt::Vertical) ? data.rows() : data.columns();
+    LookupEntry entry;
+    for (int i = 0; i < count; ++i) {
+        const Value value = (orientation == Qt::Vertical) ? data.element(0, i) : data.element(i, 0);
+        if (!makeEntry(value, caseSensitivity, &entry))
+            continue;
+        entry.position = i;
+        m_entries.append(entry);
+        if (entry.kind == StringKind && !m_strings.contains(entry.string))
+            m_strings.insert(entry.string, i);
+    }
+    std::sort(m_entries.begin(), m_entries.end(), lessThan);
+}
+
+int LookupIndex::find(const LookupEntry& key, bool rangeLookup) const
+{
+    if (key.kind == StringKind) {
+        const QHash<QString, int>::ConstIterator it = m_strings.constFind(key.string);
+        if (it != m_strings.constEnd())
+            return it.value();
+        if (!rangeLookup)
+            return -1;
+    }
+
+    // the first entry not lower than the key
+    const QVector<LookupEntry>::ConstIterator begin = m_entries.constBegin();
+    const QVector<LookupEntry>::ConstIterator end = m_entries.constEnd();
+    QVector<LookupEntry>::ConstIterator it = std::lower_bound(begin, end, key, entryLowerThanKey);
+
+    // Numbers are equal within a tolerance. Pick the first position of all equal ones.
+    int position = -1;
+    for (QVector<LookupEntry>::ConstIterator equal = it; equal != end && compareEntries(*equal, key) == 0; ++equal) {
+        if (position == -1 || equal->position < position)
+            position = equal->position;
+    }
+    if (position != -1 || !rangeLookup || it == begin)
+        return position;
+
+    // the first position of the largest value less than the key
+    const LookupEntry& lower = *(it - 1);
+    for (QVector<LookupEntry>::ConstIterator equal = it; equal != begin && compareEntries(*(equal - 1), lower) == 0; --equal) {
+        if (position == -1 || (equal - 1)->position < position)
+            position = (equal - 1)->position;
+    }
+    return position;
+}
+
+struct LookupKey {
+    QRect range;
+    Qt::Orientation orientation;
+    Qt::CaseSensitivity caseSensitivity;
+
+    bool operator==(const LookupKey& other) const {
+        return range == other.range && orientation == other.orientation &&
+               caseSensitivity == other.caseSensitivity;
+    }
+};
+
+uint qHash(const LookupKey& key)
+{
+    return ::qHash(qMakePair(qMakePair(key.range.left(), key.range.top()),
+                             qMakePair(key.range.right(), key.range.bottom())))
+           ^ (uint(key.orientation) << 1) ^ uint(key.caseSensitivity);
+}
+
+} // namespace
+
+class Q_DECL_HIDDEN LookupCache::Private
+{
+public:
+    QMutex mutex;
+    RangeCache<LookupKey, QSharedPointer<const LookupIndex> > indices;
+};
+
+LookupCache::LookupCache()
+        : d(new Private)
+{
+}
+
+LookupCache::~LookupCache()
+{
+    delete d;
+}
+
+bool LookupCache::find(Sheet* sheet, const QRect& range, Qt::Orientation orientation,
+                       const Value& data, const Value& key, bool rangeLookup,
+                       Qt::CaseSensitivity caseSensitivity, int* position)
+{
+    LookupEntry needle;
+    if (!sheet || !makeEntry(key, caseSensitivity, &needle))
+        return false;
+    // An empty string equals empty cells, which are not indexed.
+    if (needle.kind == StringKind && needle.string.isEmpty())
+        return false;
+    if (!data.isArray() || int(data.columns()) != range.width() || int(data.rows()) != range.height())
+        return false;
+    if (((orientation == Qt::Vertical) ? range.height() : range.width()) < g_minimumIndexSize)
+        return false;
+
+    LookupKey lookupKey;
+    lookupKey.range = range;
+    lookupKey.orientation = orientation;
+    lookupKey.caseSensitivity = caseSensitivity;
+
+    QSharedPointer<const LookupIndex> index;
+    {
+        QMutexLocker locker(&d->mutex);
+        index = d->indices.value(sheet, lookupKey);
+        if (!index) {
+            index = QSharedPointer<const LookupIndex>(new LookupIndex(data, orientation, caseSensitivity));
+            d->indices.insert(sheet, lookupKey, index);
+        }
+    }
+    *position = index->find(needle, rangeLookup);
+    return true;
+}
+
+void LookupCache::regionChanged(Sheet* sheet, const Region& region)
+{
+    // Most damages occur without any lookup index.
+    if (d->indices.isEmpty())
+        return;
+    QMutexLocker locker(&d->mutex);
+    d->indices.regionChanged(sheet, region);
+}
+
+void LookupCache::removeSheet(Sheet* sheet)
+{
+    QMutexLocker locker(&d->mutex);
+    d->indices.removeSheet(sheet);
+}
+
+void LookupCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->indices.clear();
+}
@@ -0,0 +1,109 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_LOOKUP_CACHE
+#define CALLIGRA_SHEETS_LOOKUP_CACHE
+
+#include <Qt>
+
+#include "sheets_odf_export.h"
+
+class QRect;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Region;
+class Sheet;
+class Value;
+
+/**
+ * \class LookupCache
+ * \brief Caches search indices for the lookup functions.
+ * \ingroup Value
+ *
+ * VLOOKUP, HLOOKUP and MATCH search the first column or row of a cell
+ * range. For large ranges an index of this line is built on the first
+ * lookup. It consists of the values sorted in their natural order, which
+ * is searched binary, and of a hash of the strings for exact matches.
+ * Numbers are compared with a tolerance and always use the sorted values.
+ *
+ * An index is kept until a CellDamage touches its range.
+ *
+ * The cache may be used from several threads at once.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT LookupCache
+{
+public:
+    /**
+     * Constructor.
+     */
+    LookupCache();
+
+    /**
+     * Destructor.
+     */
+    ~LookupCache();
+
+    /**
+     * Searches \p key in the first line of \p range on \p sheet .
+     *
+     * The position of the first value equal to \p key is returned. If there
+     * is none and \p rangeLookup is set, the position of the first occurrence
+     * of the largest value less than \p key is returned. Empty cells and
+     * errors are never found.
+     *
+     * \param data the values of \p range
+     * \param orientation Qt::Vertical searches the first column,
+     *                    Qt::Horizontal searches the first row
+     * \param position the zero-based position in the line or -1, if nothing was found
+     * \return \c false, if the cache cannot handle this lookup; the caller
+     *         has to search the values itself then
+     */
+    bool find(Sheet* sheet, const QRect& range, Qt::Orientation orientation,
+              const Value& data, const Value& key, bool rangeLookup,
+              Qt::CaseSensitivity caseSensitivity, int* position);
+
+    /**
+     * Drops the indices of the ranges on \p sheet intersecting \p region .
+     */
+    void regionChanged(Sheet* sheet, const Region& region);
+
+    /**
+     * Drops the indices of the ranges on \p sheet .
+     */
+    void removeSheet(Sheet* sheet);
+
+    /**
+     * Drops all indices.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(LookupCache)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_LOOKUP_CACHE
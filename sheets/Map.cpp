@@ -24,6 +24,10 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include <QAtomicInt>
+#include <QHash>
+#include <QPair>
+#include <QRegion>
 #include <QTimer>
 
 #include <kcodecs.h>
@@ -40,15 +44,19 @@
 #include "BindingManager.h"
 #include "CalculationSettings.h"
 #include "CellStorage.h"
+#include "CriteriaCache.h"
 #include "Damages.h"
 #include "DependencyManager.h"
 #include "DocBase.h"
 #include "LoadingInfo.h"
 #include "Localization.h"
+#include "LookupCache.h"
 #include "NamedAreaManager.h"
 #include "RecalcManager.h"
+#include "Region.h"
 #include "RowColumnFormat.h"
 #include "Sheet.h"
+#include "StringPool.h"
 #include "StyleManager.h"
 #include "ValueCalc.h"
 #include "ValueConverter.h"
@@ -57,6 +65,7 @@
 
 // database
 #include "database/DatabaseManager.h"
+#include "database/FilterCache.h"
 
 using namespace Calligra::Sheets;
 
@@ -76,7 +85,7 @@ public:
 
     // used to determine the loading progress
     int overallRowCount;
-    int loadedRowsCounter;
+    QAtomicInt loadedRowsCounter; // the sheets may be loaded in parallel
 
     LoadingInfo* loadingInfo;
     bool readwrite;
@@ -84,10 +93,14 @@ public:
     BindingManager* bindingManager;
     DatabaseManager* databaseManager;
     DependencyManager* dependencyManager;
+    LookupCache* lookupCache;
+    CriteriaCache* criteriaCache;
+    FilterCache* filterCache;
     NamedAreaManager* namedAreaManager;
     RecalcManager* recalcManager;
     StyleManager* styleManager;
     KoStyleManager* textStyleManager;
+    StringPool* stringPool;
 
     ApplicationSettings* applicationSettings;
     CalculationSettings* calculationSettings;
@@ -101,13 +114,56 @@ public:
     RowFormat* defaultRowFormat;
 
     QList<Damage*> damages;
+    // The cell damages since the last other damage, merged per sheet and changes.
+    QList<QPair<Sheet*, int> > cellDamageKeys;
+    QHash<QPair<Sheet*, int>, QRegion> cellDamageRegions;
+    bool flushScheduled;
     bool isLoading;
 
+    // incremented, if formulas need to resolve their references again
+    int referenceGeneration;
+
     int syntaxVersion;
 
     KCompletion listCompletion;
+
+public:
+    void dropCaches(Sheet* sheet, const Region& region);
+    void addCellDamageRect(Sheet* sheet, const QRect& rect, int changes);
+    void mergeCellDamages();
 };
 
+void Map::Private::dropCaches(Sheet* sheet, const Region& region)
+{
+    lookupCache->regionChanged(sheet, region);
+    criteriaCache->regionChanged(sheet, region);
+    filterCache->regionChanged(sheet, region);
+}
+
+void Map::Private::addCellDamageRect(Sheet* sheet, const QRect& rect, int changes)
+{
+    const QPair<Sheet*, int> key(sheet, changes);
+    QHash<QPair<Sheet*, int>, QRegion>::Iterator it = cellDamageRegions.find(key);
+    if (it == cellDamageRegions.end()) {
+        cellDamageKeys.append(key);
+        it = cellDamageRegions.insert(key, QRegion());
+    }
+    *it += rect;
+}
+
+void Map::Private::mergeCellDamages()
+{
+    for (int i = 0; i < cellDamageKeys.count(); ++i) {
+        const QPair<Sheet*, int>& key = cellDamageKeys[i];
+        Region region;
+        foreach (const QRect& rect, cellDamageRegions.value(key).rects())
+            region.add(rect, key.first);
+        damages.append(new CellDamage(key.first, region, CellDamage::Changes(QFlag(key.second))));
+    }
+    cellDamageKeys.clear();
+    cellDamageRegions.clear();
+}
+
 
 Map::Map(DocBase* doc, int syntaxVersion)
         : QObject(doc),
@@ -117,17 +173,21 @@ Map::Map(DocBase* doc, int syntaxVersion)
     d->doc = doc;
     d->tableId = 1;
     d->overallRowCount = 0;
-    d->loadedRowsCounter = 0;
+    d->loadedRowsCounter.store(0);
     d->loadingInfo = 0;
     d->readwrite = true;
 
     d->bindingManager = new BindingManager(this);
     d->databaseManager = new DatabaseManager(this);
     d->dependencyManager = new DependencyManager(this);
+    d->lookupCache = new LookupCache();
+    d->criteriaCache = new CriteriaCache();
+    d->filterCache = new FilterCache();
     d->namedAreaManager = new NamedAreaManager(this);
     d->recalcManager = new RecalcManager(this);
     d->styleManager = new StyleManager();
     d->textStyleManager = new KoStyleManager(this);
+    d->stringPool = new StringPool();
     d->applicationSettings = new ApplicationSettings();
     d->calculationSettings = new CalculationSettings();
 
@@ -143,7 +203,9 @@ Map::Map(DocBase* doc, int syntaxVersion)
     d->defaultRowFormat->setHeight(font.pointSizeF() + 4);
     d->defaultColumnFormat->setWidth((font.pointSizeF() + 4) * 5);
 
+    d->flushScheduled = false;
     d->isLoading = false;
+    d->referenceGeneration = 0;
 
     // default document properties
     d->syntaxVersion = syntaxVersion;
@@ -160,6 +222,8 @@ Map::Map(DocBase* doc, int syntaxVersion)
             d->dependencyManager, SLOT(addSheet(Sheet*)));
     connect(this, SIGNAL(sheetRevived(Sheet*)),
             d->recalcManager, SLOT(addSheet(Sheet*)));
+    connect(d->namedAreaManager, SIGNAL(namedAreaModified(QString)),
+            this, SLOT(invalidateReferences()));
     connect(d->namedAreaManager, SIGNAL(namedAreaModified(QString)),
             d->dependencyManager, SLOT(namedAreaModified(QString)));
     connect(this, SIGNAL(damagesFlushed(QList<Damage*>)),
@@ -182,9 +246,13 @@ Map::~Map()
     delete d->bindingManager;
     delete d->databaseManager;
     delete d->dependencyManager;
+    delete d->lookupCache;
+    delete d->criteriaCache;
+    delete d->filterCache;
     delete d->namedAreaManager;
     delete d->recalcManager;
     delete d->styleManager;
+    delete d->stringPool;
 
     delete d->parser;
     delete d->formatter;
@@ -224,6 +292,15 @@ bool Map::completeLoading(KoStore *store)
         recalcUpdater = doc()->progressUpdater()->startSubtask(1, "Calligra::Sheets::RecalcManager::recalc");
     }
 
+    // Cell values were set without damages while loading.
+    d->lookupCache->clear();
+    d->criteriaCache->clear();
+    d->filterCache->clear();
+    foreach (Sheet* sheet, d->lstSheets) {
+        const StringPool::Statistics statistics = d->stringPool->statistics(sheet);
+        debugSheets << sheet->sheetName() << "interned" << statistics.strings << "strings,"
+                    << statistics.reused << "reused," << statistics.savedBytes << "of" << statistics.bytes << "bytes saved";
+    }
     // Initial build of all cell dependencies.
     d->dependencyManager->updateAllDependencies(this, dependencyUpdater);
     // Recalc the whole workbook now, since there may be formulas other spreadsheets support,
@@ -256,6 +333,26 @@ DependencyManager* Map::dependencyManager() const
     return d->dependencyManager;
 }
 
+LookupCache* Map::lookupCache() const
+{
+    return d->lookupCache;
+}
+
+CriteriaCache* Map::criteriaCache() const
+{
+    return d->criteriaCache;
+}
+
+FilterCache* Map::filterCache() const
+{
+    return d->filterCache;
+}
+
+StringPool* Map::stringPool() const
+{
+    return d->stringPool;
+}
+
 NamedAreaManager* Map::namedAreaManager() const
 {
     return d->namedAreaManager;
@@ -266,6 +363,16 @@ RecalcManager* Map::recalcManager() const
     return d->recalcManager;
 }
 
+int Map::referenceGeneration() const
+{
+    return d->referenceGeneration;
+}
+
+void Map::invalidateReferences()
+{
+    ++d->referenceGeneration;
+}
+
 StyleManager* Map::styleManager() const
 {
     return d->styleManager;
@@ -340,6 +447,7 @@ Sheet* Map::createSheet(const QString& name)
 void Map::addSheet(Sheet *_sheet)
 {
     d->lstSheets.append(_sheet);
+    invalidateReferences();
     emit sheetAdded(_sheet);
 }
 
@@ -414,7 +522,7 @@ QDomElement Map::save(QDomDocument& doc)
 
 bool Map::loadXML(const KoXmlElement& mymap)
 {
-    d->isLoading = true;
+    setLoading(true);
     loadingInfo()->setFileFormat(LoadingInfo::NativeFormat);
     const QString activeSheet = mymap.attribute("activeTable");
     const QPoint marker(mymap.attribute("markerColumn").toInt(), mymap.attribute("markerRow").toInt());
@@ -426,7 +534,7 @@ bool Map::loadXML(const KoXmlElement& mymap)
     if (n.isNull()) {
         // We need at least one sheet !
         doc()->setErrorMessage(i18n("This document has no sheets (tables)."));
-        d->isLoading = false;
+        setLoading(false);
         return false;
     }
     while (!n.isNull()) {
@@ -434,7 +542,7 @@ bool Map::loadXML(const KoXmlElement& mymap)
         if (!e.isNull() && e.tagName() == "table") {
             Sheet *t = addNewSheet();
             if (!t->loadXML(e)) {
-                d->isLoading = false;
+                setLoading(false);
                 return false;
             }
         }
@@ -448,7 +556,7 @@ bool Map::loadXML(const KoXmlElement& mymap)
         loadingInfo()->setInitialActiveSheet(findSheet(activeSheet));
     }
 
-    d->isLoading = false;
+    setLoading(false);
     return true;
 }
 
@@ -501,6 +609,11 @@ void Map::removeSheet(Sheet* sheet)
     d->lstSheets.removeAll(sheet);
     d->lstDeletedSheets.append(sheet);
     d->namedAreaManager->remove(sheet);
+    d->lookupCache->removeSheet(sheet);
+    d->criteriaCache->removeSheet(sheet);
+    d->filterCache->removeSheet(sheet);
+    d->stringPool->removeSheet(sheet);
+    invalidateReferences();
     emit sheetRemoved(sheet);
 }
 
@@ -508,6 +621,7 @@ void Map::reviveSheet(Sheet* sheet)
 {
     d->lstDeletedSheets.removeAll(sheet);
     d->lstSheets.append(sheet);
+    invalidateReferences();
     emit sheetRevived(sheet);
 }
 
@@ -560,9 +674,9 @@ void Map::setOverallRowsCounter(int number)
 
 int Map::increaseLoadedRowsCounter(int number)
 {
-    d->loadedRowsCounter += number;
+    const int loadedRowsCounter = d->loadedRowsCounter.fetchAndAddOrdered(number) + number;
     if (d->overallRowCount) {
-        return 100 * d->loadedRowsCounter / d->overallRowCount;
+        return 100 * loadedRowsCounter / d->overallRowCount;
     }
     return -1;
 }
@@ -575,6 +689,8 @@ bool Map::isLoading() const
 
 void Map::setLoading(bool l) {
     d->isLoading = l;
+    // Pool the strings of the loaded cells only, see StringPool.
+    d->stringPool->setEnabled(l);
 }
 
 int Map::syntaxVersion() const
@@ -621,6 +737,24 @@ void Map::addDamage(Damage* damage)
 //     Q_ASSERT(!isLoading());
     Q_CHECK_PTR(damage);
 
+    if (damage->type() == Damage::Cell) {
+        CellDamage* cellDamage = static_cast<CellDamage*>(damage);
+        // Column/row insertions and removals shift the named areas.
+        if (cellDamage->changes() & CellDamage::NamedArea) {
+            invalidateReferences();
+        }
+        // Drop the lookup, criteria and filter caches immediately. Recalculations do not wait for
+        // the damages to get processed.
+        if (cellDamage->changes() & (CellDamage::Binding | CellDamage::Formula |
+                                     CellDamage::NamedArea | CellDamage::Value)) {
+            d->dropCaches(cellDamage->sheet(), cellDamage->region());
+        }
+    } else if (damage->type() == Damage::Workbook) {
+        d->lookupCache->clear();
+        d->criteriaCache->clear();
+        d->filterCache->clear();
+    }
+
 #ifndef NDEBUG
     if (damage->type() == Damage::Cell) {
         debugSheetsDamage << "Adding\t" << *static_cast<CellDamage*>(damage);
@@ -633,15 +767,64 @@ void Map::addDamage(Damage* damage)
     }
 #endif
 
-    d->damages.append(damage);
+    // Merge the cell damages, so that bulk edits get processed like one
+    // region-wide change. Other damages keep their order.
+    bool merged = false;
+    if (damage->type() == Damage::Cell) {
+        CellDamage* cellDamage = static_cast<CellDamage*>(damage);
+        Sheet* const sheet = cellDamage->sheet();
+        const Region& region = cellDamage->region();
+        merged = true;
+        Region::ConstIterator end(region.constEnd());
+        for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+            if ((*it)->sheet() && (*it)->sheet() != sheet) {
+                merged = false;
+                break;
+            }
+        }
+        if (merged) {
+            for (Region::ConstIterator it(region.constBegin()); it != end; ++it)
+                d->addCellDamageRect(sheet, (*it)->rect(), int(cellDamage->changes()));
+            delete damage;
+        }
+    }
+    if (!merged) {
+        d->mergeCellDamages();
+        d->damages.append(damage);
+    }
+
+    if (!d->flushScheduled) {
+        d->flushScheduled = true;
+        QTimer::singleShot(0, this, SLOT(flushDamages()));
+    }
+}
+
+void Map::addCellDamage(Sheet* sheet, const QRect& range, CellDamage::Changes changes)
+{
+    if (!Region::isValid(range))
+        return;
+    if (changes & CellDamage::NamedArea) {
+        invalidateReferences();
+    }
+    if (changes & (CellDamage::Binding | CellDamage::Formula | CellDamage::NamedArea | CellDamage::Value)) {
+        d->dropCaches(sheet, Region(range, sheet));
+    }
+#ifndef NDEBUG
+    debugSheetsDamage << "Adding\t" << sheet << range << changes;
+#endif
+
+    d->addCellDamageRect(sheet, range, int(changes));
 
-    if (d->damages.count() == 1) {
+    if (!d->flushScheduled) {
+        d->flushScheduled = true;
         QTimer::singleShot(0, this, SLOT(flushDamages()));
     }
 }
 
 void Map::flushDamages()
 {
+    d->mergeCellDamages();
+    d->flushScheduled = false;
     // Copy the damages to process. This allows new damages while processing.
     QList<Damage*> damages = d->damages;
     d->damages.clear();
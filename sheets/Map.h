@@ -26,6 +26,7 @@
 #include <QString>
 #include <QStringList>
 
+#include "Damages.h"
 #include "ProtectableObject.h"
 
 #include "sheets_odf_export.h"
@@ -41,6 +42,7 @@ class KCompletion;
 
 class QDomElement;
 class QDomDocument;
+class QRect;
 class KUndo2Command;
 
 class KoXmlWriter;
@@ -53,15 +55,18 @@ class ApplicationSettings;
 class BindingManager;
 class CalculationSettings;
 class ColumnFormat;
-class Damage;
+class CriteriaCache;
 class DatabaseManager;
 class DependencyManager;
 class DocBase;
+class FilterCache;
 class LoadingInfo;
+class LookupCache;
 class NamedAreaManager;
 class RecalcManager;
 class RowFormat;
 class Sheet;
+class StringPool;
 class Style;
 class StyleManager;
 class ValueParser;
@@ -121,6 +126,26 @@ public:
      */
     DependencyManager* dependencyManager() const;
 
+    /**
+     * \return a pointer to the cache of the conditional aggregate matches
+     */
+    CriteriaCache* criteriaCache() const;
+
+    /**
+     * \return a pointer to the cache of the filtered database fields
+     */
+    FilterCache* filterCache() const;
+
+    /**
+     * \return a pointer to the pool of the cell strings
+     */
+    StringPool* stringPool() const;
+
+    /**
+     * \return a pointer to the cache of the lookup function indices
+     */
+    LookupCache* lookupCache() const;
+
     /**
      * \return a pointer to the named area manager
      */
@@ -131,6 +156,15 @@ public:
      */
     RecalcManager* recalcManager() const;
 
+    /**
+     * \return the current generation of cell and range references
+     *
+     * Compiled formulas resolve their references once and reuse them until
+     * this number changes.
+     * \see invalidateReferences()
+     */
+    int referenceGeneration() const;
+
     /**
      * @return the StyleManager of this Document
      */
@@ -333,9 +367,19 @@ public:
 
     /**
      * \ingroup Damages
+     * Takes ownership of \p damage . The cell damages are merged per sheet
+     * and changes until the next flush.
      */
     void addDamage(Damage* damage);
 
+    /**
+     * \ingroup Damages
+     * Adds a damage of the cells in \p range on \p sheet like addDamage()
+     * does, but without allocating a CellDamage. Meant for the frequent
+     * changes of single cells.
+     */
+    void addCellDamage(Sheet* sheet, const QRect& range, CellDamage::Changes changes);
+
     /**
      * Return a pointer to the resource manager associated with the
      * document. The resource manager contains
@@ -362,6 +406,14 @@ public Q_SLOTS:
      */
     void addCommand(KUndo2Command *command);
 
+    /**
+     * Invalidates the references resolved by compiled formulas.
+     * Called, if reference strings may denote other cells than before, i.e.
+     * on sheet additions, removals and renamings, named area changes and
+     * column/row insertions or removals.
+     */
+    void invalidateReferences();
+
 Q_SIGNALS:
     /**
      * \ingroup Damages
@@ -800,6 +800,15 @@ public:
         return m_data.value(index);
     }
 
+    /**
+     * Returns a reference to the non-default data at \p index .
+     * Avoids the copy of data(); \p index has to be valid.
+     * \see data()
+     */
+    const T& constData(int index) const {
+        return m_data.at(index);
+    }
+
     /**
      * The maximum occupied column, i.e. the horizontal storage dimension.
      * \return the maximum column
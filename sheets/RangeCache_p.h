@@ -0,0 +1,143 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_RANGE_CACHE_P
+#define CALLIGRA_SHEETS_RANGE_CACHE_P
+
+// Sheets
+#include "Region.h"
+#include "RTree.h"
+
+// Qt
+#include <QAtomicInt>
+#include <QHash>
+#include <QPair>
+#include <QRect>
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Sheet;
+
+/**
+ * \class RangeCache
+ * \brief Cached data of cell ranges, which is dropped when the cells change.
+ * \ingroup Value
+ *
+ * The keys need a \c range member, an equality operator and a qHash().
+ * The ranges of each sheet are kept in an RTree, so that a change only
+ * visits the entries intersecting it.
+ *
+ * Except for isEmpty(), the caller has to serialize the access.
+ */
+template<typename Key, typename T>
+class RangeCache
+{
+public:
+    RangeCache() : m_nextId(0) {}
+    ~RangeCache() {
+        clear();
+    }
+
+    /**
+     * \return \c true, if nothing is cached; may be called without locking
+     */
+    bool isEmpty() const {
+        return m_count.load() == 0;
+    }
+
+    T value(Sheet* sheet, const Key& key) const {
+        const Entries* entries = m_sheets.value(sheet);
+        if (!entries)
+            return T();
+        return entries->values.value(key).second;
+    }
+
+    void insert(Sheet* sheet, const Key& key, const T& value) {
+        Entries*& entries = m_sheets[sheet];
+        if (!entries)
+            entries = new Entries;
+        const typename QHash<Key, QPair<int, T> >::Iterator it = entries->values.find(key);
+        if (it != entries->values.end()) {
+            it->second = value;
+            return;
+        }
+        const int id = m_nextId++;
+        entries->values.insert(key, qMakePair(id, value));
+        entries->keys.insert(id, key);
+        entries->tree.insert(key.range, id);
+        m_count.ref();
+    }
+
+    /**
+     * Drops the entries of the ranges on \p sheet intersecting \p region .
+     */
+    void regionChanged(Sheet* sheet, const Region& region) {
+        Entries* entries = m_sheets.value(sheet);
+        if (!entries)
+            return;
+        Region::ConstIterator end(region.constEnd());
+        for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+            const QList<int> ids = entries->tree.intersects((*it)->rect());
+            for (int i = 0; i < ids.count(); ++i) {
+                const Key key = entries->keys.take(ids[i]);
+                entries->tree.remove(key.range, ids[i]);
+                entries->values.remove(key);
+                m_count.deref();
+            }
+        }
+        if (entries->values.isEmpty()) {
+            m_sheets.remove(sheet);
+            delete entries;
+        }
+    }
+
+    void removeSheet(Sheet* sheet) {
+        Entries* entries = m_sheets.take(sheet);
+        if (!entries)
+            return;
+        m_count.fetchAndAddOrdered(-entries->values.count());
+        delete entries;
+    }
+
+    void clear() {
+        qDeleteAll(m_sheets);
+        m_sheets.clear();
+        m_count.store(0);
+    }
+
+private:
+    Q_DISABLE_COPY(RangeCache)
+
+    struct Entries {
+        QHash<Key, QPair<int, T> > values;
+        QHash<int, Key> keys;
+        RTree<int> tree;
+    };
+
+    QHash<Sheet*, Entries*> m_sheets;
+    QAtomicInt m_count;
+    int m_nextId;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_RANGE_CACHE_P
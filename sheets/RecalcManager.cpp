@@ -27,20 +27,94 @@
 #include "Formula.h"
 #include "FormulaStorage.h"
 #include "Map.h"
+#include "RecalcProfile.h"
 #include "Sheet.h"
 #include "Region.h"
 #include "Value.h"
 #include "ValueFormatter.h"
+#include "CalculationSettings.h"
 #include "DocBase.h"
 #include "ElapsedTime_p.h"
 
 #include <KoUpdater.h>
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QMap>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
 
 using namespace Calligra::Sheets;
 
+// Levels with less cells are evaluated in the calling thread.
+static const int g_minimumParallelLevelSize = 64;
+// The number of cells a worker takes at once from the level.
+static const int g_parallelChunkSize = 16;
+
+/**
+ * The error values are created on first use. Make sure this happened
+ * before several threads may ask for them at once.
+ */
+static void initializeErrorValues()
+{
+    Value::null();
+    Value::errorCIRCLE();
+    Value::errorDEPEND();
+    Value::errorDIV0();
+    Value::errorNA();
+    Value::errorNAME();
+    Value::errorNUM();
+    Value::errorNULL();
+    Value::errorPARSE();
+    Value::errorREF();
+    Value::errorVALUE();
+}
+
+namespace Calligra
+{
+namespace Sheets
+{
+/**
+ * \internal
+ * Evaluates the formulas of one reference depth level.
+ * The workers pick chunks of cells from a shared counter until the level is
+ * exhausted, so that idle threads take over the remaining work. Only reading
+ * access to the storages happens here; the results are stored afterwards.
+ */
+class RecalcLevelJob : public QRunnable
+{
+public:
+    RecalcLevelJob(const Cell* cells, Value* results, qint64* times, int count, QAtomicInt* next)
+            : m_cells(cells), m_results(results), m_times(times), m_count(count), m_next(next) {}
+
+    virtual void run() {
+        QElapsedTimer timer;
+        int begin;
+        while ((begin = m_next->fetchAndAddOrdered(g_parallelChunkSize)) < m_count) {
+            const int end = qMin(begin + g_parallelChunkSize, m_count);
+            for (int i = begin; i < end; ++i) {
+                if (m_times)
+                    timer.start();
+                m_results[i] = m_cells[i].formula().eval();
+                if (m_times)
+                    m_times[i] = timer.nsecsElapsed();
+            }
+        }
+    }
+
+private:
+    const Cell* m_cells;
+    Value* m_results;
+    qint64* m_times; // evaluation times, if profiling
+    int m_count;
+    QAtomicInt* m_next;
+};
+} // namespace Sheets
+} // namespace Calligra
+
 class Q_DECL_HIDDEN RecalcManager::Private
 {
 public:
@@ -62,9 +136,29 @@ public:
     void cellsToCalculate(Sheet* sheet = 0);
 
     /**
-     * Helper function for cellsToCalculate(const Region&) and cellsToCalculate(Sheet*).
+     * \return \c true, if \p cell has a valid formula and is not part of a
+     * circular dependency. Parses the formula, if not done already.
+     */
+    bool needsRecalculation(const Cell& cell) const;
+
+    /**
+     * Stores the formula \p result of \p cell. Array results are distributed
+     * over the cells locked by \p cell.
      */
-    void cellsToCalculate(const Region& region, QSet<Cell>& cells) const;
+    void storeResult(const Cell& cell, const Value& result) const;
+
+    /**
+     * Evaluates the cells one by one in the order of their reference depth.
+     */
+    void recalcSerial(KoUpdater *updater);
+
+    /**
+     * Evaluates the cells of each reference depth level concurrently and
+     * stores the results before the next level is processed.
+     * Cells of the same depth cannot refer to each other, hence the results
+     * equal those of recalcSerial().
+     */
+    void recalcParallel(KoUpdater *updater);
 
     /*
      * Stores cells ordered by its reference depth.
@@ -84,30 +178,136 @@ public:
     QMap<int, Cell> cells;
     const Map* map;
     bool active;
+    QThreadPool threadPool;
+    RecalcProfile* profile;
 };
 
+bool RecalcManager::Private::needsRecalculation(const Cell& cell) const
+{
+    // only recalculate, if no circular dependency occurred
+    if (cell.value() == Value::errorCIRCLE())
+        return false;
+    // Check for valid formula; parses the expression, if not done already.
+    return cell.formula().isValid();
+}
+
+void RecalcManager::Private::storeResult(const Cell& cell, const Value& result) const
+{
+    const Sheet* sheet = cell.sheet();
+    if (result.isArray() && (result.columns() > 1 || result.rows() > 1)) {
+        const QRect rect = cell.lockedCells();
+        // unlock
+        sheet->cellStorage()->unlockCells(rect.left(), rect.top());
+        for (int row = rect.top(); row <= rect.bottom(); ++row) {
+            for (int col = rect.left(); col <= rect.right(); ++col) {
+                Cell(sheet, col, row).setValue(result.element(col - rect.left(), row - rect.top()));
+            }
+        }
+        // relock
+        sheet->cellStorage()->lockCells(rect);
+    } else {
+        Cell(cell).setValue(result);
+    }
+}
+
+void RecalcManager::Private::recalcSerial(KoUpdater *updater)
+{
+    const int cellsCount = cells.count();
+    QElapsedTimer timer;
+    int c = 0;
+    QMap<int, Cell>::ConstIterator end(cells.constEnd());
+    for (QMap<int, Cell>::ConstIterator it(cells.constBegin()); it != end; ++it, ++c) {
+        const Cell cell = it.value();
+        if (!needsRecalculation(cell))
+            continue;
+
+        // evaluate the formula and set the result
+        if (profile) {
+            timer.start();
+            const Value result = cell.formula().eval();
+            profile->addCell(cell, it.key(), timer.nsecsElapsed());
+            storeResult(cell, result);
+        } else {
+            storeResult(cell, cell.formula().eval());
+        }
+        if (updater)
+            updater->setProgress(int(qreal(c) / qreal(cellsCount) * 100.));
+    }
+}
+
+void RecalcManager::Private::recalcParallel(KoUpdater *updater)
+{
+    const int threadCount = map->calculationSettings()->calculationThreadCount();
+    threadPool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+    initializeErrorValues();
+
+    const int cellsCount = cells.count();
+    int processed = 0;
+    QVector<Cell> level;
+    QVector<Value> results;
+    QVector<qint64> times;
+    QMap<int, Cell>::ConstIterator it(cells.constBegin());
+    const QMap<int, Cell>::ConstIterator end(cells.constEnd());
+    while (it != end) {
+        // Collect the level. Parsing the formulas is not thread-safe and
+        // happens here.
+        const int depth = it.key();
+        level.clear();
+        for (; it != end && it.key() == depth; ++it, ++processed) {
+            if (needsRecalculation(it.value()))
+                level.append(it.value());
+        }
+
+        // evaluate the formulas
+        const int count = level.count();
+        results.fill(Value(), count);
+        if (profile)
+            times.fill(0, count);
+        qint64* const levelTimes = profile ? times.data() : 0;
+        QAtomicInt next(0);
+        RecalcLevelJob job(level.constData(), results.data(), levelTimes, count, &next);
+        job.setAutoDelete(false);
+        if (count >= g_minimumParallelLevelSize && threadPool.maxThreadCount() > 1) {
+            const int jobs = qMin(threadPool.maxThreadCount(), count / g_parallelChunkSize) - 1;
+            for (int j = 0; j < jobs; ++j)
+                threadPool.start(new RecalcLevelJob(level.constData(), results.data(), levelTimes, count, &next));
+            // the calling thread takes part, too
+            job.run();
+            threadPool.waitForDone();
+        } else {
+            job.run();
+        }
+
+        // set the results
+        for (int c = 0; c < count; ++c)
+            storeResult(level[c], results[c]);
+        if (profile) {
+            for (int c = 0; c < count; ++c)
+                profile->addCell(level[c], depth, times[c]);
+        }
+        if (updater)
+            updater->setProgress(int(qreal(processed) / qreal(cellsCount) * 100.));
+    }
+}
+
 void RecalcManager::Private::cellsToCalculate(const Region& region)
 {
     if (region.isEmpty())
         return;
 
-    // retrieve the cell depths
-    QMap<Cell, int> depths = map->dependencyManager()->depths();
-
     // create the cell map ordered by depth
-    QSet<Cell> cells;
-    cellsToCalculate(region, cells);
-    const QSet<Cell>::ConstIterator end(cells.end());
-    for (QSet<Cell>::ConstIterator it(cells.begin()); it != end; ++it) {
-        if ((*it).sheet()->isAutoCalculationEnabled())
-            this->cells.insertMulti(depths[*it], *it);
+    const DependencyManager* manager = map->dependencyManager();
+    const QList<Cell> cells = manager->dependentCells(region);
+    for (int c = 0; c < cells.count(); ++c) {
+        const Cell& cell = cells[c];
+        if (cell.sheet()->isAutoCalculationEnabled())
+            this->cells.insertMulti(manager->depth(cell), cell);
     }
 }
 
 void RecalcManager::Private::cellsToCalculate(Sheet* sheet)
 {
-    // retrieve the cell depths
-    QMap<Cell, int> depths = map->dependencyManager()->depths();
+    const DependencyManager* manager = map->dependencyManager();
 
     // NOTE Stefan: It's necessary, that the cells are filled in row-wise;
     //              beginning with the top left; ending with the bottom right.
@@ -121,40 +321,13 @@ void RecalcManager::Private::cellsToCalculate(Sheet* sheet)
             sheet = map->sheet(s);
             for (int c = 0; c < sheet->formulaStorage()->count(); ++c) {
                 cell = Cell(sheet, sheet->formulaStorage()->col(c), sheet->formulaStorage()->row(c));
-                cells.insertMulti(depths[cell], cell);
+                cells.insertMulti(manager->depth(cell), cell);
             }
         }
     } else { // sheet recalculation
         for (int c = 0; c < sheet->formulaStorage()->count(); ++c) {
             cell = Cell(sheet, sheet->formulaStorage()->col(c), sheet->formulaStorage()->row(c));
-            cells.insertMulti(depths[cell], cell);
-        }
-    }
-}
-
-void RecalcManager::Private::cellsToCalculate(const Region& region, QSet<Cell>& cells) const
-{
-    Region::ConstIterator end(region.constEnd());
-    for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
-        const QRect range = (*it)->rect();
-        const Sheet* sheet = (*it)->sheet();
-        for (int col = range.left(); col <= range.right(); ++col) {
-            for (int row = range.top(); row <= range.bottom(); ++row) {
-                Cell cell(sheet, col, row);
-                // Even empty cells may act as value
-                // providers and need to be processed.
-
-                // check for already processed cells
-                if (cells.contains(cell))
-                    continue;
-
-                // add it to the list
-                if (cell.isFormula())
-                    cells.insert(cell);
-
-                // add its consumers to the list
-                cellsToCalculate(map->dependencyManager()->consumingRegion(cell), cells);
-            }
+            cells.insertMulti(manager->depth(cell), cell);
         }
     }
 }
@@ -165,10 +338,12 @@ RecalcManager::RecalcManager(Map *const map)
 {
     d->map  = map;
     d->active = false;
+    d->profile = 0;
 }
 
 RecalcManager::~RecalcManager()
 {
+    delete d->profile;
     delete d;
 }
 
@@ -236,37 +411,14 @@ void RecalcManager::recalc(KoUpdater *updater)
     if (updater)
         updater->setProgress(0);
 
-    const QList<Cell> cells = d->cells.values();
-    const int cellsCount = cells.count();
-    for (int c = 0; c < cellsCount; ++c) {
-        // only recalculate, if no circular dependency occurred
-        if (cells.value(c).value() == Value::errorCIRCLE())
-            continue;
-        // Check for valid formula; parses the expression, if not done already.
-        if (!cells.value(c).formula().isValid())
-            continue;
-
-        const Sheet* sheet = cells.value(c).sheet();
-
-        // evaluate the formula and set the result
-        Value result = cells.value(c).formula().eval();
-        if (result.isArray() && (result.columns() > 1 || result.rows() > 1)) {
-            const QRect rect = cells.value(c).lockedCells();
-            // unlock
-            sheet->cellStorage()->unlockCells(rect.left(), rect.top());
-            for (int row = rect.top(); row <= rect.bottom(); ++row) {
-                for (int col = rect.left(); col <= rect.right(); ++col) {
-                    Cell(sheet, col, row).setValue(result.element(col - rect.left(), row - rect.top()));
-                }
-            }
-            // relock
-            sheet->cellStorage()->lockCells(rect);
-        } else {
-            Cell(cells.value(c)).setValue(result);
-        }
-        if (updater)
-            updater->setProgress(int(qreal(c) / qreal(cellsCount) * 100.));
-    }
+    QElapsedTimer timer;
+    timer.start();
+    if (d->map->calculationSettings()->isParallelCalculationEnabled())
+        d->recalcParallel(updater);
+    else
+        d->recalcSerial(updater);
+    if (d->profile)
+        d->profile->addRecalculation(timer.nsecsElapsed());
 
     if (updater)
         updater->setProgress(100);
@@ -285,3 +437,23 @@ void RecalcManager::dump() const
         debugSheetsFormula << "depth(" << cellName << " ) =" << it.key();
     }
 }
+
+void RecalcManager::setProfilingEnabled(bool enable)
+{
+    if (enable && !d->profile) {
+        d->profile = new RecalcProfile();
+    } else if (!enable) {
+        delete d->profile;
+        d->profile = 0;
+    }
+}
+
+bool RecalcManager::isProfilingEnabled() const
+{
+    return d->profile != 0;
+}
+
+RecalcProfile* RecalcManager::profile() const
+{
+    return d->profile;
+}
@@ -32,6 +32,7 @@ namespace Sheets
 {
 class Cell;
 class Map;
+class RecalcProfile;
 class Sheet;
 
 /**
@@ -51,6 +52,13 @@ class Sheet;
  *
  * Cell value changes are blocked while doing this, i.e. they do not
  * trigger a new recalculation event.
+ *
+ * If enabled in the CalculationSettings, the cells of one reference depth
+ * are evaluated concurrently. The results are stored in a separate step
+ * before the next depth is processed.
+ *
+ * If profiling is enabled, the timings of the recalculations are collected
+ * in a RecalcProfile.
  */
 class CALLIGRA_SHEETS_ODF_EXPORT RecalcManager : public QObject
 {
@@ -103,6 +111,25 @@ public:
      */
     void dump() const;
 
+    /**
+     * Enables or disables the collection of recalculation timings.
+     * Disabling drops the collected data.
+     *
+     * \see profile()
+     */
+    void setProfilingEnabled(bool enable);
+
+    /**
+     * \return \c true, if the recalculation timings are collected
+     */
+    bool isProfilingEnabled() const;
+
+    /**
+     * \return the collected recalculation timings or \c 0, if profiling is
+     * disabled
+     */
+    RecalcProfile* profile() const;
+
 public Q_SLOTS:
     /**
      * Called after a sheet was added.
@@ -0,0 +1,295 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+// Local
+#include "RecalcProfile.h"
+
+#include "Formula.h"
+#include "FormulaStorage.h"
+#include "Map.h"
+#include "Region.h"
+#include "Sheet.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+
+using namespace Calligra::Sheets;
+
+namespace
+{
+
+bool slowerCell(const RecalcProfile::CellTiming& a, const RecalcProfile::CellTiming& b)
+{
+    return a.time > b.time;
+}
+
+bool slowerFunction(const RecalcProfile::FunctionTiming& a, const RecalcProfile::FunctionTiming& b)
+{
+    return a.time > b.time;
+}
+
+bool longerChain(const QPair<qint64, Cell>& a, const QPair<qint64, Cell>& b)
+{
+    return a.first > b.first;
+}
+
+bool lowerDepth(const RecalcProfile::CellTiming& a, const RecalcProfile::CellTiming& b)
+{
+    return a.depth < b.depth;
+}
+
+// The profiled cells referred to by the formula of cell.
+QList<Cell> precedents(const Cell& cell, const QHash<Cell, RecalcProfile::CellTiming>& cells)
+{
+    QList<Cell> result;
+    const Formula formula = cell.formula();
+    if (!formula.isValid())
+        return result;
+    const Tokens tokens = formula.tokens();
+    Sheet* const sheet = cell.sheet();
+    for (int i = 0; i < tokens.count(); ++i) {
+        const Token& token = tokens[i];
+        if (token.type() != Token::Cell && token.type() != Token::Range)
+            continue;
+        const Region region(token.text(), sheet->map(), sheet);
+        if (!region.isValid())
+            continue;
+        // only formula cells may have been profiled
+        Region::ConstIterator end(region.constEnd());
+        for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+            Sheet* const precedentSheet = (*it)->sheet();
+            const Region range((*it)->rect(), precedentSheet);
+            const FormulaStorageBase storage = precedentSheet->formulaStorage()->subStorage(range);
+            for (int j = 0; j < storage.count(); ++j) {
+                const Cell precedent(precedentSheet, storage.col(j), storage.row(j));
+                if (cells.contains(precedent))
+                    result.append(precedent);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+class Q_DECL_HIDDEN RecalcProfile::Private
+{
+public:
+    mutable QMutex mutex;
+    QHash<Cell, CellTiming> cells;
+    QHash<QString, FunctionTiming> functions;
+    QMap<int, int> depths;
+    int recalculations;
+    qint64 totalTime;
+};
+
+RecalcProfile::RecalcProfile()
+        : d(new Private)
+{
+    d->recalculations = 0;
+    d->totalTime = 0;
+}
+
+RecalcProfile::~RecalcProfile()
+{
+    delete d;
+}
+
+void RecalcProfile::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->cells.clear();
+    d->functions.clear();
+    d->depths.clear();
+    d->recalculations = 0;
+    d->totalTime = 0;
+}
+
+void RecalcProfile::addCell(const Cell& cell, int depth, qint64 time)
+{
+    QMutexLocker locker(&d->mutex);
+    QHash<Cell, CellTiming>::Iterator it = d->cells.find(cell);
+    if (it == d->cells.end()) {
+        CellTiming timing;
+        timing.cell = cell;
+        timing.evaluations = 0;
+        timing.time = 0;
+        it = d->cells.insert(cell, timing);
+    }
+    it->depth = depth;
+    ++it->evaluations;
+    it->time += time;
+    ++d->depths[depth];
+}
+
+void RecalcProfile::addFunctionCall(const QString& name, qint64 time)
+{
+    QMutexLocker locker(&d->mutex);
+    QHash<QString, FunctionTiming>::Iterator it = d->functions.find(name);
+    if (it == d->functions.end()) {
+        FunctionTiming timing;
+        timing.name = name;
+        timing.calls = 0;
+        timing.time = 0;
+        it = d->functions.insert(name, timing);
+    }
+    ++it->calls;
+    it->time += time;
+}
+
+void RecalcProfile::addRecalculation(qint64 time)
+{
+    QMutexLocker locker(&d->mutex);
+    ++d->recalculations;
+    d->totalTime += time;
+}
+
+int RecalcProfile::recalculations() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->recalculations;
+}
+
+qint64 RecalcProfile::totalTime() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->totalTime;
+}
+
+QList<RecalcProfile::CellTiming> RecalcProfile::cellTimings() const
+{
+    QMutexLocker locker(&d->mutex);
+    QList<CellTiming> timings = d->cells.values();
+    std::stable_sort(timings.begin(), timings.end(), slowerCell);
+    return timings;
+}
+
+QList<RecalcProfile::FunctionTiming> RecalcProfile::functionTimings() const
+{
+    QMutexLocker locker(&d->mutex);
+    QList<FunctionTiming> timings = d->functions.values();
+    std::stable_sort(timings.begin(), timings.end(), slowerFunction);
+    return timings;
+}
+
+QMap<int, int> RecalcProfile::depthHistogram() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->depths;
+}
+
+QList<RecalcProfile::Chain> RecalcProfile::slowestChains(int count) const
+{
+    QHash<Cell, CellTiming> cells;
+    {
+        QMutexLocker locker(&d->mutex);
+        cells = d->cells;
+    }
+
+    // The precedents have a lower depth. Process the cells in depth order and
+    // extend the most expensive chain of the precedents by each cell.
+    QList<CellTiming> timings = cells.values();
+    std::stable_sort(timings.begin(), timings.end(), lowerDepth);
+    QHash<Cell, qint64> chainTimes;
+    QHash<Cell, Cell> predecessors;
+    for (int i = 0; i < timings.count(); ++i) {
+        const CellTiming& timing = timings[i];
+        const QList<Cell> cellPrecedents = precedents(timing.cell, cells);
+        qint64 chainTime = 0;
+        for (int j = 0; j < cellPrecedents.count(); ++j) {
+            const Cell& precedent = cellPrecedents[j];
+            if (cells[precedent].depth >= timing.depth)
+                continue; // circular or outdated
+            const qint64 precedentTime = chainTimes.value(precedent);
+            if (precedentTime > chainTime || !predecessors.contains(timing.cell)) {
+                chainTime = precedentTime;
+                predecessors.insert(timing.cell, precedent);
+            }
+        }
+        chainTimes.insert(timing.cell, chainTime + timing.time);
+    }
+
+    // the most expensive chain ends first
+    QList<QPair<qint64, Cell> > ends;
+    for (QHash<Cell, qint64>::ConstIterator it = chainTimes.constBegin(); it != chainTimes.constEnd(); ++it)
+        ends.append(qMakePair(it.value(), it.key()));
+    std::stable_sort(ends.begin(), ends.end(), longerChain);
+
+    QList<Chain> chains;
+    QSet<Cell> reported;
+    for (int i = 0; i < ends.count() && chains.count() < count; ++i) {
+        Cell cell = ends[i].second;
+        if (reported.contains(cell))
+            continue;
+        Chain chain;
+        chain.time = ends[i].first;
+        while (!cell.isNull()) {
+            chain.cells.prepend(cell);
+            reported.insert(cell);
+            cell = predecessors.value(cell);
+        }
+        chains.append(chain);
+    }
+    return chains;
+}
+
+void RecalcProfile::dump(QTextStream& stream, int limit) const
+{
+    stream << "# recalculations\t" << recalculations() << "\ttime\t" << totalTime() << '\n';
+
+    const QList<CellTiming> cells = cellTimings();
+    stream << "[cells]\n";
+    stream << "# cell\tdepth\tevaluations\ttime\n";
+    for (int i = 0; i < cells.count() && i < limit; ++i) {
+        const CellTiming& timing = cells[i];
+        stream << timing.cell.fullName() << '\t' << timing.depth << '\t'
+               << timing.evaluations << '\t' << timing.time << '\n';
+    }
+
+    const QList<FunctionTiming> functions = functionTimings();
+    stream << "[functions]\n";
+    stream << "# function\tcalls\ttime\n";
+    for (int i = 0; i < functions.count() && i < limit; ++i) {
+        const FunctionTiming& timing = functions[i];
+        stream << timing.name << '\t' << timing.calls << '\t' << timing.time << '\n';
+    }
+
+    const QMap<int, int> depths = depthHistogram();
+    stream << "[depths]\n";
+    stream << "# depth\tevaluations\n";
+    for (QMap<int, int>::ConstIterator it = depths.constBegin(); it != depths.constEnd(); ++it)
+        stream << it.key() << '\t' << it.value() << '\n';
+
+    const QList<Chain> chains = slowestChains(limit);
+    stream << "[chains]\n";
+    stream << "# time\tlength\tcells\n";
+    for (int i = 0; i < chains.count(); ++i) {
+        const Chain& chain = chains[i];
+        QStringList names;
+        for (int j = 0; j < chain.cells.count(); ++j)
+            names.append(chain.cells[j].fullName());
+        stream << chain.time << '\t' << chain.cells.count() << '\t' << names.join(" > ") << '\n';
+    }
+}
@@ -0,0 +1,162 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_RECALC_PROFILE
+#define CALLIGRA_SHEETS_RECALC_PROFILE
+
+#include <QList>
+#include <QMap>
+#include <QString>
+
+#include "Cell.h"
+
+#include "sheets_odf_export.h"
+
+class QTextStream;
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+/**
+ * \class RecalcProfile
+ * \brief Collects timings of the recalculations.
+ * \ingroup Value
+ *
+ * If profiling is enabled in the RecalcManager, it records the evaluation
+ * time of each recalculated cell and Formula records the calls of each
+ * Function. The data accumulates over all recalculations until clear() is
+ * called.
+ *
+ * All times are given in nanoseconds. The time of a function is exclusive:
+ * the functions nested in its arguments are evaluated before it is called,
+ * so their time is recorded for them only.
+ *
+ * \see RecalcManager::setProfilingEnabled()
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT RecalcProfile
+{
+public:
+    /**
+     * The evaluations of a cell.
+     */
+    struct CellTiming {
+        Cell cell;
+        int depth;          ///< the reference depth in the last recalculation
+        int evaluations;
+        qint64 time;
+    };
+
+    /**
+     * The calls of a function.
+     */
+    struct FunctionTiming {
+        QString name;
+        int calls;
+        qint64 time;
+    };
+
+    /**
+     * A chain of cells, each referring to its predecessor.
+     */
+    struct Chain {
+        QList<Cell> cells;  ///< beginning with the cell without profiled precedents
+        qint64 time;        ///< the evaluation time of all cells
+    };
+
+    /**
+     * Constructor.
+     */
+    RecalcProfile();
+
+    /**
+     * Destructor.
+     */
+    ~RecalcProfile();
+
+    /**
+     * Drops all collected data.
+     */
+    void clear();
+
+    /**
+     * Records the evaluation of \p cell at reference depth \p depth .
+     */
+    void addCell(const Cell& cell, int depth, qint64 time);
+
+    /**
+     * Records a call of the function \p name .
+     * May be called from several threads at once.
+     */
+    void addFunctionCall(const QString& name, qint64 time);
+
+    /**
+     * Records a whole recalculation.
+     */
+    void addRecalculation(qint64 time);
+
+    /**
+     * \return the number of recorded recalculations
+     */
+    int recalculations() const;
+
+    /**
+     * \return the overall time of the recorded recalculations
+     */
+    qint64 totalTime() const;
+
+    /**
+     * \return the evaluated cells, the slowest first
+     */
+    QList<CellTiming> cellTimings() const;
+
+    /**
+     * \return the called functions, the slowest first
+     */
+    QList<FunctionTiming> functionTimings() const;
+
+    /**
+     * \return the number of cell evaluations per reference depth
+     */
+    QMap<int, int> depthHistogram() const;
+
+    /**
+     * Follows the references of the evaluated cells and returns the
+     * \p count most expensive chains. Cells are reported in one chain only.
+     */
+    QList<Chain> slowestChains(int count) const;
+
+    /**
+     * Writes a tab-separated report with the sections "cells", "functions",
+     * "depths" and "chains". Each section lists at most \p limit entries.
+     */
+    void dump(QTextStream& stream, int limit = 50) const;
+
+private:
+    Q_DISABLE_COPY(RecalcProfile)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_RECALC_PROFILE
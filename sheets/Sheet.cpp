@@ -24,6 +24,7 @@
 #include "Sheet.h"
 
 #include <QApplication>
+#include <QBitArray>
 
 #include <kcodecs.h>
 
@@ -1711,6 +1712,7 @@ bool Sheet::setSheetName(const QString& name, bool init)
 
     QString old_name = d->name;
     d->name = name;
+    map()->invalidateReferences();
 
     // FIXME: Why is the change of a sheet's name not supposed to be propagated here?
     // If it is not, we have to manually do so in the loading process, e.g. for the
@@ -1796,8 +1798,9 @@ void Sheet::applyDatabaseFilter(const Database &database)
     const QRect range = database.range().lastRange();
     const int start = database.orientation() == Qt::Vertical ? range.top() : range.left();
     const int end = database.orientation() == Qt::Vertical ? range.bottom() : range.right();
+    const QBitArray matches = database.filter().evaluate(database);
     for (int i = start + 1; i <= end; ++i) {
-        const bool isFiltered = !database.filter().evaluate(database, i);
+        const bool isFiltered = !matches.testBit(i - start - 1);
 //         debugSheets <<"Filtering column/row" << i <<"?" << isFiltered;
         if (database.orientation() == Qt::Vertical) {
             sheet->rowFormats()->setFiltered(i, i, isFiltered);
@@ -0,0 +1,162 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+// Local
+#include "StringPool.h"
+
+#include "Value.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+
+using namespace Calligra::Sheets;
+
+class Q_DECL_HIDDEN StringPool::Private
+{
+public:
+    // Looks up the string value equal to string; inserts it, if not found.
+    QHash<QString, Value>::ConstIterator lookup(const QString& string, Sheet* sheet);
+
+    // Checked without the mutex, so disabled pools cost nothing.
+    QAtomicInt enabled;
+    mutable QMutex mutex;
+    // The keys share their data with the string values.
+    QHash<QString, Value> strings;
+    qint64 bytes;
+    QHash<Sheet*, Statistics> statistics;
+};
+
+QHash<QString, Value>::ConstIterator StringPool::Private::lookup(const QString& string, Sheet* sheet)
+{
+    const qint64 size = string.size() * sizeof(QChar);
+    Statistics& sheetStatistics = statistics[sheet];
+    ++sheetStatistics.strings;
+    sheetStatistics.bytes += size;
+
+    QHash<QString, Value>::ConstIterator it = strings.constFind(string);
+    if (it != strings.constEnd()) {
+        ++sheetStatistics.reused;
+        sheetStatistics.savedBytes += size;
+        return it;
+    }
+    bytes += size;
+    return strings.insert(string, Value(string));
+}
+
+StringPool::StringPool()
+        : d(new Private)
+{
+    d->bytes = 0;
+}
+
+StringPool::~StringPool()
+{
+    delete d;
+}
+
+void StringPool::setEnabled(bool enable)
+{
+    QMutexLocker locker(&d->mutex);
+    d->enabled.storeRelease(enable);
+    if (!enable) {
+        d->strings.clear();
+        d->bytes = 0;
+    }
+}
+
+bool StringPool::isEnabled() const
+{
+    return d->enabled.loadAcquire();
+}
+
+QString StringPool::intern(const QString& string, Sheet* sheet)
+{
+    if (string.isEmpty() || !d->enabled.loadAcquire())
+        return string;
+    QMutexLocker locker(&d->mutex);
+    if (!d->enabled.load())
+        return string;
+    return d->lookup(string, sheet).key();
+}
+
+Value StringPool::intern(const Value& value, Sheet* sheet)
+{
+    if (!value.isString() || !d->enabled.loadAcquire())
+        return value;
+    const QString string = value.asString();
+    if (string.isEmpty())
+        return value;
+    QMutexLocker locker(&d->mutex);
+    if (!d->enabled.load())
+        return value;
+    const QHash<QString, Value>::ConstIterator it = d->lookup(string, sheet);
+    if (it.value().format() == value.format())
+        return it.value();
+    // share the string at least
+    Value result(it.key());
+    result.setFormat(value.format());
+    return result;
+}
+
+int StringPool::count() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->strings.count();
+}
+
+qint64 StringPool::bytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->bytes;
+}
+
+StringPool::Statistics StringPool::statistics(Sheet* sheet) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->statistics.value(sheet);
+}
+
+StringPool::Statistics StringPool::statistics() const
+{
+    QMutexLocker locker(&d->mutex);
+    Statistics result;
+    QHash<Sheet*, Statistics>::ConstIterator end(d->statistics.constEnd());
+    for (QHash<Sheet*, Statistics>::ConstIterator it(d->statistics.constBegin()); it != end; ++it) {
+        result.strings += it->strings;
+        result.reused += it->reused;
+        result.bytes += it->bytes;
+        result.savedBytes += it->savedBytes;
+    }
+    return result;
+}
+
+void StringPool::removeSheet(Sheet* sheet)
+{
+    QMutexLocker locker(&d->mutex);
+    d->statistics.remove(sheet);
+}
+
+void StringPool::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->strings.clear();
+    d->bytes = 0;
+    d->statistics.clear();
+}
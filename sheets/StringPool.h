@@ -0,0 +1,148 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_STRING_POOL
+#define CALLIGRA_SHEETS_STRING_POOL
+
+#include <QString>
+
+#include "sheets_odf_export.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Sheet;
+class Value;
+
+/**
+ * \class StringPool
+ * \brief Shares equal strings of the cells of a workbook.
+ * \ingroup Value
+ *
+ * Imported data often repeats a few strings, like country codes or
+ * categories, in many cells. While a file is loaded, the CellStorage interns
+ * the string values and the user inputs of the cells, so that equal strings
+ * share one QString and equal string values share one Value.
+ *
+ * The pool is only enabled while loading. Disabling it drops the pooled
+ * strings, the cells keep sharing them. Hence, strings edited or calculated
+ * later are neither pooled nor kept alive by the pool. The interning while
+ * loading is accounted per sheet to show the effect of the deduplication.
+ *
+ * The pool may be used from several threads at once.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT StringPool
+{
+public:
+    /**
+     * The interning of the strings of a sheet.
+     */
+    struct Statistics {
+        Statistics() : strings(0), reused(0), bytes(0), savedBytes(0) {}
+
+        int strings;        ///< the number of interned strings
+        int reused;         ///< the strings found in the pool
+        qint64 bytes;       ///< the size of the interned strings
+        qint64 savedBytes;  ///< the size of the strings found in the pool
+
+        /**
+         * \return the share of the strings found in the pool
+         */
+        qreal ratio() const {
+            return strings ? qreal(reused) / strings : 0.0;
+        }
+    };
+
+    /**
+     * Constructor.
+     */
+    StringPool();
+
+    /**
+     * Destructor.
+     */
+    ~StringPool();
+
+    /**
+     * Enables or disables the interning. Disabling drops the pooled strings,
+     * but not the statistics.
+     * The Map enables the pool while it is loading.
+     */
+    void setEnabled(bool enable);
+
+    /**
+     * \return true, if the strings get interned
+     */
+    bool isEnabled() const;
+
+    /**
+     * \return the pooled string equal to \p string , if the pool is enabled;
+     *         \p string itself otherwise
+     */
+    QString intern(const QString& string, Sheet* sheet = 0);
+
+    /**
+     * \return the pooled string value equal to \p value , if it is a string
+     *         and the pool is enabled; \p value itself otherwise
+     */
+    Value intern(const Value& value, Sheet* sheet = 0);
+
+    /**
+     * \return the number of distinct strings in the pool
+     */
+    int count() const;
+
+    /**
+     * \return the size of the distinct strings in the pool
+     */
+    qint64 bytes() const;
+
+    /**
+     * \return the interning of the strings of \p sheet
+     */
+    Statistics statistics(Sheet* sheet) const;
+
+    /**
+     * \return the interning of the strings of all sheets
+     */
+    Statistics statistics() const;
+
+    /**
+     * Drops the statistics of \p sheet .
+     */
+    void removeSheet(Sheet* sheet);
+
+    /**
+     * Drops all strings and statistics.
+     * Cells keep the strings they use.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(StringPool)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_STRING_POOL
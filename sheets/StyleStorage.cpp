@@ -108,7 +108,7 @@ void StyleStorageLoaderJob::run()
     d->usedRows.clear();
     {
 #ifdef CALLIGRA_SHEETS_MT
-        QMutexLocker(&d->cacheMutex);
+        QMutexLocker ml(&d->cacheMutex);
 #endif
         d->cachedArea = QRegion();
         d->cache.clear();
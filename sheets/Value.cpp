@@ -51,127 +51,57 @@ private:
     ValueStorage m_storage;
 };
 
+// The data not stored inline in Value.
 class Q_DECL_HIDDEN Value::Private : public QSharedData
 {
 public:
-
-    Value::Type type: 4;
-    Value::Format format: 4;
-
-    union { // 64 bits at max!
-        // b is also secondarily used to indicate a null value if type == Empty,
-        // without using up space for an explicit member variable.
-        bool b;
-        qint64 i;
-        Number f;
-        complex<Number>* pc;
-        QString* ps;
-        ValueArray* pa;
-    };
-
-    // create empty data
-    Private() : type(Value::Empty), format(Value::fmt_None), ps(0) {}
+    Private() : f(0.0), pc(0), pa(0) {}
 
     Private(const Private& o)
             : QSharedData(o)
-            , type(o.type)
-            , format(o.format) {
-        switch (type) {
-        case Value::Empty:
-        default:
-            ps = 0;
-            break;
-        case Value::Boolean:
-            b = o.b;
-            break;
-        case Value::Integer:
-            i = o.i;
-            break;
-        case Value::Float:
-            f = o.f;
-            break;
-        case Value::Complex:
-            pc = new complex<Number>(*o.pc);
-            break;
-        case Value::String:
-        case Value::Error:
-            ps = new QString(*o.ps);
-            break;
-        case Value::Array:
-            pa = new ValueArray(*o.pa);
-            break;
-        }
-    }
+            , f(o.f)
+            , pc(o.pc ? new complex<Number>(*o.pc) : 0)
+            , s(o.s)
+            , pa(o.pa ? new ValueArray(*o.pa) : 0) {}
 
-    // destroys data
     ~Private() {
-        if (this == s_null)
-            s_null = 0;
-        clear();
-    }
-
-    // static empty data to be shared
-    static Private* null() {
-        if (!s_null) s_null = new Private;
-        return s_null;
-    }
-
-    // true if it's null (which is shared)
-    bool isNull() {
-        return this == s_null;
-    }
-
-    /** Deletes all data. */
-    void clear() {
-        if (type == Value::Array)   delete pa;
-        if (type == Value::Complex) delete pc;
-        if (type == Value::Error)   delete ps;
-        if (type == Value::String)  delete ps;
-        type = Value::Empty;
-        b = 0;
+        delete pc;
+        delete pa;
     }
 
-    /** set most probable formatting based on the type */
-    void setFormatByType();
+    Number f;               // floats exceeding the double precision
+    complex<Number>* pc;
+    QString s;              // strings and error messages
+    ValueArray* pa;
 
 private:
     void operator=(const Value::Private& o);
-
-    static Private* s_null;
 };
 
-void Value::Private::setFormatByType()
+// most probable formatting based on the type
+static Value::Format formatByType(Value::Type type)
 {
     switch (type) {
     case Value::Empty:
-        format = Value::fmt_None;
-        break;
+        return Value::fmt_None;
     case Value::Boolean:
-        format = Value::fmt_Boolean;
-        break;
+        return Value::fmt_Boolean;
     case Value::Integer:
     case Value::Float:
     case Value::Complex:
-        format = Value::fmt_Number;
-        break;
+        return Value::fmt_Number;
     case Value::String:
-        format = Value::fmt_String;
-        break;
+        return Value::fmt_String;
     case Value::Array:
-        format = Value::fmt_None;
-        break;
+        return Value::fmt_None;
     case Value::CellRange:
-        format = Value::fmt_None;
-        break;
+        return Value::fmt_None;
     case Value::Error:
-        format = Value::fmt_String;
-        break;
+        return Value::fmt_String;
     };
+    return Value::fmt_None;
 }
 
-// to be shared between all empty value
-Value::Private* Value::Private::s_null = 0;
-
 // static things
 Value ks_value_empty;
 Value ks_value_null;
@@ -188,193 +118,288 @@ Value ks_error_value;
 
 // create an empty value
 Value::Value()
-        : d(Private::null())
+        : m_type(Empty)
+        , m_format(fmt_None)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
 }
 
 // destructor
 Value::~Value()
 {
+    release();
 }
 
 // create value of certain type
 Value::Value(Value::Type _type)
-        : d(Private::null())
+        : m_type(_type)
+        , m_format(formatByType(_type))
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = _type;
-    d->setFormatByType();
 }
 
 // copy constructor
 Value::Value(const Value& _value)
-        : d(_value.d)
+        : m_type(_value.m_type)
+        , m_format(_value.m_format)
+        , m_null(_value.m_null)
+        , m_shared(_value.m_shared)
+        , m_i(_value.m_i)
 {
+    if (m_shared)
+        m_d->ref.ref();
 }
 
 // assignment operator
 Value& Value::operator=(const Value & _value)
 {
-    d = _value.d;
+    if (_value.m_shared)
+        _value.m_d->ref.ref();
+    release();
+    m_type = _value.m_type;
+    m_format = _value.m_format;
+    m_null = _value.m_null;
+    m_shared = _value.m_shared;
+    m_i = _value.m_i;
     return *this;
 }
 
 // comparison operator - returns true only if strictly identical, unlike equal()/compare()
 bool Value::operator==(const Value& o) const
 {
-    if (d->type != o.d->type)
+    if (m_type != o.m_type)
         return false;
-    switch (d->type) {
-    // null() (d->b == 1) and empty() (d->b == 0) are equal to this operator
+    // values of the other types without shared data hold nothing
+    if (m_type > Float && (!m_shared || !o.m_shared))
+        return !m_shared && !o.m_shared;
+    switch (type()) {
+    // null() and empty() are equal to this operator
     case Empty:   return true;
-    case Boolean: return o.d->b == d->b;
-    case Integer: return o.d->i == d->i;
-    case Float:   return compare(o.d->f, d->f) == 0;
-    case Complex: return (!d->pc && !o.d->pc) || ((d->pc && o.d->pc) && (*o.d->pc == *d->pc));
-    case String:  return (!d->ps && !o.d->ps) || ((d->ps && o.d->ps) && (*o.d->ps == *d->ps));
-    case Array:   return (!d->pa && !o.d->pa) || ((d->pa && o.d->pa) && (*o.d->pa == *d->pa));
-    case Error:   return (!d->ps && !o.d->ps) || ((d->ps && o.d->ps) && (*o.d->ps == *d->ps));
+    case Boolean: return o.m_b == m_b;
+    case Integer: return o.m_i == m_i;
+    case Float:   return compare(o.floatValue(), floatValue()) == 0;
+    case Complex: return *o.m_d->pc == *m_d->pc;
+    case String:  return o.m_d->s == m_d->s;
+    case Array:   return *o.m_d->pa == *m_d->pa;
+    case Error:   return o.m_d->s == m_d->s;
     default: break;
     }
-    warnSheets << "Unhandled type in Value::operator==: " << d->type;
+    warnSheets << "Unhandled type in Value::operator==: " << type();
     return false;
 }
 
 // create a boolean value
 Value::Value(bool b)
-        : d(Private::null())
+        : m_type(Boolean)
+        , m_format(fmt_Boolean)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = Boolean;
-    d->b = b;
-    d->format = fmt_Boolean;
+    m_b = b;
 }
 
 // create an integer value
 Value::Value(qint64 i)
-        : d(Private::null())
+        : m_type(Integer)
+        , m_format(fmt_Number)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(i)
 {
-    d->type = Integer;
-    d->i = i;
-    d->format = fmt_Number;
 }
 
 // create an integer value
 Value::Value(int i)
-        : d(Private::null())
+        : m_type(Integer)
+        , m_format(fmt_Number)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(static_cast<qint64>(i))
 {
-    d->type = Integer;
-    d->i = static_cast<qint64>(i);
-    d->format = fmt_Number;
 }
 
 // create a floating-point value
 Value::Value(double f)
-        : d(Private::null())
+        : m_type(Float)
+        , m_format(fmt_Number)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = Float;
-    d->f = Number(f);
-    d->format = fmt_Number;
+    setFloat(Number(f));
 }
 
 // create a floating-point value
 Value::Value(long double f)
-        : d(Private::null())
+        : m_type(Float)
+        , m_format(fmt_Number)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = Float;
-    d->f = Number(f);
-    d->format = fmt_Number;
+    setFloat(Number(f));
 }
 
 
 #ifdef CALLIGRA_SHEETS_HIGH_PRECISION_SUPPORT
 // create a floating-point value
 Value::Value(Number f)
-        : d(Private::null())
+        : m_type(Float)
+        , m_format(fmt_Number)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = Float;
-    d->f = f;
-    d->format = fmt_Number;
+    setFloat(f);
 }
 #endif // CALLIGRA_SHEETS_HIGH_PRECISION_SUPPORT
 
 // create a complex number value
 Value::Value(const complex<Number>& c)
-        : d(Private::null())
+        : m_type(Complex)
+        , m_format(fmt_Number)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = Complex;
+    Private* d = new Private;
     d->pc = new complex<Number>(c);
-    d->format = fmt_Number;
+    setShared(d);
 }
 
 // create a string value
 Value::Value(const QString& s)
-        : d(Private::null())
+        : m_type(String)
+        , m_format(fmt_String)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = String;
-    d->ps = new QString(s);
-    d->format = fmt_String;
+    Private* d = new Private;
+    d->s = s;
+    setShared(d);
 }
 
 // create a string value
 Value::Value(const char *s)
-        : d(Private::null())
+        : m_type(String)
+        , m_format(fmt_String)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = String;
-    d->ps = new QString(s);
-    d->format = fmt_String;
+    Private* d = new Private;
+    d->s = QString(s);
+    setShared(d);
 }
 
 // create a floating-point value from date/time
 Value::Value(const QDateTime& dt, const CalculationSettings* settings)
-        : d(Private::null())
+        : m_type(Float)
+        , m_format(fmt_DateTime)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
     const QDate refDate(settings->referenceDate());
     const QTime refTime(0, 0);    // reference time is midnight
-    d->type = Float;
-    d->f = Number(refDate.daysTo(dt.date()));
-    d->f += static_cast<double>(refTime.msecsTo(dt.time())) / 86400000.0;     // 24*60*60*1000
-    d->format = fmt_DateTime;
+    Number f = Number(refDate.daysTo(dt.date()));
+    f += static_cast<double>(refTime.msecsTo(dt.time())) / 86400000.0;     // 24*60*60*1000
+    setFloat(f);
 }
 
 // create a floating-point value from time
 Value::Value(const QTime& time)
-        : d(Private::null())
+        : m_type(Float)
+        , m_format(fmt_Time)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
     const QTime refTime(0, 0);    // reference time is midnight
 
-    d->type = Float;
-    d->f = Number(static_cast<double>(refTime.msecsTo(time)) / 86400000.0);      // 24*60*60*1000
-    d->format = fmt_Time;
+    setFloat(Number(static_cast<double>(refTime.msecsTo(time)) / 86400000.0));      // 24*60*60*1000
 }
 
 // create a floating-point value from date
 Value::Value(const QDate& date, const CalculationSettings* settings)
-        : d(Private::null())
+        : m_type(Integer)
+        , m_format(fmt_Date)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
     const QDate refDate(settings->referenceDate());
 
-    d->type = Integer;
-    d->i = refDate.daysTo(date);
-    d->format = fmt_Date;
+    m_i = refDate.daysTo(date);
 }
 
 // create an array value
 Value::Value(const ValueStorage& array, const QSize& size)
-        : d(Private::null())
+        : m_type(Array)
+        , m_format(fmt_None)
+        , m_null(false)
+        , m_shared(false)
+        , m_i(0)
 {
-    d->type = Array;
+    Private* d = new Private;
     d->pa = new ValueArray(array, size);
-    d->format = fmt_None;
+    setShared(d);
 }
 
-// return type of the value
-Value::Type Value::type() const
+// the floating-point number, either inline or shared
+Number Value::floatValue() const
 {
-    return d ? d->type : Empty;
+    return m_shared ? m_d->f : Number(m_f);
 }
 
-bool Value::isNull() const
+// store a floating-point number inline, if it is representable as double;
+// otherwise it is shared, so that no precision of the long double is lost
+void Value::setFloat(Number f)
 {
-    return d ? d->type == Empty && d->b : false;
+#ifndef CALLIGRA_SHEETS_HIGH_PRECISION_SUPPORT
+    const double inlined = static_cast<double>(f);
+    if (Number(inlined) == f || f != f) {
+        release();
+        m_f = inlined;
+        return;
+    }
+#endif // CALLIGRA_SHEETS_HIGH_PRECISION_SUPPORT
+    Private* d = new Private;
+    d->f = f;
+    setShared(d);
+}
+
+// take a reference to the shared data d
+void Value::setShared(Private* d)
+{
+    d->ref.ref();
+    release();
+    m_d = d;
+    m_shared = true;
+}
+
+// drop the reference to the shared data
+void Value::release()
+{
+    if (m_shared && !m_d->ref.deref())
+        delete m_d;
+    m_shared = false;
+}
+
+// shared data exclusively owned by this value
+Value::Private* Value::detach()
+{
+    if (!m_shared)
+        setShared(new Private);
+    else if (m_d->ref.load() != 1)
+        setShared(new Private(*m_d));
+    return m_d;
 }
 
 // get the value as boolean
@@ -383,7 +408,7 @@ bool Value::asBoolean() const
     bool result = false;
 
     if (type() == Value::Boolean)
-        result = d->b;
+        result = m_b;
 
     return result;
 }
@@ -393,11 +418,11 @@ qint64 Value::asInteger() const
 {
     qint64 result = 0;
     if (type() == Integer)
-        result = d->i;
+        result = m_i;
     else if (type() == Float)
-        result = static_cast<qint64>(floor(numToDouble(d->f)));
-    else if (type() == Complex)
-        result = static_cast<qint64>(floor(numToDouble(d->pc->real())));
+        result = static_cast<qint64>(floor(numToDouble(floatValue())));
+    else if (type() == Complex && m_shared)
+        result = static_cast<qint64>(floor(numToDouble(m_d->pc->real())));
     return result;
 }
 
@@ -406,11 +431,11 @@ Number Value::asFloat() const
 {
     Number result = 0.0;
     if (type() == Float)
-        result = d->f;
+        result = floatValue();
     else if (type() == Integer)
-        result = static_cast<Number>(d->i);
-    else if (type() == Complex)
-        result = d->pc->real();
+        result = static_cast<Number>(m_i);
+    else if (type() == Complex && m_shared)
+        result = m_d->pc->real();
     return result;
 }
 
@@ -418,12 +443,12 @@ Number Value::asFloat() const
 complex<Number> Value::asComplex() const
 {
     complex<Number> result(0.0, 0.0);
-    if (type() == Complex)
-        result = *d->pc;
+    if (type() == Complex && m_shared)
+        result = *m_d->pc;
     else if (type() == Float)
-        result = d->f;
+        result = floatValue();
     else if (type() == Integer)
-        result = static_cast<Number>(d->i);
+        result = static_cast<Number>(m_i);
     return result;
 }
 
@@ -433,8 +458,8 @@ QString Value::asString() const
     QString result;
 
     if (type() == Value::String)
-        if (d->ps)
-            result = QString(*d->ps);
+        if (m_shared)
+            result = m_d->s;
 
     return result;
 }
@@ -457,19 +482,19 @@ QVariant Value::asVariant() const
 {
     QVariant result;
 
-    switch (d->type) {
+    switch (type()) {
     case Value::Empty:
     default:
         result = 0;
         break;
     case Value::Boolean:
-        result = d->b;
+        result = m_b;
         break;
     case Value::Integer:
-        result = d->i;
+        result = m_i;
         break;
     case Value::Float:
-        result = (double) numToDouble(d->f);
+        result = (double) numToDouble(floatValue());
         break;
     case Value::Complex:
         // FIXME: add support for complex numbers
@@ -477,7 +502,8 @@ QVariant Value::asVariant() const
         break;
     case Value::String:
     case Value::Error:
-        result = *d->ps;
+        if (m_shared)
+            result = m_d->s;
         break;
     case Value::Array:
         // FIXME: not supported yet
@@ -491,9 +517,11 @@ QVariant Value::asVariant() const
 // set error message
 void Value::setError(const QString& msg)
 {
-    d->clear();
-    d->type = Error;
-    d->ps = new QString(msg);
+    Private* d = new Private;
+    d->s = msg;
+    setShared(d);
+    m_type = Error;
+    m_null = false;
 }
 
 // get error message
@@ -502,8 +530,8 @@ QString Value::errorMessage() const
     QString result;
 
     if (type() == Value::Error)
-        if (d->ps)
-            result = QString(*d->ps);
+        if (m_shared)
+            result = m_d->s;
 
     return result;
 }
@@ -544,56 +572,64 @@ QTime Value::asTime() const
     return dt;
 }
 
-Value::Format Value::format() const
-{
-    return d ? d->format : fmt_None;
-}
-
 void Value::setFormat(Value::Format fmt)
 {
-    d->format = fmt;
+    m_format = fmt;
 }
 
 Value Value::element(unsigned column, unsigned row) const
 {
-    if (d->type != Array) return *this;
-    if (!d->pa) return empty();
-    return d->pa->storage().lookup(column + 1, row + 1);
+    if (m_type != Array) return *this;
+    if (!m_shared) return empty();
+    return m_d->pa->storage().lookup(column + 1, row + 1);
 }
 
 Value Value::element(unsigned index) const
 {
-    if (d->type != Array) return *this;
-    if (!d->pa) return empty();
-    return d->pa->storage().data(index);
+    if (m_type != Array) return *this;
+    if (!m_shared) return empty();
+    return m_d->pa->storage().data(index);
 }
 
 void Value::setElement(unsigned column, unsigned row, const Value& v)
 {
-    if (d->type != Array) return;
+    if (m_type != Array) return;
+    Private* const d = detach();
     if (!d->pa) d->pa = new ValueArray();
     d->pa->storage().insert(column + 1, row + 1, v);
 }
 
 unsigned Value::columns() const
 {
-    if (d->type != Array) return 1;
-    if (!d->pa) return 1;
-    return d->pa->columns();
+    if (m_type != Array) return 1;
+    if (!m_shared) return 1;
+    return m_d->pa->columns();
 }
 
 unsigned Value::rows() const
 {
-    if (d->type != Array) return 1;
-    if (!d->pa) return 1;
-    return d->pa->rows();
+    if (m_type != Array) return 1;
+    if (!m_shared) return 1;
+    return m_d->pa->rows();
 }
 
 unsigned Value::count() const
 {
-    if (d->type != Array) return 1;
-    if (!d->pa) return 1;
-    return d->pa->storage().count();
+    if (m_type != Array) return 1;
+    if (!m_shared) return 1;
+    return m_d->pa->storage().count();
+}
+
+bool Value::numbers(QVector<Number>* numbers, QVector<bool>* mask) const
+{
+    if (m_type != Array || !m_shared) return false;
+    return m_d->pa->storage().numbers(numbers, mask);
+}
+
+bool Value::matrix(QVector<Number>* matrix) const
+{
+    if (m_type != Array || !m_shared) return false;
+    return m_d->pa->storage().matrix(matrix, m_d->pa->rows(), m_d->pa->columns());
 }
 
 // reference to empty value
@@ -606,7 +642,7 @@ const Value& Value::empty()
 const Value& Value::null()
 {
     if (!ks_value_null.isNull())
-        ks_value_null.d->b = true;
+        ks_value_null.m_null = true;
     return ks_value_null;
 }
 
@@ -711,7 +747,7 @@ bool Value::isZero() const
 
 bool Value::allowComparison(const Value& v) const
 {
-    Value::Type t1 = d->type;
+    Value::Type t1 = m_type;
     Value::Type t2 = v.type();
 
     if ((t1 == Empty) && (t2 == Empty)) return true;
@@ -756,7 +792,7 @@ bool Value::allowComparison(const Value& v) const
 // compare values. looks strange in order to be compatible with Excel
 int Value::compare(const Value& v, Qt::CaseSensitivity cs) const
 {
-    Value::Type t1 = d->type;
+    Value::Type t1 = m_type;
     Value::Type t2 = v.type();
 
     // errors always less than everything else
@@ -28,6 +28,7 @@
 #include <QString>
 #include <QTextStream>
 #include <QVariant>
+#include <QVector>
 
 #include "SheetsDebug.h"
 #include "Number.h"
@@ -48,7 +49,12 @@ class ValueStorage;
  * Each cell in a worksheet must hold a value, either as entered by user
  * or as a result of formula evaluation. Default cell holds empty value.
  *
- * Value uses implicit data sharing to reduce memory usage.
+ * Booleans, integers and floating-point numbers, that are representable as
+ * double, are stored inline without any allocation. Strings, errors, arrays,
+ * complex numbers and floating-point numbers exceeding the double precision
+ * use implicit data sharing to reduce memory usage. Number is a long double,
+ * so most results of formula evaluation, e.g. 1/3, are not representable as
+ * double and are allocated; they are kept exactly, not rounded.
  */
 class CALLIGRA_SHEETS_ODF_EXPORT Value
 {
@@ -91,7 +97,7 @@ public:
     /**
      * Destroys the value.
      */
-    virtual ~Value();
+    ~Value();
 
     /**
      * Creates a copy from another value.
@@ -181,7 +187,9 @@ public:
     /**
      * Returns the type of the value.
      */
-    Type type() const;
+    Type type() const {
+        return static_cast<Type>(m_type);
+    }
 
     /**
      * Returns true if null.
@@ -189,12 +197,16 @@ public:
      * A null value is equal to an empty value (and the other way around) in
      * every way, except for what isNull() returns.
      */
-    bool isNull() const;
+    bool isNull() const {
+        return m_type == Empty && m_null;
+    }
 
     /**
      * Returns the format of the value, i.e. how should it be interpreted.
      */
-    Format format() const;
+    Format format() const {
+        return static_cast<Format>(m_format);
+    }
 
     /**
      * Sets format information for this value.
@@ -372,6 +384,27 @@ public:
      */
     unsigned count() const;
 
+    /**
+     * If this value is an array, extracts the numbers of its elements in the
+     * order of element(unsigned) into a contiguous block.
+     * Entries for empty elements and strings are zero and \p mask is \c false
+     * for them.
+     * \return \c false, if this is no array or if an element is neither a
+     * number, a string nor empty
+     * \see ValueStorage::numbers()
+     */
+    bool numbers(QVector<Number>* numbers, QVector<bool>* mask) const;
+
+    /**
+     * If this value is an array, extracts the numbers of all its elements
+     * into a dense block of rows() * columns() entries, row by row.
+     * Empty elements are zero and booleans are one or zero.
+     * \return \c false, if this is no array or if an element is neither a
+     * number, a boolean nor empty
+     * \see ValueStorage::matrix()
+     */
+    bool matrix(QVector<Number>* matrix) const;
+
     /**
      * Returns error message associated with this value.
      *
@@ -506,7 +539,27 @@ public:
 
 private:
     class Private;
-    QSharedDataPointer<Private> d;
+
+    Number floatValue() const;
+    void setFloat(Number f);
+    void setShared(Private* d);
+    void release();
+    Private* detach();
+
+    // unsigned, as the signedness of enum and bool bit-fields differs
+    // between compilers; use type() and format() to read them
+    unsigned m_type : 4;
+    unsigned m_format : 4;
+    // distinguishes null() from empty()
+    unsigned m_null : 1;
+    // if set, the data is held by m_d
+    unsigned m_shared : 1;
+    union {
+        bool m_b;
+        qint64 m_i;
+        double m_f;
+        Private* m_d;
+    };
 };
 
 /***************************************************************************
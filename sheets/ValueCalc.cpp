@@ -21,11 +21,16 @@
 #include "ValueCalc.h"
 
 #include "Cell.h"
+#include "CriteriaCache.h"
+#include "Map.h"
 #include "Number.h"
+#include "Region.h"
+#include "Sheet.h"
 #include "ValueConverter.h"
 #include "CalculationSettings.h"
 #include "SheetsDebug.h"
 
+#include <QBitArray>
 #include <QRegExp>
 
 #include <errno.h>
@@ -190,6 +195,121 @@ void awDevSqA(ValueCalc *c, Value &res, Value val,
         res = c->add(res, c->sqr(c->sub(val, avg)));
 }
 
+// Unboxed reductions for the common aggregates. The numbers of an array are
+// extracted into a contiguous block and reduced in the order of the array
+// walk, so the results do not change. Values other than numbers, strings and
+// empty cells need the array walk, which is used, if these return false.
+
+// adds the numbers (or their squares) in range to sum
+static bool addNumbers(const Value &range, bool squares, Number *sum, int *count)
+{
+    switch (range.type()) {
+    case Value::Empty:
+    case Value::String:
+        return true;
+    case Value::Integer:
+    case Value::Float: {
+        const Number number = range.asFloat();
+        *sum += squares ? number * number : number;
+        ++(*count);
+        return true;
+    }
+    case Value::Array:
+        break;
+    default:
+        return false;
+    }
+
+    QVector<Number> numbers;
+    QVector<bool> mask;
+    if (!range.numbers(&numbers, &mask))
+        return false;
+    const Number *number = numbers.constData();
+    const bool *valid = mask.constData();
+    const int size = numbers.count();
+    // the extraction zeroed the other entries
+    Number total = *sum;
+    if (squares) {
+        for (int i = 0; i < size; ++i)
+            total += number[i] * number[i];
+    } else {
+        for (int i = 0; i < size; ++i)
+            total += number[i];
+    }
+    int numberCount = 0;
+    for (int i = 0; i < size; ++i)
+        numberCount += valid[i];
+    *sum = total;
+    *count += numberCount;
+    return true;
+}
+
+static bool addNumbers(const QVector<Value> &range, bool squares, Number *sum, int *count)
+{
+    for (int i = 0; i < range.count(); ++i) {
+        if (!addNumbers(range[i], squares, sum, count))
+            return false;
+    }
+    return true;
+}
+
+// finds the first occurrence of the largest (or smallest) number in range
+static bool findExtremeNumber(const Value &range, bool largest, Value *result)
+{
+    switch (range.type()) {
+    case Value::Empty:
+    case Value::String:
+        return true;
+    case Value::Integer:
+    case Value::Float:
+        if (result->isEmpty() || (largest ? range.asFloat() > result->asFloat()
+                                          : range.asFloat() < result->asFloat()))
+            *result = range;
+        return true;
+    case Value::Array:
+        break;
+    default:
+        return false;
+    }
+
+    QVector<Number> numbers;
+    QVector<bool> mask;
+    if (!range.numbers(&numbers, &mask))
+        return false;
+    const Number *number = numbers.constData();
+    const bool *valid = mask.constData();
+    const int size = numbers.count();
+    int best = -1;
+    for (int i = 0; i < size; ++i) {
+        if (!valid[i])
+            continue;
+        if (best == -1 || (largest ? number[i] > number[best] : number[i] < number[best]))
+            best = i;
+    }
+    if (best == -1)
+        return true;
+    if (result->isEmpty() || (largest ? number[best] > result->asFloat()
+                                      : number[best] < result->asFloat()))
+        *result = range.element(best);
+    return true;
+}
+
+// The array walk adjusts the format of an unformatted result.
+static bool extremeNumber(const Value &range, bool largest, Value *result)
+{
+    if (!findExtremeNumber(range, largest, result))
+        return false;
+    return !result->isEmpty() && result->format() != Value::fmt_None;
+}
+
+static bool extremeNumber(const QVector<Value> &range, bool largest, Value *result)
+{
+    for (int i = 0; i < range.count(); ++i) {
+        if (!findExtremeNumber(range[i], largest, result))
+            return false;
+    }
+    return !result->isEmpty() && result->format() != Value::fmt_None;
+}
 
 // ***********************
 // ****** ValueCalc ******
@@ -1925,6 +2045,11 @@ void ValueCalc::registerAwFunc(const QString &name, arrayWalkFunc func)
 
 Value ValueCalc::sum(const Value &range, bool full)
 {
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, false, &total, &numberCount))
+        return numberCount ? Value(total) : Value(0);
+
     Value res(0);
     arrayWalk(range, res, full ? awSumA : awSum, Value(0));
     return res;
@@ -1932,6 +2057,11 @@ Value ValueCalc::sum(const Value &range, bool full)
 
 Value ValueCalc::sum(QVector<Value> range, bool full)
 {
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, false, &total, &numberCount))
+        return numberCount ? Value(total) : Value(0);
+
     Value res(0);
     arrayWalk(range, res, full ? awSumA : awSum, Value(0));
     return res;
@@ -1940,6 +2070,23 @@ Value ValueCalc::sum(QVector<Value> range, bool full)
 // sum of squares
 Value ValueCalc::sumsq(const Value &range, bool full)
 {
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, true, &total, &numberCount))
+        return numberCount ? Value(total) : Value(0);
+
+    Value res(0);
+    arrayWalk(range, res, full ? awSumSqA : awSumSq, Value(0));
+    return res;
+}
+
+Value ValueCalc::sumsq(QVector<Value> range, bool full)
+{
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, true, &total, &numberCount))
+        return numberCount ? Value(total) : Value(0);
+
     Value res(0);
     arrayWalk(range, res, full ? awSumSqA : awSumSq, Value(0));
     return res;
@@ -2192,6 +2339,11 @@ Value ValueCalc::averageIfs(const Cell &avgRangeStart, QList<Value> range, QList
 
 int ValueCalc::count(const Value &range, bool full)
 {
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, false, &total, &numberCount))
+        return numberCount;
+
     Value res(0);
     arrayWalk(range, res, full ? awCountA : awCount, Value(0));
     return converter->asInteger(res).asInteger();
@@ -2199,6 +2351,11 @@ int ValueCalc::count(const Value &range, bool full)
 
 int ValueCalc::count(QVector<Value> range, bool full)
 {
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, false, &total, &numberCount))
+        return numberCount;
+
     Value res(0);
     arrayWalk(range, res, full ? awCountA : awCount, Value(0));
     return converter->asInteger(res).asInteger();
@@ -2275,6 +2432,11 @@ Value ValueCalc::countIfs(const Cell &cntRangeStart, QList<Value> range, QList<C
 
 Value ValueCalc::avg(const Value &range, bool full)
 {
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, false, &total, &numberCount))
+        return numberCount ? div(Value(total), numberCount) : Value(0.0);
+
     int cnt = count(range, full);
     if (cnt)
         return div(sum(range, full), cnt);
@@ -2283,6 +2445,11 @@ Value ValueCalc::avg(const Value &range, bool full)
 
 Value ValueCalc::avg(QVector<Value> range, bool full)
 {
+    Number total = 0.0;
+    int numberCount = 0;
+    if (!full && addNumbers(range, false, &total, &numberCount))
+        return numberCount ? div(Value(total), numberCount) : Value(0.0);
+
     int cnt = count(range, full);
     if (cnt)
         return div(sum(range, full), cnt);
@@ -2292,6 +2459,10 @@ Value ValueCalc::avg(QVector<Value> range, bool full)
 Value ValueCalc::max(const Value &range, bool full)
 {
     Value res;
+    if (!full && extremeNumber(range, true, &res))
+        return res;
+    // start over with the array walk
+    res = Value();
     arrayWalk(range, res, full ? awMaxA : awMax, Value(0));
     return res;
 }
@@ -2299,6 +2470,10 @@ Value ValueCalc::max(const Value &range, bool full)
 Value ValueCalc::max(QVector<Value> range, bool full)
 {
     Value res;
+    if (!full && extremeNumber(range, true, &res))
+        return res;
+    // start over with the array walk
+    res = Value();
     arrayWalk(range, res, full ? awMaxA: awMax, Value(0));
     return res;
 }
@@ -2306,6 +2481,10 @@ Value ValueCalc::max(QVector<Value> range, bool full)
 Value ValueCalc::min(const Value &range, bool full)
 {
     Value res;
+    if (!full && extremeNumber(range, false, &res))
+        return res;
+    // start over with the array walk
+    res = Value();
     arrayWalk(range, res, full ? awMinA : awMin, Value(0));
     return res;
 }
@@ -2313,6 +2492,10 @@ Value ValueCalc::min(const Value &range, bool full)
 Value ValueCalc::min(QVector<Value> range, bool full)
 {
     Value res;
+    if (!full && extremeNumber(range, false, &res))
+        return res;
+    // start over with the array walk
+    res = Value();
     arrayWalk(range, res, full ? awMinA : awMin, Value(0));
     return res;
 }
@@ -2462,8 +2645,10 @@ void ValueCalc::getCond(Condition &cond, Value val)
         cond.stringValue = text;
         if (settings()->useWildcards()) { // HOST-USE-WILDCARDS Excel like wildcard matching
             cond.comp = wildcardMatch;
+            cond.regex = QRegExp(text, Qt::CaseInsensitive, QRegExp::Wildcard);
         } else if (settings()->useRegularExpressions()) { // HOST-USE-REGULAR-EXPRESSION ODF like regex matching
             cond.comp = regexMatch;
+            cond.regex = QRegExp(text, Qt::CaseInsensitive, QRegExp::RegExp);
         } else { // Simple string matching
             cond.comp = stringMatch;
         }
@@ -2549,19 +2734,10 @@ bool ValueCalc::matches(const Condition &cond, Value val)
             if (d.toLower() == cond.stringValue.toLower()) return true;
             break;
 
-        case regexMatch: {
-            QRegExp rx;
-            rx.setPattern(cond.stringValue);
-            rx.setPatternSyntax(QRegExp::RegExp);
-            rx.setCaseSensitivity(Qt::CaseInsensitive);
-            if (rx.exactMatch(d)) return true;
-        } break;
-
+        case regexMatch:
         case wildcardMatch: {
-            QRegExp rx;
-            rx.setPattern(cond.stringValue);
-            rx.setPatternSyntax(QRegExp::Wildcard);
-            rx.setCaseSensitivity(Qt::CaseInsensitive);
+            // exactMatch() stores the captures; match on a copy sharing the compiled pattern
+            QRegExp rx = cond.regex;
             if (rx.exactMatch(d)) return true;
         } break;
 
@@ -2570,3 +2746,77 @@ bool ValueCalc::matches(const Condition &cond, Value val)
     return false;
 }
 
+bool ValueCalc::matchingElements(const Region &region, const Value &range,
+                                 const Condition &cond, QBitArray *mask)
+{
+    if (!region.isValid() || !region.isContiguous() || !region.firstSheet())
+        return false;
+    Sheet *const sheet = region.firstSheet();
+    return sheet->map()->criteriaCache()->matches(sheet, region.firstRange(), range,
+                                                  cond, this, mask);
+}
+
+bool ValueCalc::matchingElements(const QVector<Value> &args, const QVector<Region> &regions, int first,
+                                 const QList<Condition> &cond, const Value &data, QBitArray *mask)
+{
+    if (cond.isEmpty() || !data.isArray())
+        return false;
+    for (int i = 0; i < cond.count(); ++i) {
+        const int index = first + 2 * i;
+        if (index >= args.count() || index >= regions.count())
+            return false;
+        const Value &range = args[index];
+        if (range.columns() != data.columns() || range.rows() != data.rows())
+            return false;
+        QBitArray matches;
+        if (!matchingElements(regions[index], range, cond[i], &matches))
+            return false;
+        if (i == 0)
+            *mask = matches;
+        else
+            *mask &= matches;
+    }
+    return true;
+}
+
+Value ValueCalc::sumIf(const Value &range, const QBitArray &mask, int *count, bool addUnmarked)
+{
+    const int cols = range.columns();
+    Value res(0);
+    int cnt = 0;
+    for (int i = 0; i < mask.size(); ++i) {
+        if (!mask.testBit(i)) {
+            if (addUnmarked)
+                res = add(res, Value(0.0));
+            continue;
+        }
+        const Value val = range.element(i % cols, i / cols);
+        if (val.isNumber()) { // only add numbers, no conversion from string allowed
+            res = add(res, val);
+            ++cnt;
+        }
+    }
+    if (count)
+        *count = cnt;
+    return res;
+}
+
+Value ValueCalc::sumIf(const Cell &rangeStart, int columns, const QBitArray &mask, int *count)
+{
+    Value res(0);
+    int cnt = 0;
+    for (int i = 0; i < mask.size(); ++i) {
+        if (!mask.testBit(i))
+            continue;
+        const Value val = Cell(rangeStart.sheet(), rangeStart.column() + i % columns,
+                               rangeStart.row() + i / columns).value();
+        if (val.isNumber()) { // only add numbers, no conversion from string allowed
+            res = add(res, val);
+            ++cnt;
+        }
+    }
+    if (count)
+        *count = cnt;
+    return res;
+}
+
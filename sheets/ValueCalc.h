@@ -22,6 +22,7 @@
 
 #include <map>
 
+#include <QRegExp>
 #include <QVector>
 
 #include "Number.h"
@@ -29,6 +30,8 @@
 
 #include "sheets_odf_export.h"
 
+class QBitArray;
+
 #ifdef max
 # undef max
 #endif
@@ -41,6 +44,7 @@ namespace Calligra
 namespace Sheets
 {
 class Cell;
+class Region;
 class ValueCalc;
 class ValueConverter;
 
@@ -54,6 +58,7 @@ struct Condition {
     Number   value;
     QString  stringValue;
     Type     type;
+    QRegExp  regex; // compiled stringValue of regexMatch and wildcardMatch
 };
 
 typedef void (*arrayWalkFunc)(ValueCalc *, Value &result,
@@ -300,6 +305,7 @@ public:
 
     /** range functions using value lists */
     Value sum(QVector<Value> range, bool full = true);
+    Value sumsq(QVector<Value> range, bool full = true);
     int count(QVector<Value> range, bool full = true);
     Value avg(QVector<Value> range, bool full = true);
     Value max(QVector<Value> range, bool full = true);
@@ -325,6 +331,38 @@ public:
     */
     bool matches(const Condition &cond, Value d);
 
+    /**
+      Marks the elements of range matching the condition cond in mask, which
+      holds the matches in row-major order. The matches are shared through the
+      map's CriteriaCache, if range holds the values of the cell range region.
+      Returns false, if the cache does not handle the range.
+    */
+    bool matchingElements(const Region &region, const Value &range,
+                          const Condition &cond, QBitArray *mask);
+
+    /**
+      Marks the elements of data matching all criteria in mask. The criteria
+      ranges are args[first], args[first + 2], ... and hold the values of the
+      cell ranges regions[first], regions[first + 2], ...
+      Returns false, if a range is not handled by the cache or differs in size
+      from data.
+    */
+    bool matchingElements(const QVector<Value> &args, const QVector<Region> &regions, int first,
+                          const QList<Condition> &cond, const Value &data, QBitArray *mask);
+
+    /**
+      Sums up the numbers among the elements of range marked in mask, see
+      matchingElements(). Returns the number of added numbers in count, if
+      given. If addUnmarked is true, 0.0 is added for each unmarked element,
+      like sumIfs() and averageIfs() do.
+    */
+    Value sumIf(const Value &range, const QBitArray &mask, int *count = 0, bool addUnmarked = false);
+    /**
+      Same as above for the cells of the range with the given number of
+      columns starting at rangeStart. Only the marked cells are fetched.
+    */
+    Value sumIf(const Cell &rangeStart, int columns, const QBitArray &mask, int *count = 0);
+
     /** return formatting for the result, based on formattings of input values */
     Value::Format format(Value a, Value b);
 
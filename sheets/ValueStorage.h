@@ -20,34 +20,115 @@
 #ifndef KSPREAD_VALUE_STORAGE
 #define KSPREAD_VALUE_STORAGE
 
+#ifdef CALLIGRA_SHEETS_CHUNKED_STORAGE
+#include "ChunkedPointStorage.h"
+#else
 #include "PointStorage.h"
+#endif
+#include "Value.h"
 
 namespace Calligra
 {
 namespace Sheets
 {
 
+#ifdef CALLIGRA_SHEETS_CHUNKED_STORAGE
+typedef ChunkedPointStorage<Value> ValueStorageBase;
+#else
+typedef PointStorage<Value> ValueStorageBase;
+#endif
+
 /**
  * \class ValueStorage
  * \ingroup Storage
  * \ingroup Value
  * Stores cell values.
  */
-class ValueStorage : public PointStorage<Value>
+class ValueStorage : public ValueStorageBase
 {
 public:
     ValueStorage()
-            : PointStorage<Value>() {
+            : ValueStorageBase() {
     }
 
-    ValueStorage(const PointStorage<Value>& o)  //krazy:exclude=explicit
-            : PointStorage<Value>(o) {
+    ValueStorage(const ValueStorageBase& o)  //krazy:exclude=explicit
+            : ValueStorageBase(o) {
     }
 
-    ValueStorage& operator=(const PointStorage<Value>& o) {
-        PointStorage<Value>::operator=(o);
+    ValueStorage& operator=(const ValueStorageBase& o) {
+        ValueStorageBase::operator=(o);
         return *this;
     }
+
+    /**
+     * Extracts the numbers in storage order, i.e. row by row, into a
+     * contiguous block.
+     *
+     * \p numbers gets one entry for each stored value. The entries of empty
+     * values and strings are zero and \p mask is \c false for them.
+     *
+     * \return \c false, if a value is neither a number, a string nor empty
+     */
+    bool numbers(QVector<Number>* numbers, QVector<bool>* mask) const {
+        const int count = this->count();
+        numbers->resize(count);
+        mask->resize(count);
+        Number* number = numbers->data();
+        bool* valid = mask->data();
+        for (int i = 0; i < count; ++i) {
+            const Value& value = constData(i);
+            switch (value.type()) {
+            case Value::Integer:
+            case Value::Float:
+                number[i] = value.asFloat();
+                valid[i] = true;
+                break;
+            case Value::Empty:
+            case Value::String:
+                number[i] = 0.0;
+                valid[i] = false;
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Extracts the numbers of the area of \p rows and \p columns starting
+     * at A1 into a dense block, row by row.
+     *
+     * Empty values are zero and booleans are one or zero.
+     *
+     * \return \c false, if a value is neither a number, a boolean nor empty
+     */
+    bool matrix(QVector<Number>* matrix, int rows, int columns) const {
+        matrix->fill(0.0, rows * columns);
+        Number* number = matrix->data();
+        const int count = this->count();
+        for (int i = 0; i < count; ++i) {
+            const int row = this->row(i);
+            const int col = this->col(i);
+            if (row > rows || col > columns)
+                continue;
+            const Value& value = constData(i);
+            switch (value.type()) {
+            case Value::Integer:
+            case Value::Float:
+                number[(row - 1) * columns + col - 1] = value.asFloat();
+                break;
+            case Value::Boolean:
+                number[(row - 1) * columns + col - 1] = value.asBoolean() ? 1.0 : 0.0;
+                break;
+            case Value::Empty:
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
 };
 
 } // namespace Sheets
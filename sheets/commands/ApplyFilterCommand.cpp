@@ -19,6 +19,8 @@
 
 #include "ApplyFilterCommand.h"
 
+#include <QBitArray>
+
 #include <KLocalizedString>
 
 #include "CellStorage.h"
@@ -52,8 +54,9 @@ void ApplyFilterCommand::redo()
     const QRect range = database.range().lastRange();
     const int start = database.orientation() == Qt::Vertical ? range.top() : range.left();
     const int end = database.orientation() == Qt::Vertical ? range.bottom() : range.right();
+    const QBitArray matches = database.filter().evaluate(database);
     for (int i = start + 1; i <= end; ++i) {
-        const bool isFiltered = !database.filter().evaluate(database, i);
+        const bool isFiltered = !matches.testBit(i - start - 1);
 //         debugSheets <<"Filtering column/row" << i <<"?" << isFiltered;
         if (database.orientation() == Qt::Vertical) {
             m_undoData[i] = sheet->rowFormats()->isFiltered(i);
@@ -17,22 +17,183 @@
    Boston, MA 02110-1301, USA.
 */
 
-
 #include "SortManipulator.h"
 
+#include "Formula.h"
 #include "Map.h"
+#include "Region.h"
 #include "Sheet.h"
-#include "ValueCalc.h"
 #include "ValueConverter.h"
 
 #include <KLocalizedString>
 
+#include <QHash>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+
 using namespace Calligra::Sheets;
 
+// Smaller ranges are sorted in this thread.
+static const int g_parallelSortSize = 8192;
+
+namespace
+{
+
+// The sort key of a value. As in Value::compare(), errors are lower than
+// numbers, numbers lower than strings and strings lower than booleans.
+// Empty values always go to the end.
+struct SortKey {
+    enum Rank { Error, Number, String, Boolean, Empty };
+
+    int rank;
+    double number;
+    QString string; // lower case, if the criterion is case insensitive
+    int listIndex;  // the position in the custom list or -1
+};
+
+// The sort keys of the columns/rows of a range for each criterion.
+class SortKeys
+{
+public:
+    SortKeys(int count, int criteria)
+            : m_criteria(criteria)
+            , m_ascending(criteria, true)
+            , m_keys(count * criteria) {}
+
+    void setAscending(int criterion, bool ascending) {
+        m_ascending[criterion] = ascending;
+    }
+
+    SortKey& key(int index, int criterion) {
+        return m_keys[index * m_criteria + criterion];
+    }
+
+    bool lessThan(int first, int second) const;
+
+private:
+    int m_criteria;
+    QVector<bool> m_ascending;
+    QVector<SortKey> m_keys;
+};
+
+bool SortKeys::lessThan(int first, int second) const
+{
+    for (int i = 0; i < m_criteria; ++i) {
+        const SortKey& a = m_keys[first * m_criteria + i];
+        const SortKey& b = m_keys[second * m_criteria + i];
+        // empty values always go to the end
+        if (a.rank == SortKey::Empty || b.rank == SortKey::Empty) {
+            if (a.rank != b.rank)
+                return b.rank == SortKey::Empty;
+            continue;
+        }
+        // if both are in the custom list, its ordering applies
+        if (a.listIndex >= 0 && b.listIndex >= 0 && a.listIndex != b.listIndex)
+            return a.listIndex < b.listIndex;
+        int result = a.rank - b.rank;
+        if (result == 0 && a.rank == SortKey::String)
+            result = QString::compare(a.string, b.string);
+        else if (result == 0)
+            result = (a.number < b.number) ? -1 : (b.number < a.number) ? 1 : 0;
+        if (result != 0)
+            return m_ascending[i] ? result < 0 : result > 0;
+        // equal - don't know yet, continue
+    }
+    // no difference found, keep the order
+    return false;
+}
+
+class LessThan
+{
+public:
+    explicit LessThan(const SortKeys* keys) : m_keys(keys) {}
+
+    bool operator()(int first, int second) const {
+        return m_keys->lessThan(first, second);
+    }
+
+private:
+    const SortKeys* m_keys;
+};
+
+// Sorts a chunk of the indices.
+class SortJob : public QRunnable
+{
+public:
+    SortJob(int* begin, int* end, const SortKeys* keys)
+            : m_begin(begin), m_end(end), m_keys(keys) {}
+
+    virtual void run() {
+        std::stable_sort(m_begin, m_end, LessThan(m_keys));
+    }
+
+private:
+    int* m_begin;
+    int* m_end;
+    const SortKeys* m_keys;
+};
+
+// Merges two sorted neighbouring chunks of the indices.
+class MergeJob : public QRunnable
+{
+public:
+    MergeJob(int* begin, int* middle, int* end, const SortKeys* keys)
+            : m_begin(begin), m_middle(middle), m_end(end), m_keys(keys) {}
+
+    virtual void run() {
+        std::inplace_merge(m_begin, m_middle, m_end, LessThan(m_keys));
+    }
+
+private:
+    int* m_begin;
+    int* m_middle;
+    int* m_end;
+    const SortKeys* m_keys;
+};
+
+// Large ranges are split into one chunk per thread. The chunks are sorted in
+// parallel and merged pairwise. Merging neighbours only keeps the sort stable.
+void stableSort(int* begin, int* end, const SortKeys& keys)
+{
+    const int count = end - begin;
+    const int threadCount = QThread::idealThreadCount();
+    if (count < g_parallelSortSize || threadCount < 2) {
+        std::stable_sort(begin, end, LessThan(&keys));
+        return;
+    }
+
+    QVector<int*> bounds;
+    for (int i = 0; i <= threadCount; ++i)
+        bounds.append(begin + qint64(count) * i / threadCount);
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+    for (int i = 1; i < bounds.count(); ++i)
+        threadPool.start(new SortJob(bounds[i - 1], bounds[i], &keys));
+    threadPool.waitForDone();
+    while (bounds.count() > 2) {
+        QVector<int*> merged;
+        merged.append(bounds[0]);
+        for (int i = 2; i < bounds.count(); i += 2) {
+            threadPool.start(new MergeJob(bounds[i - 2], bounds[i - 1], bounds[i], &keys));
+            merged.append(bounds[i]);
+        }
+        // an odd chunk gets merged in the next round
+        if (bounds.count() % 2 == 0)
+            merged.append(bounds.last());
+        threadPool.waitForDone();
+        bounds = merged;
+    }
+}
+
+} // namespace
+
 SortManipulator::SortManipulator()
-        : AbstractDFManipulator()
-        , m_cellStorage(0)
+        : AbstractRegionCommand()
 {
+    m_checkLock = true;
     m_changeformat = false;
     m_rows = true;
     m_skipfirst = false;
@@ -49,52 +210,57 @@ bool SortManipulator::process(Element* element)
 {
     // process one element - rectangular range
 
-    // here we perform the actual sorting, remember the new ordering and
-    // let AbstractDFManipulator::process do the rest of the work
-    // the new ordering is used in newValue and newFormat to return proper
-    // values
+    // here we perform the actual sorting and remember the new ordering;
+    // then the cells are moved in one pass
 
     // sort
     sort(element);
 
-    // set values
-    return AbstractDFManipulator::process(element);
+    // the cells get overwritten - store them first
+    const QRect range = element->rect();
+    takeCells(range);
+    moveCells(range);
+    return true;
 }
 
 bool SortManipulator::preProcessing()
 {
-    // Only on sorting we need to temporarily store the old data.
-    // On restoring (undo) we return immediately.
-    if (m_reverse)
-        return AbstractDFManipulator::preProcessing();
-
-    m_cellStorage = new CellStorage(m_sheet->cellStorage()->subStorage(*this));
-
-    Region::ConstIterator endOfList(cells().constEnd());
-    for (Region::ConstIterator it = cells().constBegin(); it != endOfList; ++it) {
-        QRect range = (*it)->rect();
-        for (int col = range.left(); col <= range.right(); ++col)
-            for (int row = range.top(); row <= range.bottom(); ++row) {
-                Cell cell = Cell(m_sheet, col, row);
-                m_styles.insert(cell, cell.style());
-                // encode the formula if there is one, so that cell references get updated correctly
-                if (cell.isFormula()) m_formulas.insert(cell, cell.encodeFormula());
-            }
-    }
+    if (!m_reverse)
+        m_merges.clear();
+    // not the first run - data already stored ...
+    if (!m_firstrun)
+        return true;
+    m_sheet->cellStorage()->startUndoRecording();
+    return AbstractRegionCommand::preProcessing();
+}
 
-    // to start undo recording
-    return AbstractDFManipulator::preProcessing();
+bool SortManipulator::mainProcessing()
+{
+    if (m_reverse) {
+        // reverse - use the stored values
+        KUndo2Command::undo(); // undo child commands
+        // the merged cells are not part of the undo data; restore them
+        CellStorage *storage = m_sheet->cellStorage();
+        for (int i = 0; i < m_merges.count(); ++i)
+            storage->mergeCells(m_merges[i].second.left(), m_merges[i].second.top(), 0, 0);
+        for (int i = 0; i < m_merges.count(); ++i) {
+            const QRect& rect = m_merges[i].first;
+            storage->mergeCells(rect.left(), rect.top(), rect.width() - 1, rect.height() - 1);
+        }
+        return true;
+    }
+    return AbstractRegionCommand::mainProcessing();
 }
 
 bool SortManipulator::postProcessing()
 {
-    delete m_cellStorage;
-    m_cellStorage = 0;
-    m_styles.clear();
-    m_formulas.clear();
+    m_cells.clear();
 
-    // to stop undo recording
-    return AbstractDFManipulator::postProcessing();
+    // not the first run - data already stored ...
+    if (!m_firstrun)
+        return true;
+    m_sheet->cellStorage()->stopUndoRecording(this);
+    return true;
 }
 
 void SortManipulator::addCriterion(int index, Qt::SortOrder order, Qt::CaseSensitivity caseSensitivity)
@@ -111,136 +277,143 @@ void SortManipulator::clearCriteria()
     m_criteria.clear();
 }
 
-Value SortManipulator::newValue(Element *element, int col, int row,
-                                bool *parse, Format::Type *)
-{
-    QRect range = element->rect();
-    int colidx = col - range.left();
-    int rowidx = row - range.top();
-    if (m_rows)  // sort rows
-        rowidx = sorted[rowidx];
-    else
-        colidx = sorted[colidx];
-    rowidx += range.top();
-    colidx += range.left();
-
-    // If the cell contained a formula, we need to decode it with the -new- coordinates, so that the references remain intact
-    Cell orig_cell = Cell(m_sheet, colidx, rowidx);
-    Cell new_cell = Cell(m_sheet, col, row);
-    if (m_formulas.contains(orig_cell)) {
-        *parse = true;
-        return Value(new_cell.decodeFormula(m_formulas[orig_cell]));
-    }
-
-    *parse = false;
-    // have to return the stored value, to prevent the earlier calls from disrupting the latter ones
-    return m_cellStorage->value(colidx, rowidx);
-}
-
-Style SortManipulator::newFormat(Element *element, int col, int row)
-{
-    QRect range = element->rect();
-    int colidx = col - range.left();
-    int rowidx = row - range.top();
-    if (m_changeformat) {
-        if (m_rows)  // sort rows
-            rowidx = sorted[rowidx];
-        else
-            colidx = sorted[colidx];
-    }
-
-    // have to return stored format, to avoid earlier calls disrupting latter ones
-    return m_styles.value(Cell(m_sheet, colidx + range.left(), rowidx + range.top()));
-}
-
 void SortManipulator::sort(Element *element)
 {
-    // we'll use insert-sort to sort
     QRect range = element->rect();
-    int max = m_rows ? range.bottom() : range.right();
-    int min = m_rows ? range.top() : range.left();
-    int count = max - min + 1;
+    int count = m_rows ? range.height() : range.width();
     // initially, all values are at their original positions
-    sorted.clear();
+    sorted.resize(count);
     for (int i = 0; i < count; ++i) sorted[i] = i;
 
-    // for each position, find the lowest value and move it there
     int start = m_skipfirst ? 1 : 0;
-    for (int i = start; i < count - 1; ++i) {
-        int lowest = i;
-        for (int j = i + 1; j < count; ++j)
-            if (shouldReorder(element, sorted[lowest], sorted[j]))
-                lowest = j;
-        // move lowest to start
-        int tmp = sorted[i];
-        sorted[i] = sorted[lowest];
-        sorted[lowest] = tmp;
+    if (count - start < 2 || m_criteria.isEmpty())
+        return;
+
+    // Extract the sort keys once, so that the comparisons convert no values.
+    const CellStorage *storage = m_sheet->cellStorage();
+    ValueConverter *conv = m_sheet->map()->converter();
+    QHash<QString, int> customList;
+    if (m_usecustomlist) {
+        // the first occurrence counts
+        for (int i = m_customlist.count() - 1; i >= 0; --i)
+            customList.insert(m_customlist[i].toLower(), i);
+    }
+    SortKeys keys(count, m_criteria.count());
+    for (int c = 0; c < m_criteria.count(); ++c) {
+        const Criterion& criterion = m_criteria[c];
+        keys.setAscending(c, criterion.order == Qt::AscendingOrder);
+        for (int i = start; i < count; ++i) {
+            const int col = range.left() + (m_rows ? criterion.index : i);
+            const int row = range.top() + (m_rows ? i : criterion.index);
+            const Value value = storage->value(col, row);
+            SortKey& key = keys.key(i, c);
+            key.number = 0.0;
+            key.listIndex = -1;
+            switch (value.type()) {
+            case Value::Empty:
+                key.rank = SortKey::Empty;
+                continue;
+            case Value::Boolean:
+                key.rank = SortKey::Boolean;
+                key.number = value.asBoolean() ? 1.0 : 0.0;
+                break;
+            case Value::Integer:
+            case Value::Float:
+                key.rank = SortKey::Number;
+                key.number = numToDouble(value.asFloat());
+                break;
+            case Value::Error:
+                key.rank = SortKey::Error;
+                break;
+            default:
+                // complex numbers and arrays are ordered by their text
+                key.rank = SortKey::String;
+                key.string = value.isString() ? value.asString() : conv->asString(value).asString();
+                if (criterion.caseSensitivity == Qt::CaseInsensitive)
+                    key.string = key.string.toLower();
+                break;
+            }
+            if (!customList.isEmpty())
+                key.listIndex = customList.value(conv->asString(value).asString().toLower(), -1);
+        }
     }
 
-    // that's all - process will take care of the rest, together with our
-    // newValue/newFormat
+    stableSort(sorted.data() + start, sorted.data() + count, keys);
+
+    // that's all - moveCells will take care of the rest
 }
 
-bool SortManipulator::shouldReorder(Element *element, int first, int second)
+void SortManipulator::takeCells(const QRect& range)
 {
-    // we use ValueCalc::natural* to compare
-    // indexes are real indexes, we don't use the sorted array here
-
-    ValueCalc *calc = m_sheet->map()->calc();
-    ValueConverter *conv = m_sheet->map()->converter();
+    const CellStorage *storage = m_sheet->cellStorage();
+    m_cells.clear();
+    m_cells.resize(range.width() * range.height());
+    int i = 0;
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int col = range.left(); col <= range.right(); ++col, ++i) {
+            CellData& data = m_cells[i];
+            const Cell cell(m_sheet, col, row);
+            // encode the formula if there is one, so that cell references get updated correctly
+            if (cell.isFormula())
+                data.formula = cell.encodeFormula();
+            data.value = storage->value(col, row);
+            data.userInput = storage->userInput(col, row);
+            data.comment = storage->comment(col, row);
+            data.richText = storage->richText(col, row);
+            const bool master = storage->doesMergeCells(col, row);
+            data.mergedXCells = master ? storage->mergedXCells(col, row) : 0;
+            data.mergedYCells = master ? storage->mergedYCells(col, row) : 0;
+            if (m_changeformat)
+                data.style = storage->style(col, row);
+        }
+    }
+}
 
-    QRect range = element->rect();
-    int firstrow = range.top();
-    int firstcol = range.left();
-
-    for (int i = 0; i < m_criteria.count(); ++i) {
-        int which = m_criteria[i].index;
-        bool ascending = m_criteria[i].order == Qt::AscendingOrder;
-        bool caseSensitive = m_criteria[i].caseSensitivity == Qt::CaseSensitive;
-
-        // figure out coordinates of the cells
-        int row1 = firstrow + (m_rows ? first : which);
-        int row2 = firstrow + (m_rows ? second : which);
-        int col1 = firstcol + (m_rows ? which : first);
-        int col2 = firstcol + (m_rows ? which : second);
-        Value val1 = Cell(m_sheet, col1, row1).value();
-        Value val2 = Cell(m_sheet, col2, row2).value();
-        // empty values always go to the end, so if second value is empty and
-        // first one is not, we don't need to reorder
-        if (!val1.isEmpty() && val2.isEmpty())
-            return false;
-        if (val1.isEmpty() && !val2.isEmpty())
-            return true;
-
-        // custom list ?
-        if (m_usecustomlist) {
-            QString s1 = conv->asString(val1).asString().toLower();
-            QString s2 = conv->asString(val2).asString().toLower();
-            int pos1 = -1, pos2 = -1;
-            int pos = 0;
-            // Try to locate our two strings in the list. If both are there, assume
-            // ordering as specified by the list.
-            for (QStringList::ConstIterator  it = m_customlist.constBegin(); it != m_customlist.constEnd(); ++it) {
-                if ((pos1 == -1) && ((*it).toLower() == s1))
-                    pos1 = pos;
-                if ((pos2 == -1) && ((*it).toLower() == s2))
-                    pos2 = pos;
-                pos++;
+void SortManipulator::moveCells(const QRect& range)
+{
+    CellStorage *storage = m_sheet->cellStorage();
+    // the merged cells move with their master cells; dissolve them first
+    int i = 0;
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int col = range.left(); col <= range.right(); ++col, ++i) {
+            const int index = m_rows ? row - range.top() : col - range.left();
+            if (sorted[index] != index && (m_cells[i].mergedXCells > 0 || m_cells[i].mergedYCells > 0))
+                storage->mergeCells(col, row, 0, 0);
+        }
+    }
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int col = range.left(); col <= range.right(); ++col) {
+            const int index = m_rows ? row - range.top() : col - range.left();
+            // the cells staying in place are left alone
+            if (sorted[index] == index)
+                continue;
+            const int colidx = m_rows ? col - range.left() : sorted[index];
+            const int rowidx = m_rows ? sorted[index] : row - range.top();
+            const CellData& data = m_cells[rowidx * range.width() + colidx];
+
+            // a covered cell is moved like the others, never into its master cell
+            Cell cell = Cell(m_sheet, col, row);
+            if (data.formula.isEmpty()) {
+                storage->setFormula(col, row, Formula::empty());
+                storage->setValue(col, row, data.value);
+                storage->setUserInput(col, row, data.userInput);
+            } else {
+                // decode the formula with the -new- coordinates, so that the references remain intact
+                Formula formula(m_sheet, cell);
+                formula.setExpression(cell.decodeFormula(data.formula));
+                storage->setFormula(col, row, formula);
+                storage->setUserInput(col, row, QString());
+            }
+            storage->setRichText(col, row, data.richText);
+            storage->setComment(Region(col, row), data.comment);
+            if (m_changeformat)
+                cell.setStyle(data.style);
+            if (data.mergedXCells > 0 || data.mergedYCells > 0) {
+                storage->mergeCells(col, row, data.mergedXCells, data.mergedYCells);
+                const QSize size(data.mergedXCells + 1, data.mergedYCells + 1);
+                m_merges.append(qMakePair(QRect(QPoint(range.left() + colidx, range.top() + rowidx), size),
+                                          QRect(QPoint(col, row), size)));
             }
-            if ((pos1 >= 0) && (pos2 >= 0) && (pos1 != pos2))
-                // both are in the list, not the same
-                return (pos1 > pos2);
         }
-
-        if (calc->naturalGreater(val1, val2, caseSensitive))
-            // first one greater - must reorder if ascending, don't reorder if not
-            return ascending;
-        if (calc->naturalLower(val1, val2, caseSensitive))
-            // first one lower - don't reorder if ascending, reorder if not
-            return !ascending;
-        // equal - don't know yet, continue
     }
-
-    // no difference found, they're the same - no need to reorder
-    return false;
 }
@@ -20,8 +20,18 @@
 #ifndef CALLIGRA_SHEETS_SORT_MANIPULATOR
 #define CALLIGRA_SHEETS_SORT_MANIPULATOR
 
+#include <QPair>
+#include <QRect>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+#include "AbstractRegionCommand.h"
 #include "CellStorage.h"
-#include "DataManipulators.h"
+#include "Style.h"
+#include "Value.h"
+
+class QTextDocument;
 
 namespace Calligra
 {
@@ -32,8 +42,13 @@ class CellStorage;
 /**
  * \ingroup Commands
  * \brief Sorts the values in a cell range.
+ *
+ * The sort keys of each column/row are extracted once before sorting. Large
+ * ranges are sorted in several threads. The sorting is stable. Afterwards the
+ * values, formulas, comments and, if requested, the styles are moved in one
+ * pass over the range. Merged cells move with their master cells.
  */
-class CALLIGRA_SHEETS_COMMON_EXPORT SortManipulator : public AbstractDFManipulator
+class CALLIGRA_SHEETS_COMMON_EXPORT SortManipulator : public AbstractRegionCommand
 {
 public:
     SortManipulator();
@@ -51,7 +66,7 @@ public:
     }
     /** set whether cell formats should be moved with data */
     void setCopyFormat(bool v) {
-        setChangeFormat(v);
+        m_changeformat = v;
     }
     /** set whether we will use a custom list */
     void setUseCustomList(bool v) {
@@ -74,16 +89,17 @@ public:
 
 protected:
     virtual bool preProcessing();
+    virtual bool mainProcessing();
     virtual bool postProcessing();
-    virtual Value newValue(Element *element, int col, int row,
-                           bool *parse, Format::Type *fmtType);
-    virtual Style newFormat(Element *element, int col, int row);
 
     /** sort the data, filling the "sorted" structure */
     void sort(Element *element);
-    bool shouldReorder(Element *element, int first, int second);
+    /** store the contents of the cells of \p range in "m_cells" */
+    void takeCells(const QRect& range);
+    /** move the cells of \p range to their sorted positions */
+    void moveCells(const QRect& range);
 
-    bool m_rows, m_skipfirst, m_usecustomlist;
+    bool m_changeformat, m_rows, m_skipfirst, m_usecustomlist;
     QStringList m_customlist;
 
     struct Criterion {
@@ -94,11 +110,22 @@ protected:
     QList<Criterion> m_criteria;
 
     /** sorted order - which row/column will move to where */
-    QMap<int, int> sorted;
+    QVector<int> sorted;
+
+    struct CellData {
+        Value value;
+        QString userInput;
+        QString formula; // encoded, so that cell references get updated correctly
+        QString comment;
+        QSharedPointer<QTextDocument> richText;
+        Style style;
+        int mergedXCells; // the merged cells, if it is a master cell
+        int mergedYCells;
+    };
+    QVector<CellData> m_cells; // temporary; row by row
 
-    CellStorage* m_cellStorage; // temporary
-    QHash<Cell, Style> m_styles; // temporary
-    QHash<Cell, QString> m_formulas; // temporary; encoded formulas
+    /** the merged cells moved by the sorting; their old and new areas */
+    QList<QPair<QRect, QRect> > m_merges;
 };
 
 } // namespace Sheets
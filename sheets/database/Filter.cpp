@@ -19,14 +19,17 @@
 
 #include "Filter.h"
 
+#include <QBitArray>
 #include <QList>
 #include <QRect>
+#include <QSharedPointer>
 
 #include <KoXmlNS.h>
 #include <KoXmlWriter.h>
 
 #include "CellStorage.h"
 #include "Database.h"
+#include "FilterCache.h"
 #include "Map.h"
 #include "Region.h"
 #include "Sheet.h"
@@ -36,6 +39,46 @@
 
 using namespace Calligra::Sheets;
 
+namespace
+{
+
+// The fields of a database, fetched from the FilterCache on first use.
+class FilterFields
+{
+public:
+    explicit FilterFields(const Database& database)
+            : m_sheet(database.range().lastSheet())
+            , m_range(database.range().lastRange())
+            , m_isRowFilter(database.orientation() == Qt::Vertical)
+            , m_count(qMax(0, (m_isRowFilter ? m_range.height() : m_range.width()) - 1)) {
+    }
+
+    // the number of columns/rows following the first one
+    int count() const {
+        return m_count;
+    }
+
+    const FilterCache::Field& field(int fieldNumber) {
+        QSharedPointer<const FilterCache::Field>& field = m_fields[fieldNumber];
+        if (!field) {
+            const QRect range = m_isRowFilter
+                                ? QRect(m_range.left() + fieldNumber, m_range.top() + 1, 1, m_count)
+                                : QRect(m_range.left() + 1, m_range.top() + fieldNumber, m_count, 1);
+            field = m_sheet->map()->filterCache()->field(m_sheet, range);
+        }
+        return *field;
+    }
+
+private:
+    Sheet* m_sheet;
+    QRect m_range;
+    bool m_isRowFilter;
+    int m_count;
+    QHash<int, QSharedPointer<const FilterCache::Field> > m_fields;
+};
+
+} // namespace
+
 class Calligra::Sheets::AbstractCondition
 {
 public:
@@ -45,6 +88,7 @@ public:
     virtual bool loadOdf(const KoXmlElement& element) = 0;
     virtual void saveOdf(KoXmlWriter& xmlWriter) = 0;
     virtual bool evaluate(const Database& database, int index) const = 0;
+    virtual QBitArray evaluate(FilterFields& fields) const = 0;
     virtual bool isEmpty() const = 0;
     virtual QHash<QString, Filter::Comparison> conditions(int fieldNumber) const = 0;
     virtual void removeConditions(int fieldNumber) = 0;
@@ -85,6 +129,16 @@ public:
         }
         return true;
     }
+    virtual QBitArray evaluate(FilterFields& fields) const {
+        QBitArray result(fields.count(), true);
+        for (int i = 0; i < list.count(); ++i) {
+            // stop, if no column/row is left
+            if (result.count(true) == 0)
+                break;
+            result &= list[i]->evaluate(fields);
+        }
+        return result;
+    }
     virtual bool isEmpty() const {
         return list.isEmpty();
     }
@@ -154,6 +208,16 @@ public:
         }
         return false;
     }
+    virtual QBitArray evaluate(FilterFields& fields) const {
+        QBitArray result(fields.count(), false);
+        for (int i = 0; i < list.count(); ++i) {
+            // stop, if all columns/rows are in
+            if (result.count(true) == result.size())
+                break;
+            result |= list[i]->evaluate(fields);
+        }
+        return result;
+    }
     virtual bool isEmpty() const {
         return list.isEmpty();
     }
@@ -368,6 +432,23 @@ public:
         }
         return false;
     }
+    virtual QBitArray evaluate(FilterFields& fields) const {
+        QBitArray result(fields.count());
+        if (operation != Match && operation != NotMatch)
+            return result;
+        // Compare each distinct string once.
+        const FilterCache::Field& field = fields.field(fieldNumber);
+        QBitArray matches(field.strings.count());
+        for (int i = 0; i < field.strings.count(); ++i) {
+            const bool equal = QString::compare(value, field.strings[i], caseSensitivity) == 0;
+            matches.setBit(i, equal == (operation == Match));
+        }
+        for (int i = 0; i < field.codes.count(); ++i) {
+            if (matches.testBit(field.codes[i]))
+                result.setBit(i);
+        }
+        return result;
+    }
     virtual bool isEmpty() const {
         return fieldNumber == -1;
     }
@@ -663,6 +744,12 @@ bool Filter::evaluate(const Database& database, int index) const
     return d->condition ? d->condition->evaluate(database, index) : true;
 }
 
+QBitArray Filter::evaluate(const Database& database) const
+{
+    FilterFields fields(database);
+    return d->condition ? d->condition->evaluate(fields) : QBitArray(fields.count(), true);
+}
+
 bool Filter::loadOdf(const KoXmlElement& element, const Map* map)
 {
     if (element.hasAttributeNS(KoXmlNS::table, "target-range-address")) {
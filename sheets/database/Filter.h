@@ -27,6 +27,7 @@
 
 #include "sheets_odf_export.h"
 
+class QBitArray;
 class KoXmlWriter;
 
 namespace Calligra
@@ -101,6 +102,15 @@ public:
      */
     bool evaluate(const Database& database, int index) const;
 
+    /**
+     * Evaluates the conditions for all columns/rows of \p database following the first one.
+     * The cells of each field are converted once and each condition tests the distinct
+     * strings of its field only.
+     * \return a bit for each column/row; set, if it should not be filtered
+     * \see FilterCache
+     */
+    QBitArray evaluate(const Database& database) const;
+
     bool loadOdf(const KoXmlElement& element, const Map* map);
     void saveOdf(KoXmlWriter& xmlWriter) const;
 
@@ -0,0 +1,138 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+// Local
+#include "FilterCache.h"
+
+#include "CellStorage.h"
+#include "Map.h"
+#include "RangeCache_p.h"
+#include "Region.h"
+#include "Sheet.h"
+#include "Value.h"
+#include "ValueConverter.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QRect>
+
+#include <algorithm>
+
+using namespace Calligra::Sheets;
+
+namespace
+{
+
+struct RangeKey {
+    QRect range;
+
+    bool operator==(const RangeKey& other) const {
+        return range == other.range;
+    }
+};
+
+uint qHash(const RangeKey& key)
+{
+    return ::qHash(qMakePair(qMakePair(key.range.left(), key.range.top()),
+                             qMakePair(key.range.right(), key.range.bottom())));
+}
+
+FilterCache::Field* createField(Sheet* sheet, const QRect& range)
+{
+    FilterCache::Field* field = new FilterCache::Field;
+    const bool isColumn = range.width() == 1;
+    const int first = isColumn ? range.top() : range.left();
+    const int last = isColumn ? range.bottom() : range.right();
+    const CellStorage* storage = sheet->cellStorage();
+    ValueConverter* const converter = sheet->map()->converter();
+    QHash<QString, int> codes;
+    field->codes.reserve(last - first + 1);
+    for (int i = first; i <= last; ++i) {
+        const Value value = isColumn ? storage->value(range.left(), i) : storage->value(i, range.top());
+        const QString string = converter->asString(value).asString();
+        QHash<QString, int>::ConstIterator it = codes.constFind(string);
+        if (it == codes.constEnd()) {
+            it = codes.insert(string, field->strings.count());
+            field->strings.append(string);
+            if (!string.isEmpty())
+                field->items.append(string);
+        }
+        field->codes.append(it.value());
+    }
+    std::sort(field->items.begin(), field->items.end());
+    return field;
+}
+
+} // namespace
+
+class Q_DECL_HIDDEN FilterCache::Private
+{
+public:
+    QMutex mutex;
+    RangeCache<RangeKey, QSharedPointer<const Field> > fields;
+};
+
+FilterCache::FilterCache()
+        : d(new Private)
+{
+}
+
+FilterCache::~FilterCache()
+{
+    delete d;
+}
+
+QSharedPointer<const FilterCache::Field> FilterCache::field(Sheet* sheet, const QRect& range)
+{
+    RangeKey rangeKey;
+    rangeKey.range = range;
+    {
+        QMutexLocker locker(&d->mutex);
+        const QSharedPointer<const Field> field = d->fields.value(sheet, rangeKey);
+        if (field)
+            return field;
+    }
+
+    // Convert the cells without holding the lock.
+    const QSharedPointer<const Field> field(createField(sheet, range));
+    QMutexLocker locker(&d->mutex);
+    d->fields.insert(sheet, rangeKey, field);
+    return field;
+}
+
+void FilterCache::regionChanged(Sheet* sheet, const Region& region)
+{
+    if (d->fields.isEmpty())
+        return;
+    QMutexLocker locker(&d->mutex);
+    d->fields.regionChanged(sheet, region);
+}
+
+void FilterCache::removeSheet(Sheet* sheet)
+{
+    QMutexLocker locker(&d->mutex);
+    d->fields.removeSheet(sheet);
+}
+
+void FilterCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->fields.clear();
+}
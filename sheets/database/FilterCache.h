@@ -0,0 +1,105 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_FILTER_CACHE
+#define CALLIGRA_SHEETS_FILTER_CACHE
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+#include "sheets_odf_export.h"
+
+class QRect;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Region;
+class Sheet;
+
+/**
+ * \class FilterCache
+ * \brief Caches the string columns of the filtered databases.
+ * \ingroup Value
+ *
+ * The Filter compares the string representations of the cell values. Each
+ * field of a database is converted once into a dictionary of its distinct
+ * strings and a code per column/row, so that a condition is tested once per
+ * distinct string. The FilterPopup shows the same distinct strings.
+ *
+ * A field is kept until a CellDamage touches its range.
+ *
+ * The cache may be used from several threads at once.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT FilterCache
+{
+public:
+    /**
+     * The strings of a database field.
+     */
+    struct Field {
+        QStringList strings;    ///< the distinct strings in order of appearance
+        QVector<int> codes;     ///< the index into strings of each cell
+        QStringList items;      ///< the sorted distinct strings without the empty one
+    };
+
+    /**
+     * Constructor.
+     */
+    FilterCache();
+
+    /**
+     * Destructor.
+     */
+    ~FilterCache();
+
+    /**
+     * \return the strings of the cells of \p range on \p sheet ; \p range
+     *         is one column or row wide
+     */
+    QSharedPointer<const Field> field(Sheet* sheet, const QRect& range);
+
+    /**
+     * Drops the fields on \p sheet intersecting \p region .
+     */
+    void regionChanged(Sheet* sheet, const Region& region);
+
+    /**
+     * Drops the fields on \p sheet .
+     */
+    void removeSheet(Sheet* sheet);
+
+    /**
+     * Drops all fields.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(FilterCache)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_FILTER_CACHE
@@ -24,6 +24,7 @@
 #include <QHash>
 #include <QList>
 #include <QScrollArea>
+#include <QStringList>
 #include <QVBoxLayout>
 
 #include <KLocalizedString>
@@ -31,10 +32,10 @@
 #include "CellStorage.h"
 #include "Database.h"
 #include "Filter.h"
+#include "FilterCache.h"
 #include "Map.h"
 #include "RowColumnFormat.h"
 #include "Sheet.h"
-#include "ValueConverter.h"
 
 #include "commands/ApplyFilterCommand.h"
 
@@ -79,19 +80,19 @@ void FilterPopup::Private::initGUI(FilterPopup* parent, const Cell& cell, const
     layout->addWidget(notEmptyCheckbox);
     layout->addSpacing(3);
 
-    const Sheet* sheet = cell.sheet();
+    Sheet* const sheet = cell.sheet();
     const QRect range = database->range().lastRange();
     const bool isRowFilter = database->orientation() == Qt::Vertical;
     const int start = isRowFilter ? range.top() : range.left();
     const int end = isRowFilter ? range.bottom() : range.right();
     const int j = isRowFilter ? cell.column() : cell.row();
-    QSet<QString> items;
-    for (int i = start + (database->containsHeader() ? 1 : 0); i <= end; ++i) {
-        const Value value = isRowFilter ? sheet->cellStorage()->value(j, i)
-                            : sheet->cellStorage()->value(i, j);
-        const QString string = sheet->map()->converter()->asString(value).asString();
-        if (!string.isEmpty())
-            items.insert(string);
+    const int first = start + (database->containsHeader() ? 1 : 0);
+    // The distinct strings are shared with the filter evaluation.
+    QStringList sortedItems;
+    if (first <= end) {
+        const QRect fieldRange = isRowFilter ? QRect(j, first, 1, end - first + 1)
+                                 : QRect(first, j, end - first + 1, 1);
+        sortedItems = sheet->map()->filterCache()->field(sheet, fieldRange)->items;
     }
 
     QWidget* scrollWidget = new QWidget(parent);
@@ -104,8 +105,6 @@ void FilterPopup::Private::initGUI(FilterPopup* parent, const Cell& cell, const
     const bool defaultCheckState = conditions.isEmpty() ? true
                                    : !(conditions[conditions.keys()[0]] == Filter::Match ||
                                        conditions[conditions.keys()[0]] == Filter::Empty);
-    QList<QString> sortedItems = items.toList();
-    qSort(sortedItems);
     bool isAll = true;
     QCheckBox* item;
     for (int i = 0; i < sortedItems.count(); ++i) {
@@ -50,6 +50,8 @@
 
 #include <Eigen/LU>
 
+#include <QBitArray>
+
 using namespace Calligra::Sheets;
 
 // RANDBINOM and RANDNEGBINOM won't support arbitrary precision
@@ -575,11 +577,19 @@ Value func_sumif(valVector args, ValueCalc *calc, FuncExtra *e)
     Condition cond;
     calc->getCond(cond, Value(condition));
 
+    QBitArray mask;
+    const bool cached = e && calc->matchingElements(args, e->regions, 0, QList<Condition>() << cond, checkRange, &mask);
+
     if (args.count() == 3) {
         Cell sumRangeStart(e->regions[2].firstSheet(), e->regions[2].firstRange().topLeft());
-        return calc->sumIf(sumRangeStart, checkRange, cond);
+        if (!cached)
+            return calc->sumIf(sumRangeStart, checkRange, cond);
+        // only fetch the cells to sum up
+        return calc->sumIf(sumRangeStart, checkRange.columns(), mask);
     } else {
-        return calc->sumIf(checkRange, cond);
+        if (!cached)
+            return calc->sumIf(checkRange, cond);
+        return calc->sumIf(checkRange, mask);
     }
 }
 
@@ -601,6 +611,11 @@ Value func_sumifs(valVector args, ValueCalc *calc, FuncExtra *e)
         calc->getCond(c, Value(condition.last()));
         cond.append(c);
     }
+
+    QBitArray mask;
+    if (e && calc->matchingElements(args, e->regions, 1, cond, c_Range[0], &mask))
+        return calc->sumIf(c_Range[0], mask, 0, true);
+
     Cell sumRangeStart(e->sheet, e->ranges[2].col1, e->ranges[2].row1);
     return calc->sumIfs(sumRangeStart, c_Range, cond, lim);
 }
@@ -655,9 +670,7 @@ Value func_div(valVector args, ValueCalc *calc, FuncExtra *)
 // Function: SUMSQ
 Value func_sumsq(valVector args, ValueCalc *calc, FuncExtra *)
 {
-    Value res;
-    calc->arrayWalk(args, res, calc->awFunc("sumsq"), Value(0));
-    return res;
+    return calc->sumsq(args, false);
 }
 
 // Function: MAX
@@ -1053,6 +1066,10 @@ Value func_countif(valVector args, ValueCalc *calc, FuncExtra *e)
     Condition cond;
     calc->getCond(cond, Value(condition));
 
+    QBitArray mask;
+    if (e && calc->matchingElements(args, e->regions, 0, QList<Condition>() << cond, range, &mask))
+        return Value(mask.count(true));
+
     return Value(calc->countIf(range, cond));
 }
 
@@ -1076,6 +1093,13 @@ Value func_countifs(valVector args, ValueCalc *calc, FuncExtra *e)
         calc->getCond(c, Value(condition.last()));
         cond.append(c);
     }
+
+    QBitArray mask;
+    if (e && calc->matchingElements(args, e->regions, 0, cond, c_Range[0], &mask)) {
+        const int count = mask.count(true);
+        return count ? calc->add(Value(0), Number(count)) : Value(0);
+    }
+
     Cell cntRangeStart(e->sheet, e->ranges[2].col1, e->ranges[2].row1);
     return calc->countIfs(cntRangeStart, c_Range, cond, lim);
 }
@@ -1185,6 +1209,18 @@ static Eigen::MatrixXd convert(const Value& matrix, ValueCalc *calc)
 {
     const int rows = matrix.rows(), cols = matrix.columns();
     Eigen::MatrixXd eMatrix(rows, cols);
+    // Copy plain numbers in one pass instead of looking up each element.
+    QVector<Number> numbers;
+    if (matrix.matrix(&numbers)) {
+        const Number* number = numbers.constData();
+        for (int row = 0; row < rows; ++row) {
+            for (int col = 0; col < cols; ++col) {
+                eMatrix(row, col) = numToDouble(number[row * cols + col]);
+            }
+        }
+        return eMatrix;
+    }
+    // strings need to be parsed
     for (int row = 0; row < rows; ++row) {
         for (int col = 0; col < cols; ++col) {
             eMatrix(row, col) = numToDouble(calc->conv()->toFloat(matrix.element(col, row)));
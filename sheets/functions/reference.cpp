@@ -32,6 +32,7 @@
 #include "Formula.h"
 #include "Function.h"
 #include "FunctionModuleRegistry.h"
+#include "LookupCache.h"
 #include "ValueCalc.h"
 #include "ValueConverter.h"
 
@@ -94,6 +95,7 @@ ReferenceModule::ReferenceModule(QObject* parent, const QVariantList&)
     f = new Function("HLOOKUP",  func_hlookup);
     f->setParamCount(3, 4);
     f->setAcceptArray();
+    f->setNeedsExtra(true);
     add(f);
     f = new Function("INDEX",   func_index);
     f->setParamCount(3);
@@ -140,6 +142,7 @@ ReferenceModule::ReferenceModule(QObject* parent, const QVariantList&)
     f = new Function("VLOOKUP",  func_vlookup);
     f->setParamCount(3, 4);
     f->setAcceptArray();
+    f->setNeedsExtra(true);
     add(f);
 }
 
@@ -149,6 +152,22 @@ QString ReferenceModule::descriptionFileName() const
 }
 
 
+// Searches the first column or row of a range argument using the map's lookup cache.
+// Returns false, if the argument is not a cell range or the cache does not handle the key.
+static bool cachedLookup(FuncExtra *e, int index, Qt::Orientation orientation, const Value &data,
+                         const Value &key, bool rangeLookup, Qt::CaseSensitivity cs, int *position)
+{
+    if (!e || index >= e->regions.count())
+        return false;
+    const Region &region = e->regions[index];
+    if (!region.isValid() || !region.isContiguous() || !region.firstSheet())
+        return false;
+    Sheet *const sheet = region.firstSheet();
+    return sheet->map()->lookupCache()->find(sheet, region.firstRange(), orientation, data,
+                                             key, rangeLookup, cs, position);
+}
+
+
 //
 // Function: ADDRESS
 //
@@ -353,7 +372,7 @@ Value func_columns(valVector, ValueCalc *, FuncExtra *e)
 //
 // Function: HLOOKUP
 //
-Value func_hlookup(valVector args, ValueCalc *calc, FuncExtra *)
+Value func_hlookup(valVector args, ValueCalc *calc, FuncExtra *e)
 {
     const Value key = args[0];
     const Value data = args[1];
@@ -364,17 +383,23 @@ Value func_hlookup(valVector args, ValueCalc *calc, FuncExtra *)
         return Value::errorVALUE();
     const bool rangeLookup = (args.count() > 3) ? calc->conv()->asBoolean(args[3]).asBoolean() : true;
 
+    // use the index of the first row, if the data is a cell range
+    int col = -1;
+    if (cachedLookup(e, 1, Qt::Horizontal, data, key, rangeLookup, Qt::CaseSensitive, &col))
+        return (col == -1) ? Value::errorNA() : data.element(col, row - 1);
+
     // now traverse the array and perform comparison
     Value r;
     Value v = Value::errorNA();
-    for (int col = 0; col < cols; ++col) {
+    for (col = 0; col < cols; ++col) {
         // search in the first row
         const Value le = data.element(col, 0);
         if (calc->naturalEqual(key, le)) {
             return data.element(col, row - 1);
         }
         // optionally look for the next largest value that is less than key
-        if (rangeLookup && calc->naturalLower(le, key) && calc->naturalLower(r, le)) {
+        if (rangeLookup && !le.isEmpty() && calc->naturalLower(le, key) &&
+                (r.isEmpty() || calc->naturalLower(r, le))) {
             r = le;
             v = data.element(col, row - 1);
         }
@@ -485,6 +510,11 @@ Value func_match(valVector args, ValueCalc *calc, FuncExtra* e)
     int n = qMax(searchArray.rows(), searchArray.columns());
 
     if (matchType == 0) {
+        // use the index, if the data is a cell range
+        int position = -1;
+        const Qt::Orientation orientation = (dr == 1) ? Qt::Vertical : Qt::Horizontal;
+        if (cachedLookup(e, 1, orientation, searchArray, searchValue, false, Qt::CaseInsensitive, &position))
+            return (position == -1) ? Value::errorNA() : Value(position + 1);
         // linear search
         for (int r = 0, c = 0; r < n && c < n; r += dr, c += dc) {
             if (calc->naturalEqual(searchValue, searchArray.element(c, r), false)) {
@@ -648,7 +678,7 @@ Value func_sheets(valVector /*args*/, ValueCalc *, FuncExtra *e)
 //
 // Function: VLOOKUP
 //
-Value func_vlookup(valVector args, ValueCalc *calc, FuncExtra *)
+Value func_vlookup(valVector args, ValueCalc *calc, FuncExtra *e)
 {
     const Value key = args[0];
     const Value data = args[1];
@@ -659,17 +689,23 @@ Value func_vlookup(valVector args, ValueCalc *calc, FuncExtra *)
         return Value::errorVALUE();
     const bool rangeLookup = (args.count() > 3) ? calc->conv()->asBoolean(args[3]).asBoolean() : true;
 
+    // use the index of the first column, if the data is a cell range
+    int row = -1;
+    if (cachedLookup(e, 1, Qt::Vertical, data, key, rangeLookup, Qt::CaseSensitive, &row))
+        return (row == -1) ? Value::errorNA() : data.element(col - 1, row);
+
     // now traverse the array and perform comparison
     Value r;
     Value v = Value::errorNA();
-    for (int row = 0; row < rows; ++row) {
+    for (row = 0; row < rows; ++row) {
         // search in the first column
         const Value le = data.element(0, row);
         if (calc->naturalEqual(key, le)) {
             return data.element(col - 1, row);
         }
         // optionally look for the next largest value that is less than key
-        if (rangeLookup && calc->naturalLower(le, key) && calc->naturalLower(r, le)) {
+        if (rangeLookup && !le.isEmpty() && calc->naturalLower(le, key) &&
+                (r.isEmpty() || calc->naturalLower(r, le))) {
             r = le;
             v = data.element(col - 1, row);
         }
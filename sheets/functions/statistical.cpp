@@ -30,6 +30,8 @@
 
 #include <Formula.h>
 
+#include <QBitArray>
+
 // needed for MODE
 #include <QList>
 #include <QMap>
@@ -792,11 +794,23 @@ Value func_averageif(valVector args, ValueCalc *calc, FuncExtra *e)
     Condition cond;
     calc->getCond(cond, Value(condition));
 
+    QBitArray mask;
+    const bool cached = e && calc->matchingElements(args, e->regions, 0, QList<Condition>() << cond, checkRange, &mask);
+
     if (args.count() == 3) {
         Cell avgRangeStart(e->sheet, e->ranges[2].col1, e->ranges[2].row1);
-        return calc->averageIf(avgRangeStart, checkRange, cond);
+        if (!cached)
+            return calc->averageIf(avgRangeStart, checkRange, cond);
+        // only fetch the cells to average
+        int cnt = 0;
+        const Value res = calc->sumIf(avgRangeStart, checkRange.columns(), mask, &cnt);
+        return calc->div(res, cnt);
     } else {
-        return calc->averageIf(checkRange, cond);
+        if (!cached)
+            return calc->averageIf(checkRange, cond);
+        int cnt = 0;
+        const Value res = calc->sumIf(checkRange, mask, &cnt);
+        return calc->div(res, cnt);
     }
 }
 
@@ -820,6 +834,11 @@ Value func_averageifs(valVector args, ValueCalc *calc, FuncExtra *e)
         calc->getCond(c, Value(condition.last()));
         cond.append(c);
     }
+
+    QBitArray mask;
+    if (e && calc->matchingElements(args, e->regions, 1, cond, c_Range[0], &mask))
+        return calc->div(calc->sumIf(c_Range[0], mask, 0, true), mask.count(true));
+
     Cell avgRangeStart(e->sheet, e->ranges[2].col1, e->ranges[2].row1);
     return calc->averageIfs(avgRangeStart, c_Range, cond, lim);
 }
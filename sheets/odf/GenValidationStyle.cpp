@@ -24,17 +24,31 @@
 // Calligra
 #include <KoXmlWriter.h>
 
+// Qt
+#include <QMutexLocker>
+
 // Sheets
 #include "Validity.h"
 #include "ValueConverter.h"
 
 using namespace Calligra::Sheets;
 
+// The provisional names are enclosed in noncharacters, that Unicode reserves
+// for the internal use of applications. KoGenStyles uses U+FDD0 and U+FDD1.
+static const ushort provisionalBegin = 0xFDD2;
+static const ushort provisionalEnd = 0xFDD3;
+
 GenValidationStyles::GenValidationStyles()
+    : m_target(0)
 {
 
 }
 
+GenValidationStyles::GenValidationStyles(GenValidationStyles *target)
+    : m_target(target)
+{
+}
+
 GenValidationStyles::~GenValidationStyles()
 {
 
@@ -42,17 +56,56 @@ GenValidationStyles::~GenValidationStyles()
 
 QString GenValidationStyles::insert(const GenValidationStyle& style)
 {
+    QMutexLocker locker(&m_mutex);
     StyleMap::iterator it = m_styles.find(style);
     if (it == m_styles.end()) {
 
         QString styleName("val");
-        styleName = makeUniqueName(styleName);
+        if (m_target) {
+            styleName = QChar(provisionalBegin) + QString::number(m_provisional.count()) + QChar(provisionalEnd);
+            m_provisional.append(style);
+        } else {
+            styleName = makeUniqueName(styleName);
+        }
         m_names.insert(styleName, true);
         it = m_styles.insert(style, styleName);
     }
     return it.value();
 }
 
+void GenValidationStyles::commit(QByteArray &xml)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT(m_target);
+    if (!m_target)
+        return;
+    QList<QByteArray> names;
+    foreach(const GenValidationStyle& style, m_provisional) {
+        names.append(m_target->insert(style).toUtf8());
+    }
+
+    const QByteArray begin = QString(QChar(provisionalBegin)).toUtf8();
+    const QByteArray end = QString(QChar(provisionalEnd)).toUtf8();
+    int from = xml.indexOf(begin);
+    if (from == -1)
+        return;
+    QByteArray result;
+    result.reserve(xml.size());
+    int pos = 0;
+    while (from != -1) {
+        const int to = xml.indexOf(end, from);
+        if (to == -1)
+            break;
+        const int index = xml.mid(from + begin.size(), to - from - begin.size()).toInt();
+        result.append(xml.constData() + pos, from - pos);
+        result.append(names.value(index));
+        pos = to + end.size();
+        from = xml.indexOf(begin, pos);
+    }
+    result.append(xml.constData() + pos, xml.size() - pos);
+    xml = result;
+}
+
 QString GenValidationStyles::makeUniqueName(const QString& base) const
 {
     int num = 1;
@@ -24,7 +24,9 @@
 
 #include "sheets_odf_export.h"
 
+#include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QString>
 
 class KoXmlWriter;
@@ -87,14 +89,28 @@ private:
 /**
  * \class GenValidationStyles
  * \ingroup OpenDocument
+ * Styles may be inserted from several threads at once. Sheets saved in
+ * parallel gather their styles in collections of their own, see commit().
  */
 class CALLIGRA_SHEETS_ODF_EXPORT GenValidationStyles
 {
 public:
     GenValidationStyles();
+    /**
+     * Creates a collection for a sheet, that is saved while other sheets are
+     * saved into \p target , too. The styles get provisional names.
+     */
+    explicit GenValidationStyles(GenValidationStyles *target);
     ~GenValidationStyles();
     QString insert(const GenValidationStyle& style);
 
+    /**
+     * Inserts the styles into the target, in the order they were inserted
+     * here, and replaces their provisional names in \p xml , the saved
+     * sheet, by the final ones.
+     */
+    void commit(QByteArray &xml);
+
     typedef QMap<GenValidationStyle, QString> StyleMap;
     void writeStyle(KoXmlWriter& writer) const;
 
@@ -106,7 +122,11 @@ private:
     /// name -> style   (used to check for name uniqueness)
     typedef QMap<QString, bool> NameMap;
     NameMap m_names;
-
+    QMutex m_mutex;
+    /// the collection receiving the styles in commit()
+    GenValidationStyles *m_target;
+    /// the styles with provisional names, in the order of insertion
+    QList<GenValidationStyle> m_provisional;
 };
 
 } // namespace Sheets
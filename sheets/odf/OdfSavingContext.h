@@ -47,7 +47,14 @@ class OdfSavingContext
 {
 public:
     explicit OdfSavingContext(KoShapeSavingContext &shapeContext)
-            : shapeContext(shapeContext) {}
+            : shapeContext(shapeContext), valStyle(m_valStyle) {}
+
+    /**
+     * Inserts the validation styles into \p valStyle instead of an own
+     * collection, e.g. to gather the ones of a sheet saved in parallel.
+     */
+    OdfSavingContext(KoShapeSavingContext &shapeContext, GenValidationStyles &valStyle)
+            : shapeContext(shapeContext), valStyle(valStyle) {}
 
     void insertCellAnchoredShape(const Sheet *sheet, int row, int column, KoShape* shape) {
         Q_ASSERT_X(1 <= column && column <= KS_colMax, __FUNCTION__, QString("%1 out of bounds").arg(column).toLocal8Bit());
@@ -99,11 +106,14 @@ public:
 
 public:
     KoShapeSavingContext& shapeContext;
-    GenValidationStyles valStyle;
+    GenValidationStyles &valStyle;
     QMap<int, Style> columnDefaultStyles;
     QMap<int, Style> rowDefaultStyles;
 
 private:
+    Q_DISABLE_COPY(OdfSavingContext)
+
+    GenValidationStyles m_valStyle;
     typedef QHash < int /*row*/, QMultiHash < int /*col*/, KoShape* > > AnchoredShape;
     typedef QHash < const Sheet*, AnchoredShape > AnchoredShapes;
     AnchoredShapes m_cellAnchoredShapes;
@@ -63,6 +63,13 @@ namespace Odf {
     struct ShapeLoadingData;
 
     CALLIGRA_SHEETS_ODF_EXPORT bool loadDocument(DocBase *doc, KoOdfReadStore &odfStore);
+    /**
+     * Loads the document without building a DOM tree of content.xml.
+     * The styles and settings of \p odfStore have to be loaded already, see
+     * KoOdfReadStore::loadAndParseStylesAndSettings(). The rows of the sheets
+     * are created while content.xml is read.
+     */
+    CALLIGRA_SHEETS_ODF_EXPORT bool loadDocumentStreaming(DocBase *doc, KoOdfReadStore &odfStore);
     CALLIGRA_SHEETS_ODF_EXPORT bool saveDocument(DocBase *doc, KoDocument::SavingContext &documentContext);
 
     CALLIGRA_SHEETS_ODF_EXPORT bool loadTableShape(Sheet *sheet, const KoXmlElement &element, KoShapeLoadingContext &context);
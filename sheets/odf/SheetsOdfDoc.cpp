@@ -51,11 +51,14 @@
 #include <KoUnit.h>
 #include <KoUpdater.h>
 #include <KoXmlReader.h>
+#include <KoXmlStreamReader.h>
 #include <KoXmlWriter.h>
 #include <KoXmlNS.h>
 
 #include <KCodecs>
 #include <QBuffer>
+#include <QScopedPointer>
+#include <QXmlStreamWriter>
 
 // This file contains functionality to load/save a DocBase
 
@@ -63,13 +66,191 @@ namespace Calligra {
 namespace Sheets {
 
 namespace Odf {
+    bool loadDocumentContent(DocBase *doc, KoOdfReadStore &odfStore, const KoXmlDocument &contentDoc, TableStream *tables);
+    bool loadContentSkeleton(QIODevice *device, QByteArray *skeleton, TableStream *tables, QString *errorMessage);
     void loadDocSettings(DocBase *doc, const KoXmlDocument &settingsDoc);
     void loadDocIgnoreList(DocBase *doc, const KoOasisSettings& settings);
     void saveSettings(DocBase *doc, KoXmlWriter &settingsWriter);
 };
 
+// Writes the start element at the current position of reader to writer.
+// The original prefixes and namespace declarations are kept.
+static void copyStartElement(KoXmlStreamReader &reader, QXmlStreamWriter &writer)
+{
+    writer.writeStartElement(reader.QXmlStreamReader::qualifiedName().toString());
+    const QXmlStreamNamespaceDeclarations namespaces = reader.namespaceDeclarations();
+    for (int i = 0; i < namespaces.count(); ++i) {
+        const QString prefix = namespaces[i].prefix().toString();
+        writer.writeAttribute(prefix.isEmpty() ? QString("xmlns") : "xmlns:" + prefix,
+                              namespaces[i].namespaceUri().toString());
+    }
+    const QXmlStreamAttributes attributes = reader.QXmlStreamReader::attributes();
+    for (int i = 0; i < attributes.count(); ++i)
+        writer.writeAttribute(attributes[i].qualifiedName().toString(), attributes[i].value().toString());
+}
+
+// Writes the text at the current position of reader to writer.
+static void copyCharacters(KoXmlStreamReader &reader, QXmlStreamWriter &writer)
+{
+    if (reader.isCDATA())
+        writer.writeCDATA(reader.text().toString());
+    else
+        writer.writeCharacters(reader.text().toString());
+}
+
+// Copies everything in front of the first table of the spreadsheet into
+// head. The stream is left at the start of the first table, or at the end of
+// the document, if there is none.
+static bool loadContentHead(Odf::TableStream *tables, QByteArray *head, QString *errorMessage)
+{
+    KoXmlStreamReader &reader = *tables->reader;
+    QXmlStreamWriter writer(head);
+    int depth = 0;
+    int spreadsheetDepth = -1;
+    while (!reader.atEnd()) {
+        switch (reader.readNext()) {
+        case QXmlStreamReader::StartDocument:
+            writer.writeStartDocument();
+            break;
+        case QXmlStreamReader::StartElement: {
+            const QStringRef name = reader.qualifiedName();
+            if (depth == spreadsheetDepth && name == QLatin1String("table:table")) {
+                // closes the open elements
+                writer.writeEndDocument();
+                return true;
+            }
+            copyStartElement(reader, writer);
+            ++depth;
+            if ((depth == 1 && name == QLatin1String("office:document-content")) ||
+                    (depth == 2 && name == QLatin1String("office:body")) ||
+                    (depth == 3 && name == QLatin1String("office:spreadsheet"))) {
+                // declared for the tables and the elements following them
+                tables->namespaces += reader.namespaceDeclarations();
+                if (depth == 3)
+                    spreadsheetDepth = depth;
+            }
+            break;
+        }
+        case QXmlStreamReader::EndElement:
+            writer.writeEndElement();
+            --depth;
+            break;
+        case QXmlStreamReader::Characters:
+            copyCharacters(reader, writer);
+            break;
+        default:
+            break;
+        }
+    }
+    if (reader.hasError()) {
+        *errorMessage = Odf::streamErrorMessage(tables);
+        return false;
+    }
+    writer.writeEndDocument();
+    return true;
+}
 
 bool Odf::loadDocument(DocBase *doc, KoOdfReadStore &odfStore)
+{
+    return loadDocumentContent(doc, odfStore, odfStore.contentDoc(), 0);
+}
+
+bool Odf::loadDocumentStreaming(DocBase *doc, KoOdfReadStore &odfStore)
+{
+    // content.xml is read once. The device is independent of the store,
+    // because shapes and images open other files of the store, while the
+    // sheets are loaded.
+    QScopedPointer<QIODevice> device(odfStore.store()->createReadDevice("content.xml"));
+    if (!device) {
+        doc->setErrorMessage(i18n("Could not find %1", QString("content.xml")));
+        return false;
+    }
+    KoXmlStreamReader reader(device.data());
+    prepareForOdf(reader);
+    TableStream tables;
+    tables.reader = &reader;
+    tables.size = device->size();
+
+    // The elements in front of the tables, e.g. the automatic styles and
+    // the validations, are needed by all tables. They are loaded at once.
+    QByteArray head;
+    QString errorMessage;
+    if (!loadContentHead(&tables, &head, &errorMessage)) {
+        doc->setErrorMessage(errorMessage);
+        return false;
+    }
+    KoXmlDocument contentDoc;
+    QBuffer headBuffer(&head);
+    if (!KoOdfReadStore::loadAndParse(&headBuffer, contentDoc, errorMessage, "content.xml")) {
+        doc->setErrorMessage(errorMessage);
+        return false;
+    }
+    head.clear();
+    // Also load styles from content.xml
+    odfStore.styles().createStyleMap(contentDoc, false);
+
+    return loadDocumentContent(doc, odfStore, contentDoc, &tables);
+}
+
+int Odf::streamProgress(const TableStream *tables)
+{
+    if (tables->size <= 0)
+        return -1;
+    return qMin<qint64>(100, 100 * tables->reader->device()->pos() / tables->size);
+}
+
+QString Odf::streamErrorMessage(const TableStream *tables)
+{
+    const KoXmlStreamReader &reader = *tables->reader;
+    errorSheetsODF << "Parsing error in content.xml! Aborting!" << endl
+    << " In line: " << reader.lineNumber() << ", column: " << reader.columnNumber() << endl
+    << " Error message: " << reader.errorString() << endl;
+    return i18n("Parsing error in the main document at line %1, column %2\nError message: %3",
+                reader.lineNumber(), reader.columnNumber(), reader.errorString());
+}
+
+KoXmlElement Odf::loadStreamEpilogue(TableStream *tables, KoXmlDocument *doc)
+{
+    KoXmlStreamReader &reader = *tables->reader;
+    QByteArray data;
+    QXmlStreamWriter writer(&data);
+    writer.writeStartDocument();
+    // declares the namespaces of the enclosing elements
+    writer.writeStartElement("epilogue");
+    for (int i = 0; i < tables->namespaces.count(); ++i) {
+        const QString prefix = tables->namespaces[i].prefix().toString();
+        writer.writeAttribute(prefix.isEmpty() ? QString("xmlns") : "xmlns:" + prefix,
+                              tables->namespaces[i].namespaceUri().toString());
+    }
+    // the current element and its siblings up to the end of the spreadsheet
+    int depth = 0;
+    for (; !reader.atEnd(); reader.readNext()) {
+        if (depth == 0 && reader.isEndElement())
+            break;
+        switch (reader.tokenType()) {
+        case QXmlStreamReader::StartElement:
+            copyStartElement(reader, writer);
+            ++depth;
+            break;
+        case QXmlStreamReader::EndElement:
+            writer.writeEndElement();
+            --depth;
+            break;
+        case QXmlStreamReader::Characters:
+            copyCharacters(reader, writer);
+            break;
+        default:
+            break;
+        }
+    }
+    writer.writeEndDocument();
+    if (reader.hasError())
+        return KoXmlElement();
+    doc->setContent(data, true);
+    return doc->documentElement();
+}
+
+bool Odf::loadDocumentContent(DocBase *doc, KoOdfReadStore &odfStore, const KoXmlDocument &contentDoc, TableStream *tables)
 {
     QPointer<KoUpdater> updater;
     if (doc->progressUpdater()) {
@@ -79,7 +260,7 @@ bool Odf::loadDocument(DocBase *doc, KoOdfReadStore &odfStore)
 
     doc->setSpellListIgnoreAll(QStringList());
 
-    KoXmlElement content = odfStore.contentDoc().documentElement();
+    KoXmlElement content = contentDoc.documentElement();
     KoXmlElement realBody(KoXml::namedItemNS(content, KoXmlNS::office, "body"));
     if (realBody.isNull()) {
         doc->setErrorMessage(i18n("Invalid OASIS OpenDocument file. No office:body tag found."));
@@ -111,7 +292,7 @@ bool Odf::loadDocument(DocBase *doc, KoOdfReadStore &odfStore)
     // TODO check versions and mimetypes etc.
 
     // all <sheet:sheet> goes to workbook
-    if (!loadMap(doc->map(), body, context)) {
+    if (!loadMap(doc->map(), body, context, tables)) {
         doc->map()->deleteLoadingInfo();
         return false;
     }
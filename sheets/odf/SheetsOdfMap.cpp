@@ -35,6 +35,7 @@
 #include "SheetsOdfPrivate.h"
 
 #include "CalculationSettings.h"
+#include "CellStorage.h"
 #include "DocBase.h"
 #include "LoadingInfo.h"
 #include "Map.h"
@@ -48,16 +49,29 @@
 #include <KoCharacterStyle.h>
 #include <KoDocumentResourceManager.h>
 #include <KoGenStyles.h>
+#include <KoOdfStylesReader.h>
+#include <KoProgressUpdater.h>
 #include <KoStyleManager.h>
 #include <KoStyleStack.h>
 #include <KoText.h>
 #include <KoTextSharedLoadingData.h>
 #include <KoUnit.h>
+#include <KoUpdater.h>
 #include <KoXmlNS.h>
+#include <KoXmlReader.h>
+#include <KoXmlStreamReader.h>
 #include <KoXmlWriter.h>
 
 #include <kcodecs.h>
 
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QPointer>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+
 // This file contains functionality to load/save a Map
 
 namespace Calligra {
@@ -94,7 +108,171 @@ void Odf::fixupStyle(KoCharacterStyle* style)
     style->copyProperties(format);
 }
 
-bool Odf::loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfContext)
+// The depth up to which the shared elements are loaded in advance.
+static const int g_preloadDepth = 16;
+
+// Returns false, if element contains shapes or text elements, that may lead
+// to rich text, see Odf::loadCellTextNodes().
+static bool isIndependentElement(const KoXmlElement &element, bool inParagraph)
+{
+    KoXmlElement child;
+    forEachElement(child, element) {
+        if (child.namespaceURI() == KoXmlNS::draw)
+            return false;
+        const bool text = child.namespaceURI() == KoXmlNS::text;
+        if (inParagraph && !(text && (child.localName() == "s" || child.localName() == "tab" ||
+                                      child.localName() == "line-break")))
+            return false;
+        if (!isIndependentElement(child, inParagraph || (text && child.localName() == "p")))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * \internal
+ * Loads the columns, rows and cells of a sheet from its table:table element,
+ * that was built from the table stream. The shared elements are only read,
+ * see preloadSharedElements().
+ * Tables with shapes or rich text need the shape loading context, that is
+ * not thread-safe. They are left to the main thread, see loadDependent().
+ */
+class SheetLoadingJob : public QRunnable
+{
+public:
+    SheetLoadingJob(Sheet *sheet, Odf::OdfLoadingContext *tableContext,
+                    const Styles *autoStyles, const QHash<QString, Conditions> *conditionalStyles,
+                    KoUpdater *updater, QSemaphore *tables)
+            : m_sheet(sheet), m_tableContext(tableContext)
+            , m_autoStyles(autoStyles), m_conditionalStyles(conditionalStyles), m_updater(updater)
+            , m_tables(tables), m_dependent(false) {}
+
+    virtual void run() {
+        KoXmlElement sheetElement = document.documentElement();
+        KoXmlElement child;
+        forEachElement(child, sheetElement) {
+            const bool independent = isIndependentElement(child, false);
+            // reduce memory usage
+            KoXml::unload(child);
+            if (!independent) {
+                m_dependent = true;
+                break;
+            }
+        }
+        if (!m_dependent) {
+            Odf::loadSheetContent(m_sheet, sheetElement, *m_tableContext, *m_autoStyles,
+                                  *m_conditionalStyles, 0, m_updater);
+            document = KoXmlDocument();
+            if (m_updater) m_updater->setProgress(100);
+        }
+        m_tables->release();
+    }
+
+    /// Loads the sheet in the calling thread, if the job left it.
+    void loadDependent() {
+        if (!m_dependent)
+            return;
+        Odf::loadSheetContent(m_sheet, document.documentElement(), *m_tableContext, *m_autoStyles,
+                              *m_conditionalStyles, 0, m_updater);
+        document = KoXmlDocument();
+        if (m_updater) m_updater->setProgress(100);
+    }
+
+    /// the table:table element with all its children
+    KoXmlDocument document;
+
+private:
+    Sheet* m_sheet;
+    Odf::OdfLoadingContext* m_tableContext;
+    const Styles* m_autoStyles;
+    const QHash<QString, Conditions>* m_conditionalStyles;
+    QPointer<KoUpdater> m_updater;
+    QSemaphore* m_tables;
+    bool m_dependent;
+};
+
+// Loads the elements read by several sheets at once in advance, i.e. the
+// column and row styles and the validations. On-demand loading of KoXml
+// elements is not thread-safe.
+static void preloadSharedElements(const KoOdfStylesReader &stylesReader, QHash<QString, KoXmlElement> &validities)
+{
+    const QStringList families = QStringList() << "table-column" << "table-row";
+    foreach (const QString &family, families) {
+        QList<KoXmlElement*> styles = stylesReader.customStyles(family).values();
+        styles += stylesReader.autoStyles(family, false).values();
+        styles += stylesReader.autoStyles(family, true).values();
+        foreach (KoXmlElement *style, styles)
+            KoXml::load(*style, g_preloadDepth);
+    }
+    for (QHash<QString, KoXmlElement>::Iterator it = validities.begin(); it != validities.end(); ++it)
+        KoXml::load(it.value(), g_preloadDepth);
+}
+
+// Creates and loads the sheets of the tables following each other in the
+// stream. The stream is left behind the last table.
+// With a single thread, the tables are loaded row by row while they are
+// read. Otherwise each table is built as a whole and loaded by a worker,
+// while the next table is read. The number of tables held by the workers is
+// limited by their number.
+static bool loadStreamSheets(Map *map, Odf::OdfLoadingContext &tableContext, const Styles &autoStyles,
+                             const QHash<QString, Conditions> &conditionalStyles, Odf::TableStream *tables)
+{
+    KoXmlStreamReader &reader = *tables->reader;
+    const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+    QSemaphore freeTables(threadCount);
+    QList<SheetLoadingJob*> jobs;
+    if (threadCount > 1)
+        preloadSharedElements(tableContext.odfContext.stylesReader(), tableContext.validities);
+
+    bool ok = true;
+    while (ok && reader.isStartElement() && reader.qualifiedName() == QLatin1String("table:table")) {
+        KoXmlDocument sheetDocument;
+        ok = KoXml::setElement(sheetDocument, &reader, false);
+        const KoXmlElement sheetElement = sheetDocument.documentElement();
+        const QString name = sheetElement.attributeNS(KoXmlNS::table, "name", QString());
+        if (!ok || name.isEmpty()) {
+            reader.skipCurrentElement();
+        } else {
+            Sheet* sheet = map->addNewSheet(name);
+            sheet->setSheetName(name, true);
+            if (threadCount > 1) {
+                QPointer<KoUpdater> updater;
+                if (map->doc() && map->doc()->progressUpdater()) {
+                    updater = map->doc()->progressUpdater()->startSubtask(1, "Calligra::Sheets::Odf::loadSheet");
+                    updater->setProgress(0);
+                }
+                Odf::loadSheetProperties(sheet, sheetElement, tableContext);
+                freeTables.acquire();
+                SheetLoadingJob *job = new SheetLoadingJob(sheet, &tableContext, &autoStyles, &conditionalStyles,
+                                                           updater, &freeTables);
+                job->setAutoDelete(false);
+                jobs.append(job);
+                ok = KoXml::setElement(job->document, &reader);
+                if (ok)
+                    threadPool.start(job);
+                else
+                    freeTables.release();
+            } else {
+                Odf::loadSheet(sheet, sheetElement, tableContext, autoStyles, conditionalStyles, tables);
+            }
+        }
+        if (ok)
+            reader.readNextStartElement();
+    }
+    threadPool.waitForDone();
+
+    // the tables with shapes or rich text, now that all sheets exist
+    foreach (SheetLoadingJob *job, jobs) {
+        if (ok)
+            job->loadDependent();
+        delete job;
+    }
+    return ok && !reader.hasError();
+}
+
+bool Odf::loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfContext, TableStream *tables)
 {
     map->setLoading(true);
     map->loadingInfo()->setFileFormat(LoadingInfo::OpenDocument);
@@ -162,9 +340,10 @@ bool Odf::loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfCo
         loadProtection(map, body);
     }
 
+    // The tables of a stream follow the body, the stream is at the first one.
     KoXmlNode sheetNode = KoXml::namedItemNS(body, KoXmlNS::table, "table");
 
-    if (sheetNode.isNull()) {
+    if (tables ? !tables->reader->isStartElement() : sheetNode.isNull()) {
         // We need at least one sheet !
         map->doc()->setErrorMessage(i18n("This document has no sheets (tables)."));
         map->setLoading(false);
@@ -203,6 +382,17 @@ bool Odf::loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfCo
                         conditionalStyles, map->parser());
 
     // load the sheet
+    KoXmlDocument epilogueDoc;
+    KoXmlElement epilogue;
+    if (tables) {
+        if (!loadStreamSheets(map, tableContext, autoStyles, conditionalStyles, tables)) {
+            map->doc()->setErrorMessage(streamErrorMessage(tables));
+            map->setLoading(false);
+            return false;
+        }
+        if (tables->reader->isStartElement())
+            epilogue = loadStreamEpilogue(tables, &epilogueDoc);
+    }
     sheetNode = body.firstChild();
     while (!sheetNode.isNull()) {
         KoXmlElement sheetElement = sheetNode.toElement();
@@ -238,6 +428,10 @@ bool Odf::loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfCo
 ///TODO new style odf
     map->databaseManager()->loadOdf(body); // table:database-ranges
     loadNamedAreas(map->namedAreaManager(), body); // table:named-expressions
+    if (!epilogue.isNull()) {
+        map->databaseManager()->loadOdf(epilogue);
+        loadNamedAreas(map->namedAreaManager(), epilogue);
+    }
 
     map->setLoading(false);
     return true;
@@ -266,6 +460,65 @@ void Odf::loadMapSettings(Map *map, const KoOasisSettings &settings)
     }
 }
 
+/**
+ * \internal
+ * A sheet written by a SheetSavingJob. Its styles and validations keep
+ * provisional names, until they are committed in the order of the sheets.
+ */
+struct SavedSheet
+{
+    SavedSheet() : styles(0), validations(0) {}
+    QByteArray xml;
+    KoGenStyles* styles;
+    GenValidationStyles* validations;
+};
+
+/**
+ * \internal
+ * Writes sheets into buffers of their own, one KoXmlWriter per sheet.
+ * The workers pick the sheets from a shared counter. The styles and the
+ * validations are gathered per sheet, so their final names do not depend on
+ * the order, in which the workers finish.
+ */
+class SheetSavingJob : public QRunnable
+{
+public:
+    SheetSavingJob(const QList<Sheet*>& sheets, SavedSheet* saved, int indentLevel,
+                   Odf::OdfSavingContext* tableContext, QAtomicInt* next)
+            : m_sheets(sheets), m_saved(saved), m_indentLevel(indentLevel)
+            , m_tableContext(tableContext), m_next(next) {}
+
+    virtual void run() {
+        KoShapeSavingContext& savingContext = m_tableContext->shapeContext;
+        int i;
+        while ((i = m_next->fetchAndAddOrdered(1)) < m_sheets.count()) {
+            SavedSheet& saved = m_saved[i];
+            saved.styles = new KoGenStyles(&savingContext.mainStyles());
+            saved.validations = new GenValidationStyles(&m_tableContext->valStyle);
+            QBuffer buffer(&saved.xml);
+            buffer.open(QIODevice::WriteOnly);
+            KoXmlWriter xmlWriter(&buffer, m_indentLevel);
+            KoShapeSavingContext shapeContext(xmlWriter, *saved.styles, savingContext.embeddedSaver());
+            Odf::OdfSavingContext tableContext(shapeContext, *saved.validations);
+            Odf::saveSheet(m_sheets[i], tableContext);
+        }
+    }
+
+private:
+    const QList<Sheet*> m_sheets;
+    SavedSheet* m_saved;
+    int m_indentLevel;
+    Odf::OdfSavingContext* m_tableContext;
+    QAtomicInt* m_next;
+};
+
+// Shapes and rich text are saved through the shared saving context,
+// which is not thread-safe.
+static bool canSaveInParallel(Sheet *sheet)
+{
+    return sheet->shapes().isEmpty() && sheet->cellStorage()->richTextStorage()->count() == 0;
+}
+
 bool Odf::saveMap(Map *map, KoXmlWriter & xmlWriter, KoShapeSavingContext & savingContext)
 {
     // Saving the custom cell styles including the default cell style.
@@ -296,8 +549,44 @@ bool Odf::saveMap(Map *map, KoXmlWriter & xmlWriter, KoShapeSavingContext & savi
 
     OdfSavingContext tableContext(savingContext);
 
-    foreach(Sheet* sheet, map->sheetList()) {
-        saveSheet(sheet, tableContext);
+    // Write the sheets without shapes and rich text in parallel first.
+    const QList<Sheet*> sheets = map->sheetList();
+    QList<Sheet*> parallelSheets;
+    foreach(Sheet* sheet, sheets) {
+        if (canSaveInParallel(sheet))
+            parallelSheets.append(sheet);
+    }
+    QVector<SavedSheet> savedSheets;
+    const int threadCount = qMin(QThreadPool::globalInstance()->maxThreadCount(), parallelSheets.count());
+    if (threadCount > 1) {
+        savedSheets.resize(parallelSheets.count());
+        QAtomicInt next(0);
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(threadCount - 1);
+        for (int i = 0; i < threadCount - 1; ++i)
+            threadPool.start(new SheetSavingJob(parallelSheets, savedSheets.data(), xmlWriter.indentLevel(), &tableContext, &next));
+        SheetSavingJob(parallelSheets, savedSheets.data(), xmlWriter.indentLevel(), &tableContext, &next).run();
+        threadPool.waitForDone();
+    } else {
+        parallelSheets.clear();
+    }
+
+    // Keep the order of the sheets. The styles of the sheets written in
+    // parallel get their names now, as if all sheets were written here.
+    foreach(Sheet* sheet, sheets) {
+        const int index = parallelSheets.indexOf(sheet);
+        if (index == -1) {
+            saveSheet(sheet, tableContext);
+        } else {
+            SavedSheet& saved = savedSheets[index];
+            saved.styles->commit(saved.xml);
+            saved.validations->commit(saved.xml);
+            delete saved.styles;
+            delete saved.validations;
+            QBuffer buffer(&saved.xml);
+            xmlWriter.addCompleteElement(&buffer);
+            saved.xml.clear();
+        }
     }
 
     tableContext.valStyle.writeStyle(xmlWriter);
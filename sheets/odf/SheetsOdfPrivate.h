@@ -41,9 +41,15 @@
 #include <KoShapeLoadingContext.h>
 #include <KoShapeSavingContext.h>
 
+#include <QVector>
+#include <QXmlStreamNamespaceDeclarations>
+
 #include "OdfLoadingContext.h"
 #include "OdfSavingContext.h"
 
+class KoUpdater;
+class KoXmlStreamReader;
+
 namespace Calligra {
 namespace Sheets {
 
@@ -54,19 +60,58 @@ class Conditional;
 
 namespace Odf {
 
+    /**
+     * The tables of content.xml, read while the sheets are loaded. The body
+     * of the content document holds the elements in front of the tables only
+     * then.
+     */
+    struct TableStream {
+        KoXmlStreamReader *reader;
+        qint64 size;                                ///< of content.xml, for the progress
+        QXmlStreamNamespaceDeclarations namespaces; ///< declared in the elements enclosing the tables
+    };
+
     // SheetsOdfDoc
     void loadCalculationSettings(CalculationSettings *settings, const KoXmlElement& body);
     bool saveCalculationSettings(const CalculationSettings *settings, KoXmlWriter &settingsWriter);
 
+    /**
+     * @return the part of content.xml read so far in percent, or -1
+     */
+    int streamProgress(const TableStream *tables);
+    /**
+     * @return the message for the parsing error of the table stream
+     */
+    QString streamErrorMessage(const TableStream *tables);
+    /**
+     * Loads the elements following the tables, e.g. the named expressions and
+     * the database ranges, from the current position of the table stream up
+     * to the end of the office:spreadsheet element into \p doc .
+     * @return the element holding them like office:spreadsheet, or a null
+     *         element on parsing errors
+     */
+    KoXmlElement loadStreamEpilogue(TableStream *tables, KoXmlDocument *doc);
+
     // SheetsOdfMap
-    bool loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfContext);
+    bool loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfContext, TableStream *tables = 0);
     void loadMapSettings(Map *map, const KoOasisSettings &settingsDoc);
     bool saveMap(Map *map, KoXmlWriter & xmlWriter, KoShapeSavingContext & savingContext);
     void loadNamedAreas(NamedAreaManager *manager, const KoXmlElement& body);
     void saveNamedAreas(const NamedAreaManager *manager, KoXmlWriter& xmlWriter);
 
     // SheetsOdfSheet
-    bool loadSheet(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext, const Styles& autoStyles, const QHash<QString, Conditions>& conditionalStyles);
+    bool loadSheet(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext, const Styles& autoStyles, const QHash<QString, Conditions>& conditionalStyles, TableStream *tables = 0);
+    /**
+     * Loads the attributes of the table:table element, i.e. the table style,
+     * the print ranges and the protection. Part of loadSheet().
+     */
+    void loadSheetProperties(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext);
+    /**
+     * Loads the columns, rows and cells of the table:table element. Part of
+     * loadSheet(). Does not touch the shape loading context, if the table has
+     * neither shapes nor rich text.
+     */
+    void loadSheetContent(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext, const Styles& autoStyles, const QHash<QString, Conditions>& conditionalStyles, TableStream *tables, KoUpdater *updater);
     void loadSheetSettings(Sheet *sheet, const KoOasisSettings::NamedMap &settings);
     bool saveSheet(Sheet *sheet, OdfSavingContext& tableContext);
     void saveSheetSettings(Sheet *sheet, KoXmlWriter &settingsWriter);
@@ -46,6 +46,7 @@
 #include "KoUnit.h"
 #include <KoUpdater.h>
 #include <KoXmlNS.h>
+#include <KoXmlStreamReader.h>
 #include <KoXmlWriter.h>
 
 #include "CellStorage.h"
@@ -94,7 +95,33 @@ private:
 
 
 namespace Odf {
+    // The state of a sheet while its columns and rows are loaded.
+    struct SheetLoadingState {
+        // Cell style regions
+        QHash<QString, QRegion> cellStyleRegions;
+        // Cell style regions (row defaults)
+        QHash<QString, QRegion> rowStyleRegions;
+        // Cell style regions (column defaults)
+        QHash<QString, QRegion> columnStyleRegions;
+        IntervalMap<QString> columnStyles;
+
+        // List of shapes that need to have their size recalculated after loading is complete
+        QList<ShapeLoadingData> shapeData;
+
+        int rowIndex;
+        int indexCol;
+        int maxColumn;
+    };
+
     // Sheet loading - helper functions
+    /**
+     * Loads a child element of the table:table element, i.e. columns, rows
+     * and shapes.
+     */
+    void loadSheetChild(Sheet *sheet, const KoXmlElement& rowElement,
+                            OdfLoadingContext& tableContext,
+                            const Styles& autoStyles,
+                            SheetLoadingState& state);
     /**
      * Inserts the styles contained in \p styleRegions into the style storage.
      * Looks automatic styles up in the map of preloaded automatic styles,
@@ -152,7 +179,7 @@ namespace Odf {
 
 // *************** Loading *****************
 
-bool Odf::loadSheet(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext, const Styles& autoStyles, const QHash<QString, Conditions>& conditionalStyles)
+bool Odf::loadSheet(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext, const Styles& autoStyles, const QHash<QString, Conditions>& conditionalStyles, TableStream *tables)
 {
     QPointer<KoUpdater> updater;
     if (sheet->doc() && sheet->doc()->progressUpdater()) {
@@ -161,6 +188,13 @@ bool Odf::loadSheet(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingCo
         updater->setProgress(0);
     }
 
+    loadSheetProperties(sheet, sheetElement, tableContext);
+    loadSheetContent(sheet, sheetElement, tableContext, autoStyles, conditionalStyles, tables, updater);
+    return true;
+}
+
+void Odf::loadSheetProperties(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext)
+{
     KoOdfLoadingContext& odfContext = tableContext.odfContext;
     if (sheetElement.hasAttributeNS(KoXmlNS::table, "style-name")) {
         QString stylename = sheetElement.attributeNS(KoXmlNS::table, "style-name", QString());
@@ -297,85 +331,97 @@ bool Odf::loadSheet(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingCo
         }
     }
 
-    // Cell style regions
-    QHash<QString, QRegion> cellStyleRegions;
-    // Cell style regions (row defaults)
-    QHash<QString, QRegion> rowStyleRegions;
-    // Cell style regions (column defaults)
-    QHash<QString, QRegion> columnStyleRegions;
-    IntervalMap<QString> columnStyles;
+    if (sheetElement.hasAttributeNS(KoXmlNS::table, "print-ranges")) {
+        // e.g.: Sheet4.A1:Sheet4.E28
+        QString range = sheetElement.attributeNS(KoXmlNS::table, "print-ranges", QString());
+        Region region(loadRegion(range));
+        if (!region.firstSheet() || sheet->sheetName() == region.firstSheet()->sheetName())
+            sheet->printSettings()->setPrintRegion(region);
+    }
+
+    if (sheetElement.attributeNS(KoXmlNS::table, "protected", QString()) == "true") {
+        loadProtection(sheet, sheetElement);
+    }
+}
 
-    // List of shapes that need to have their size recalculated after loading is complete
-    QList<ShapeLoadingData> shapeData;
+void Odf::loadSheetContent(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingContext& tableContext, const Styles& autoStyles, const QHash<QString, Conditions>& conditionalStyles, TableStream *tables, KoUpdater *updater)
+{
+    SheetLoadingState state;
+    state.rowIndex = 1;
+    state.indexCol = 1;
+    state.maxColumn = 1;
 
-    int rowIndex = 1;
-    int indexCol = 1;
-    int maxColumn = 1;
-    KoXmlNode rowNode = sheetElement.firstChild();
     // Some spreadsheet programs may support more rows than
     // Calligra Sheets so limit the number of repeated rows.
     // FIXME POSSIBLE DATA LOSS!
 
     // First load all style information for rows, columns and cells
-    while (!rowNode.isNull() && rowIndex <= KS_rowMax) {
-        //debugSheetsODF << " rowIndex :" << rowIndex << " indexCol :" << indexCol;
-        KoXmlElement rowElement = rowNode.toElement();
-        if (!rowElement.isNull()) {
-            // slightly faster
-            KoXml::load(rowElement);
-
-            //debugSheetsODF << " Odf::loadSheet rowElement.tagName() :" << rowElement.localName();
-            if (rowElement.namespaceURI() == KoXmlNS::table) {
-                if (rowElement.localName() == "table-header-columns") {
-                    // NOTE Handle header cols as ordinary ones
-                    //      as long as they're not supported.
-                    loadColumnNodes(sheet, rowElement, indexCol, maxColumn, odfContext, columnStyleRegions, columnStyles);
-                } else if (rowElement.localName() == "table-column-group") {
-                    loadColumnNodes(sheet, rowElement, indexCol, maxColumn, odfContext, columnStyleRegions, columnStyles);
-                } else if (rowElement.localName() == "table-column" && indexCol <= KS_colMax) {
-                    //debugSheetsODF << " table-column found : index column before" << indexCol;
-                    loadColumnFormat(sheet, rowElement, odfContext.stylesReader(), indexCol, columnStyleRegions, columnStyles);
-                    //debugSheetsODF << " table-column found : index column after" << indexCol;
-                    maxColumn = qMax(maxColumn, indexCol - 1);
-                } else if (rowElement.localName() == "table-header-rows") {
-                    // NOTE Handle header rows as ordinary ones
-                    //      as long as they're not supported.
-                    loadRowNodes(sheet, rowElement, rowIndex, maxColumn, tableContext, rowStyleRegions, cellStyleRegions, columnStyles, autoStyles, shapeData);
-                } else if (rowElement.localName() == "table-row-group") {
-                    loadRowNodes(sheet, rowElement, rowIndex, maxColumn, tableContext, rowStyleRegions, cellStyleRegions, columnStyles, autoStyles, shapeData);
-                } else if (rowElement.localName() == "table-row") {
-                    //debugSheetsODF << " table-row found :index row before" << rowIndex;
-                    int columnMaximal = loadRowFormat(sheet, rowElement, rowIndex, tableContext,
-                                  rowStyleRegions, cellStyleRegions, columnStyles, autoStyles, shapeData);
-                    // allow the row to define more columns then defined via table-column
-                    maxColumn = qMax(maxColumn, columnMaximal);
-                    //debugSheetsODF << " table-row found :index row after" << rowIndex;
-                } else if (rowElement.localName() == "shapes") {
-                    // OpenDocument v1.1, 8.3.4 Shapes:
-                    // The <table:shapes> element contains all graphic shapes
-                    // with an anchor on the table this element is a child of.
-                    KoShapeLoadingContext* shapeLoadingContext = tableContext.shapeContext;
-                    KoXmlElement element;
-                    forEachElement(element, rowElement) {
-                        if (element.namespaceURI() != KoXmlNS::draw)
-                            continue;
-                        loadSheetObject(sheet, element, *shapeLoadingContext);
-                    }
+    if (tables) {
+        // The sheet element is empty. Build the children one by one from the
+        // stream instead of keeping all of them. Row groups are entered, so
+        // that their rows are built one by one, too.
+        KoXmlStreamReader &reader = *tables->reader;
+        int groupDepth = 0;
+        forever {
+            if (!reader.readNextStartElement()) {
+                // the end of a group or of the table
+                if (groupDepth == 0)
+                    break;
+                if (--groupDepth > 0)
+                    continue;
+            } else if (state.rowIndex > KS_rowMax) {
+                reader.skipCurrentElement();
+                continue;
+            } else if (reader.qualifiedName() == QLatin1String("table:table-row-group") ||
+                       (groupDepth == 0 && reader.qualifiedName() == QLatin1String("table:table-header-rows"))) {
+                ++groupDepth;
+                continue;
+            } else if (groupDepth > 0 && reader.qualifiedName() != QLatin1String("table:table-row")) {
+                // like loadRowNodes()
+                reader.skipCurrentElement();
+                continue;
+            } else {
+                KoXmlDocument rowDocument;
+                if (!KoXml::setElement(rowDocument, &reader))
+                    break; // the parsing error is reported by the caller
+                const KoXmlElement rowElement = rowDocument.documentElement();
+                if (groupDepth > 0) {
+                    const int columnMaximal = loadRowFormat(sheet, rowElement, state.rowIndex, tableContext,
+                                                            state.rowStyleRegions, state.cellStyleRegions,
+                                                            state.columnStyles, autoStyles, state.shapeData);
+                    state.maxColumn = qMax(state.maxColumn, columnMaximal);
+                } else {
+                    loadSheetChild(sheet, rowElement, tableContext, autoStyles, state);
                 }
             }
 
-            // don't need it anymore
-            KoXml::unload(rowElement);
+            int count = streamProgress(tables);
+            if (updater && count >= 0) updater->setProgress(count);
         }
+    } else {
+        KoXmlNode rowNode = sheetElement.firstChild();
+        while (!rowNode.isNull() && state.rowIndex <= KS_rowMax) {
+            //debugSheetsODF << " rowIndex :" << state.rowIndex << " indexCol :" << state.indexCol;
+            KoXmlElement rowElement = rowNode.toElement();
+            if (!rowElement.isNull()) {
+                // slightly faster
+                KoXml::load(rowElement);
+
+                loadSheetChild(sheet, rowElement, tableContext, autoStyles, state);
+
+                // don't need it anymore
+                KoXml::unload(rowElement);
+            }
 
-        rowNode = rowNode.nextSibling();
+            rowNode = rowNode.nextSibling();
 
-        int count = sheet->map()->increaseLoadedRowsCounter();
-        if (updater && count >= 0) updater->setProgress(count);
+            int count = sheet->map()->increaseLoadedRowsCounter();
+            if (updater && count >= 0) updater->setProgress(count);
+        }
     }
 
     // now recalculate the size for embedded shapes that had sizes specified relative to a bottom-right corner cell
-    foreach (const ShapeLoadingData& sd, shapeData) {
+    foreach (const ShapeLoadingData& sd, state.shapeData) {
         // subtract offset because the accumulated width and height we calculate below starts
         // at the top-left corner of this cell, but the shape can have an offset to that corner
         QSizeF size = QSizeF( sd.endPoint.x() - sd.offset.x(), sd.endPoint.y() - sd.offset.y());
@@ -390,32 +436,66 @@ bool Odf::loadSheet(Sheet *sheet, const KoXmlElement& sheetElement, OdfLoadingCo
     QList<QPair<QRegion, Conditions> > conditionRegions;
     // insert the styles into the storage (column defaults)
     debugSheetsODF << "Inserting column default cell styles ...";
-    loadSheetInsertStyles(sheet, autoStyles, columnStyleRegions, conditionalStyles,
-                        QRect(1, 1, maxColumn, rowIndex - 1), styleRegions, conditionRegions);
+    loadSheetInsertStyles(sheet, autoStyles, state.columnStyleRegions, conditionalStyles,
+                        QRect(1, 1, state.maxColumn, state.rowIndex - 1), styleRegions, conditionRegions);
     // insert the styles into the storage (row defaults)
     debugSheetsODF << "Inserting row default cell styles ...";
-    loadSheetInsertStyles(sheet, autoStyles, rowStyleRegions, conditionalStyles,
-                        QRect(1, 1, maxColumn, rowIndex - 1), styleRegions, conditionRegions);
+    loadSheetInsertStyles(sheet, autoStyles, state.rowStyleRegions, conditionalStyles,
+                        QRect(1, 1, state.maxColumn, state.rowIndex - 1), styleRegions, conditionRegions);
     // insert the styles into the storage
     debugSheetsODF << "Inserting cell styles ...";
-    loadSheetInsertStyles(sheet, autoStyles, cellStyleRegions, conditionalStyles,
-                        QRect(1, 1, maxColumn, rowIndex - 1), styleRegions, conditionRegions);
+    loadSheetInsertStyles(sheet, autoStyles, state.cellStyleRegions, conditionalStyles,
+                        QRect(1, 1, state.maxColumn, state.rowIndex - 1), styleRegions, conditionRegions);
 
     sheet->cellStorage()->loadStyles(styleRegions);
     sheet->cellStorage()->loadConditions(conditionRegions);
+}
 
-    if (sheetElement.hasAttributeNS(KoXmlNS::table, "print-ranges")) {
-        // e.g.: Sheet4.A1:Sheet4.E28
-        QString range = sheetElement.attributeNS(KoXmlNS::table, "print-ranges", QString());
-        Region region(loadRegion(range));
-        if (!region.firstSheet() || sheet->sheetName() == region.firstSheet()->sheetName())
-            sheet->printSettings()->setPrintRegion(region);
-    }
-
-    if (sheetElement.attributeNS(KoXmlNS::table, "protected", QString()) == "true") {
-        loadProtection(sheet, sheetElement);
+void Odf::loadSheetChild(Sheet *sheet, const KoXmlElement& rowElement,
+                            OdfLoadingContext& tableContext,
+                            const Styles& autoStyles,
+                            SheetLoadingState& state)
+{
+    KoOdfLoadingContext& odfContext = tableContext.odfContext;
+    //debugSheetsODF << " Odf::loadSheet rowElement.tagName() :" << rowElement.localName();
+    if (rowElement.namespaceURI() != KoXmlNS::table)
+        return;
+    if (rowElement.localName() == "table-header-columns") {
+        // NOTE Handle header cols as ordinary ones
+        //      as long as they're not supported.
+        loadColumnNodes(sheet, rowElement, state.indexCol, state.maxColumn, odfContext, state.columnStyleRegions, state.columnStyles);
+    } else if (rowElement.localName() == "table-column-group") {
+        loadColumnNodes(sheet, rowElement, state.indexCol, state.maxColumn, odfContext, state.columnStyleRegions, state.columnStyles);
+    } else if (rowElement.localName() == "table-column" && state.indexCol <= KS_colMax) {
+        //debugSheetsODF << " table-column found : index column before" << state.indexCol;
+        loadColumnFormat(sheet, rowElement, odfContext.stylesReader(), state.indexCol, state.columnStyleRegions, state.columnStyles);
+        //debugSheetsODF << " table-column found : index column after" << state.indexCol;
+        state.maxColumn = qMax(state.maxColumn, state.indexCol - 1);
+    } else if (rowElement.localName() == "table-header-rows") {
+        // NOTE Handle header rows as ordinary ones
+        //      as long as they're not supported.
+        loadRowNodes(sheet, rowElement, state.rowIndex, state.maxColumn, tableContext, state.rowStyleRegions, state.cellStyleRegions, state.columnStyles, autoStyles, state.shapeData);
+    } else if (rowElement.localName() == "table-row-group") {
+        loadRowNodes(sheet, rowElement, state.rowIndex, state.maxColumn, tableContext, state.rowStyleRegions, state.cellStyleRegions, state.columnStyles, autoStyles, state.shapeData);
+    } else if (rowElement.localName() == "table-row") {
+        //debugSheetsODF << " table-row found :index row before" << state.rowIndex;
+        int columnMaximal = loadRowFormat(sheet, rowElement, state.rowIndex, tableContext,
+                      state.rowStyleRegions, state.cellStyleRegions, state.columnStyles, autoStyles, state.shapeData);
+        // allow the row to define more columns then defined via table-column
+        state.maxColumn = qMax(state.maxColumn, columnMaximal);
+        //debugSheetsODF << " table-row found :index row after" << state.rowIndex;
+    } else if (rowElement.localName() == "shapes") {
+        // OpenDocument v1.1, 8.3.4 Shapes:
+        // The <table:shapes> element contains all graphic shapes
+        // with an anchor on the table this element is a child of.
+        KoShapeLoadingContext* shapeLoadingContext = tableContext.shapeContext;
+        KoXmlElement element;
+        forEachElement(element, rowElement) {
+            if (element.namespaceURI() != KoXmlNS::draw)
+                continue;
+            loadSheetObject(sheet, element, *shapeLoadingContext);
+        }
     }
-    return true;
 }
 
 void Odf::loadSheetObject(Sheet *sheet, const KoXmlElement& element, KoShapeLoadingContext& shapeContext)
@@ -1111,6 +1191,9 @@ void Odf::saveColRowCell(Sheet *sheet, int maxCols, int maxRows, OdfSavingContex
     KoGenStyles & mainStyles = tableContext.shapeContext.mainStyles();
 
     // calculate the column/row default cell styles
+    // The default styles of a previously saved sheet must not leak into this one.
+    tableContext.columnDefaultStyles.clear();
+    tableContext.rowDefaultStyles.clear();
     int maxMaxRows = maxRows; // includes the max row a column default style occupies
     // also extends the maximum column/row to include column/row styles
     sheet->styleStorage()->saveCreateDefaultStyles(maxCols, maxMaxRows, tableContext.columnDefaultStyles, tableContext.rowDefaultStyles);
@@ -21,6 +21,7 @@
 
 #include "calligra_sheets_limits.h"
 
+#include "ChunkedPointStorage.h"
 #include "PointStorage.h"
 
 #include <QTest>
@@ -61,6 +62,26 @@ void PointStorageBenchmark::testInsertionPerformance_singular()
     }
 }
 
+void PointStorageBenchmark::testInsertionPerformance_random()
+{
+    QBENCHMARK {
+        PointStorage<int> storage;
+        qsrand(1);
+        for (int i = 0; i < 100000; ++i)
+            storage.insert(1 + qrand() % 100, 1 + qrand() % 10000, i);
+    }
+}
+
+void PointStorageBenchmark::testInsertionPerformance_randomChunked()
+{
+    QBENCHMARK {
+        ChunkedPointStorage<int> storage;
+        qsrand(1);
+        for (int i = 0; i < 100000; ++i)
+            storage.insert(1 + qrand() % 100, 1 + qrand() % 10000, i);
+    }
+}
+
 void PointStorageBenchmark::testLookupPerformance_data()
 {
     QTest::addColumn<int>("maxrow");
@@ -33,6 +33,8 @@ class PointStorageBenchmark : public QObject
 private Q_SLOTS:
     void testInsertionPerformance_loadingLike();
     void testInsertionPerformance_singular();
+    void testInsertionPerformance_random();
+    void testInsertionPerformance_randomChunked();
     void testLookupPerformance_data();
     void testLookupPerformance();
     void testInsertColumnsPerformance();
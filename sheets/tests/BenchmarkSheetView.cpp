@@ -0,0 +1,100 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkSheetView.h"
+
+#include "CellStorage.h"
+#include "Map.h"
+#include "Region.h"
+#include "Sheet.h"
+#include "Style.h"
+#include "Value.h"
+#include "ui/SheetView.h"
+
+#include <KoViewConverter.h>
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QTest>
+
+using namespace Calligra::Sheets;
+
+static const int g_rows = 100000;
+static const int g_columns = 10;
+// the visible cells of a frame
+static const int g_visibleRows = 40;
+
+void SheetViewBenchmark::testScrollingPerformance_data()
+{
+    QTest::addColumn<int>("step");
+    QTest::addColumn<int>("range");
+
+    QTest::newRow("page-wise") << g_visibleRows << g_rows;
+    QTest::newRow("line-wise") << 1 << 5000;
+}
+
+void SheetViewBenchmark::testScrollingPerformance()
+{
+    QFETCH(int, step);
+    QFETCH(int, range);
+
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+
+    // uniformly formatted numbers
+    map.setLoading(true);
+    for (int row = 1; row <= g_rows; ++row) {
+        for (int col = 1; col <= g_columns; ++col)
+            storage->setValue(col, row, Value((row % 1000) * 0.25 + col));
+    }
+    Style style;
+    style.setFormatType(Format::Number);
+    style.setPrecision(2);
+    storage->setStyle(Region(QRect(1, 1, g_columns, g_rows)), style);
+    map.setLoading(false);
+
+    KoViewConverter viewConverter;
+    SheetView sheetView(sheet);
+    sheetView.setViewConverter(&viewConverter);
+
+    QImage image(1000, 800, QImage::Format_ARGB32_Premultiplied);
+    int frames = 0;
+    QElapsedTimer timer;
+    timer.start();
+    // scroll down and up again
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i + g_visibleRows <= range; i += step) {
+            const int top = pass == 0 ? 1 + i : range - g_visibleRows + 1 - i;
+            const QRect visibleRect(1, top, g_columns, g_visibleRows);
+            const QRectF paintRect = sheet->cellCoordinatesToDocument(visibleRect);
+            sheetView.setPaintCellRange(visibleRect);
+
+            image.fill(Qt::white);
+            QPainter painter(&image);
+            painter.translate(-paintRect.topLeft());
+            sheetView.paintCells(painter, paintRect, paintRect.topLeft(), 0, visibleRect);
+            ++frames;
+        }
+    }
+    QTest::setBenchmarkResult(frames * 1000.0 / qMax(qint64(1), timer.elapsed()), QTest::FramesPerSecond);
+}
+
+QTEST_MAIN(SheetViewBenchmark)
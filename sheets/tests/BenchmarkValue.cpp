@@ -0,0 +1,171 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkValue.h"
+
+#include "Value.h"
+#include "ValueStorage.h"
+
+#include <QTest>
+#include <QVector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace Calligra::Sheets;
+
+// Run the benchmarks of two builds to compare the Value implementations.
+static const int g_count = 1000000;
+
+static Value createValue(int kind, int i)
+{
+    switch (kind) {
+    case 0:
+        return Value(i % 2 == 0);
+    case 1:
+        return Value(i);
+    case 2:
+        // representable as double, stored inline
+        return Value(i + 0.25);
+    case 3:
+        // a typical formula result, which needs the long double precision
+        // and is allocated
+        return Value(1.0l / (i + 3));
+    default:
+        return Value(QString::number(i % 100));
+    }
+}
+
+static void addKinds()
+{
+    QTest::addColumn<int>("kind");
+
+    QTest::newRow("boolean") << 0;
+    QTest::newRow("integer") << 1;
+    QTest::newRow("float (inline)") << 2;
+    QTest::newRow("float (computed)") << 3;
+    QTest::newRow("string") << 4;
+}
+
+void ValueBenchmark::testMemoryUsage_data()
+{
+    addKinds();
+}
+
+void ValueBenchmark::testMemoryUsage()
+{
+#ifdef __GLIBC__
+    QFETCH(int, kind);
+
+    QVector<Value> values;
+    const int before = mallinfo().uordblks;
+    values.reserve(g_count);
+    for (int i = 0; i < g_count; ++i)
+        values.append(createValue(kind, i));
+    const int after = mallinfo().uordblks;
+
+    // the heap bytes per value, including the vector
+    QTest::setBenchmarkResult(qreal(after - before) / g_count, QTest::BytesAllocated);
+#else
+    QSKIP("The heap usage is measured using glibc's mallinfo().");
+#endif
+}
+
+void ValueBenchmark::testConstructionPerformance_data()
+{
+    addKinds();
+}
+
+void ValueBenchmark::testConstructionPerformance()
+{
+    QFETCH(int, kind);
+
+    QBENCHMARK {
+        QVector<Value> values;
+        values.reserve(g_count);
+        for (int i = 0; i < g_count; ++i)
+            values.append(createValue(kind, i));
+    }
+}
+
+void ValueBenchmark::testCopyPerformance_data()
+{
+    addKinds();
+}
+
+void ValueBenchmark::testCopyPerformance()
+{
+    QFETCH(int, kind);
+
+    QVector<Value> values;
+    values.reserve(g_count);
+    for (int i = 0; i < g_count; ++i)
+        values.append(createValue(kind, i));
+
+    QBENCHMARK {
+        QVector<Value> copies(g_count);
+        for (int i = 0; i < g_count; ++i)
+            copies[i] = values[i];
+    }
+}
+
+void ValueBenchmark::testInsertionPerformance_loadingLike()
+{
+    QBENCHMARK {
+        ValueStorage storage;
+        for (int r = 1; r <= 10000; ++r) {
+            for (int c = 1; c <= 100; ++c) {
+                storage.insert(c, r, Value(r * 0.5 + c));
+            }
+        }
+    }
+}
+
+void ValueBenchmark::testInsertionPerformance_computed()
+{
+    QBENCHMARK {
+        ValueStorage storage;
+        for (int r = 1; r <= 10000; ++r) {
+            for (int c = 1; c <= 100; ++c) {
+                storage.insert(c, r, Value(Number(r) / (c + 2)));
+            }
+        }
+    }
+}
+
+void ValueBenchmark::testIterationPerformance()
+{
+    ValueStorage storage;
+    for (int r = 1; r <= 10000; ++r) {
+        for (int c = 1; c <= 100; ++c) {
+            storage.insert(c, r, Value(r * 0.5 + c));
+        }
+    }
+
+    Number sum = 0.0;
+    QBENCHMARK {
+        for (int i = 0; i < storage.count(); ++i) {
+            sum += storage.data(i).asFloat();
+        }
+    }
+    Q_UNUSED(sum);
+}
+
+QTEST_MAIN(ValueBenchmark)
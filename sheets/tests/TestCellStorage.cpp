@@ -19,12 +19,21 @@
 
 #include "TestCellStorage.h"
 
+#include <sheets/Cell.h>
 #include <sheets/CellStorage.h>
+#include <sheets/Formula.h>
 #include <sheets/Map.h>
+#include <sheets/Region.h>
 #include <sheets/Sheet.h>
+#include <sheets/StringPool.h>
+#include <sheets/Style.h>
 #include <sheets/Value.h>
 
+#include <QAtomicInt>
+#include <QMap>
+#include <QRunnable>
 #include <QTest>
+#include <QThreadPool>
 
 using namespace Calligra::Sheets;
 
@@ -72,4 +81,220 @@ void CellStorageTest::testMergedCellsInsertRowBug()
     QCOMPARE(storage->mergedYCells(1, 3), 2);
 }
 
+void CellStorageTest::testStringPool()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+    StringPool* pool = map.stringPool();
+    QVERIFY(!pool->isEnabled());
+
+    // the strings are interned while loading only
+    map.setLoading(true);
+    QVERIFY(pool->isEnabled());
+    for (int row = 1; row <= 100; ++row) {
+        storage->setValue(1, row, Value(QString(row % 2 ? "yes" : "no")));
+        storage->setUserInput(1, row, QString(row % 2 ? "yes" : "no"));
+        storage->setValue(2, row, Value(row));
+    }
+
+    // only the strings are interned
+    QCOMPARE(pool->count(), 2);
+    QCOMPARE(pool->bytes(), qint64(5 * sizeof(QChar)));
+    const StringPool::Statistics statistics = pool->statistics(sheet);
+    QCOMPARE(statistics.strings, 200);
+    QCOMPARE(statistics.reused, 198);
+    QCOMPARE(statistics.bytes, qint64(500 * sizeof(QChar)));
+    QCOMPARE(statistics.savedBytes, qint64(495 * sizeof(QChar)));
+    QCOMPARE(storage->value(1, 1), Value("yes"));
+    QCOMPARE(storage->value(1, 2), Value("no"));
+    QCOMPARE(storage->userInput(1, 2), QString("no"));
+
+    // the format of the values is kept
+    Value percent("50%");
+    percent.setFormat(Value::fmt_Percent);
+    storage->setValue(3, 1, Value("50%"));
+    storage->setValue(3, 2, percent);
+    QCOMPARE(storage->value(3, 1).format(), Value::fmt_String);
+    QCOMPARE(storage->value(3, 2).format(), Value::fmt_Percent);
+
+    // the pool releases its strings after loading, but keeps the statistics
+    map.setLoading(false);
+    QVERIFY(!pool->isEnabled());
+    QCOMPARE(pool->count(), 0);
+    QCOMPARE(pool->bytes(), qint64(0));
+    QCOMPARE(pool->statistics(sheet).strings, 202);
+    QCOMPARE(storage->value(1, 1), Value("yes"));
+    QCOMPARE(storage->userInput(1, 2), QString("no"));
+
+    // later edits are neither pooled nor counted
+    storage->setValue(4, 1, Value("edited"));
+    storage->setUserInput(4, 1, QString("edited"));
+    QCOMPARE(pool->count(), 0);
+    QCOMPARE(pool->statistics(sheet).strings, 202);
+    QCOMPARE(storage->value(4, 1), Value("edited"));
+}
+
+#ifdef CALLIGRA_SHEETS_MT
+namespace
+{
+// Reads values and styles until it gets stopped. Counts the values, which
+// were never written.
+class StorageReader : public QRunnable
+{
+public:
+    StorageReader(const CellStorage* storage, const QAtomicInt* stop, QAtomicInt* failures)
+            : m_storage(storage), m_stop(stop), m_failures(failures) {}
+
+    virtual void run() {
+        while (!m_stop->load()) {
+            for (int row = 1; row <= 100; ++row) {
+                for (int col = 1; col <= 10; ++col) {
+                    const Value value = m_storage->value(col, row);
+                    if (!value.isEmpty() && !(value.isInteger() && value.asInteger() >= 0 && value.asInteger() < 1000))
+                        m_failures->ref();
+                    m_storage->style(col, row);
+                    m_storage->mergedXCells(col, row);
+                }
+                m_storage->firstInRow(row);
+            }
+            const Value region = m_storage->valueRegion(Region(QRect(1, 1, 10, 100)));
+            if (!region.isArray() && !region.isEmpty())
+                m_failures->ref();
+        }
+    }
+
+private:
+    const CellStorage* const m_storage;
+    const QAtomicInt* const m_stop;
+    QAtomicInt* const m_failures;
+};
+} // namespace
+#endif
+
+void CellStorageTest::testConcurrentAccess()
+{
+#ifndef CALLIGRA_SHEETS_MT
+    QSKIP("Concurrent access needs a build with CALLIGRA_SHEETS_MT.");
+#else
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+    for (int row = 1; row <= 100; ++row) {
+        for (int col = 1; col <= 10; ++col)
+            storage->setValue(col, row, Value(row));
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    QAtomicInt stop(0);
+    QAtomicInt failures(0);
+    for (int i = 0; i < 4; ++i)
+        pool.start(new StorageReader(storage, &stop, &failures));
+
+    // edit meanwhile
+    Style style;
+    for (int i = 0; i < 500; ++i) {
+        const int col = 1 + i % 10;
+        const int row = 1 + (i * 7) % 100;
+        storage->setValue(col, row, Value(i));
+        storage->setValue(col % 10 + 1, row, Value());
+        style.setBackgroundColor((i % 2) ? Qt::red : Qt::blue);
+        storage->setStyle(Region(QRect(col, row, 2, 2)), style);
+        if (i % 50 == 0) {
+            storage->insertRows(row, 2);
+            storage->removeRows(row, 2);
+            storage->mergeCells(col, row, 1, 1);
+            storage->mergeCells(col, row, 0, 0);
+        }
+    }
+    stop.store(1);
+    pool.waitForDone();
+
+    QCOMPARE(failures.load(), 0);
+    QCOMPARE(storage->value(1, 1), Value(400));
+#endif
+}
+
+// Checks the values of the second column against the expected ones.
+static void compareColumn(const CellStorage* storage, const QMap<int, int>& expected)
+{
+    for (int row = 1; row <= 1400; ++row) {
+        const Value value = storage->value(2, row);
+        if (expected.contains(row))
+            QCOMPARE(value, Value(expected.value(row)));
+        else
+            QVERIFY2(value.isEmpty(), QByteArray::number(row).constData());
+    }
+    QCOMPARE(storage->firstInColumn(2).row(), expected.firstKey());
+    QCOMPARE(storage->lastInColumn(2).row(), expected.lastKey());
+}
+
+// Moves the expected rows from \p position on by \p number rows; a negative
+// \p number removes rows.
+static QMap<int, int> shiftRows(const QMap<int, int>& expected, int position, int number)
+{
+    QMap<int, int> result;
+    QMap<int, int>::ConstIterator end(expected.constEnd());
+    for (QMap<int, int>::ConstIterator it = expected.constBegin(); it != end; ++it) {
+        if (it.key() < position)
+            result.insert(it.key(), it.value());
+        else if (it.key() >= position - qMin(number, 0))
+            result.insert(it.key() + number, it.value());
+    }
+    return result;
+}
+
+void CellStorageTest::testRowBlocks()
+{
+    // The value and formula storages may keep their data in blocks of rows,
+    // see CALLIGRA_SHEETS_CHUNKED_STORAGE. Spread the data over several of
+    // them and insert it in random order.
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+
+    QMap<int, int> expected;
+    for (int i = 0; i < 180; ++i) {
+        const int row = 1 + (i * 97) % 180 * 7;
+        storage->setValue(2, row, Value(row));
+        expected.insert(row, row);
+    }
+    compareColumn(storage, expected);
+    if (QTest::currentTestFailed())
+        return;
+
+    storage->insertRows(500, 3);
+    expected = shiftRows(expected, 500, 3);
+    compareColumn(storage, expected);
+    if (QTest::currentTestFailed())
+        return;
+
+    storage->removeRows(100, 10);
+    expected = shiftRows(expected, 100, -10);
+    compareColumn(storage, expected);
+    if (QTest::currentTestFailed())
+        return;
+
+    storage->insertShiftDown(QRect(2, 700, 1, 2));
+    expected = shiftRows(expected, 700, 2);
+    compareColumn(storage, expected);
+    if (QTest::currentTestFailed())
+        return;
+
+    storage->removeShiftUp(QRect(2, 250, 1, 300));
+    expected = shiftRows(expected, 250, -300);
+    compareColumn(storage, expected);
+    if (QTest::currentTestFailed())
+        return;
+
+    // the formulas are stored the same way
+    Formula formula(sheet, Cell(sheet, 3, 900));
+    formula.setExpression("=1+2");
+    storage->setFormula(3, 900, formula);
+    storage->insertRows(800, 1);
+    QCOMPARE(storage->formula(3, 901).expression(), QString("=1+2"));
+    QVERIFY(storage->formula(3, 900).expression().isEmpty());
+}
+
 QTEST_MAIN(CellStorageTest)
@@ -32,6 +32,9 @@ class CellStorageTest : public QObject
     Q_OBJECT
 private Q_SLOTS:
     void testMergedCellsInsertRowBug();
+    void testStringPool();
+    void testConcurrentAccess();
+    void testRowBlocks();
 };
 
 } // namespace Sheets
@@ -19,8 +19,16 @@
 
 #include "TestDatabaseFilter.h"
 
+#include <sheets/CellStorage.h>
+#include <sheets/Map.h>
+#include <sheets/Region.h>
+#include <sheets/Sheet.h>
+#include <sheets/Value.h>
+#include <sheets/database/Database.h>
 #include <sheets/database/Filter.h>
+#include <sheets/database/FilterCache.h>
 
+#include <QBitArray>
 #include <QTest>
 
 using namespace Calligra::Sheets;
@@ -87,4 +95,43 @@ void DatabaseFilterTest::testOrEquals()
     QVERIFY(a == b);
 }
 
+void DatabaseFilterTest::testEvaluate()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+    const QStringList strings = QStringList() << "x" << "y" << "x" << "" << "X" << "z";
+    storage->setValue(1, 1, Value("text"));
+    storage->setValue(2, 1, Value("number"));
+    for (int i = 0; i < strings.count(); ++i) {
+        storage->setValue(1, i + 2, Value(strings[i]));
+        storage->setValue(2, i + 2, Value(i + 1));
+    }
+
+    Filter filter;
+    filter.addCondition(Filter::AndComposition, 0, Filter::Match, "x");
+    filter.addCondition(Filter::OrComposition, 1, Filter::Match, "6");
+    Database database;
+    database.setRange(Region(QRect(1, 1, 2, 7), sheet));
+    database.setFilter(filter);
+
+    QBitArray matches = filter.evaluate(database);
+    QCOMPARE(matches.size(), 6);
+    for (int i = 0; i < matches.size(); ++i)
+        QCOMPARE(matches.testBit(i), filter.evaluate(database, i + 2));
+    QVERIFY(matches.testBit(0));
+    QVERIFY(!matches.testBit(1));
+    QVERIFY(matches.testBit(4)); // case insensitive
+    QVERIFY(matches.testBit(5)); // second field
+
+    const QStringList items = map.filterCache()->field(sheet, QRect(1, 2, 1, 6))->items;
+    QCOMPARE(items, QStringList() << "X" << "x" << "y" << "z");
+
+    // changed cells drop the cached field
+    storage->setValue(1, 3, Value("x"));
+    matches = filter.evaluate(database);
+    QVERIFY(matches.testBit(1));
+    QCOMPARE(map.filterCache()->field(sheet, QRect(1, 2, 1, 6))->items, QStringList() << "X" << "x" << "z");
+}
+
 QTEST_MAIN(DatabaseFilterTest)
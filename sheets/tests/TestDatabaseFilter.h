@@ -38,6 +38,7 @@ private Q_SLOTS:
     void testNotEquals2();
     void testAndEquals();
     void testOrEquals();
+    void testEvaluate();
 };
 
 } // namespace Sheets
@@ -108,6 +108,38 @@ void TestDependencies::testDepths()
     QCOMPARE(depths[a4], 2);
 }
 
+void TestDependencies::testDependentCells()
+{
+    Cell a1(m_sheet, 1, 1); a1.setUserInput("5");
+    Cell a2(m_sheet, 1, 2); a2.setUserInput("=A1");
+    Cell a3(m_sheet, 1, 3); a3.setUserInput("=A2");
+    Cell a4(m_sheet, 1, 4); a4.setUserInput("=A1 + A3");
+    Cell b1(m_sheet, 2, 1); b1.setUserInput("=A4");
+    Cell b2(m_sheet, 2, 2); b2.setUserInput("=C1");
+
+    QApplication::processEvents(); // handle Damages
+
+    DependencyManager* manager = m_map->dependencyManager();
+    QList<Cell> cells = manager->dependentCells(Region(QPoint(1, 1), m_sheet));
+    QCOMPARE(cells.count(), 4);
+    QVERIFY(cells.contains(a2));
+    QVERIFY(cells.contains(a3));
+    QVERIFY(cells.contains(a4));
+    QVERIFY(cells.contains(b1));
+    QCOMPARE(manager->depth(b1), 4);
+
+    // formulas in the region itself are included
+    cells = manager->dependentCells(Region(QPoint(1, 3), m_sheet));
+    QCOMPARE(cells.count(), 3);
+    QVERIFY(cells.contains(a3));
+    QVERIFY(cells.contains(a4));
+    QVERIFY(cells.contains(b1));
+
+    cells = manager->dependentCells(Region(QPoint(3, 1), m_sheet));
+    QCOMPARE(cells.count(), 1);
+    QCOMPARE(cells.first(), b2);
+}
+
 void TestDependencies::cleanupTestCase()
 {
     delete m_map;
@@ -20,6 +20,10 @@
 
 #include "TestKspreadCommon.h"
 
+#include "CellStorage.h"
+#include "Map.h"
+#include "Sheet.h"
+
 using namespace Calligra::Sheets;
 
 static char encodeTokenType(const Token& token)
@@ -369,4 +373,35 @@ void TestFormula::testInlineArrays()
 #endif
 }
 
+void TestFormula::testResolvedReferences()
+{
+    Map map(0 /* no Doc */);
+    Sheet* sheet1 = map.addNewSheet();
+    sheet1->setSheetName("Sheet1");
+    Sheet* sheet2 = map.addNewSheet();
+    sheet2->setSheetName("Sheet2");
+    sheet1->cellStorage()->setValue(1, 1, Value(1));
+    sheet2->cellStorage()->setValue(1, 1, Value(2));
+    sheet2->cellStorage()->setValue(1, 2, Value(4));
+
+    Formula formula(sheet1);
+    formula.setExpression("=Sheet2!A1+A1+SUM(Sheet2!A1:A2)");
+    QVERIFY(formula.isValid());
+    QCOMPARE(formula.eval(), Value(9.0));
+
+    // the resolved references stay valid on value changes
+    sheet2->cellStorage()->setValue(1, 1, Value(3));
+    QCOMPARE(formula.eval(), Value(11.0));
+
+    // a sheet added after the compilation
+    formula.setExpression("=Sheet3!A1*2");
+    QVERIFY(formula.isValid());
+    QCOMPARE(formula.eval(), Value::errorREF());
+    Sheet* sheet3 = map.addNewSheet();
+    sheet3->setSheetName("Sheet3");
+    sheet3->cellStorage()->setValue(1, 1, Value(5));
+    QVERIFY(formula.isValid());
+    QCOMPARE(formula.eval(), Value(10.0));
+}
+
 QTEST_MAIN(TestFormula)
@@ -45,6 +45,7 @@ private Q_SLOTS:
     void testString();
     void testFunction();
     void testInlineArrays();
+    void testResolvedReferences();
 
 private:
     Value evaluate(const QString&, Value&);
@@ -22,7 +22,9 @@
 
 #include <CellStorage.h>
 #include <Formula.h>
+#include <LookupCache.h>
 #include <Map.h>
+#include <Region.h>
 #include <Sheet.h>
 #include <CalculationSettings.h>
 
@@ -616,6 +618,89 @@ void TestInformationFunctions::testMATCH()
     CHECK_EVAL("MATCH(13;C11:D13;-1)", Value::errorNA()); // not sure if this is the best error
 }
 
+void TestInformationFunctions::testLookupIndex()
+{
+    Sheet* sheet = m_map->sheet(0);
+    CellStorage* storage = sheet->cellStorage();
+
+    // J101:K200, large enough to get indexed
+    for (int i = 1; i <= 100; ++i) {
+        storage->setValue(10, 100 + i, Value(2 * i));
+        storage->setValue(11, 100 + i, Value(QString("v%1").arg(i)));
+    }
+    // A300:AN301
+    for (int i = 1; i <= 40; ++i) {
+        storage->setValue(i, 300, Value(i));
+        storage->setValue(i, 301, Value(10 * i));
+    }
+
+    CHECK_EVAL("VLOOKUP(20;J101:K200;2)", Value("v10"));
+    CHECK_EVAL("VLOOKUP(21;J101:K200;2)", Value("v10"));
+    CHECK_EVAL("VLOOKUP(21;J101:K200;2;0)", Value::errorNA());
+    CHECK_EVAL("VLOOKUP(1;J101:K200;2)", Value::errorNA());
+    CHECK_EVAL("VLOOKUP(500;J101:K200;2)", Value("v100"));
+    CHECK_EVAL("MATCH(\"V10\";K101:K200;0)", Value(10));
+    CHECK_EVAL("MATCH(\"v101\";K101:K200;0)", Value::errorNA());
+    CHECK_EVAL("HLOOKUP(7;A300:AN301;2)", Value(70));
+    CHECK_EVAL("HLOOKUP(7.5;A300:AN301;2)", Value(70));
+    CHECK_EVAL("HLOOKUP(0;A300:AN301;2)", Value::errorNA());
+
+    // the small range is searched linearly and yields the same results
+    CHECK_EVAL("VLOOKUP(20;J101:K110;2)", Value("v10"));
+    CHECK_EVAL("VLOOKUP(21;J101:K110;2)", Value("v10"));
+
+    // a value change drops the index
+    storage->setValue(10, 110, Value(1000));
+    CHECK_EVAL("VLOOKUP(20;J101:K200;2;0)", Value::errorNA());
+    CHECK_EVAL("VLOOKUP(1000;J101:K200;2;0)", Value("v10"));
+    CHECK_EVAL("VLOOKUP(21;J101:K200;2)", Value("v9"));
+}
+
+void TestInformationFunctions::testLookupIndexInvalidation()
+{
+    Sheet* sheet = m_map->sheet(0);
+    LookupCache cache;
+    Value data(Value::Array);
+    Value changed(Value::Array);
+    for (int i = 0; i < 40; ++i) {
+        data.setElement(0, i, Value(i));
+        changed.setElement(0, i, Value(100 + i));
+    }
+    // A1:A40 and C1:C40
+    const QRect range(1, 1, 1, 40);
+    const QRect other(3, 1, 1, 40);
+
+    int position = -1;
+    QVERIFY(cache.find(sheet, range, Qt::Vertical, data, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, 5);
+    QVERIFY(cache.find(sheet, other, Qt::Vertical, data, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, 5);
+
+    // While an index is kept, the passed values are not looked at.
+    QVERIFY(cache.find(sheet, range, Qt::Vertical, changed, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, 5);
+
+    // a change between the ranges keeps both indices
+    cache.regionChanged(sheet, Region(QRect(2, 1, 1, 40), sheet));
+    QVERIFY(cache.find(sheet, range, Qt::Vertical, changed, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, 5);
+    QVERIFY(cache.find(sheet, other, Qt::Vertical, changed, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, 5);
+
+    // a change inside the first range drops its index only
+    cache.regionChanged(sheet, Region(QPoint(1, 20), sheet));
+    QVERIFY(cache.find(sheet, range, Qt::Vertical, changed, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, -1);
+    QVERIFY(cache.find(sheet, range, Qt::Vertical, changed, Value(105), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, 5);
+    QVERIFY(cache.find(sheet, other, Qt::Vertical, changed, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, 5);
+
+    cache.removeSheet(sheet);
+    QVERIFY(cache.find(sheet, other, Qt::Vertical, changed, Value(5), false, Qt::CaseSensitive, &position));
+    QCOMPARE(position, -1);
+}
+
 //
 // cleanup test
 //
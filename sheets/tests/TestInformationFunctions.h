@@ -64,6 +64,8 @@ private Q_SLOTS:
     void testISODD();
     void testISTEXT();
     void testISREF();
+    void testLookupIndex();
+    void testLookupIndexInvalidation();
     void testMATCH();
     void testN();
     void testNA();
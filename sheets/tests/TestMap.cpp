@@ -0,0 +1,103 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestMap.h"
+
+#include <QTest>
+
+#include "Cell.h"
+#include "Map.h"
+#include "Region.h"
+#include "Sheet.h"
+
+using namespace Calligra::Sheets;
+
+void TestMap::recordDamages(const QList<Damage*>& damages)
+{
+    foreach (Damage* damage, damages) {
+        FlushedDamage flushed;
+        flushed.type = damage->type();
+        flushed.changes = 0;
+        if (damage->type() == Damage::Cell) {
+            const CellDamage* cellDamage = static_cast<CellDamage*>(damage);
+            flushed.changes = int(cellDamage->changes());
+            const Region& region = cellDamage->region();
+            Region::ConstIterator end(region.constEnd());
+            for (Region::ConstIterator it(region.constBegin()); it != end; ++it)
+                flushed.region += (*it)->rect();
+        }
+        m_damages.append(flushed);
+    }
+}
+
+void TestMap::testCellDamageMerging()
+{
+    Map map(0 /* no Doc */);
+    Sheet* sheet = map.addNewSheet();
+    connect(&map, SIGNAL(damagesFlushed(QList<Damage*>)),
+            this, SLOT(recordDamages(QList<Damage*>)));
+    m_damages.clear();
+
+    // A1:B1000 in single cells, through both ways to add them
+    for (int row = 1; row <= 1000; ++row) {
+        map.addDamage(new CellDamage(Cell(sheet, 1, row), CellDamage::Value));
+        map.addCellDamage(sheet, QRect(2, row, 1, 1), CellDamage::Value);
+    }
+    // other changes are kept apart
+    map.addCellDamage(sheet, QRect(5, 5, 1, 1), CellDamage::Appearance);
+    map.flushDamages();
+
+    QCOMPARE(m_damages.count(), 2);
+    QCOMPARE(m_damages[0].type, Damage::Cell);
+    QCOMPARE(m_damages[0].changes, int(CellDamage::Value));
+    QCOMPARE(m_damages[0].region, QRegion(QRect(1, 1, 2, 1000)));
+    QCOMPARE(m_damages[1].type, Damage::Cell);
+    QCOMPARE(m_damages[1].changes, int(CellDamage::Appearance));
+    QCOMPARE(m_damages[1].region, QRegion(QRect(5, 5, 1, 1)));
+
+    // nothing is left for the next flush
+    m_damages.clear();
+    map.flushDamages();
+    QVERIFY(m_damages.isEmpty());
+}
+
+void TestMap::testDamageOrder()
+{
+    Map map(0 /* no Doc */);
+    Sheet* sheet = map.addNewSheet();
+    connect(&map, SIGNAL(damagesFlushed(QList<Damage*>)),
+            this, SLOT(recordDamages(QList<Damage*>)));
+    m_damages.clear();
+
+    map.addCellDamage(sheet, QRect(1, 1, 1, 1), CellDamage::Value);
+    map.addCellDamage(sheet, QRect(1, 2, 1, 1), CellDamage::Value);
+    map.addDamage(new SheetDamage(sheet, SheetDamage::PropertiesChanged));
+    map.addCellDamage(sheet, QRect(1, 3, 1, 1), CellDamage::Value);
+    map.flushDamages();
+
+    // The cell damages are not merged across the sheet damage.
+    QCOMPARE(m_damages.count(), 3);
+    QCOMPARE(m_damages[0].type, Damage::Cell);
+    QCOMPARE(m_damages[0].region, QRegion(QRect(1, 1, 1, 2)));
+    QCOMPARE(m_damages[1].type, Damage::Sheet);
+    QCOMPARE(m_damages[2].type, Damage::Cell);
+    QCOMPARE(m_damages[2].region, QRegion(QRect(1, 3, 1, 1)));
+}
+
+QTEST_MAIN(TestMap)
@@ -0,0 +1,58 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_TEST_MAP
+#define CALLIGRA_SHEETS_TEST_MAP
+
+#include <QList>
+#include <QObject>
+#include <QRegion>
+
+#include "Damages.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+class TestMap : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void recordDamages(const QList<Damage*>& damages);
+
+private Q_SLOTS:
+    void testCellDamageMerging();
+    void testDamageOrder();
+
+private:
+    // the flushed damages; the cell region and changes for cell damages
+    struct FlushedDamage {
+        Damage::Type type;
+        int changes;
+        QRegion region;
+    };
+    QList<FlushedDamage> m_damages;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_TEST_MAP
@@ -26,6 +26,7 @@
 #include <Map.h>
 #include <Sheet.h>
 #include <CalculationSettings.h>
+#include <ValueCalc.h>
 
 // NOTE: we do not compare the numbers _exactly_ because it is difficult
 // to get one "true correct" expected values for the functions due to:
@@ -681,6 +682,10 @@ void TestMathFunctions::testMINVERSE()
 void TestMathFunctions::testMMULT()
 {
     CHECK_EVAL("MMULT({2;4|3;5};{2;4|3;5})", evaluate("{16.0;28.0|21.0;37.0}"));
+    CHECK_EVAL("MMULT({\"2\";4|3;5};{2;4|3;5})", evaluate("{16.0;28.0|21.0;37.0}")); // strings are parsed
+    CHECK_EVAL("MMULT({1;2|3;4};{TRUE();0|0;1})", evaluate("{1.0;2.0|3.0;4.0}"));
+    CHECK_EVAL("MMULT(B4:B5;{1;2})", evaluate("{2.0;4.0|3.0;6.0}"));
+    CHECK_EVAL("MMULT({1;2};{2;4})", Value::errorVALUE());
 }
 
 void TestMathFunctions::testMOD()
@@ -941,6 +946,110 @@ void TestMathFunctions::testSUMSQ()
     CHECK_EVAL("SUMSQ(B4:B5)",      Value(13));     // 2*2+3*3 is 13.
 }
 
+// The unboxed reductions have to yield exactly the results of the array walk.
+void TestMathFunctions::testNumericAggregates()
+{
+    ValueCalc* calc = m_map->calc();
+
+    Value array(Value::Array);
+    for (int row = 0; row < 200; ++row) {
+        array.setElement(0, row, Value(row * 0.1));
+        if (row % 7 == 0)
+            array.setElement(1, row, Value("text"));
+        else if (row % 5 != 0)
+            array.setElement(1, row, Value(200 - row));
+    }
+
+    Value expected(0);
+    calc->arrayWalk(array, expected, calc->awFunc("sum"), Value(0));
+    QCOMPARE(calc->sum(array, false), expected);
+    QCOMPARE(calc->sum(array, false).format(), expected.format());
+
+    expected = Value(0);
+    calc->arrayWalk(array, expected, calc->awFunc("sumsq"), Value(0));
+    QCOMPARE(calc->sumsq(array, false), expected);
+
+    expected = Value(0);
+    calc->arrayWalk(array, expected, calc->awFunc("count"), Value(0));
+    QCOMPARE(calc->count(array, false), int(numToDouble(expected.asFloat())));
+
+    expected = Value();
+    calc->arrayWalk(array, expected, calc->awFunc("max"), Value(0));
+    QCOMPARE(calc->max(array, false), expected);
+    QCOMPARE(calc->max(array, false).type(), Value::Integer);
+
+    expected = Value();
+    calc->arrayWalk(array, expected, calc->awFunc("min"), Value(0));
+    QCOMPARE(calc->min(array, false), expected);
+    QCOMPARE(calc->min(array, false).type(), Value::Float);
+
+    // several arguments
+    QVector<Value> arguments;
+    arguments << array << Value(1000) << Value("text") << array;
+    expected = Value(0);
+    calc->arrayWalk(arguments, expected, calc->awFunc("sum"), Value(0));
+    QCOMPARE(calc->sum(arguments, false), expected);
+    expected = Value();
+    calc->arrayWalk(arguments, expected, calc->awFunc("max"), Value(0));
+    QCOMPARE(calc->max(arguments, false), expected);
+
+    // errors take the array walk
+    array.setElement(1, 3, Value::errorDIV0());
+    QCOMPARE(calc->sum(array, false), Value::errorDIV0());
+    QCOMPARE(calc->max(array, false), Value::errorDIV0());
+}
+
+// The shared criteria matches have to yield the results of the functions themselves.
+void TestMathFunctions::testCriteriaCache()
+{
+    Sheet* sheet = m_map->addNewSheet("Criteria");
+    CellStorage* storage = sheet->cellStorage();
+    ValueCalc* calc = m_map->calc();
+
+    // Criteria!A1:B100
+    Value range(Value::Array);
+    for (int row = 1; row <= 100; ++row) {
+        const Value value = (row % 3) ? Value(row % 10) : Value(QString("Item%1").arg(row % 4));
+        storage->setValue(1, row, value);
+        storage->setValue(2, row, Value(row));
+        range.setElement(0, row - 1, value);
+    }
+
+    QStringList criteria;
+    criteria << ">4" << "<=2" << "<>3" << "=7" << "item1" << "Item2";
+    foreach (const QString& criterion, criteria) {
+        Condition cond;
+        calc->getCond(cond, Value(criterion));
+        // twice: the second evaluation uses the remembered matches
+        for (int i = 0; i < 2; ++i) {
+            QCOMPARE(evaluate(QString("COUNTIF(Criteria!A1:A100;\"%1\")").arg(criterion)),
+                     Value(calc->countIf(range, cond)));
+            QCOMPARE(evaluate(QString("SUMIF(Criteria!A1:A100;\"%1\")").arg(criterion)),
+                     calc->sumIf(range, cond));
+        }
+    }
+    CHECK_EVAL("SUMIF(Criteria!A1:A100;\">4\";Criteria!B1:B100)", Value(1730));
+    CHECK_EVAL("COUNTIFS(Criteria!A1:A100;\">4\";Criteria!B1:B100;\"<50\")", Value(16));
+
+    // changes drop the matches
+    CHECK_EVAL("COUNTIF(Criteria!A1:A100;\"=1\")", Value(7));
+    storage->setValue(1, 2, Value(1));
+    CHECK_EVAL("COUNTIF(Criteria!A1:A100;\"=1\")", Value(8));
+
+    // simple string matching compares the lower case texts
+    m_map->calculationSettings()->setUseRegularExpressions(false);
+    storage->setValue(3, 1, Value(QString::fromUtf8("\xc3\x84rger")));  // upper case a umlaut
+    storage->setValue(3, 2, Value(QString::fromUtf8("\xc3\xa4rger")));  // lower case a umlaut
+    storage->setValue(3, 3, Value(QString::fromUtf8("\xce\xa3")));      // capital sigma
+    for (int i = 0; i < 2; ++i) {
+        CHECK_EVAL(QString::fromUtf8("COUNTIF(Criteria!C1:C3;\"\xc3\x84RGER\")"), Value(2));
+        CHECK_EVAL(QString::fromUtf8("COUNTIF(Criteria!C1:C3;\"\xcf\x83\")"), Value(1));
+        // the final sigma is not the lower case form of the capital one
+        CHECK_EVAL(QString::fromUtf8("COUNTIF(Criteria!C1:C3;\"\xcf\x82\")"), Value(0));
+    }
+    m_map->calculationSettings()->setUseRegularExpressions(true);
+}
+
 void TestMathFunctions::testTRUNC()
 {
     // ODF-tests
@@ -109,6 +109,8 @@ private Q_SLOTS:
     void testSUMIF_WILDCARDS();
     void testSUMIF_REGULAREXPRESSIONS();
     void testSUMSQ();
+    void testNumericAggregates();
+    void testCriteriaCache();
     void testTRUNC();
 
 private:
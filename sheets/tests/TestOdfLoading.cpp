@@ -0,0 +1,381 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; only
+   version 2 of the License.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "TestOdfLoading.h"
+
+#include <QBuffer>
+#include <QTest>
+#include <QThreadPool>
+
+#include <KoEmbeddedDocumentSaver.h>
+#include <KoOdfReadStore.h>
+#include <KoOdfWriteStore.h>
+#include <KoStore.h>
+
+#include "MockPart.h"
+
+#include "part/Doc.h"
+#include "Cell.h"
+#include "Condition.h"
+#include "Format.h"
+#include "RowColumnFormat.h"
+#include "Map.h"
+#include "NamedAreaManager.h"
+#include "Region.h"
+#include "RowFormatStorage.h"
+#include "Sheet.h"
+#include "Style.h"
+#include "Validity.h"
+#include "Value.h"
+
+using namespace Calligra::Sheets;
+
+static const char contentXml[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<office:document-content"
+    " xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+    " xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\""
+    " xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\""
+    " xmlns:fo=\"urn:oasis:names:tc:opendocument:xmlns:xsl-fo-compatible:1.0\""
+    " xmlns:of=\"urn:oasis:names:tc:opendocument:xmlns:of:1.2\""
+    " office:version=\"1.2\">"
+    "<office:automatic-styles>"
+    "<style:style style:name=\"co1\" style:family=\"table-column\">"
+    "<style:table-column-properties style:column-width=\"2in\"/>"
+    "</style:style>"
+    "<style:style style:name=\"co2\" style:family=\"table-column\">"
+    "<style:table-column-properties style:column-width=\"0.5in\"/>"
+    "</style:style>"
+    "<style:style style:name=\"ro1\" style:family=\"table-row\">"
+    "<style:table-row-properties style:row-height=\"0.4in\"/>"
+    "</style:style>"
+    "<style:style style:name=\"ro2\" style:family=\"table-row\">"
+    "<style:table-row-properties style:row-height=\"0.1in\"/>"
+    "</style:style>"
+    "<style:style style:name=\"ce1\" style:family=\"table-cell\">"
+    "<style:text-properties fo:font-weight=\"bold\" fo:color=\"#ff0000\"/>"
+    "</style:style>"
+    "<style:style style:name=\"ce2\" style:family=\"table-cell\">"
+    "<style:table-cell-properties fo:background-color=\"#00ff00\"/>"
+    "</style:style>"
+    "</office:automatic-styles>"
+    "<office:body>"
+    "<office:spreadsheet xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\">"
+    // The first sheet has repeated and hidden columns, merged cells and formulas.
+    "<table:table table:name=\"First\">"
+    "<table:table-column table:style-name=\"co1\" table:default-cell-style-name=\"ce2\"/>"
+    "<table:table-column table:style-name=\"co2\" table:number-columns-repeated=\"3\"/>"
+    "<table:table-column table:style-name=\"co1\" table:visibility=\"collapse\"/>"
+    "<table:table-row table:style-name=\"ro1\">"
+    "<table:table-cell office:value-type=\"float\" office:value=\"1\"><text:p>1</text:p></table:table-cell>"
+    "<table:table-cell office:value-type=\"string\" table:style-name=\"ce1\"><text:p>text</text:p></table:table-cell>"
+    "<table:table-cell table:number-columns-spanned=\"2\" table:number-rows-spanned=\"2\""
+    " office:value-type=\"float\" office:value=\"3\"><text:p>3</text:p></table:table-cell>"
+    "<table:covered-table-cell/>"
+    "</table:table-row>"
+    "<table:table-row table:number-rows-repeated=\"2\">"
+    "<table:table-cell table:formula=\"of:=[.A1]*2\" office:value-type=\"float\" office:value=\"2\"><text:p>2</text:p></table:table-cell>"
+    "<table:table-cell table:style-name=\"ce1\" table:number-columns-repeated=\"1\"/>"
+    "<table:covered-table-cell table:number-columns-repeated=\"2\"/>"
+    "</table:table-row>"
+    "<table:table-row table:style-name=\"ro2\" table:visibility=\"collapse\">"
+    "<table:table-cell office:value-type=\"boolean\" office:boolean-value=\"true\"><text:p>TRUE</text:p></table:table-cell>"
+    "</table:table-row>"
+    "</table:table>"
+    // The rows of the second sheet are in groups that declare their own prefixes.
+    "<table:table table:name=\"Second\">"
+    "<table:table-column table:number-columns-repeated=\"2\"/>"
+    "<t:table-header-rows xmlns:t=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\">"
+    "<t:table-row t:style-name=\"ro1\">"
+    "<t:table-cell office:value-type=\"string\"><text:p>header</text:p></t:table-cell>"
+    "</t:table-row>"
+    "</t:table-header-rows>"
+    "<g:table-row-group xmlns:g=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\""
+    " xmlns:p=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\">"
+    "<g:table-row g:number-rows-repeated=\"3\">"
+    "<g:table-cell g:formula=\"of:=[First.A1]+1\" office:value-type=\"float\" office:value=\"2\"><p:p>2</p:p></g:table-cell>"
+    "<g:table-cell g:style-name=\"ce1\" office:value-type=\"string\"><p:p>grouped</p:p></g:table-cell>"
+    "</g:table-row>"
+    "<g:table-row g:style-name=\"ro2\">"
+    "<g:table-cell g:number-columns-spanned=\"2\" office:value-type=\"float\" office:value=\"5\"><p:p>5</p:p></g:table-cell>"
+    "<g:covered-table-cell/>"
+    "</g:table-row>"
+    "</g:table-row-group>"
+    "</table:table>"
+    // The named areas follow the tables.
+    "<table:named-expressions>"
+    "<table:named-range table:name=\"Values\" table:base-cell-address=\"$First.$A$1\""
+    " table:cell-range-address=\"$First.$A$1:.$A$3\"/>"
+    "<table:named-range table:name=\"Header\" table:base-cell-address=\"$Second.$A$1\""
+    " table:cell-range-address=\"$Second.$A$1\"/>"
+    "</table:named-expressions>"
+    "</office:spreadsheet>"
+    "</office:body>"
+    "</office:document-content>\n";
+
+static const char mimeType[] = "application/vnd.oasis.opendocument.spreadsheet";
+
+// Fills the map with sheets, that share some styles and have some of their own.
+static void fillMap(Map *map)
+{
+    for (int i = 1; i <= 6; ++i) {
+        Sheet *sheet = map->addNewSheet(QString("Sheet%1").arg(i));
+        for (int row = 1; row <= 20; ++row) {
+            for (int col = 1; col <= 5; ++col) {
+                Cell cell(sheet, col, row);
+                if (col == 5)
+                    cell.parseUserInput(QString("=A%1+B%1").arg(row));
+                else if (col == 4)
+                    cell.parseUserInput(QString("text %1").arg(row * i));
+                else
+                    cell.parseUserInput(QString::number(row * col * i));
+
+                Style style;
+                if (row % 3 == 0)
+                    style.setFontBold(true);
+                if (col == 2) {
+                    style.setFormatType(Format::Percentage);
+                    style.setPrecision(i);
+                }
+                if (row % 4 == i % 4)
+                    style.setFontColor(QColor(20 * i, 0, 255 - 20 * row));
+                if (col == 3 && row % 2)
+                    style.setBackgroundColor(QColor(0, 10 * i, 0));
+                if (!style.isEmpty())
+                    cell.setStyle(style);
+
+                if (col == 1 && row % 5 == 0) {
+                    Validity validity;
+                    validity.setRestriction(Validity::Number);
+                    validity.setCondition(Conditional::Superior);
+                    validity.setMinimumValue(Value(row % 3 + i % 2));
+                    cell.setValidity(validity);
+                }
+            }
+        }
+        sheet->nonDefaultColumnFormat(i % 5 + 1)->setWidth(40 + 10 * i);
+        sheet->nonDefaultColumnFormat(6)->setHidden(i % 2);
+        sheet->rowFormats()->setRowHeight(i, i + 2, 15 + i);
+        sheet->rowFormats()->setHidden(10 + i, 10 + i, true);
+    }
+}
+
+// Saves the document into a package in memory.
+static QByteArray savePackage(DocBase *doc)
+{
+    QByteArray package;
+    QBuffer buffer(&package);
+    buffer.open(QIODevice::WriteOnly);
+    KoStore *store = KoStore::createStore(&buffer, KoStore::Write, mimeType, KoStore::Zip);
+    KoOdfWriteStore odfStore(store);
+    odfStore.manifestWriter(mimeType);
+    KoEmbeddedDocumentSaver embeddedSaver;
+    KoDocumentBase::SavingContext documentContext(odfStore, embeddedSaver);
+    const bool ok = doc->saveOdf(documentContext) && odfStore.closeManifestWriter() && store->finalize();
+    delete store;
+    return ok ? package : QByteArray();
+}
+
+static QByteArray readFile(const QByteArray &package, const QString &name)
+{
+    QBuffer buffer(const_cast<QByteArray*>(&package));
+    buffer.open(QIODevice::ReadOnly);
+    KoStore *store = KoStore::createStore(&buffer, KoStore::Read);
+    QByteArray data;
+    if (store && store->extractFile(name, data)) {
+        delete store;
+        return data;
+    }
+    delete store;
+    return QByteArray();
+}
+
+void OdfLoadingTest::initTestCase()
+{
+    m_maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    KoStore *store = KoStore::createStore(&buffer, KoStore::Write,
+                                          "application/vnd.oasis.opendocument.spreadsheet", KoStore::Zip);
+    QVERIFY(store);
+    QVERIFY(store->open("content.xml"));
+    QVERIFY(store->write(contentXml, qstrlen(contentXml)) > 0);
+    QVERIFY(store->close());
+    QVERIFY(store->finalize());
+    delete store;
+}
+
+void OdfLoadingTest::cleanupTestCase()
+{
+    QThreadPool::globalInstance()->setMaxThreadCount(m_maxThreadCount);
+}
+
+void OdfLoadingTest::testStreamingMatchesDom_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("serial") << 1;
+    QTest::newRow("parallel") << 4;
+}
+
+void OdfLoadingTest::testStreamingMatchesDom()
+{
+    QFETCH(int, threads);
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    Doc domDoc(new MockPart);
+    {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        KoStore *store = KoStore::createStore(&buffer, KoStore::Read);
+        QVERIFY(store);
+        KoOdfReadStore odfStore(store);
+        QString errorMessage;
+        QVERIFY(odfStore.loadAndParse(errorMessage));
+        QVERIFY(domDoc.loadOdf(odfStore));
+        delete store;
+    }
+
+    Doc streamedDoc(new MockPart);
+    {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        KoStore *store = KoStore::createStore(&buffer, KoStore::Read);
+        QVERIFY(store);
+        QVERIFY(streamedDoc.loadOasisFromStore(store));
+        delete store;
+    }
+
+    compareMaps(domDoc.map(), streamedDoc.map());
+
+    // The values of the test document itself.
+    const Map *map = domDoc.map();
+    QCOMPARE(map->count(), 2);
+    const Sheet *first = map->sheet(0);
+    QCOMPARE(Cell(first, 3, 1).mergedXCells(), 1);
+    QCOMPARE(Cell(first, 3, 1).mergedYCells(), 1);
+    QCOMPARE(Cell(first, 1, 3).userInput(), QString("=A1*2"));
+    QVERIFY(first->columnFormat(5)->isHidden());
+    QVERIFY(first->rowFormats()->isHidden(4));
+    const Sheet *second = map->sheet(1);
+    QCOMPARE(Cell(second, 2, 4).value(), Value("grouped"));
+    QCOMPARE(Cell(second, 1, 5).mergedXCells(), 1);
+    QCOMPARE(map->namedAreaManager()->areaNames().count(), 2);
+}
+
+void OdfLoadingTest::testParallelSave()
+{
+    Doc doc(new MockPart);
+    fillMap(doc.map());
+
+    QThreadPool::globalInstance()->setMaxThreadCount(1);
+    const QByteArray serial = savePackage(&doc);
+    QVERIFY(!serial.isEmpty());
+    QThreadPool::globalInstance()->setMaxThreadCount(4);
+    const QByteArray parallel = savePackage(&doc);
+    QVERIFY(!parallel.isEmpty());
+
+    const QByteArray serialContent = readFile(serial, "content.xml");
+    QVERIFY(serialContent.contains("table:style-name=\"ce"));
+    QVERIFY(serialContent.contains("table:validation-name=\"val"));
+    QCOMPARE(readFile(parallel, "content.xml"), serialContent);
+    QCOMPARE(readFile(parallel, "styles.xml"), readFile(serial, "styles.xml"));
+}
+
+void OdfLoadingTest::testParallelLoad()
+{
+    QByteArray package;
+    {
+        Doc doc(new MockPart);
+        fillMap(doc.map());
+        QThreadPool::globalInstance()->setMaxThreadCount(1);
+        package = savePackage(&doc);
+        QVERIFY(!package.isEmpty());
+    }
+
+    Doc serialDoc(new MockPart);
+    {
+        QBuffer buffer(&package);
+        buffer.open(QIODevice::ReadOnly);
+        KoStore *store = KoStore::createStore(&buffer, KoStore::Read);
+        QVERIFY(store);
+        QVERIFY(serialDoc.loadOasisFromStore(store));
+        delete store;
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(4);
+    Doc parallelDoc(new MockPart);
+    {
+        QBuffer buffer(&package);
+        buffer.open(QIODevice::ReadOnly);
+        KoStore *store = KoStore::createStore(&buffer, KoStore::Read);
+        QVERIFY(store);
+        QVERIFY(parallelDoc.loadOasisFromStore(store));
+        delete store;
+    }
+
+    QCOMPARE(serialDoc.map()->count(), 6);
+    compareMaps(serialDoc.map(), parallelDoc.map());
+    QVERIFY(Cell(parallelDoc.map()->sheet(2), 1, 5).validity().restriction() == Validity::Number);
+    QVERIFY(parallelDoc.map()->sheet(3)->rowFormats()->isHidden(14));
+}
+
+void OdfLoadingTest::compareMaps(const Map *dom, const Map *streamed)
+{
+    QCOMPARE(streamed->count(), dom->count());
+    for (int i = 0; i < dom->count(); ++i) {
+        const Sheet *domSheet = dom->sheet(i);
+        const Sheet *streamedSheet = streamed->sheet(i);
+        QCOMPARE(streamedSheet->sheetName(), domSheet->sheetName());
+
+        const QRect area = domSheet->usedArea();
+        QCOMPARE(streamedSheet->usedArea(), area);
+        QVERIFY(!area.isEmpty());
+        // one more row and column to also compare the defaults
+        for (int row = 1; row <= area.bottom() + 1; ++row) {
+            QCOMPARE(streamedSheet->rowFormats()->rowHeight(row), domSheet->rowFormats()->rowHeight(row));
+            QCOMPARE(streamedSheet->rowFormats()->isHidden(row), domSheet->rowFormats()->isHidden(row));
+            for (int col = 1; col <= area.right() + 1; ++col) {
+                const Cell domCell(domSheet, col, row);
+                const Cell streamedCell(streamedSheet, col, row);
+                QCOMPARE(streamedCell.value(), domCell.value());
+                QCOMPARE(streamedCell.userInput(), domCell.userInput());
+                QVERIFY(streamedCell.style() == domCell.style());
+                QCOMPARE(streamedCell.mergedXCells(), domCell.mergedXCells());
+                QCOMPARE(streamedCell.mergedYCells(), domCell.mergedYCells());
+                QCOMPARE(streamedCell.isPartOfMerged(), domCell.isPartOfMerged());
+            }
+        }
+        for (int col = 1; col <= area.right() + 1; ++col) {
+            QCOMPARE(streamedSheet->columnFormat(col)->width(), domSheet->columnFormat(col)->width());
+            QCOMPARE(streamedSheet->columnFormat(col)->isHidden(), domSheet->columnFormat(col)->isHidden());
+        }
+    }
+
+    QList<QString> names = dom->namedAreaManager()->areaNames();
+    qSort(names);
+    QList<QString> streamedNames = streamed->namedAreaManager()->areaNames();
+    qSort(streamedNames);
+    QCOMPARE(streamedNames, names);
+    foreach (const QString &name, names) {
+        QCOMPARE(streamed->namedAreaManager()->namedArea(name).name(), dom->namedAreaManager()->namedArea(name).name());
+    }
+}
+
+QTEST_MAIN(OdfLoadingTest)
@@ -0,0 +1,53 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; only
+   version 2 of the License.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_ODF_LOADING_TEST
+#define CALLIGRA_SHEETS_ODF_LOADING_TEST
+
+#include <QObject>
+#include <QByteArray>
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Map;
+
+class OdfLoadingTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testStreamingMatchesDom_data();
+    void testStreamingMatchesDom();
+    void testParallelSave();
+    void testParallelLoad();
+
+private:
+    void compareMaps(const Map *dom, const Map *streamed);
+
+    QByteArray m_package;
+    int m_maxThreadCount;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_ODF_LOADING_TEST
@@ -0,0 +1,119 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestPixmapCachingSheetView.h"
+
+#include "CellStorage.h"
+#include "Map.h"
+#include "Sheet.h"
+#include "Value.h"
+#include "ui/PixmapCachingSheetView.h"
+#include "ui/PixmapCachingSheetView_p.h"
+
+#include <KoViewConverter.h>
+
+#include <QImage>
+#include <QTest>
+
+using namespace Calligra::Sheets;
+
+// Renders the tile at \p x , \p y and waits for a threaded rendering to finish.
+static PixmapCachingSheetView::Private::Tile* renderTile(PixmapCachingSheetView::Private* d, const Sheet* sheet, int x, int y)
+{
+    d->getTile(sheet, x, y, 0);
+    PixmapCachingSheetView::Private::Tile* tile = d->tileCache.object(PixmapCachingSheetView::Private::tileKey(x, y));
+    for (int i = 0; tile && tile->pending && i < 1000; ++i)
+        QTest::qWait(10);
+    return tile;
+}
+
+void TestPixmapCachingSheetView::testPartialRendering()
+{
+    Map map(0 /* no Doc */);
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+    for (int row = 1; row <= 20; ++row) {
+        for (int col = 1; col <= 6; ++col)
+            storage->setValue(col, row, Value(row * col));
+    }
+
+    KoViewConverter viewConverter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&viewConverter);
+    view.d->lastScale = QPointF(1.0, 1.0);
+
+    PixmapCachingSheetView::Private::Tile* tile = renderTile(view.d, sheet, 0, 0);
+    QVERIFY(tile);
+    QVERIFY(!tile->pending);
+    QVERIFY(!tile->pixmap.isNull());
+    QVERIFY(tile->dirty.isEmpty());
+    const QImage full = tile->pixmap.toImage();
+
+    // Mark the cached pixels to see, which ones get rendered again.
+    tile->pixmap.fill(Qt::red);
+    const QImage marked = tile->pixmap.toImage();
+
+    view.invalidateRange(QRect(2, 3, 2, 2));
+    const QRect damage = tile->dirty.boundingRect();
+    QVERIFY(!damage.isEmpty());
+    QVERIFY(!damage.contains(full.rect()));
+
+    QVERIFY(renderTile(view.d, sheet, 0, 0) == tile);
+    QVERIFY(!tile->pending);
+    QVERIFY(tile->dirty.isEmpty());
+    const QImage partial = tile->pixmap.toImage();
+    QCOMPARE(partial.size(), full.size());
+    for (int y = 0; y < full.height(); ++y) {
+        for (int x = 0; x < full.width(); ++x) {
+            if (damage.contains(x, y))
+                QCOMPARE(partial.pixel(x, y), full.pixel(x, y));
+            else
+                QCOMPARE(partial.pixel(x, y), marked.pixel(x, y));
+        }
+    }
+}
+
+void TestPixmapCachingSheetView::testTileKeys()
+{
+    Map map(0 /* no Doc */);
+    Sheet* sheet = map.addNewSheet();
+
+    KoViewConverter viewConverter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&viewConverter);
+    const qreal scale = 4.0;
+    view.d->lastScale = QPointF(scale, scale);
+
+    // Tile rows beyond 65535 must not share the keys of other tiles.
+    PixmapCachingSheetView::Private::Tile* far = renderTile(view.d, sheet, 0, 70000);
+    PixmapCachingSheetView::Private::Tile* near = renderTile(view.d, sheet, 1, 70000 - 65536);
+    QVERIFY(far);
+    QVERIFY(near);
+    QVERIFY(far != near);
+    QCOMPARE(view.d->tileCache.count(), 2);
+
+    // a damage inside the far tile
+    qreal offset;
+    const int row = sheet->topRow(70000 * 256 / scale + 64 / scale, offset);
+    view.invalidateRange(QRect(1, row, 1, 1));
+    QVERIFY(!far->dirty.isEmpty());
+    QVERIFY(near->dirty.isEmpty());
+}
+
+QTEST_MAIN(TestPixmapCachingSheetView)
@@ -22,9 +22,13 @@
 
 #include "TestPointStorage.h"
 
+#include "ChunkedPointStorage.h"
 #include "PointStorage.h"
 
+#include <QAtomicInt>
+#include <QRunnable>
 #include <QTest>
+#include <QThreadPool>
 
 using namespace Calligra::Sheets;
 
@@ -1198,4 +1202,153 @@ void PointStorageTest::testSubStorage()
 // #endif
 }
 
+// Compares the chunked storage with the plain one. Blocks of three rows
+// spread the data of the small test dimension over several blocks.
+typedef ChunkedPointStorage<int, 3> SmallChunkedStorage;
+
+static void compareStorages(const PointStorage<int>& storage, const SmallChunkedStorage& chunked)
+{
+    QCOMPARE(chunked.dump(), storage.dump());
+    QCOMPARE(chunked.count(), storage.count());
+    QCOMPARE(chunked.columns(), storage.columns());
+    for (int i = 0; i < storage.count(); ++i) {
+        QCOMPARE(chunked.col(i), storage.col(i));
+        QCOMPARE(chunked.row(i), storage.row(i));
+        QCOMPARE(chunked.data(i), storage.data(i));
+    }
+    int chunkedPosition;
+    int position;
+    for (int i = 1; i <= 10; ++i) {
+        QCOMPARE(chunked.firstInColumn(i, &chunkedPosition), storage.firstInColumn(i, &position));
+        QCOMPARE(chunkedPosition, position);
+        QCOMPARE(chunked.lastInColumn(i, &chunkedPosition), storage.lastInColumn(i, &position));
+        QCOMPARE(chunkedPosition, position);
+        QCOMPARE(chunked.firstInRow(i, &chunkedPosition), storage.firstInRow(i, &position));
+        QCOMPARE(chunkedPosition, position);
+        QCOMPARE(chunked.lastInRow(i, &chunkedPosition), storage.lastInRow(i, &position));
+        QCOMPARE(chunkedPosition, position);
+        for (int j = 1; j <= 10; ++j) {
+            QCOMPARE(chunked.lookup(i, j), storage.lookup(i, j));
+            QCOMPARE(chunked.nextInColumn(i, j, &chunkedPosition), storage.nextInColumn(i, j, &position));
+            QCOMPARE(chunkedPosition, position);
+            QCOMPARE(chunked.prevInColumn(i, j, &chunkedPosition), storage.prevInColumn(i, j, &position));
+            QCOMPARE(chunkedPosition, position);
+            QCOMPARE(chunked.nextInRow(i, j, &chunkedPosition), storage.nextInRow(i, j, &position));
+            QCOMPARE(chunkedPosition, position);
+            QCOMPARE(chunked.prevInRow(i, j, &chunkedPosition), storage.prevInRow(i, j, &position));
+            QCOMPARE(chunkedPosition, position);
+        }
+    }
+    const Region region(QRect(2, 3, 4, 6));
+    QCOMPARE(chunked.subStorage(region, false).dump(), storage.subStorage(region, false).dump());
+}
+
+void PointStorageTest::testChunkedStorage()
+{
+    PointStorage<int> storage;
+    SmallChunkedStorage chunked;
+
+    // random order
+    qsrand(1);
+    for (int i = 1; i <= 60; ++i) {
+        const int col = 1 + qrand() % 10;
+        const int row = 1 + qrand() % 10;
+        QCOMPARE(chunked.insert(col, row, i), storage.insert(col, row, i));
+    }
+    compareStorages(storage, chunked);
+    if (QTest::currentTestFailed())
+        return;
+
+    for (int i = 1; i <= 20; ++i) {
+        const int col = 1 + qrand() % 10;
+        const int row = 1 + qrand() % 10;
+        QCOMPARE(chunked.take(col, row), storage.take(col, row));
+    }
+    compareStorages(storage, chunked);
+    if (QTest::currentTestFailed())
+        return;
+
+    QCOMPARE(chunked.insertColumns(3, 2), storage.insertColumns(3, 2));
+    compareStorages(storage, chunked);
+    QCOMPARE(chunked.removeColumns(2, 3), storage.removeColumns(2, 3));
+    compareStorages(storage, chunked);
+    QCOMPARE(chunked.insertRows(2, 3), storage.insertRows(2, 3));
+    compareStorages(storage, chunked);
+    QCOMPARE(chunked.removeRows(4, 2), storage.removeRows(4, 2));
+    compareStorages(storage, chunked);
+    QCOMPARE(chunked.insertShiftRight(QRect(2, 2, 2, 5)), storage.insertShiftRight(QRect(2, 2, 2, 5)));
+    compareStorages(storage, chunked);
+    QCOMPARE(chunked.removeShiftLeft(QRect(3, 1, 2, 8)), storage.removeShiftLeft(QRect(3, 1, 2, 8)));
+    compareStorages(storage, chunked);
+    QCOMPARE(chunked.insertShiftDown(QRect(2, 2, 3, 2)), storage.insertShiftDown(QRect(2, 2, 3, 2)));
+    compareStorages(storage, chunked);
+    QCOMPARE(chunked.removeShiftUp(QRect(1, 3, 4, 3)), storage.removeShiftUp(QRect(1, 3, 4, 3)));
+    compareStorages(storage, chunked);
+
+    QVERIFY(chunked == SmallChunkedStorage(storage));
+    QCOMPARE(chunked.toPointStorage().dump(), storage.dump());
+}
+
+// Reads all data of a chunked storage by index and by position.
+class ChunkedReader : public QRunnable
+{
+public:
+    ChunkedReader(const PointStorage<int>* storage, const SmallChunkedStorage* chunked, QAtomicInt* errors)
+            : m_storage(storage), m_chunked(chunked), m_errors(errors) {}
+
+    virtual void run() {
+        for (int round = 0; round < 100; ++round) {
+            for (int i = 0; i < m_storage->count(); ++i) {
+                if (m_chunked->col(i) != m_storage->col(i) || m_chunked->row(i) != m_storage->row(i) ||
+                        m_chunked->data(i) != m_storage->data(i))
+                    m_errors->ref();
+            }
+            for (int col = 1; col <= 10; ++col) {
+                for (int row = 1; row <= 10; ++row) {
+                    if (m_chunked->lookup(col, row) != m_storage->lookup(col, row))
+                        m_errors->ref();
+                }
+            }
+        }
+    }
+
+private:
+    const PointStorage<int>* m_storage;
+    const SmallChunkedStorage* m_chunked;
+    QAtomicInt* m_errors;
+};
+
+void PointStorageTest::testChunkedConcurrentReads()
+{
+    PointStorage<int> storage;
+    SmallChunkedStorage chunked;
+
+    // modify several blocks, so that their offsets change
+    qsrand(2);
+    for (int i = 1; i <= 60; ++i) {
+        const int col = 1 + qrand() % 10;
+        const int row = 1 + qrand() % 10;
+        storage.insert(col, row, i);
+        chunked.insert(col, row, i);
+    }
+    for (int i = 1; i <= 20; ++i) {
+        const int col = 1 + qrand() % 10;
+        const int row = 1 + qrand() % 10;
+        storage.take(col, row);
+        chunked.take(col, row);
+    }
+    storage.removeShiftLeft(QRect(3, 1, 2, 8));
+    chunked.removeShiftLeft(QRect(3, 1, 2, 8));
+
+    // reading from several threads at once must not alter the storage
+    QAtomicInt errors(0);
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(4);
+    for (int i = 0; i < 4; ++i)
+        threadPool.start(new ChunkedReader(&storage, &chunked, &errors));
+    threadPool.waitForDone();
+    QCOMPARE(int(errors.load()), 0);
+    compareStorages(storage, chunked);
+}
+
 QTEST_MAIN(PointStorageTest)
@@ -56,6 +56,8 @@ private Q_SLOTS:
     void testRowIteration();
     void testDimension();
     void testSubStorage();
+    void testChunkedStorage();
+    void testChunkedConcurrentReads();
 };
 
 } // namespace Sheets
@@ -0,0 +1,139 @@
+/* This file is part of the KDE project
+   Copyright 2026 Calligra Sheets developers <calligra-devel@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestRecalcManager.h"
+
+#include <QTest>
+#include <QTextStream>
+
+#include "CalculationSettings.h"
+#include "Cell.h"
+#include "CellStorage.h"
+#include "FunctionModuleRegistry.h"
+#include "Map.h"
+#include "RecalcManager.h"
+#include "RecalcProfile.h"
+#include "Region.h"
+#include "Sheet.h"
+#include "Value.h"
+
+using namespace Calligra::Sheets;
+
+static const int g_rows = 500;
+
+void TestRecalcManager::initTestCase()
+{
+    FunctionModuleRegistry::instance()->loadFunctionModules();
+    m_map = new Map(0 /* no Doc */);
+    m_sheet = m_map->addNewSheet();
+    m_sheet->setSheetName("Sheet1");
+
+    for (int row = 1; row <= g_rows; ++row) {
+        Cell(m_sheet, 1, row).setUserInput(QString::number(row));
+        Cell(m_sheet, 2, row).setUserInput(QString("=A%1*2").arg(row));
+        Cell(m_sheet, 3, row).setUserInput(QString("=B%1+A%1").arg(row));
+        Cell(m_sheet, 4, row).setUserInput(QString("=IF(C%1>100;SQRT(C%1);-C%1)").arg(row));
+    }
+    Cell(m_sheet, 5, 1).setUserInput(QString("=SUM(D1:D%1)").arg(g_rows));
+
+    QApplication::processEvents(); // handle Damages
+}
+
+void TestRecalcManager::testParallelRecalc()
+{
+    CalculationSettings* settings = m_map->calculationSettings();
+
+    settings->setParallelCalculationEnabled(false);
+    m_map->recalcManager()->recalcMap();
+    const Value serial = m_sheet->cellStorage()->valueRegion(Region(QRect(1, 1, 5, g_rows), m_sheet));
+    QCOMPARE(double(numToDouble(Cell(m_sheet, 3, g_rows).value().asFloat())), double(3 * g_rows));
+
+    // clear the results; the parallel recalculation has to restore them
+    for (int row = 1; row <= g_rows; ++row) {
+        for (int col = 2; col <= 5; ++col)
+            m_sheet->cellStorage()->setValue(col, row, Value());
+    }
+
+    settings->setParallelCalculationEnabled(true);
+    settings->setCalculationThreadCount(4);
+    m_map->recalcManager()->recalcMap();
+    const Value parallel = m_sheet->cellStorage()->valueRegion(Region(QRect(1, 1, 5, g_rows), m_sheet));
+
+    QCOMPARE(parallel, serial);
+    settings->setParallelCalculationEnabled(false);
+}
+
+void TestRecalcManager::testProfiling()
+{
+    RecalcManager* manager = m_map->recalcManager();
+    QVERIFY(!manager->profile());
+    manager->setProfilingEnabled(true);
+    QVERIFY(manager->profile());
+    m_map->recalcManager()->recalcMap();
+    const RecalcProfile* profile = manager->profile();
+
+    QCOMPARE(profile->recalculations(), 1);
+    QCOMPARE(profile->cellTimings().count(), 3 * g_rows + 1);
+
+    // B depends on values only, C on B, D on C and E on all of D
+    const QMap<int, int> depths = profile->depthHistogram();
+    QCOMPARE(depths.count(), 4);
+    QCOMPARE(depths.value(1), g_rows);
+    QCOMPARE(depths.value(2), g_rows);
+    QCOMPARE(depths.value(3), g_rows);
+    QCOMPARE(depths.value(4), 1);
+
+    int sqrtCalls = 0;
+    int ifCalls = 0;
+    int sumCalls = 0;
+    foreach (const RecalcProfile::FunctionTiming& timing, profile->functionTimings()) {
+        if (timing.name == "SQRT")
+            sqrtCalls = timing.calls;
+        else if (timing.name == "IF")
+            ifCalls = timing.calls;
+        else if (timing.name == "SUM")
+            sumCalls = timing.calls;
+    }
+    QCOMPARE(ifCalls, g_rows);
+    QCOMPARE(sqrtCalls, g_rows); // both branches are evaluated
+    QCOMPARE(sumCalls, 1);
+
+    // the longest chain ends in E1
+    const QList<RecalcProfile::Chain> chains = profile->slowestChains(1);
+    QCOMPARE(chains.count(), 1);
+    QCOMPARE(chains[0].cells.count(), 4);
+    QCOMPARE(chains[0].cells.last(), Cell(m_sheet, 5, 1));
+
+    QString report;
+    QTextStream stream(&report);
+    profile->dump(stream, 10);
+    stream.flush();
+    QVERIFY(report.contains("[functions]\n"));
+    QVERIFY(report.contains("Sheet1!E1"));
+
+    manager->setProfilingEnabled(false);
+    QVERIFY(!manager->profile());
+}
+
+void TestRecalcManager::cleanupTestCase()
+{
+    delete m_map;
+}
+
+QTEST_MAIN(TestRecalcManager)
@@ -26,6 +26,7 @@
 #include "Map.h"
 #include "Region.h"
 #include "Sheet.h"
+#include "ValueCalc.h"
 #include "ui/Selection.h"
 #include "../commands/SortManipulator.h"
 
@@ -138,4 +139,156 @@ void TestSort::DescendingOrder()
     QCOMPARE(storage->value(2,3),Value());
 }
 
+void TestSort::MultipleCriteria()
+{
+    Map map;
+    Sheet* sheet = new Sheet(&map, "Sheet1");
+    map.addSheet(sheet);
+
+    CellStorage* storage = sheet->cellStorage();
+    // Data to sort...
+    // A: case insensitive ascending, B: descending, C: original row
+    const QStringList texts = QStringList() << "b" << "A" << "a" << QString() << "B" << "a";
+    const QList<int> numbers = QList<int>() << 2 << 1 << 3 << 5 << 1 << 1;
+    for (int row = 1; row <= 6; ++row) {
+        if (!texts[row - 1].isNull())
+            storage->setValue(1, row, Value(texts[row - 1]));
+        storage->setValue(2, row, Value(numbers[row - 1]));
+        storage->setValue(3, row, Value(row));
+    }
+    storage->setComment(Region(QPoint(3, 6), sheet), "sixth");
+
+    // Sort Manipulator
+    SortManipulator *const command = new SortManipulator();
+    command->setRegisterUndo(0);
+    command->setSheet(sheet);
+
+    // Parameters.
+    command->setSortRows(Qt::Vertical);
+    command->setSkipFirst(false);
+    command->setCopyFormat(false);
+
+    command->addCriterion(0, Qt::AscendingOrder, Qt::CaseInsensitive);
+    command->addCriterion(1, Qt::DescendingOrder, Qt::CaseInsensitive);
+
+    command->add(QRect(1, 1, 3, 6));
+
+    // Execute sort
+    command->execute();
+
+    // equal keys keep their order; empty values go to the end
+    const QList<int> expected = QList<int>() << 3 << 2 << 6 << 1 << 5 << 4;
+    for (int row = 1; row <= 6; ++row)
+        QCOMPARE(storage->value(3, row), Value(expected[row - 1]));
+    QCOMPARE(storage->value(1, 1), Value("a"));
+    QCOMPARE(storage->value(2, 1), Value(3));
+    QCOMPARE(storage->value(1, 6), Value());
+    QCOMPARE(storage->comment(3, 3), QString("sixth"));
+    QCOMPARE(storage->comment(3, 6), QString());
+}
+
+void TestSort::NaturalOrder_data()
+{
+    QTest::addColumn<int>("order");
+    QTest::addColumn<int>("caseSensitivity");
+
+    QTest::newRow("ascending, case insensitive") << int(Qt::AscendingOrder) << int(Qt::CaseInsensitive);
+    QTest::newRow("ascending, case sensitive") << int(Qt::AscendingOrder) << int(Qt::CaseSensitive);
+    QTest::newRow("descending, case insensitive") << int(Qt::DescendingOrder) << int(Qt::CaseInsensitive);
+    QTest::newRow("descending, case sensitive") << int(Qt::DescendingOrder) << int(Qt::CaseSensitive);
+}
+
+void TestSort::NaturalOrder()
+{
+    QFETCH(int, order);
+    QFETCH(int, caseSensitivity);
+
+    Map map;
+    Sheet* sheet = new Sheet(&map, "Sheet1");
+    map.addSheet(sheet);
+
+    CellStorage* storage = sheet->cellStorage();
+    // A: the values, B: the original row
+    const QList<Value> values = QList<Value>() << Value("b") << Value("a10") << Value(10)
+                                << Value("B") << Value(true) << Value("a2") << Value(2.5)
+                                << Value("A2") << Value("10") << Value(false) << Value("Zeta")
+                                << Value("alpha") << Value("b") << Value(-1);
+    for (int row = 1; row <= values.count(); ++row) {
+        storage->setValue(1, row, values[row - 1]);
+        storage->setValue(2, row, Value(row));
+    }
+
+    SortManipulator *const command = new SortManipulator();
+    command->setRegisterUndo(0);
+    command->setSheet(sheet);
+    command->setSortRows(true);
+    command->addCriterion(0, Qt::SortOrder(order), Qt::CaseSensitivity(caseSensitivity));
+    command->add(QRect(1, 1, 2, values.count()));
+    command->execute();
+
+    // the order has to agree with ValueCalc::naturalGreater/naturalLower,
+    // which the sorting used before the keys got extracted; equal values
+    // keep their order
+    ValueCalc* calc = map.calc();
+    const bool caseSensitive = caseSensitivity == Qt::CaseSensitive;
+    for (int row = 2; row <= values.count(); ++row) {
+        const Value previous = storage->value(1, row - 1);
+        const Value current = storage->value(1, row);
+        if (order == Qt::AscendingOrder)
+            QVERIFY(!calc->naturalGreater(previous, current, caseSensitive));
+        else
+            QVERIFY(!calc->naturalLower(previous, current, caseSensitive));
+        if (calc->naturalEqual(previous, current, caseSensitive))
+            QVERIFY(storage->value(2, row - 1).asInteger() < storage->value(2, row).asInteger());
+    }
+}
+
+void TestSort::MergedCells()
+{
+    Map map;
+    Sheet* sheet = new Sheet(&map, "Sheet1");
+    map.addSheet(sheet);
+
+    CellStorage* storage = sheet->cellStorage();
+    // A1:B1 are merged; the other cells of B are visible
+    storage->setValue(1, 1, Value(3));
+    storage->setValue(1, 2, Value(1));
+    storage->setValue(2, 2, Value("one"));
+    storage->setValue(1, 3, Value(2));
+    storage->setValue(2, 3, Value("two"));
+    storage->mergeCells(1, 1, 1, 0);
+
+    SortManipulator *const command = new SortManipulator();
+    command->setRegisterUndo(0);
+    command->setSheet(sheet);
+    command->setSortRows(true);
+    command->addCriterion(0, Qt::AscendingOrder, Qt::CaseInsensitive);
+    command->add(QRect(1, 1, 2, 3));
+    command->execute();
+
+    // the merged cell moved with its master cell, which kept its value
+    QCOMPARE(storage->value(1, 1), Value(1));
+    QCOMPARE(storage->value(2, 1), Value("one"));
+    QCOMPARE(storage->value(1, 2), Value(2));
+    QCOMPARE(storage->value(2, 2), Value("two"));
+    QCOMPARE(storage->value(1, 3), Value(3));
+    QVERIFY(!storage->doesMergeCells(1, 1));
+    QVERIFY(!storage->isPartOfMerged(2, 1));
+    QVERIFY(storage->doesMergeCells(1, 3));
+    QCOMPARE(storage->mergedXCells(1, 3), 1);
+    QCOMPARE(storage->mergedYCells(1, 3), 0);
+    QVERIFY(storage->isPartOfMerged(2, 3));
+
+    // undo restores the merged cell at its old place
+    command->undo();
+    QCOMPARE(storage->value(1, 1), Value(3));
+    QCOMPARE(storage->value(2, 2), Value("one"));
+    QVERIFY(storage->doesMergeCells(1, 1));
+    QCOMPARE(storage->mergedXCells(1, 1), 1);
+    QVERIFY(!storage->doesMergeCells(1, 3));
+    QVERIFY(!storage->isPartOfMerged(2, 3));
+
+    delete command;
+}
+
 QTEST_MAIN(TestSort)
@@ -33,6 +33,10 @@ class TestSort : public QObject
 private Q_SLOTS:
     void AscendingOrder();
     void DescendingOrder();
+    void MultipleCriteria();
+    void NaturalOrder_data();
+    void NaturalOrder();
+    void MergedCells();
 
 };
 
@@ -31,6 +31,14 @@ void TestValue::testEmpty()
     // empty value
     v1 = new Value();
     QCOMPARE(v1->type(), Value::Empty);
+    QVERIFY(!v1->isNull());
+    delete v1;
+
+    // null value
+    v1 = new Value(Value::null());
+    QCOMPARE(v1->type(), Value::Empty);
+    QVERIFY(v1->isNull());
+    QVERIFY(*v1 == Value::empty());
     delete v1;
 }
 
@@ -97,6 +105,20 @@ void TestValue::testFloat()
     delete v1;
 }
 
+void TestValue::testFloatPrecision()
+{
+    // floats exceeding the double precision are kept exactly
+    const long double third = 1.0l / 3.0l;
+    Value v1(third);
+    QCOMPARE(v1.type(), Value::Float);
+    QVERIFY(v1.asFloat() == Number(third));
+    Value v2(v1);
+    QVERIFY(v2.asFloat() == Number(third));
+    v2 = Value(0.5);
+    QVERIFY(v1.asFloat() == Number(third));
+    QCOMPARE(numToDouble(v2.asFloat()), 0.5l);
+}
+
 void TestValue::testString()
 {
     Value* v1;
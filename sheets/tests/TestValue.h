@@ -35,6 +35,7 @@ private Q_SLOTS:
     void testBoolean();
     void testInteger();
     void testFloat();
+    void testFloatPrecision();
     void testString();
     void testDate();
     void testTime();
@@ -44,6 +44,7 @@
 
 // Qt
 #include <QApplication>
+#include <QCache>
 #include <QColor>
 #include <QPainter>
 #include <QRectF>
@@ -86,6 +87,70 @@ using namespace Calligra::Sheets;
 
 const int s_borderSpace = 1;
 
+namespace
+{
+// The horizontal text layout depends on these only.
+struct TextLayoutKey {
+    QFont font;
+    QString text;
+    int alignment;
+    bool wrap;
+    qreal lineWidth;
+    qreal maxHeight;
+
+    bool operator==(const TextLayoutKey& other) const {
+        return text == other.text && lineWidth == other.lineWidth && maxHeight == other.maxHeight &&
+               alignment == other.alignment && wrap == other.wrap && font == other.font;
+    }
+};
+
+uint qHash(const TextLayoutKey& key)
+{
+    return ::qHash(key.text) ^ ::qHash(key.font) ^ ::qHash(key.lineWidth) ^ uint(key.alignment);
+}
+
+struct TextLayout {
+    qreal width;
+    qreal height;
+    int linesCount;
+    bool fittingHeight;
+};
+
+// Shared by all CellViews. Uniformly formatted cells often display the same
+// texts, e.g. numbers, and scrolling back and forth lays them out again.
+class TextLayoutCache
+{
+public:
+    TextLayoutCache() : m_cache(10000) {}
+
+    bool lookup(const TextLayoutKey& key, TextLayout* layout) {
+#ifdef CALLIGRA_SHEETS_MT
+        QMutexLocker locker(&m_mutex);
+#endif
+        const TextLayout* cached = m_cache.object(key);
+        if (!cached)
+            return false;
+        *layout = *cached;
+        return true;
+    }
+
+    void insert(const TextLayoutKey& key, const TextLayout& layout) {
+#ifdef CALLIGRA_SHEETS_MT
+        QMutexLocker locker(&m_mutex);
+#endif
+        m_cache.insert(key, new TextLayout(layout));
+    }
+
+private:
+#ifdef CALLIGRA_SHEETS_MT
+    QMutex m_mutex;
+#endif
+    QCache<TextLayoutKey, TextLayout> m_cache;
+};
+
+Q_GLOBAL_STATIC(TextLayoutCache, s_textLayoutCache)
+} // namespace
+
 class Q_DECL_HIDDEN CellView::Private : public QSharedData
 {
 public:
@@ -307,7 +372,7 @@ void CellView::detach()
     d.detach();
     if (!d->richText.isNull()) {
 #ifdef CALLIGRA_SHEETS_MT
-        QMutexLocker(d->mutex.data());
+        QMutexLocker ml(d->mutex.data());
 #endif
         d->richText = QSharedPointer<QTextDocument>(d->richText->clone());
     }
@@ -1230,7 +1295,7 @@ void CellView::paintText(QPainter& painter,
     } else if (tmpRichText) {
         // Case 5: Rich text.
 #ifdef CALLIGRA_SHEETS_MT
-        QMutexLocker(d->mutex.data());
+        QMutexLocker ml(d->mutex.data());
 #endif
         QTextDocument* doc = d->richText->clone();
         doc->setDefaultTextOption(d->textOptions());
@@ -2113,8 +2178,6 @@ void CellView::Private::calculateTextSize(const QFont& font, const QFontMetricsF
 
 void CellView::Private::calculateHorizontalTextSize(const QFont& font, const QFontMetricsF& fontMetrics)
 {
-    const QStringList textLines = displayText.split('\n');
-    const qreal leading = fontMetrics.leading();
     const QTextOption options = textOptions();
 
     const qreal tmpIndent = style.halign() != Style::Left ? 0.0 : style.indentation();
@@ -2122,6 +2185,23 @@ void CellView::Private::calculateHorizontalTextSize(const QFont& font, const QFo
                              - 0.5 * style.leftBorderPen().width()
                              - 0.5 * style.rightBorderPen().width())
                              - tmpIndent;
+    const qreal maxHeight = height - 2 * s_borderSpace
+                            - 0.5 * style.topBorderPen().width()
+                            - 0.5 * style.bottomBorderPen().width();
+
+    const TextLayoutKey key = { font, displayText, int(options.alignment()), style.wrapText(), lineWidth, maxHeight };
+    TextLayout layout;
+    if (s_textLayoutCache->lookup(key, &layout)) {
+        textWidth = layout.width;
+        textHeight = layout.height;
+        textLinesCount = layout.linesCount;
+        fittingHeight = layout.fittingHeight;
+        fittingWidth = style.wrapText() || textWidth <= lineWidth;
+        return;
+    }
+
+    const QStringList textLines = displayText.split('\n');
+    const qreal leading = fontMetrics.leading();
 
     textHeight = 0.0;
     textWidth = 0.0;
@@ -2139,9 +2219,7 @@ void CellView::Private::calculateHorizontalTextSize(const QFont& font, const QFo
                 break; // forever
             line.setLineWidth(lineWidth);
             textHeight += leading + line.height();
-            if ((textHeight - fontMetrics.descent()) > (height - 2 * s_borderSpace
-                    - 0.5 * style.topBorderPen().width()
-                    - 0.5 * style.bottomBorderPen().width())) {
+            if ((textHeight - fontMetrics.descent()) > maxHeight) {
                 fittingHeight = false;
                 break; // forever
             }
@@ -2152,6 +2230,12 @@ void CellView::Private::calculateHorizontalTextSize(const QFont& font, const QFo
     // The width fits, if the text is wrapped or all lines are smaller than the cell width.
     fittingWidth = style.wrapText() ||
                    textWidth <= lineWidth;
+
+    layout.width = textWidth;
+    layout.height = textHeight;
+    layout.linesCount = textLinesCount;
+    layout.fittingHeight = fittingHeight;
+    s_textLayoutCache->insert(key, layout);
 }
 
 void CellView::Private::calculateVerticalTextSize(const QFont& font, const QFontMetricsF& fontMetrics)
@@ -2187,7 +2271,7 @@ void CellView::Private::calculateRichTextSize(const QFont& font, const QFontMetr
 {
     Q_UNUSED(fontMetrics);
 #ifdef CALLIGRA_SHEETS_MT
-    QMutexLocker(mutex.data());
+    QMutexLocker ml(mutex.data());
 #endif
     richText->setDefaultFont(font);
     richText->setDocumentMargin(0);
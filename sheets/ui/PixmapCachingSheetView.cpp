@@ -18,6 +18,7 @@
 */
 
 #include "PixmapCachingSheetView.h"
+#include "PixmapCachingSheetView_p.h"
 
 #include "CellView.h"
 #include "SheetsDebug.h"
@@ -25,38 +26,39 @@
 #include "../Sheet.h"
 #include "../part/CanvasBase.h"
 
-#include <QCache>
+#include <QImage>
 #include <QPainter>
+#include <QPixmap>
+#include <QRegion>
 
 
 #ifdef CALLIGRA_SHEETS_MT
-#include <ThreadWeaver/Job>
-#include <ThreadWeaver/Weaver>
+#include <QRunnable>
+#include <QThreadPool>
 #endif
 
 using namespace Calligra::Sheets;
 
 #define TILESIZE 256
 
-class PixmapCachingSheetView::Private
-{
-public:
-    Private(PixmapCachingSheetView* q) : q(q) {}
-    PixmapCachingSheetView* q;
-    QCache<int, QPixmap> tileCache;
-    QPointF lastScale;
-
-    QPixmap* getTile(const Sheet* sheet, int x, int y, CanvasBase* canvas);
-};
+// The memory to spend on the tiles; the visible tiles are kept in any case.
+static const int g_cacheBudget = 64 * 1024 * 1024;
+// The memory needed by a tile.
+static const int g_tileCost = TILESIZE * TILESIZE * 4;
+// The number of tile rows/columns rendered ahead of the scrolling.
+static const int g_prefetchDistance = 1;
+// Cell borders are painted across the cell boundaries.
+static const int g_damageMargin = 2;
 
 #ifdef CALLIGRA_SHEETS_MT
-class TileDrawingJob : public ThreadWeaver::Job
+class TileDrawingJob : public QObject, public QRunnable
 #else
 class TileDrawingJob
 #endif
 {
 public:
-    TileDrawingJob(const Sheet* sheet, SheetView* sheetView, CanvasBase* canvas, const QPointF& scale, int x, int y);
+    TileDrawingJob(const Sheet* sheet, SheetView* sheetView, CanvasBase* canvas, const QPointF& scale, int x, int y,
+                   const QImage& base, const QRect& rect);
     ~TileDrawingJob();
     void run();
 private:
@@ -67,14 +69,20 @@ public:
     QPointF m_scale;
     int m_x;
     int m_y;
+    QRect m_rect;       // the part of the tile to render
     QImage m_image;
+    int m_epoch;
+    int m_generation;
+    bool m_prefetch;
 };
 
-TileDrawingJob::TileDrawingJob(const Sheet *sheet, SheetView* sheetView, CanvasBase* canvas, const QPointF& scale, int x, int y)
-    : m_sheet(sheet), m_sheetView(sheetView), m_canvas(canvas), m_scale(scale), m_x(x), m_y(y)
-    , m_image(TILESIZE, TILESIZE, QImage::Format_ARGB32)
+TileDrawingJob::TileDrawingJob(const Sheet *sheet, SheetView* sheetView, CanvasBase* canvas, const QPointF& scale, int x, int y,
+                               const QImage& base, const QRect& rect)
+    : m_sheet(sheet), m_sheetView(sheetView), m_canvas(canvas), m_scale(scale), m_x(x), m_y(y), m_rect(rect)
+    , m_image(base.isNull() ? QImage(TILESIZE, TILESIZE, QImage::Format_ARGB32) : base.convertToFormat(QImage::Format_ARGB32))
+    , m_epoch(0), m_generation(0), m_prefetch(false)
 {
-    debugSheets << "new job for " << x << "," << y << " " << m_scale;
+    debugSheets << "new job for " << x << "," << y << " " << m_scale << m_rect;
 }
 
 TileDrawingJob::~TileDrawingJob()
@@ -87,9 +95,11 @@ void TileDrawingJob::run()
     debugSheets << "start draw for " << m_x << "," << m_y << " " << m_scale;
     const bool rtl = m_sheet->layoutDirection() == Qt::RightToLeft;
 
-    m_image.fill(QColor(255, 255, 255, 0).rgba());
     QPainter pixmapPainter(&m_image);
-    pixmapPainter.setClipRect(m_image.rect());
+    pixmapPainter.setCompositionMode(QPainter::CompositionMode_Source);
+    pixmapPainter.fillRect(m_rect, QColor(255, 255, 255, 0));
+    pixmapPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    pixmapPainter.setClipRect(m_rect);
     pixmapPainter.scale(m_scale.x(), m_scale.y());
 
     QRect globalPixelRect(QPoint(m_x * TILESIZE, m_y * TILESIZE), QSize(TILESIZE, TILESIZE));
@@ -106,11 +116,20 @@ void TileDrawingJob::run()
         pixmapPainter.translate(-docRect.x(), -docRect.y());
     }
 
+    // only the cells in the rendered part
+    const QRect globalPaintRect = m_rect.translated(globalPixelRect.topLeft());
+    const QRectF paintDocRect = rtl ? docRect : QRectF(
+            globalPaintRect.x() / m_scale.x(),
+            globalPaintRect.y() / m_scale.y(),
+            globalPaintRect.width() / m_scale.x(),
+            globalPaintRect.height() / m_scale.y()
+    );
+
     qreal loffset, toffset;
-    const int left = m_sheet->leftColumn(docRect.left(), loffset);
-    const int right = m_sheet->rightColumn(docRect.right());
-    const int top = m_sheet->topRow(docRect.top(), toffset);
-    const int bottom = m_sheet->bottomRow(docRect.bottom());
+    const int left = m_sheet->leftColumn(paintDocRect.left(), loffset);
+    const int right = m_sheet->rightColumn(paintDocRect.right());
+    const int top = m_sheet->topRow(paintDocRect.top(), toffset);
+    const int bottom = m_sheet->bottomRow(paintDocRect.bottom());
     QRect cellRect(left, top, right - left + 1, bottom - top + 1);
 
     debugSheets << globalPixelRect << docRect;
@@ -120,13 +139,17 @@ void TileDrawingJob::run()
 
     //m_image.save(QString("/tmp/tile%1_%2.png").arg(m_x).arg(m_y));
     debugSheets << "end draw for " << m_x << "," << m_y << " " << m_scale;
+#ifdef CALLIGRA_SHEETS_MT
+    // hand the tile over to the view's thread
+    QMetaObject::invokeMethod(m_sheetView, "jobDone", Qt::QueuedConnection, Q_ARG(QObject*, this));
+#endif
 }
 
 
 PixmapCachingSheetView::PixmapCachingSheetView(const Sheet* sheet)
     : SheetView(sheet), d(new Private(this))
 {
-    d->tileCache.setMaxCost(128); // number of tiles to cache
+    d->tileCache.setMaxCost(g_cacheBudget); // bytes of tiles to cache
 }
 
 PixmapCachingSheetView::~PixmapCachingSheetView()
@@ -134,13 +157,11 @@ PixmapCachingSheetView::~PixmapCachingSheetView()
     delete d;
 }
 
-void PixmapCachingSheetView::jobDone(ThreadWeaver::Job *tjob)
+void PixmapCachingSheetView::jobDone(QObject *tjob)
 {
 #ifdef CALLIGRA_SHEETS_MT
     TileDrawingJob* job = static_cast<TileDrawingJob*>(tjob);
-    if (job->m_scale == d->lastScale) {
-        int idx = job->m_x << 16 | job->m_y;
-        d->tileCache.insert(idx, new QPixmap(QPixmap::fromImage(job->m_image)));
+    if (d->finishTile(job) && !job->m_prefetch && job->m_canvas) {
         // TODO: figure out what area to repaint
         job->m_canvas->update();
     }
@@ -150,30 +171,91 @@ void PixmapCachingSheetView::jobDone(ThreadWeaver::Job *tjob)
 #endif
 }
 
-QPixmap* PixmapCachingSheetView::Private::getTile(const Sheet* sheet, int x, int y, CanvasBase* canvas)
+QPixmap* PixmapCachingSheetView::Private::getTile(const Sheet* sheet, int x, int y, CanvasBase* canvas, bool prefetch)
 {
-    int idx = x << 16 | y;
-    if (tileCache.contains(idx)) return tileCache.object(idx);
+    const qint64 key = tileKey(x, y);
+    Tile* tile = tileCache.object(key);
+    if (!tile) {
+        tile = new Tile;
+        tile->dirty = QRect(0, 0, TILESIZE, TILESIZE);
+        if (!tileCache.insert(key, tile, g_tileCost))
+            return 0;
+    }
+    if (!tile->dirty.isEmpty() && !tile->pending)
+        render(sheet, x, y, tile, canvas, prefetch);
+    // a damaged tile is shown until its update is rendered
+    return tile->pixmap.isNull() ? 0 : &tile->pixmap;
+}
 
+void PixmapCachingSheetView::Private::render(const Sheet* sheet, int x, int y, Tile* tile, CanvasBase* canvas, bool prefetch)
+{
+    // In right-to-left mode the tiles are rendered completely.
+    const bool complete = tile->pixmap.isNull() || sheet->layoutDirection() == Qt::RightToLeft;
+    const QRect rect = complete ? QRect(0, 0, TILESIZE, TILESIZE) : tile->dirty.boundingRect();
+    const QImage base = complete ? QImage() : tile->pixmap.toImage();
+
+    TileDrawingJob* job = new TileDrawingJob(sheet, q, canvas, lastScale, x, y, base, rect);
+    job->m_epoch = epoch;
+    job->m_generation = tile->generation;
+    job->m_prefetch = prefetch;
 #ifdef CALLIGRA_SHEETS_MT
-    TileDrawingJob* job = new TileDrawingJob(sheet, q, canvas, lastScale, x, y);
-    QObject::connect(job, SIGNAL(done(ThreadWeaver::Job*)), q, SLOT(jobDone(ThreadWeaver::Job*)), Qt::QueuedConnection);
-    ThreadWeaver::Weaver::instance()->enqueue(job);
-    QPixmap* pm = new QPixmap(TILESIZE, TILESIZE);
-    pm->fill(QColor(255, 255, 255, 0));
-    if (tileCache.insert(idx, pm)) {
-        return pm;
-    }
+    tile->pending = true;
+    job->setAutoDelete(false); // deleted by jobDone()
+    QThreadPool::globalInstance()->start(job);
 #else
-    TileDrawingJob job(sheet, q, canvas, lastScale, x, y);
-    job.run();
-    QPixmap *pm = new QPixmap(QPixmap::fromImage(job.m_image));
-    if (tileCache.insert(idx, pm)) {
-        tileCache.insert(idx, pm);
-        return pm;
-    }
+    job->run();
+    finishTile(job);
+    delete job;
 #endif
-    return 0;
+}
+
+bool PixmapCachingSheetView::Private::finishTile(TileDrawingJob* job)
+{
+    if (job->m_epoch != epoch)
+        return false;
+    // the tile may have been evicted meanwhile
+    Tile* tile = tileCache.object(tileKey(job->m_x, job->m_y));
+    if (!tile)
+        return false;
+    tile->pending = false;
+    tile->pixmap = QPixmap::fromImage(job->m_image);
+    // keep the damages that arrived while rendering
+    if (tile->generation == job->m_generation)
+        tile->dirty = QRegion();
+    return true;
+}
+
+void PixmapCachingSheetView::Private::clear()
+{
+    tileCache.clear();
+    lastTiles = QRect();
+    ++epoch;
+}
+
+void PixmapCachingSheetView::Private::invalidateTiles(const Sheet* sheet, const QRect& range)
+{
+    if (tileCache.isEmpty())
+        return;
+    const QRectF docRect = sheet->cellCoordinatesToDocument(range);
+    const QRect pixelRect = QRectF(docRect.x() * lastScale.x(), docRect.y() * lastScale.y(),
+                                   docRect.width() * lastScale.x(), docRect.height() * lastScale.y())
+                            .toAlignedRect().adjusted(-g_damageMargin, -g_damageMargin, g_damageMargin, g_damageMargin);
+    // In right-to-left mode the damaged tile rows are invalidated completely.
+    const bool rtl = sheet->layoutDirection() == Qt::RightToLeft;
+    const QRect tileRect(0, 0, TILESIZE, TILESIZE);
+    const QList<qint64> keys = tileCache.keys();
+    for (int i = 0; i < keys.count(); ++i) {
+        const QPoint position(int(keys[i] >> 32), int(keys[i] & 0xFFFFFFFF));
+        if (pixelRect.bottom() < position.y() * TILESIZE || pixelRect.top() >= (position.y() + 1) * TILESIZE)
+            continue;
+        const QRect damage = rtl ? tileRect
+                             : pixelRect.translated(-position.x() * TILESIZE, -position.y() * TILESIZE) & tileRect;
+        if (damage.isEmpty())
+            continue;
+        Tile* tile = tileCache.object(keys[i]);
+        tile->dirty += damage;
+        ++tile->generation;
+    }
 }
 
 void PixmapCachingSheetView::paintCells(QPainter& painter, const QRectF& paintRect, const QPointF& topLeft, CanvasBase* canvas, const QRect& visibleRect)
@@ -204,7 +286,7 @@ void PixmapCachingSheetView::paintCells(QPainter& painter, const QRectF& paintRe
 
     QPointF scale = QPointF(sx, sy);
     if (scale != d->lastScale) {
-        d->tileCache.clear();
+        d->clear();
     }
     d->lastScale = scale;
 
@@ -217,6 +299,10 @@ void PixmapCachingSheetView::paintCells(QPainter& painter, const QRectF& paintRe
     tiles.setRight((bottomRight.x() * sx + TILESIZE-1) / TILESIZE);
     tiles.setBottom((bottomRight.y() * sy + TILESIZE-1) / TILESIZE);
 
+    // keep at least the visible tiles and the ones rendered ahead
+    const int tileCount = (tiles.width() + 2 * g_prefetchDistance) * (tiles.height() + 2 * g_prefetchDistance);
+    d->tileCache.setMaxCost(qMax(g_cacheBudget, 2 * tileCount * g_tileCost));
+
     bool rtl = s->layoutDirection() == Qt::RightToLeft;
 
     if (rtl) {
@@ -242,19 +328,39 @@ void PixmapCachingSheetView::paintCells(QPainter& painter, const QRectF& paintRe
             }
         }
     }
+
+#ifdef CALLIGRA_SHEETS_MT
+    // render the tiles ahead of the scrolling direction
+    if (!d->lastTiles.isNull()) {
+        const int dx = tiles.left() - d->lastTiles.left();
+        const int dy = tiles.top() - d->lastTiles.top();
+        for (int i = 0; i < g_prefetchDistance; ++i) {
+            if (dx != 0) {
+                const int x = (dx > 0) ? tiles.right() + i : tiles.left() - 1 - i;
+                for (int y = qMax(0, tiles.top()); x >= 0 && y < tiles.bottom(); y++)
+                    d->getTile(s, x, y, canvas, true);
+            }
+            if (dy != 0) {
+                const int y = (dy > 0) ? tiles.bottom() + i : tiles.top() - 1 - i;
+                for (int x = qMax(0, tiles.left()); y >= 0 && x < tiles.right(); x++)
+                    d->getTile(s, x, y, canvas, true);
+            }
+        }
+    }
+#endif
+    d->lastTiles = tiles;
 }
 
 void PixmapCachingSheetView::invalidateRange(const QRect &rect)
 {
-    // TODO: figure out which tiles to invalidate
-    d->tileCache.clear();
+    d->invalidateTiles(sheet(), rect);
 
     SheetView::invalidateRange(rect);
 }
 
 void PixmapCachingSheetView::invalidate()
 {
-    d->tileCache.clear();
+    d->clear();
 
     SheetView::invalidate();
 }
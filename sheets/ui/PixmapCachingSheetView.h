@@ -22,14 +22,10 @@
 
 #include "SheetView.h"
 
-namespace ThreadWeaver {
-    class Job;
-}
-
 namespace Calligra {
 namespace Sheets {
 
-class PixmapCachingSheetView : public SheetView
+class CALLIGRA_SHEETS_COMMON_TEST_EXPORT PixmapCachingSheetView : public SheetView
 {
     Q_OBJECT
 public:
@@ -48,8 +44,10 @@ public:
 protected:
     virtual void invalidateRange(const QRect &range);
 private Q_SLOTS:
-    void jobDone(ThreadWeaver::Job* job);
+    void jobDone(QObject* job);
 private:
+    friend class TestPixmapCachingSheetView;
+
     class Private;
     Private * const d;
 };
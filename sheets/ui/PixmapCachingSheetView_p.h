@@ -0,0 +1,77 @@
+/* This file is part of the KDE project
+   Copyright 2010 Marijn Kruisselbrink <mkruisselbrink@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_PIXMAP_CACHING_SHEET_VIEW_P
+#define CALLIGRA_SHEETS_PIXMAP_CACHING_SHEET_VIEW_P
+
+// Sheets
+#include "PixmapCachingSheetView.h"
+
+// Qt
+#include <QCache>
+#include <QPixmap>
+#include <QPointF>
+#include <QRect>
+#include <QRegion>
+
+class TileDrawingJob;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class CanvasBase;
+class Sheet;
+
+class CALLIGRA_SHEETS_COMMON_TEST_EXPORT PixmapCachingSheetView::Private
+{
+public:
+    struct Tile {
+        Tile() : pending(false), generation(0) {}
+
+        QPixmap pixmap;     // null until rendered once
+        QRegion dirty;      // the damaged pixels of the tile
+        bool pending;       // a job renders the tile
+        int generation;     // increased by each damage
+    };
+
+    Private(PixmapCachingSheetView* q) : q(q), epoch(0) {}
+    PixmapCachingSheetView* q;
+    // keyed by the tile column in the upper and the tile row in the lower 32 bits
+    QCache<qint64, Tile> tileCache;
+    QPointF lastScale;
+    QRect lastTiles;
+    // increased, whenever the cache is cleared
+    int epoch;
+
+    static qint64 tileKey(int x, int y) {
+        return (qint64(x) << 32) | quint32(y);
+    }
+
+    QPixmap* getTile(const Sheet* sheet, int x, int y, CanvasBase* canvas, bool prefetch = false);
+    void render(const Sheet* sheet, int x, int y, Tile* tile, CanvasBase* canvas, bool prefetch);
+    bool finishTile(TileDrawingJob* job);
+    void clear();
+    void invalidateTiles(const Sheet* sheet, const QRect& range);
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_PIXMAP_CACHING_SHEET_VIEW_P
@@ -548,7 +548,7 @@ void SheetView::invalidateRange(const QRect& range)
 void SheetView::obscureCells(const QPoint &position, int numXCells, int numYCells)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->obscuredLock);
+    QWriteLocker wl(&d->obscuredLock);
 #endif
     // Start by un-obscuring cells that we might be obscuring right now
     const QPair<QRectF, bool> pair = d->obscuredInfo->containedPair(position);
@@ -569,7 +569,7 @@ void SheetView::obscureCells(const QPoint &position, int numXCells, int numYCell
 QPoint SheetView::obscuringCell(const QPoint &obscuredCell) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->obscuredLock);
+    QReadLocker rl(&d->obscuredLock);
 #endif
     const QPair<QRectF, bool> pair = d->obscuredInfo->containedPair(obscuredCell);
     if (pair.first.isNull())
@@ -582,7 +582,7 @@ QPoint SheetView::obscuringCell(const QPoint &obscuredCell) const
 QSize SheetView::obscuredRange(const QPoint &obscuringCell) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->obscuredLock);
+    QReadLocker rl(&d->obscuredLock);
 #endif
     const QPair<QRectF, bool> pair = d->obscuredInfo->containedPair(obscuringCell);
     if (pair.first.isNull())
@@ -598,7 +598,7 @@ QSize SheetView::obscuredRange(const QPoint &obscuringCell) const
 QRect SheetView::obscuredArea(const QPoint &cell) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->obscuredLock);
+    QReadLocker rl(&d->obscuredLock);
 #endif
     const QPair<QRectF, bool> pair = d->obscuredInfo->containedPair(cell);
     if (pair.first.isNull())
@@ -612,7 +612,7 @@ QRect SheetView::obscuredArea(const QPoint &cell) const
 bool SheetView::isObscured(const QPoint &cell) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->obscuredLock);
+    QReadLocker rl(&d->obscuredLock);
 #endif
     const QPair<QRectF, bool> pair = d->obscuredInfo->containedPair(cell);
     if (pair.first.isNull())
@@ -628,7 +628,7 @@ bool SheetView::isObscured(const QPoint &cell) const
 bool SheetView::obscuresCells(const QPoint &cell) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->obscuredLock);
+    QReadLocker rl(&d->obscuredLock);
 #endif
     const QPair<QRectF, bool> pair = d->obscuredInfo->containedPair(cell);
     if (pair.first.isNull())
@@ -644,7 +644,7 @@ bool SheetView::obscuresCells(const QPoint &cell) const
 QSize SheetView::totalObscuredRange() const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->obscuredLock);
+    QReadLocker rl(&d->obscuredLock);
 #endif
     return d->obscuredRange;
 }
@@ -684,7 +684,7 @@ CellView* SheetView::createCellView(int col, int row)
 bool SheetView::isHighlighted(const QPoint &cell) const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->highlightLock);
+    QReadLocker rl(&d->highlightLock);
 #endif
     return d->highlightedCells.lookup(cell.x(), cell.y());
 }
@@ -692,7 +692,7 @@ bool SheetView::isHighlighted(const QPoint &cell) const
 void SheetView::setHighlighted(const QPoint &cell, bool isHighlighted)
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->highlightLock);
+    QWriteLocker wl(&d->highlightLock);
 #endif
     bool oldHadHighlights = d->highlightedCells.count() > 0;
     bool oldVal;
@@ -711,7 +711,7 @@ void SheetView::setHighlighted(const QPoint &cell, bool isHighlighted)
 bool SheetView::hasHighlightedCells() const
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QReadLocker(&d->highlightLock);
+    QReadLocker rl(&d->highlightLock);
 #endif
     return d->highlightedCells.count() > 0;
 }
@@ -719,7 +719,7 @@ bool SheetView::hasHighlightedCells() const
 void SheetView::clearHighlightedCells()
 {
 #ifdef CALLIGRA_SHEETS_MT
-    QWriteLocker(&d->highlightLock);
+    QWriteLocker wl(&d->highlightLock);
 #endif
     d->activeHighlight = QPoint();
     if (d->highlightedCells.count()) {